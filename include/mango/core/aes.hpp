@@ -29,10 +29,20 @@ namespace mango
     // - the mac_length must be 4, 6, 8, 10, 12, 14, or 16
     // - output.size must be input.size + mac_length
     //
+    // gcm_encrypt() and gcm_decrypt():
+    // - the input can be any length and the output is the same length
+    // - the iv can be any length but 12 bytes (96 bits) is recommended
+    // - the tag is 16 bytes (128 bits)
+    // - gcm_decrypt() returns false if the tag does not match; the output
+    //   must not be used in that case
+    //
+    // CTR and GCM buffers of 1 MB or more are processed in the ThreadPool.
+    //
     // Hardware acceleration support:
-    // ECB: Intel AES-NI
-    // CBC: Intel AES-NI
-    // CTR: none
+    // ECB: Intel AES-NI, ARMv8 Crypto
+    // CBC: Intel AES-NI, ARMv8 Crypto
+    // CTR: Intel AES-NI, ARMv8 Crypto
+    // GCM: Intel AES-NI + PCLMULQDQ, ARMv8 Crypto
     // CCM: none
 
     class AES
@@ -56,6 +66,9 @@ namespace mango
         void ctr_block_encrypt(u8* output, const u8* input, size_t length, const u8* iv);
         void ctr_block_decrypt(u8* output, const u8* input, size_t length, const u8* iv);
 
+        void gcm_encrypt(u8* output, const u8* input, size_t length, Memory associated, Memory iv, u8* tag);
+        bool gcm_decrypt(u8* output, const u8* input, size_t length, Memory associated, Memory iv, const u8* tag);
+
         void ccm_block_encrypt(Memory output, Memory input, Memory associated, Memory nonce, int mac_length);
         void ccm_block_decrypt(Memory output, Memory input, Memory associated, Memory nonce, int mac_length);
     
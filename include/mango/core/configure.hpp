@@ -472,6 +472,11 @@
         #include <wmmintrin.h>
     #endif
 
+    #ifdef __PCLMUL__
+        #define MANGO_ENABLE_CLMUL
+        #include <wmmintrin.h>
+    #endif
+
     #ifdef __SHA__
         #define MANGO_ENABLE_SHA
         #include <immintrin.h>
@@ -492,6 +497,20 @@
         #endif
     #endif
 
+    // Runtime dispatch: functions tagged with MANGO_TARGET_xxx may use instructions above
+    // the compiled feature level and must only be called when getCPUFlags() reports them.
+    #if defined(MANGO_COMPILER_GCC) || defined(MANGO_COMPILER_CLANG)
+        #define MANGO_ENABLE_TARGET_DISPATCH
+        #define MANGO_TARGET_AVX2 __attribute__((target("avx2")))
+        #define MANGO_TARGET_F16C __attribute__((target("avx,f16c")))
+        #include <immintrin.h>
+    #elif defined(MANGO_COMPILER_MICROSOFT)
+        #define MANGO_ENABLE_TARGET_DISPATCH
+        #define MANGO_TARGET_AVX2
+        #define MANGO_TARGET_F16C
+        #include <immintrin.h>
+    #endif
+
 #elif defined(MANGO_CPU_ARM)
 
     #if defined(__ARM_NEON__) || defined(__ARM_NEON)
@@ -4,6 +4,7 @@
 */
 #pragma once
 
+#include <string>
 #include "configure.hpp"
 
 namespace mango
@@ -60,6 +61,25 @@ namespace mango
         CPU_ARM_CRC32  = 0x0010000000000000
     };
 
+    // The detected features can be limited for testing with the MANGO_CPU_FLAGS environment
+    // variable; for example MANGO_CPU_FLAGS=sse4 hides AVX and above. Recognized levels are:
+    // "none", "sse2", "sse4", "avx", "avx2" and "avx512". Any other value is reported on stderr
+    // and ignored, so that a typo does not silently test the wrong kernels.
 	u64 getCPUFlags();
 
+	// ----------------------------------------------------------------------------
+	// Kernel dispatch report
+	// ----------------------------------------------------------------------------
+
+    // Three kernels are selected at runtime from getCPUFlags() and reported here:
+    // "jpeg.ycbcr" (sse2, avx2), "jpeg.idct" (sse2) and "math.half" (f16c). Only the AVX2 color
+    // conversion and the F16C half conversion can be above the compiled feature level. All other
+    // SIMD code, e.g. the blitter, block codecs and CRC, uses the compiled level and is not listed.
+
+    // record which implementation a runtime dispatched kernel selected, e.g. ("jpeg.idct", "sse2")
+    void setKernelVariant(const std::string& kernel, const std::string& variant);
+
+    // one "kernel: variant" line per kernel which has been selected so far
+    std::string getKernelVariants();
+
 } // namespace mango
@@ -12,6 +12,22 @@ namespace mango
 
     void md5(u32 hash[4], Memory memory);
     void sha1(u32 hash[5], Memory memory);
+
+    // incremental SHA-1; the hash is in the same format as sha1() returns
+
+    class SHA1
+    {
+    protected:
+        u32 m_state[5];
+        u64 m_size;
+        u8 m_buffer[64];
+
+    public:
+        SHA1();
+
+        void update(Memory memory);
+        void final(u32 hash[5]);
+    };
     void sha2(u32 hash[8], Memory memory);
 
     u32 xxhash32(Memory memory);
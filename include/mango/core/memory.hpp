@@ -52,17 +52,72 @@ namespace mango
     protected:
         Memory m_memory;
 
+        // Lazily materialized memory (for example, a compressed file in a container) produces
+        // the range on demand and may update m_memory.address; other memory is always resident.
+        virtual void materialize(size_t offset, size_t size)
+        {
+            MANGO_UNREFERENCED_PARAMETER(offset);
+            MANGO_UNREFERENCED_PARAMETER(size);
+        }
+
     public:
+        enum Access
+        {
+            NORMAL,     // default read-ahead
+            SEQUENTIAL, // aggressive read-ahead; pages can be released soon after they are read
+            RANDOM,     // no read-ahead
+            WILLNEED,   // start reading the range in the background
+            DONTNEED,   // the range is not needed in the near future
+            POPULATE,   // fault the range in before returning
+            HUGEPAGE,   // back the range with transparent huge pages where the kernel supports it
+        };
+
         VirtualMemory() = default;
         virtual ~VirtualMemory() {}
 
+        // access hints for the range starting at offset; zero size extends to the end of the memory.
+        // the hints are ignored by memory which is not mapped from a file, except that lazily
+        // materialized memory may release the range on DONTNEED (see acquire).
+        virtual void advise(Access access, size_t offset = 0, size_t size = 0)
+        {
+            MANGO_UNREFERENCED_PARAMETER(access);
+            MANGO_UNREFERENCED_PARAMETER(offset);
+            MANGO_UNREFERENCED_PARAMETER(size);
+        }
+
+        // populate the range asynchronously
+        virtual void prefetch(size_t offset = 0, size_t size = 0)
+        {
+            advise(WILLNEED, offset, size);
+        }
+
+        // size of the memory; does not materialize it
+        size_t size() const
+        {
+            return m_memory.size;
+        }
+
+        // materialize and return a range of the memory; lazily materialized memory produces
+        // only the requested range so that, for example, header probes do not decompress
+        // the whole file. The address stays valid for the lifetime of the object; after the
+        // range is released with advise(DONTNEED) it must be acquired again before it is read.
+        Memory acquire(size_t offset, size_t size) const
+        {
+            offset = std::min(offset, m_memory.size);
+            size = std::min(size, m_memory.size - offset);
+            const_cast<VirtualMemory*>(this)->materialize(offset, size);
+            return Memory(m_memory.address + offset, size);
+        }
+
         const Memory* operator -> () const
         {
+            const_cast<VirtualMemory*>(this)->materialize(0, m_memory.size);
             return &m_memory;
         }
 
         operator Memory () const
         {
+            const_cast<VirtualMemory*>(this)->materialize(0, m_memory.size);
             return m_memory;
         }
     };
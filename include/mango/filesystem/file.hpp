@@ -7,6 +7,7 @@
 #include <cstdio>
 #include <string>
 #include <vector>
+#include <functional>
 #include "../core/configure.hpp"
 #include "../core/stream.hpp"
 #include "mapper.hpp"
@@ -36,6 +37,13 @@ namespace filesystem {
         operator const u8* () const;
         const u8* data() const;
         size_t size() const;
+
+        // materialize only the given range (see VirtualMemory::acquire)
+        Memory acquire(size_t offset, size_t size) const;
+
+        // access hints
+        void advise(VirtualMemory::Access access, size_t offset = 0, size_t size = 0) const;
+        void prefetch(size_t offset = 0, size_t size = 0) const;
     };
 
     class FileStream : public Stream
@@ -44,7 +52,15 @@ namespace filesystem {
 		struct FileHandle* m_handle;
 
     public:
-        FileStream(const std::string& filename, OpenMode mode);
+        // ASYNC and DIRECT are available on unix; other platforms throw
+        enum Buffering
+        {
+            STDIO,  // C runtime buffering
+            ASYNC,  // large blocks are written behind and read ahead in a background queue
+            DIRECT  // ASYNC bypassing the page cache (O_DIRECT) where supported
+        };
+
+        FileStream(const std::string& filename, OpenMode mode, Buffering buffering = STDIO);
         ~FileStream();
 
         const std::string& filename() const;
@@ -56,5 +72,36 @@ namespace filesystem {
         void write(const void* data, size_t size);
     };
 
+    // -----------------------------------------------------------------
+    // BatchFileReader
+    // -----------------------------------------------------------------
+
+    /*
+        BatchFileReader reads a list of files into pooled, page aligned buffers
+        and delivers each file to the callback from the ThreadPool as soon as it
+        has been read, so that decoding overlaps the I/O of the remaining files.
+        The reads are issued through io_uring on Linux and fall back to pread()
+        tasks when io_uring is not available or async is false. The memory is valid only for the
+        duration of the callback; files which cannot be read are delivered with
+        empty memory. read() returns after all callbacks have completed and then
+        rethrows the first exception thrown by the callback. read() can be called
+        from a ThreadPool task; it processes queued tasks while waiting for buffers.
+    */
+
+    class BatchFileReader : protected NonCopyable
+    {
+    protected:
+        struct BatchContext* m_context;
+
+    public:
+        using Callback = std::function<void(const std::string& filename, Memory memory)>;
+
+        BatchFileReader(size_t depth = 64, bool async = true);
+        ~BatchFileReader();
+
+        bool isAsync() const; // true when io_uring is used
+        void read(const std::vector<std::string>& filenames, Callback callback);
+    };
+
 } // namespace filesystem
 } // namespace mango
@@ -5,8 +5,11 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <functional>
 #include "../core/configure.hpp"
 #include "../core/object.hpp"
+#include "mapper.hpp"
 
 namespace mango {
 namespace filesystem {
@@ -29,7 +32,9 @@ namespace filesystem {
         FileObserver();
         virtual ~FileObserver();
 
-        void start(const std::string& pathname);
+        // recursive: the sub-folders are watched as well and the filenames are relative
+        // to pathname (Linux and Windows only)
+        void start(const std::string& pathname, bool recursive = false);
         void stop();
 
         // Two kinds of events will be generated:
@@ -44,5 +49,47 @@ namespace filesystem {
         virtual void onEvent(u32 flags, const std::string& filename) = 0;
     };
 
+    // -----------------------------------------------------------------
+    // WatchedIndex
+    // -----------------------------------------------------------------
+
+    /*
+        WatchedIndex indexes the files in a folder tree once and keeps the index up
+        to date from FileObserver events. The events are coalesced per file and applied
+        after the tree has been quiet for the debounce interval (in milliseconds), so
+        the cost of an update depends on the number of changed files, not the size of
+        the tree. Change notifications without a filename trigger a full rescan.
+
+        The cached containers of modified and deleted files are invalidated before
+        the callback is invoked from the WatchedIndex thread with the applied changes.
+        A callback which is being invoked can still run after setCallback() has replaced it.
+    */
+
+    class WatchedIndex : protected NonCopyable
+    {
+    protected:
+        struct WatchedIndexState* m_state;
+
+    public:
+        struct Change
+        {
+            u32 flags; // FileObserver::CREATED, DELETED or MODIFIED
+            std::string filename;
+        };
+
+        using Callback = std::function<void(const std::vector<Change>& changes)>;
+
+        WatchedIndex(const std::string& pathname, const IndexFilter& filter = IndexFilter(), u32 debounce = 50);
+        ~WatchedIndex();
+
+        void setCallback(Callback callback);
+
+        // incremented after every applied batch of changes
+        u64 version() const;
+
+        void getIndex(CompactFileIndex& index) const;
+        bool isFile(const std::string& filename) const;
+    };
+
 } // namespace filesystem
 } // namespace mango
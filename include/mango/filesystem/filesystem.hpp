@@ -8,3 +8,4 @@
 #include "path.hpp"
 #include "file.hpp"
 #include "fileobserver.hpp"
+#include "zipwriter.hpp"
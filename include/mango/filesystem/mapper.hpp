@@ -6,6 +6,8 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <functional>
 #include "../core/configure.hpp"
 #include "../core/memory.hpp"
 
@@ -88,22 +90,119 @@ namespace filesystem {
         }
     };
 
+    struct IndexFilter
+    {
+        std::vector<std::string> extensions; // example: ".png"; case insensitive, empty accepts all files
+        u64 minimum_size { 0 };
+        u64 maximum_size { ~u64(0) };
+        bool sizes { true }; // when false the sizes are not queried and the size limits are ignored
+
+        bool isNameAccepted(const char* name, size_t length) const;
+        bool isSizeAccepted(u64 size) const;
+    };
+
+    class CompactFileIndex
+    {
+    protected:
+        struct Entry
+        {
+            size_t offset;
+            u32 length;
+            u32 flags;
+            u64 size;
+        };
+
+        // the names are stored back-to-back with terminating zeros
+        std::vector<char> m_names;
+        std::vector<Entry> m_entries;
+
+    public:
+        void emplace(const char* name, size_t length, u64 size, u32 flags);
+        void append(const CompactFileIndex& index);
+
+        size_t size() const
+        {
+            return m_entries.size();
+        }
+
+        bool empty() const
+        {
+            return m_entries.empty();
+        }
+
+        void clear()
+        {
+            m_names.clear();
+            m_entries.clear();
+        }
+
+        const char* getName(size_t index) const
+        {
+            return m_names.data() + m_entries[index].offset;
+        }
+
+        u64 getSize(size_t index) const
+        {
+            return m_entries[index].size;
+        }
+
+        u32 getFlags(size_t index) const
+        {
+            return m_entries[index].flags;
+        }
+
+        FileInfo operator [] (size_t index) const
+        {
+            const Entry& entry = m_entries[index];
+            return FileInfo(std::string(m_names.data() + entry.offset, entry.length), entry.size, entry.flags);
+        }
+    };
+
     class AbstractMapper : protected NonCopyable
     {
+    protected:
+        // mmapBatch() scheduled in the order of the keys, for example archive offsets
+        void mmapBatchOrdered(const std::vector<std::string>& filenames, const std::vector<u64>& keys,
+                              const std::function<void(const std::string&, VirtualMemory*)>& callback);
+
     public:
+        using BatchCallback = std::function<void(const std::string& filename, VirtualMemory* memory)>;
+
         AbstractMapper() = default;
         virtual ~AbstractMapper() = default;
 
         virtual bool isFile(const std::string& filename) const = 0;
         virtual void getIndex(FileIndex& index, const std::string& pathname) = 0;
         virtual VirtualMemory* mmap(const std::string& filename) = 0;
+
+        // Memory map the files concurrently on the ThreadPool. Each file is fully materialized and
+        // delivered to the callback as soon as it is ready; the callback takes ownership of the memory,
+        // which is nullptr if the file cannot be mapped. The callback is called from multiple threads.
+        // Returns after all files have been delivered.
+        virtual void mmapBatch(const std::vector<std::string>& filenames, BatchCallback callback);
+
+        // files in pathname and all of its sub-folders, excluding the contents of containers;
+        // the names are relative to pathname and the order is unspecified
+        virtual void getIndexRecursive(CompactFileIndex& index, const std::string& pathname, const IndexFilter& filter);
+
+        // unique identity of a file for the container cache; mappers which
+        // cannot identify their files return an empty string
+        virtual std::string getIdentity(const std::string& filename) const
+        {
+            MANGO_UNREFERENCED_PARAMETER(filename);
+            return std::string();
+        }
     };
 
+    struct ContainerNode;
+
     class Mapper : protected NonCopyable
     {
     protected:
+        friend class File;
+
         AbstractMapper* m_mapper { nullptr };
-        VirtualMemory* m_parent_memory { nullptr };
+        std::shared_ptr<ContainerNode> m_container;
         std::vector<std::unique_ptr<AbstractMapper>> m_mappers;
         std::string m_basepath;
         std::string m_pathname;
@@ -124,5 +223,20 @@ namespace filesystem {
         static bool isCustomMapper(const std::string& filename);
     };
 
+    // Opened containers are shared process-wide so that repeated access into the same
+    // archive does not parse it again. Containers which are not referenced by any Mapper
+    // are evicted when the cached container memory exceeds the budget (default: 256 MB).
+    void setContainerCacheBudget(u64 bytes);
+    void clearContainerCache();
+
+    // drop the cached containers opened from the file and the containers nested in them;
+    // the filename must be canonical (absolute, symbolic links resolved)
+    void invalidateContainerCache(const std::string& filename);
+
+    // Files in solid archives are decoded in archive order and the decoded files are kept
+    // for later access until they exceed the budget (default: 64 MB per archive).
+    void setSolidArchiveBudget(u64 bytes);
+    u64 getSolidArchiveBudget();
+
 } // namespace filesystem
 } // namespace mango
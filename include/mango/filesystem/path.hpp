@@ -47,6 +47,8 @@ namespace filesystem {
         {
             return m_files[index];
         }
+
+        void getIndexRecursive(CompactFileIndex& index, const IndexFilter& filter = IndexFilter()) const;
     };
 
     // filename manipulation functions (example: "foo/bar/readme.txt")
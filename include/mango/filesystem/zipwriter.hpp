@@ -0,0 +1,59 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <string>
+#include "../core/configure.hpp"
+#include "../core/object.hpp"
+#include "../core/memory.hpp"
+#include "../core/stream.hpp"
+
+namespace mango {
+namespace filesystem {
+
+    // -----------------------------------------------------------------
+    // ZipWriter
+    // -----------------------------------------------------------------
+
+    /*
+        ZipWriter compresses the added entries in parallel in the ThreadPool and
+        writes each entry to the output stream as soon as it has been compressed;
+        the central directory is collected while the entries are written and
+        appended by close(). ZIP64 records are written when the archive needs them.
+
+        The memory given to add() must remain valid until close(). Files given to
+        addFile() are mapped when they are compressed. Stored entries are aligned
+        to the given alignment so that MapperZIP can map them without copying.
+        The destructor calls close() if it has not been called.
+    */
+
+    class ZipWriter : protected NonCopyable
+    {
+    protected:
+        struct ZipContext* m_context;
+
+    public:
+        enum Method
+        {
+            AUTO,     // STORE for already compressed file formats, DEFLATE otherwise
+            STORE,
+            DEFLATE,
+            BZIP2,
+            LZMA,
+            ZSTD
+        };
+
+        ZipWriter(Stream& output, int level = 6, u32 alignment = 4096);
+        ~ZipWriter();
+
+        void add(const std::string& name, Memory memory, Method method = AUTO);
+        void addFile(const std::string& name, const std::string& filename, Method method = AUTO);
+
+        // writes the central directory; throws if an entry could not be written
+        void close();
+    };
+
+} // namespace filesystem
+} // namespace mango
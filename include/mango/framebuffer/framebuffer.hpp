@@ -4,6 +4,7 @@
 */
 #pragma once
 
+#include <vector>
 #include "../window/window.hpp"
 
 namespace mango {
@@ -19,12 +20,95 @@ namespace framebuffer {
         struct FramebufferContext* m_context;
 
     public:
+        struct Rect
+        {
+            int x;
+            int y;
+            int width;
+            int height;
+        };
+
         Framebuffer(int width, int height);
         ~Framebuffer();
 
         Surface lock();
         void unlock();
         void present();
+
+        // present only the damaged rectangles; the surface returned by the next lock()
+        // has the same contents as the presented frame so only changes need to be drawn
+        void present(const std::vector<Rect>& rects);
+    };
+
+    // -------------------------------------------------------------------
+    // OffscreenFramebuffer
+    // -------------------------------------------------------------------
+
+    /*
+        OffscreenFramebuffer has the same lock() / unlock() / present() interface as
+        the Framebuffer but does not need a display server; the frames are rendered
+        into memory. Presented frames can be captured into image files which are
+        encoded in a background thread; the renderer is throttled only when all of
+        the capture buffers are waiting to be encoded.
+
+        Usage example:
+
+        OffscreenFramebuffer framebuffer(640, 480);
+        framebuffer.setCapture("frame", ".png");
+
+        for (int i = 0; i < 100; ++i)
+        {
+            Surface s = framebuffer.lock();
+            s.clear(0.0f, 0.0f, 0.0f, 1.0f);
+            framebuffer.unlock();
+            framebuffer.present(); // writes frame000000.png, frame000001.png, ..
+        }
+
+        for (auto& stats : framebuffer.getFrameStats())
+        {
+            // stats.render, stats.stall, ..
+        }
+    */
+
+    class OffscreenFramebuffer : public NonCopyable
+    {
+    protected:
+        struct OffscreenContext* m_context;
+
+    public:
+        struct FrameStats
+        {
+            u64 time;    // present() timestamp since construction, in microseconds
+            u64 render;  // lock() to present(), in microseconds
+            u64 stall;   // time present() waited for a free capture buffer, in microseconds
+        };
+
+        OffscreenFramebuffer(int width, int height, int buffers = 3);
+        virtual ~OffscreenFramebuffer();
+
+        int2 getWindowSize() const;
+
+        Surface lock();
+        void unlock();
+        void present();
+        void present(const std::vector<Framebuffer::Rect>& rects);
+
+        // encode every presented frame into <prefix><frame number><extension>;
+        // empty prefix disables capturing
+        void setCapture(const std::string& prefix, const std::string& extension = ".png", float quality = 1.0f);
+
+        // block until all captured frames have been written
+        void flush();
+
+        const std::vector<FrameStats>& getFrameStats() const;
+        void resetFrameStats();
+
+        // event loop emulation; onDraw() is called once, then onIdle() until breakEventLoop()
+        void enterEventLoop();
+        void breakEventLoop();
+
+        virtual void onIdle();
+        virtual void onDraw();
     };
 
 } // namespace framebuffer
@@ -50,4 +50,8 @@ namespace mango
     void registerImageDecoder(ImageDecoder::CreateFunc func, const std::string& extension);
     bool isImageDecoder(const std::string& extension);
 
+    // read only the header of an image file; the decoder is given the start of the file
+    // first and the whole file only when the header is not found there
+    ImageHeader getImageHeader(const std::string& filename);
+
 } // namespace mango
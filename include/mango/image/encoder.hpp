@@ -10,6 +10,7 @@
 #include "compression.hpp"
 #include "header.hpp"
 #include "exif.hpp"
+#include "mipmap.hpp"
 
 namespace mango
 {
@@ -33,4 +34,23 @@ namespace mango
     void registerImageEncoder(ImageEncoder::CreateFunc func, const std::string& extension);
     bool isImageEncoder(const std::string& extension);
 
+    // ------------------------------------------------------------------
+    // texture encoders
+    // ------------------------------------------------------------------
+
+    struct TextureEncoderOptions
+    {
+        TextureCompression compression { TextureCompression::NONE };
+        int levels { 1 };     // number of mipmap levels; 0 is the complete chain
+        MipmapOptions mipmap; // filtering of the generated levels (mipmap.levels is not used)
+    };
+
+    // The count is 1 for a 2D texture or 6 for a cube map with the faces in order
+    // +X, -X, +Y, -Y, +Z, -Z. The faces must have the same dimensions. The images are
+    // compressed in the ThreadPool a few at a time and written in file order, so
+    // the complete compressed texture is never held in memory. Uncompressed
+    // textures are converted to the closest format the container supports.
+    void encodeTextureDDS(Stream& output, const Surface* faces, int count, const TextureEncoderOptions& options);
+    void encodeTextureKTX(Stream& output, const Surface* faces, int count, const TextureEncoderOptions& options);
+
 } // namespace mango
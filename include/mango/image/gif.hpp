@@ -0,0 +1,99 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <vector>
+#include "../core/configure.hpp"
+#include "../core/memory.hpp"
+#include "../core/object.hpp"
+#include "color.hpp"
+#include "surface.hpp"
+
+namespace mango
+{
+
+    /*
+        GifDecoder is a streaming API for animated GIF files. The frames are decoded
+        in file order and composited into a persistent B8G8R8A8 canvas; the previous
+        frame's disposal method is applied incrementally before the next frame is drawn.
+
+        Usage example:
+
+        GifDecoder gif(memory);
+        Bitmap bitmap(gif.width(), gif.height(), FORMAT_B8G8R8A8);
+
+        GifDecoder::Frame frame;
+        while (gif.next(&frame))
+        {
+            bitmap.blit(0, 0, gif.canvas());
+            present(bitmap, frame.delay * 10); // display time in milliseconds
+        }
+
+        The index() function walks the file without decoding any LZW streams and can be
+        used to count frames and compute durations.
+    */
+
+    class GifDecoder : protected NonCopyable
+    {
+    public:
+        enum Disposal
+        {
+            DISPOSE_UNSPECIFIED = 0,
+            DISPOSE_NONE = 1,
+            DISPOSE_BACKGROUND = 2,
+            DISPOSE_PREVIOUS = 3
+        };
+
+        struct Frame
+        {
+            int left = 0;      // frame rectangle in the canvas
+            int top = 0;
+            int width = 0;
+            int height = 0;
+            int delay = 0;     // in 1/100th of a second
+            int disposal = DISPOSE_UNSPECIFIED;
+        };
+
+        GifDecoder(Memory memory);
+        ~GifDecoder();
+
+        int width() const;
+        int height() const;
+
+        // decode the next frame into the canvas; returns false when there are no more frames
+        bool next(Frame* frame = nullptr);
+
+        // skip the next frame without decoding it; the canvas is not updated
+        bool skip(Frame* frame = nullptr);
+
+        // restart from the first frame and clear the canvas
+        void rewind();
+
+        const Surface& canvas() const;
+
+        static std::vector<Frame> index(Memory memory);
+
+    protected:
+        Memory m_memory;
+
+        // the screen is parsed once when m_start is initialized; these are declared first
+        Palette m_palette;
+        int m_width;
+        int m_height;
+
+        u8* m_start;
+        u8* m_current;
+
+        Bitmap m_canvas;
+        std::vector<u8> m_bits;
+        std::vector<u8> m_deinterlace;
+        std::vector<u32> m_previous;
+        Frame m_last;
+
+        bool read(Frame& frame, bool decode);
+        void dispose();
+    };
+
+} // namespace mango
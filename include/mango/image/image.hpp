@@ -14,3 +14,6 @@
 #include "encoder.hpp"
 #include "blitter.hpp"
 #include "surface.hpp"
+#include "gif.hpp"
+#include "resample.hpp"
+#include "mipmap.hpp"
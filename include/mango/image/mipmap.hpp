@@ -0,0 +1,81 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <vector>
+#include "../core/configure.hpp"
+#include "../core/memory.hpp"
+#include "../core/object.hpp"
+#include "surface.hpp"
+#include "resample.hpp"
+
+namespace mango
+{
+
+    // ------------------------------------------------------------------
+    // Mipmaps
+    // ------------------------------------------------------------------
+
+    enum class MipmapAlpha
+    {
+        STRAIGHT,     // alpha is filtered as an independent channel
+        WEIGHTED,     // straight alpha; color is weighted by alpha so transparent texels do not bleed
+        PREMULTIPLIED // color is premultiplied; the output keeps color <= alpha
+    };
+
+    struct MipmapOptions
+    {
+        ResampleFilter filter { ResampleFilter::BOX };
+        MipmapAlpha alpha { MipmapAlpha::STRAIGHT };
+        bool srgb { false }; // filter UNORM colors in linear space (SRGB formats always are)
+        int levels { 0 };    // maximum number of levels; 0 is the complete chain down to 1x1
+    };
+
+    /*
+        Mipmap chain in the format of the source surface.
+
+        The levels are stored tightly packed (stride = width * bytes) in a single
+        allocation, level 0 first, which is the layout expected by DDS and KTX.
+        Level 0 is a copy of the source. The other levels are filtered from the
+        previous level in 32 bit floating point so the rounding errors do not
+        accumulate down the chain; the rows are processed in parallel in the ThreadPool.
+
+        Usage example:
+
+        MipmapOptions options;
+        options.filter = ResampleFilter::KAISER;
+        options.srgb = true;
+
+        MipmapChain chain = generateMipmaps(bitmap, options);
+
+        for (int level = 0; level < chain.levels(); ++level)
+        {
+            info.compress(memory, chain[level]);
+        }
+    */
+
+    class MipmapChain : private NonCopyable
+    {
+    protected:
+        std::vector<u8, AlignedAllocator<u8>> m_buffer;
+        std::vector<Surface> m_levels;
+
+        friend MipmapChain generateMipmaps(const Surface& source, const MipmapOptions& options);
+
+    public:
+        MipmapChain();
+        MipmapChain(MipmapChain&& chain);
+        ~MipmapChain();
+
+        MipmapChain& operator = (MipmapChain&& chain);
+
+        int levels() const;
+        const Surface& operator [] (int level) const;
+        Memory memory() const; // all levels
+    };
+
+    MipmapChain generateMipmaps(const Surface& source, const MipmapOptions& options = MipmapOptions());
+
+} // namespace mango
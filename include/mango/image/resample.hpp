@@ -0,0 +1,63 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include "../core/configure.hpp"
+#include "../core/object.hpp"
+#include "surface.hpp"
+
+namespace mango
+{
+
+    // ------------------------------------------------------------------
+    // Resampler
+    // ------------------------------------------------------------------
+
+    enum class ResampleFilter
+    {
+        BOX,
+        BILINEAR,
+        MITCHELL, // Mitchell-Netravali cubic, B = C = 1/3
+        KAISER,   // Kaiser windowed sinc, radius of 3 texels
+        LANCZOS   // Lanczos3
+    };
+
+    /*
+        Separable image resampler.
+
+        The filter weights are computed once in the constructor for the given
+        size pair, so the same Resampler can be used for any number of images.
+        32 bit formats with 8 bit components are filtered in fixed point when the
+        source and destination formats are the same. Other formats are converted
+        to 32 bit floating point RGBA internally and can be mixed freely.
+
+        The image is processed in horizontal bands in the ThreadPool; the
+        horizontally filtered rows of a band are kept in a small intermediate
+        buffer which the vertical pass reads sequentially.
+
+        With premultiply the color is multiplied by alpha for filtering and
+        divided after so that transparent texels do not bleed into the visible
+        ones. Images with premultiplied alpha are filtered as-is.
+    */
+
+    class Resampler : protected NonCopyable
+    {
+    protected:
+        struct ResamplerContext* m_context;
+
+    public:
+        Resampler(int destWidth, int destHeight, int sourceWidth, int sourceHeight,
+                  ResampleFilter filter = ResampleFilter::LANCZOS);
+        ~Resampler();
+
+        // dest and source must have the dimensions given in the constructor
+        void resample(const Surface& dest, const Surface& source, bool premultiply = false) const;
+    };
+
+    // scales source to the size of dest
+    void resample(const Surface& dest, const Surface& source,
+                  ResampleFilter filter = ResampleFilter::LANCZOS, bool premultiply = false);
+
+} // namespace mango
@@ -8,4 +8,5 @@
 #include "filesystem/filesystem.hpp"
 #include "image/image.hpp"
 #include "simd/simd.hpp"
-#include "math/math.hpp"
+#include "math/math.hpp"
+#include "math/bvh.hpp"
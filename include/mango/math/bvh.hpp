@@ -0,0 +1,115 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <limits>
+#include <vector>
+#include "../core/configure.hpp"
+#include "../core/memory.hpp"
+#include "../core/object.hpp"
+#include "geometry.hpp"
+
+namespace mango
+{
+
+    // ------------------------------------------------------------------
+    // BVH
+    // ------------------------------------------------------------------
+
+    /*
+        Bounding volume hierarchy over triangles or boxes.
+
+        The hierarchy is built with binned SAH; large subtrees are built in parallel
+        in the ThreadPool. The binary build tree is collapsed into 4-wide nodes which
+        store the child bounds quantized to 8 bits relative to the node bounds, so one
+        node fits in a 64 byte cache line.
+
+        The primitive indices returned by the queries refer to the array given to build().
+        refit() updates the bounds of animated geometry without changing the topology;
+        the tree quality degrades when the primitives move a lot relative to each other
+        and a new build() is recommended in that case.
+
+        Usage example:
+
+        BVH bvh(triangles.data(), triangles.size());
+
+        IntersectBarycentric result;
+        u32 index;
+
+        if (bvh.intersect(result, index, ray))
+        {
+            // triangles[index] is the closest hit
+        }
+    */
+
+    class BVH : protected NonCopyable
+    {
+    public:
+        struct Node
+        {
+            float origin[3];
+            float scale[3];
+            u8 qmin[3][4]; // quantized child bounds: [axis][child]
+            u8 qmax[3][4];
+            u32 child[4];  // node index, LEAF | first << 4 | (count - 1), or EMPTY
+        };
+
+        enum : u32
+        {
+            LEAF = 0x80000000,
+            EMPTY = 0xffffffff,
+            MAX_LEAF_SIZE = 16,
+            MAX_PRIMITIVES = 1 << 27
+        };
+
+        using NodeArray = std::vector<Node, AlignedAllocator<Node>>;
+
+        BVH();
+        BVH(const Triangle* triangles, size_t count);
+        BVH(const Box* boxes, size_t count);
+        ~BVH();
+
+        void build(const Triangle* triangles, size_t count);
+        void build(const Box* boxes, size_t count);
+
+        // update the bounds; the primitives must be in the same order as in build()
+        void refit(const Triangle* triangles);
+        void refit(const Box* boxes);
+
+        // closest hit in front of the ray origin
+        bool intersect(IntersectBarycentric& result, u32& index, const Ray& ray) const;
+        bool intersect(IntersectRange& result, u32& index, const Ray& ray) const;
+
+        // any hit in front of the ray origin and closer than distance
+        bool occluded(const Ray& ray, float distance = std::numeric_limits<float>::max()) const;
+
+        // primitives whose bounds intersect the frustum (conservative)
+        void intersect(std::vector<u32>& indices, const Frustum& frustum) const;
+
+        size_t size() const;
+        Box bounds() const;
+        const NodeArray& nodes() const;
+
+    protected:
+        enum Type
+        {
+            NONE,
+            TRIANGLES,
+            BOXES
+        };
+
+        Type m_type;
+        NodeArray m_nodes;
+        std::vector<Box> m_bounds; // node bounds for refit()
+        std::vector<u32> m_indices; // leaf order to primitive index
+        std::vector<Triangle> m_triangles; // leaf order
+        std::vector<Box> m_boxes; // leaf order
+
+        void build(const std::vector<Box>& boxes);
+        void refit();
+        Box leafBounds(u32 code) const;
+    };
+
+} // namespace mango
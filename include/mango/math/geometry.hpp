@@ -5,6 +5,9 @@
 #pragma once
 
 #include <cassert>
+#include <limits>
+#include <vector>
+#include "../core/memory.hpp"
 #include "math.hpp"
 
 namespace mango
@@ -311,6 +314,7 @@ namespace mango
     {
         float3 point[4]; // 0: top_left, 1: top_right, 2: bottom_left, 3: bottom_right
         float3 origin;
+        Plane plane[6]; // left, right, bottom, top, near, far; normals point inside
 
         Frustum() = default;
         Frustum(const float4x4& m);
@@ -319,6 +323,86 @@ namespace mango
         Ray ray(float x, float y) const;
     };
 
+    // ------------------------------------------------------------------
+    // RayPacket
+    // ------------------------------------------------------------------
+
+    // N rays in structure-of-arrays layout, where N is the width of T
+    // (float32x4, float32x8 or float32x16). The packet intersect functions
+    // return a bitmask with bit i set when ray i hits the primitive.
+
+    template <typename T>
+    struct RayPacket
+    {
+        T origin[3];
+        T direction[3];
+        T invdir[3];
+
+        RayPacket() = default;
+        RayPacket(const Ray* rays);
+        ~RayPacket() = default;
+    };
+
+    using RayPacket4 = RayPacket<float32x4>;
+    using RayPacket8 = RayPacket<float32x8>;
+    using RayPacket16 = RayPacket<float32x16>;
+
+    // ------------------------------------------------------------------
+    // BoxBatch, SphereBatch, TriangleBatch
+    // ------------------------------------------------------------------
+
+    // Primitives in structure-of-arrays layout for the batch intersect functions.
+    // The arrays are padded to a multiple of 16 elements so that the queries only
+    // process full vectors; the padding never reports a hit.
+
+    using BatchArray = std::vector<float, AlignedAllocator<float>>;
+
+    struct BoxBatch
+    {
+        BatchArray minx, miny, minz;
+        BatchArray maxx, maxy, maxz;
+
+        size_t size() const { return m_size; }
+        void reserve(size_t count);
+        void clear();
+        void push_back(const Box& box);
+        Box operator [] (size_t index) const;
+
+    private:
+        size_t m_size = 0;
+    };
+
+    struct SphereBatch
+    {
+        BatchArray x, y, z;
+        BatchArray radius;
+
+        size_t size() const { return m_size; }
+        void reserve(size_t count);
+        void clear();
+        void push_back(const Sphere& sphere);
+        Sphere operator [] (size_t index) const;
+
+    private:
+        size_t m_size = 0;
+    };
+
+    struct TriangleBatch
+    {
+        BatchArray x0, y0, z0; // position[0]
+        BatchArray x1, y1, z1; // position[1] - position[0]
+        BatchArray x2, y2, z2; // position[2] - position[0]
+
+        size_t size() const { return m_size; }
+        void reserve(size_t count);
+        void clear();
+        void push_back(const Triangle& triangle);
+        Triangle operator [] (size_t index) const;
+
+    private:
+        size_t m_size = 0;
+    };
+
     // ------------------------------------------------------------------
     // Intersect
     // ------------------------------------------------------------------
@@ -361,6 +445,53 @@ namespace mango
         bool intersect_twosided(const Ray& ray, const Triangle& triangle);
     };
 
+    // Packet versions of IntersectRange and IntersectBarycentric; the results are
+    // valid in the lanes whose bit is set in the returned mask. The sphere test
+    // assumes normalized ray directions.
+
+    template <typename T>
+    struct PacketIntersectRange
+    {
+        T t0;
+        T t1;
+
+        u32 intersect(const RayPacket<T>& packet, const Box& box);
+        u32 intersect(const RayPacket<T>& packet, const Sphere& sphere);
+    };
+
+    template <typename T>
+    struct PacketIntersectBarycentric
+    {
+        T t0;
+        T u, v, w;
+
+        u32 intersect(const RayPacket<T>& packet, const Triangle& triangle);
+    };
+
+    // One ray against a batch: finds the closest primitive in front of the ray origin.
+
+    struct IntersectBatch
+    {
+        float t0;
+        int index; // -1 when nothing was hit
+
+        bool intersect(const Ray& ray, const BoxBatch& boxes);
+        bool intersect(const Ray& ray, const SphereBatch& spheres);
+        bool intersect(const Ray& ray, const TriangleBatch& triangles);
+    };
+
+    // Batch queries writing a bitmask: bit (i % 32) of mask[i / 32] is set when
+    // primitive i is hit by the ray or is inside the frustum. The mask must have room
+    // for (size() + 31) / 32 words. The return value is the number of bits set.
+    // The frustum tests are conservative: primitives near the frustum corners can
+    // be reported visible even when they are outside.
+
+    size_t intersect(u32* mask, const Ray& ray, const BoxBatch& boxes);
+    size_t intersect(u32* mask, const Ray& ray, const SphereBatch& spheres);
+    size_t intersect(u32* mask, const Ray& ray, const TriangleBatch& triangles);
+    size_t intersect(u32* mask, const Frustum& frustum, const BoxBatch& boxes);
+    size_t intersect(u32* mask, const Frustum& frustum, const SphereBatch& spheres);
+
     bool intersect(Rectangle& result, const Rectangle& rect0, const Rectangle& rect1);
     bool intersect(Ray& result, const Plane& plane0, const Plane& plane1);
     bool intersect(float3& result, const Plane& plane0, const Plane& plane1, const Plane& plane2);
@@ -9,4 +9,5 @@
 #include "quaternion.hpp"
 #include "geometry.hpp"
 #include "spline.hpp"
-#include "srgb.hpp"
+#include "srgb.hpp"
+#include "transform.hpp"
@@ -0,0 +1,51 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include "../core/configure.hpp"
+#include "../core/half.hpp"
+#include "vector.hpp"
+#include "matrix.hpp"
+
+namespace mango
+{
+
+    // ------------------------------------------------------------------
+    // array transforms
+    // ------------------------------------------------------------------
+
+    // The array functions process count elements with SIMD kernels; large arrays
+    // are split into blocks which are processed in parallel in the ThreadPool.
+    // The transforms use the same row-vector convention as operator * (float3, float4x4).
+    // The destination can be the same as the source but the arrays must not otherwise overlap.
+
+    // positions (w = 1)
+    void transformPoints(float3* dest, const float3* source, size_t count, const float4x4& m);
+    void transformPoints(float* x, float* y, float* z, size_t count, const float4x4& m);
+
+    // normals are transformed with the inverse transpose of m and normalized
+    void transformNormals(float3* dest, const float3* source, size_t count, const float4x4& m);
+    void transformNormals(float* x, float* y, float* z, size_t count, const float4x4& m);
+
+    // homogeneous vectors
+    void transform(float32x4* dest, const float32x4* source, size_t count, const float4x4& m);
+
+    // ------------------------------------------------------------------
+    // array conversions
+    // ------------------------------------------------------------------
+
+    // F16C is selected at runtime when the CPU supports it; it rounds ties to even
+    // where the software conversion rounds them away from zero.
+    void f32_to_f16(float16* dest, const float* source, size_t count);
+    void f16_to_f32(float* dest, const float16* source, size_t count);
+
+    // Same conversion as the scalar and float32x4 versions in srgb.hpp; the 8 bit
+    // versions store UNORM values and decode through a lookup table.
+    void linear_to_srgb(float* dest, const float* source, size_t count);
+    void srgb_to_linear(float* dest, const float* source, size_t count);
+    void linear_to_srgb(u8* dest, const float* source, size_t count);
+    void srgb_to_linear(float* dest, const u8* source, size_t count);
+
+} // namespace mango
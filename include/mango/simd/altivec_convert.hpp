@@ -260,24 +260,26 @@ namespace detail {
     // narrow
     // -----------------------------------------------------------------
 
+    // vec_pack truncates, vec_packs saturates
+
     static inline u8x16 narrow(u16x8 a, u16x8 b)
     {
-        return vec_pack(a.data, b.data);
+        return vec_packs(a.data, b.data);
     }
 
     static inline u16x8 narrow(u32x4 a, u32x4 b)
     {
-        return vec_pack(a.data, b.data);
+        return vec_packs(a.data, b.data);
     }
 
     static inline s8x16 narrow(s16x8 a, s16x8 b)
     {
-        return vec_pack(a.data, b.data);
+        return vec_packs(a.data, b.data);
     }
 
     static inline s16x8 narrow(s32x4 a, s32x4 b)
     {
-        return vec_pack(a.data, b.data);
+        return vec_packs(a.data, b.data);
     }
 
     // -----------------------------------------------------------------
@@ -399,15 +401,15 @@ namespace detail {
     template <>
     inline u32x4 convert<u32x4>(f32x4 s)
     {
-        s = add(s.data, f32x4_set1(0.5f).data);
-        return vec_ctu(s.data, 0);
+        // round to nearest even, same as the other backends
+        return vec_ctu(vec_rint(s.data), 0);
     }
 
     template <>
     inline s32x4 convert<s32x4>(f32x4 s)
     {
-        s = add(s.data, f32x4_set1(0.5f).data);
-        return vec_cts(s.data, 0);
+        // round to nearest even, same as the other backends
+        return vec_cts(vec_rint(s.data), 0);
     }
 
     template <>
@@ -567,10 +569,10 @@ namespace detail {
     template <>
     inline s32x4 convert<s32x4>(f64x4 s)
     {
-        s32 x = s32(get_component<0>(s) + 0.5);
-        s32 y = s32(get_component<1>(s) + 0.5);
-        s32 z = s32(get_component<2>(s) + 0.5);
-        s32 w = s32(get_component<3>(s) + 0.5);
+        s32 x = s32(std::nearbyint(get_component<0>(s)));
+        s32 y = s32(std::nearbyint(get_component<1>(s)));
+        s32 z = s32(std::nearbyint(get_component<2>(s)));
+        s32 w = s32(std::nearbyint(get_component<3>(s)));
         return s32x4_set4(x, y, z, w);
     }
 
@@ -627,10 +629,12 @@ namespace detail {
     template <>
     inline s64x4 convert<s64x4>(f64x4 v)
     {
-        s64 x = s64(get_component<0>(v) + 0.5);
-        s64 y = s64(get_component<1>(v) + 0.5);
-        s64 z = s64(get_component<2>(v) + 0.5);
-        s64 w = s64(get_component<3>(v) + 0.5);
+        // adding 0.5 before the cast rounded negative values towards zero
+        v = round(v);
+        s64 x = s64(get_component<0>(v));
+        s64 y = s64(get_component<1>(v));
+        s64 z = s64(get_component<2>(v));
+        s64 w = s64(get_component<3>(v));
         return s64x4_set4(x, y, z, w);
     }
 
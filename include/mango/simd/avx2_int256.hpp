@@ -371,14 +371,13 @@ namespace detail {
 
     static inline u32x8 adds(u32x8 a, u32x8 b)
     {
-  	    const __m256i temp = _mm256_add_epi32(a, b);
-  	    return _mm256_or_si256(temp, _mm256_cmpgt_epi32(a, temp));
+        // a + min(b, ~a) cannot wrap around
+        return _mm256_add_epi32(a, _mm256_min_epu32(b, _mm256_xor_si256(a, _mm256_set1_epi32(-1))));
     }
 
     static inline u32x8 subs(u32x8 a, u32x8 b)
     {
-  	    const __m256i temp = _mm256_sub_epi32(a, b);
-  	    return _mm256_and_si256(temp, _mm256_cmpgt_epi32(a, temp));
+        return _mm256_sub_epi32(_mm256_max_epu32(a, b), b);
     }
 
     // bitwise
@@ -971,20 +970,20 @@ namespace detail {
 
     static inline s32x8 adds(s32x8 a, s32x8 b)
     {
+        // overflow: the operands have the same sign and the result has a different sign
         const __m256i v = _mm256_add_epi32(a, b);
-        a = _mm256_srai_epi32(a, 31);
-        __m256i temp = _mm256_xor_si256(b, v);
-        temp = _mm256_xor_si256(temp, _mm256_cmpeq_epi32(temp, temp));
-        temp = _mm256_or_si256(temp, _mm256_xor_si256(a, b));
-        return detail::simd256_select_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), temp), v, a);
+        const __m256i overflow = _mm256_srai_epi32(_mm256_and_si256(_mm256_xor_si256(a, v), _mm256_xor_si256(b, v)), 31);
+        const __m256i saturated = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(0x7fffffff));
+        return detail::simd256_select_si256(overflow, saturated, v);
     }
 
     static inline s32x8 subs(s32x8 a, s32x8 b)
     {
+        // overflow: the operands have different signs and the result has the sign of b
         const __m256i v = _mm256_sub_epi32(a, b);
-        a = _mm256_srai_epi32(a, 31);
-        __m256i temp = _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, v));
-        return detail::simd256_select_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), temp), a, v);
+        const __m256i overflow = _mm256_srai_epi32(_mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, v)), 31);
+        const __m256i saturated = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(0x7fffffff));
+        return detail::simd256_select_si256(overflow, saturated, v);
     }
 
     // bitwise
@@ -1264,7 +1263,9 @@ namespace detail {
 
     static inline u32 get_mask(mask16x16 a)
     {
-        __m256i temp = _mm256_packus_epi16(a, _mm256_setzero_si256());
+        // the pack works within the 128 bit lanes; gather the packed halves into the low lane
+        __m256i temp = _mm256_packs_epi16(a, _mm256_setzero_si256());
+        temp = _mm256_permute4x64_epi64(temp, _MM_SHUFFLE(3, 1, 2, 0));
         return _mm256_movemask_epi8(temp);
     }
 
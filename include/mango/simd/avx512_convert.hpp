@@ -245,12 +245,15 @@ namespace detail {
 
     static inline u8x16 narrow(u16x8 a, u16x8 b)
     {
-        return _mm_packus_epi16(a, b);
+        // packus saturates signed inputs; clamp the unsigned inputs first
+        const __m128i mask = _mm_set1_epi16(0xff);
+        return _mm_packus_epi16(_mm_min_epu16(a, mask), _mm_min_epu16(b, mask));
     }
 
     static inline u16x8 narrow(u32x4 a, u32x4 b)
     {
-        return detail::simd128_packus_epi32(a, b);
+        const __m128i mask = _mm_set1_epi32(0xffff);
+        return _mm_packus_epi32(_mm_min_epu32(a, mask), _mm_min_epu32(b, mask));
     }
 
     static inline s8x16 narrow(s16x8 a, s16x8 b)
@@ -526,7 +529,8 @@ namespace detail {
         return _mm256_cvtpd_epu32(d);
     }
 
-    static inline s32x4 s32x4_truncate(f64x4 s)
+    template <>
+    inline s32x4 truncate<s32x4>(f64x4 s)
     {
         return _mm256_cvttpd_epi32(s);
     }
@@ -38,7 +38,7 @@ namespace simd {
     inline f64x4 shuffle<2, 3, 0, 1>(f64x4 v)
     {
         // .zwxy
-        return _mm256_shuffle_pd(v, v, 0x0a);
+        return _mm256_permute2f128_pd(v, v, 0x01);
     }
 
     // set component
@@ -198,13 +198,13 @@ namespace simd {
     static inline f64x4 hmin(f64x4 a)
     {
         const __m256d temp = _mm256_min_pd(a, _mm256_shuffle_pd(a, a, 0x05));
-        return _mm256_min_pd(temp, _mm256_shuffle_pd(temp, temp, 0x0a));
+        return _mm256_min_pd(temp, _mm256_permute2f128_pd(temp, temp, 0x01));
     }
 
     static inline f64x4 hmax(f64x4 a)
     {
         const __m256d temp = _mm256_max_pd(a, _mm256_shuffle_pd(a, a, 0x05));
-        return _mm256_max_pd(temp, _mm256_shuffle_pd(temp, temp, 0x0a));
+        return _mm256_max_pd(temp, _mm256_permute2f128_pd(temp, temp, 0x01));
     }
 
     static inline f64x4 abs(f64x4 a)
@@ -174,12 +174,21 @@ namespace simd {
 
     static inline f64x8 rcp(f64x8 a)
     {
+#if defined(__AVX512ER__)
         return _mm512_rcp28_pd(a);
+#else
+        // AVX-512ER is only available on Xeon Phi
+        return _mm512_div_pd(_mm512_set1_pd(1.0), a);
+#endif
     }
 
     static inline f64x8 rsqrt(f64x8 a)
     {
+#if defined(__AVX512ER__)
         return _mm512_rsqrt28_pd(a);
+#else
+        return _mm512_div_pd(_mm512_set1_pd(1.0), _mm512_sqrt_pd(a));
+#endif
     }
 
     static inline f64x8 sqrt(f64x8 a)
@@ -228,22 +237,22 @@ namespace simd {
 
     static inline f64x8 round(f64x8 s)
     {
-        return _mm512_add_round_pd(s, _mm512_setzero_pd(), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        return _mm512_roundscale_pd(s, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
     }
 
     static inline f64x8 trunc(f64x8 s)
     {
-        return _mm512_add_round_pd(s, _mm512_setzero_pd(), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        return _mm512_roundscale_pd(s, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
     }
 
     static inline f64x8 floor(f64x8 s)
     {
-        return _mm512_add_round_pd(s, _mm512_setzero_pd(), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        return _mm512_roundscale_pd(s, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
     }
 
     static inline f64x8 ceil(f64x8 s)
     {
-        return _mm512_add_round_pd(s, _mm512_setzero_pd(), _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+        return _mm512_roundscale_pd(s, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
     }
 
     static inline f64x8 fract(f64x8 s)
@@ -173,12 +173,27 @@ namespace simd {
 
     static inline f32x16 rcp(f32x16 a)
     {
+#if defined(__AVX512ER__)
         return _mm512_rcp28_ps(a);
+#else
+        // AVX-512ER is only available on Xeon Phi; refine the 14 bit estimate instead
+        const __m512 n = _mm512_rcp14_ps(a);
+        const __m512 m = _mm512_mul_ps(_mm512_mul_ps(n, n), a);
+        return _mm512_sub_ps(_mm512_add_ps(n, n), m);
+#endif
     }
 
     static inline f32x16 rsqrt(f32x16 a)
     {
+#if defined(__AVX512ER__)
         return _mm512_rsqrt28_ps(a);
+#else
+        __m512 n = _mm512_rsqrt14_ps(a);
+        __m512 e = _mm512_mul_ps(_mm512_mul_ps(n, n), a);
+        n = _mm512_mul_ps(_mm512_set1_ps(0.5f), n);
+        e = _mm512_sub_ps(_mm512_set1_ps(3.0f), e);
+        return _mm512_mul_ps(n, e);
+#endif
     }
 
     static inline f32x16 sqrt(f32x16 a)
@@ -227,22 +242,22 @@ namespace simd {
 
     static inline f32x16 round(f32x16 s)
     {
-        return _mm512_add_round_ps(s, _mm512_setzero_ps(), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        return _mm512_roundscale_ps(s, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
     }
 
     static inline f32x16 trunc(f32x16 s)
     {
-        return _mm512_add_round_ps(s, _mm512_setzero_ps(), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        return _mm512_roundscale_ps(s, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
     }
 
     static inline f32x16 floor(f32x16 s)
     {
-        return _mm512_add_round_ps(s, _mm512_setzero_ps(), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        return _mm512_roundscale_ps(s, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
     }
 
     static inline f32x16 ceil(f32x16 s)
     {
-        return _mm512_add_round_ps(s, _mm512_setzero_ps(), _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+        return _mm512_roundscale_ps(s, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
     }
 
     static inline f32x16 fract(f32x16 s)
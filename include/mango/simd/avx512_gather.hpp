@@ -114,7 +114,7 @@ namespace simd {
 
     static inline f64x2 gather2(const f64* address, s32x4 offset, f64x2 value, mask64x2 mask)
     {
-        return _mm_mmask_i32gather_pd(value, mask, offset, reinterpret_cast<const void*>(address), 4);
+        return _mm_mmask_i32gather_pd(value, mask, offset, reinterpret_cast<const void*>(address), 8);
     }
 
     static inline u32x4 gather4(const u32* address, s32x4 offset, u32x4 value, mask32x4 mask)
@@ -129,12 +129,12 @@ namespace simd {
 
     static inline u64x2 gather2(const u64* address, s32x4 offset, u64x2 value, mask64x2 mask)
     {
-        return _mm_mmask_i32gather_epi64(value, mask, offset, reinterpret_cast<const void*>(address), 4);
+        return _mm_mmask_i32gather_epi64(value, mask, offset, reinterpret_cast<const void*>(address), 8);
     }
 
     static inline s64x2 gather2(const s64* address, s32x4 offset, s64x2 value, mask64x2 mask)
     {
-        return _mm_mmask_i32gather_epi64(value, mask, offset, reinterpret_cast<const void*>(address), 4);
+        return _mm_mmask_i32gather_epi64(value, mask, offset, reinterpret_cast<const void*>(address), 8);
     }
 
     // 256 bit masked gather
@@ -146,7 +146,7 @@ namespace simd {
 
     static inline f64x4 gather4(const f64* address, s32x4 offset, f64x4 value, mask64x4 mask)
     {
-        return _mm256_mmask_i32gather_pd(value, mask, offset, reinterpret_cast<const void*>(address), 4);
+        return _mm256_mmask_i32gather_pd(value, mask, offset, reinterpret_cast<const void*>(address), 8);
     }
 
     static inline u32x8 gather8(const u32* address, s32x8 offset, u32x8 value, mask32x8 mask)
@@ -161,12 +161,12 @@ namespace simd {
 
     static inline u64x4 gather4(const u64* address, s32x4 offset, u64x4 value, mask64x4 mask)
     {
-        return _mm256_mmask_i32gather_epi64(value, mask, offset, reinterpret_cast<const void*>(address), 4);
+        return _mm256_mmask_i32gather_epi64(value, mask, offset, reinterpret_cast<const void*>(address), 8);
     }
 
     static inline s64x4 gather4(const s64* address, s32x4 offset, s64x4 value, mask64x4 mask)
     {
-        return _mm256_mmask_i32gather_epi64(value, mask, offset, reinterpret_cast<const void*>(address), 4);
+        return _mm256_mmask_i32gather_epi64(value, mask, offset, reinterpret_cast<const void*>(address), 8);
     }
 
     // 512 bit masked gather
@@ -212,7 +212,7 @@ namespace detail {
 
     static inline u8x16 select(mask8x16 mask, u8x16 a, u8x16 b)
     {
-        return _mm_mask_blend_epi8(mask, b, a);
+        return _mm_mask_blend_epi8(mask, __m128i(b), __m128i(a));
     }
 
     static inline u8x16 min(u8x16 a, u8x16 b)
@@ -366,7 +366,7 @@ namespace detail {
 
     static inline u16x8 select(mask16x8 mask, u16x8 a, u16x8 b)
     {
-        return _mm_mask_blend_epi16(mask, b, a);
+        return _mm_mask_blend_epi16(mask, __m128i(b), __m128i(a));
     }
 
     // shift by constant
@@ -516,14 +516,13 @@ namespace detail {
 
     static inline u32x4 adds(u32x4 a, u32x4 b)
     {
-  	    const __m128i temp = _mm_add_epi32(a, b);
-  	    return _mm_or_si128(temp, _mm_cmplt_epi32(temp, a));
+        // a + min(b, ~a) cannot wrap around
+        return _mm_add_epi32(a, _mm_min_epu32(b, _mm_xor_si128(a, _mm_set1_epi32(-1))));
     }
 
     static inline u32x4 subs(u32x4 a, u32x4 b)
     {
-  	    const __m128i temp = _mm_sub_epi32(a, b);
-  	    return _mm_and_si128(temp, _mm_cmpgt_epi32(a, temp));
+        return _mm_sub_epi32(_mm_max_epu32(a, b), b);
     }
 
     // bitwise
@@ -587,7 +586,7 @@ namespace detail {
 
     static inline u32x4 select(mask32x4 mask, u32x4 a, u32x4 b)
     {
-        return _mm_mask_blend_epi32(mask, b, a);
+        return _mm_mask_blend_epi32(mask, __m128i(b), __m128i(a));
     }
 
     // shift by constant
@@ -911,7 +910,7 @@ namespace detail {
 
     static inline s8x16 select(mask8x16 mask, s8x16 a, s8x16 b)
     {
-        return _mm_mask_blend_epi8(mask, b, a);
+        return _mm_mask_blend_epi8(mask, __m128i(b), __m128i(a));
     }
 
     static inline s8x16 min(s8x16 a, s8x16 b)
@@ -1075,7 +1074,7 @@ namespace detail {
 
     static inline s16x8 select(mask16x8 mask, s16x8 a, s16x8 b)
     {
-        return _mm_mask_blend_epi16(mask, b, a);
+        return _mm_mask_blend_epi16(mask, __m128i(b), __m128i(a));
     }
 
     // shift by constant
@@ -1235,20 +1234,20 @@ namespace detail {
 
     static inline s32x4 adds(s32x4 a, s32x4 b)
     {
+        // overflow: the operands have the same sign and the result has a different sign
         const __m128i v = _mm_add_epi32(a, b);
-        a = _mm_srai_epi32(a, 31);
-        __m128i temp = _mm_xor_si128(b, v);
-        temp = _mm_xor_si128(temp, _mm_cmpeq_epi32(temp, temp));
-        temp = _mm_or_si128(temp, _mm_xor_si128(a, b));
-        return detail::simd128_select_si128(_mm_cmpgt_epi32(_mm_setzero_si128(), temp), v, a);
+        const __m128i overflow = _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, v), _mm_xor_si128(b, v)), 31);
+        const __m128i saturated = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(0x7fffffff));
+        return detail::simd128_select_si128(overflow, saturated, v);
     }
 
     static inline s32x4 subs(s32x4 a, s32x4 b)
     {
+        // overflow: the operands have different signs and the result has the sign of b
         const __m128i v = _mm_sub_epi32(a, b);
-        a = _mm_srai_epi32(a, 31);
-        __m128i temp = _mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, v));
-        return detail::simd128_select_si128(_mm_cmpgt_epi32(_mm_setzero_si128(), temp), a, v);
+        const __m128i overflow = _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, v)), 31);
+        const __m128i saturated = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(0x7fffffff));
+        return detail::simd128_select_si128(overflow, saturated, v);
     }
 
     // bitwise
@@ -1312,7 +1311,7 @@ namespace detail {
 
     static inline s32x4 select(mask32x4 mask, s32x4 a, s32x4 b)
     {
-        return _mm_mask_blend_epi32(mask, b, a);
+        return _mm_mask_blend_epi32(mask, __m128i(b), __m128i(a));
     }
 
     // shift by constant
@@ -128,7 +128,7 @@ namespace detail {
 
     static inline u8x32 select(mask8x32 mask, u8x32 a, u8x32 b)
     {
-        return _mm256_mask_blend_epi8(mask, b, a);
+        return _mm256_mask_blend_epi8(mask, __m256i(b), __m256i(a));
     }
 
     static inline u8x32 min(u8x32 a, u8x32 b)
@@ -247,7 +247,7 @@ namespace detail {
 
     static inline u16x16 select(mask16x16 mask, u16x16 a, u16x16 b)
     {
-        return _mm256_mask_blend_epi16(mask, b, a);
+        return _mm256_mask_blend_epi16(mask, __m256i(b), __m256i(a));
     }
 
     // shift by constant
@@ -369,14 +369,13 @@ namespace detail {
 
     static inline u32x8 adds(u32x8 a, u32x8 b)
     {
-  	    const __m256i temp = _mm256_add_epi32(a, b);
-  	    return _mm256_or_si256(temp, _mm256_cmpgt_epi32(a, temp));
+        // a + min(b, ~a) cannot wrap around
+        return _mm256_add_epi32(a, _mm256_min_epu32(b, _mm256_xor_si256(a, _mm256_set1_epi32(-1))));
     }
 
     static inline u32x8 subs(u32x8 a, u32x8 b)
     {
-  	    const __m256i temp = _mm256_sub_epi32(a, b);
-  	    return _mm256_and_si256(temp, _mm256_cmpgt_epi32(a, temp));
+        return _mm256_sub_epi32(_mm256_max_epu32(a, b), b);
     }
 
     // bitwise
@@ -420,7 +419,7 @@ namespace detail {
 
     static inline u32x8 select(mask32x8 mask, u32x8 a, u32x8 b)
     {
-        return _mm256_mask_blend_epi32(mask, b, a);
+        return _mm256_mask_blend_epi32(mask, __m256i(b), __m256i(a));
     }
 
     // shift by constant
@@ -707,7 +706,7 @@ namespace detail {
 
     static inline s8x32 select(mask8x32 mask, s8x32 a, s8x32 b)
     {
-        return _mm256_mask_blend_epi8(mask, b, a);
+        return _mm256_mask_blend_epi8(mask, __m256i(b), __m256i(a));
     }
 
     static inline s8x32 min(s8x32 a, s8x32 b)
@@ -836,7 +835,7 @@ namespace detail {
 
     static inline s16x16 select(mask16x16 mask, s16x16 a, s16x16 b)
     {
-        return _mm256_mask_blend_epi16(mask, b, a);
+        return _mm256_mask_blend_epi16(mask, __m256i(b), __m256i(a));
     }
 
     // shift by scalar
@@ -968,20 +967,20 @@ namespace detail {
 
     static inline s32x8 adds(s32x8 a, s32x8 b)
     {
+        // overflow: the operands have the same sign and the result has a different sign
         const __m256i v = _mm256_add_epi32(a, b);
-        a = _mm256_srai_epi32(a, 31);
-        __m256i temp = _mm256_xor_si256(b, v);
-        temp = _mm256_xor_si256(temp, _mm256_cmpeq_epi32(temp, temp));
-        temp = _mm256_or_si256(temp, _mm256_xor_si256(a, b));
-        return detail::simd256_select_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), temp), v, a);
+        const __m256i overflow = _mm256_srai_epi32(_mm256_and_si256(_mm256_xor_si256(a, v), _mm256_xor_si256(b, v)), 31);
+        const __m256i saturated = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(0x7fffffff));
+        return detail::simd256_select_si256(overflow, saturated, v);
     }
 
     static inline s32x8 subs(s32x8 a, s32x8 b)
     {
+        // overflow: the operands have different signs and the result has the sign of b
         const __m256i v = _mm256_sub_epi32(a, b);
-        a = _mm256_srai_epi32(a, 31);
-        __m256i temp = _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, v));
-        return detail::simd256_select_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), temp), a, v);
+        const __m256i overflow = _mm256_srai_epi32(_mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, v)), 31);
+        const __m256i saturated = _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(0x7fffffff));
+        return detail::simd256_select_si256(overflow, saturated, v);
     }
 
     // bitwise
@@ -1025,7 +1024,7 @@ namespace detail {
 
     static inline s32x8 select(mask32x8 mask, s32x8 a, s32x8 b)
     {
-        return _mm256_mask_blend_epi32(mask, b, a);
+        return _mm256_mask_blend_epi32(mask, __m256i(b), __m256i(a));
     }
 
     // shift by constant
@@ -1209,17 +1208,17 @@ namespace detail {
 
     static inline mask8x32 operator & (mask8x32 a, mask8x32 b)
     {
-        return _mm512_kand(a, b);
+        return _kand_mask32(a, b);
     }
 
     static inline mask8x32 operator | (mask8x32 a, mask8x32 b)
     {
-        return _mm512_kor(a, b);
+        return _kor_mask32(a, b);
     }
 
     static inline mask8x32 operator ^ (mask8x32 a, mask8x32 b)
     {
-        return _mm512_kxor(a, b);
+        return _kxor_mask32(a, b);
     }
 
 #endif
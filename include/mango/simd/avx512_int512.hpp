@@ -109,7 +109,7 @@ namespace detail {
 
     static inline u8x64 select(mask8x64 mask, u8x64 a, u8x64 b)
     {
-        return _mm512_mask_blend_epi8(mask, b, a);
+        return _mm512_mask_blend_epi8(mask, __m512i(b), __m512i(a));
     }
 
     static inline u8x64 min(u8x64 a, u8x64 b)
@@ -214,7 +214,7 @@ namespace detail {
 
     static inline u16x32 select(mask16x32 mask, u16x32 a, u16x32 b)
     {
-        return _mm512_mask_blend_epi16(mask, b, a);
+        return _mm512_mask_blend_epi16(mask, __m512i(b), __m512i(a));
     }
 
     // shift by constant
@@ -360,7 +360,7 @@ namespace detail {
 
     static inline u32x16 select(mask32x16 mask, u32x16 a, u32x16 b)
     {
-        return _mm512_mask_blend_epi32(mask, b, a);
+        return _mm512_mask_blend_epi32(mask, __m512i(b), __m512i(a));
     }
 
     // shift by constant
@@ -619,7 +619,7 @@ namespace detail {
 
     static inline s8x64 select(mask8x64 mask, s8x64 a, s8x64 b)
     {
-        return _mm512_mask_blend_epi8(mask, b, a);
+        return _mm512_mask_blend_epi8(mask, __m512i(b), __m512i(a));
     }
 
     static inline s8x64 min(s8x64 a, s8x64 b)
@@ -734,7 +734,7 @@ namespace detail {
 
     static inline s16x32 select(mask16x32 mask, s16x32 a, s16x32 b)
     {
-        return _mm512_mask_blend_epi16(mask, b, a);
+        return _mm512_mask_blend_epi16(mask, __m512i(b), __m512i(a));
     }
 
     // shift by constant
@@ -890,7 +890,7 @@ namespace detail {
 
     static inline s32x16 select(mask32x16 mask, s32x16 a, s32x16 b)
     {
-        return _mm512_mask_blend_epi32(mask, b, a);
+        return _mm512_mask_blend_epi32(mask, __m512i(b), __m512i(a));
     }
 
     // shift by constant
@@ -1060,17 +1060,17 @@ namespace detail {
 
     static inline mask8x64 operator & (mask8x64 a, mask8x64 b)
     {
-        return _mm512_kand(a, b);
+        return _kand_mask64(a, b);
     }
 
     static inline mask8x64 operator | (mask8x64 a, mask8x64 b)
     {
-        return _mm512_kor(a, b);
+        return _kor_mask64(a, b);
     }
 
     static inline mask8x64 operator ^ (mask8x64 a, mask8x64 b)
     {
-        return _mm512_kxor(a, b);
+        return _kxor_mask64(a, b);
     }
 
 #endif
@@ -1103,17 +1103,17 @@ namespace detail {
 
     static inline mask16x32 operator & (mask16x32 a, mask16x32 b)
     {
-        return _mm512_kand(a, b);
+        return _kand_mask32(a, b);
     }
 
     static inline mask16x32 operator | (mask16x32 a, mask16x32 b)
     {
-        return _mm512_kor(a, b);
+        return _kor_mask32(a, b);
     }
 
     static inline mask16x32 operator ^ (mask16x32 a, mask16x32 b)
     {
-        return _mm512_kxor(a, b);
+        return _kxor_mask32(a, b);
     }
 
 #endif
@@ -274,12 +274,15 @@ namespace detail {
 
     static inline u8x16 narrow(u16x8 a, u16x8 b)
     {
-        return _mm_packus_epi16(a, b);
+        // packus saturates signed inputs; clamp the unsigned inputs first
+        const __m128i mask = _mm_set1_epi16(0xff);
+        return _mm_packus_epi16(_mm_min_epu16(a, mask), _mm_min_epu16(b, mask));
     }
 
     static inline u16x8 narrow(u32x4 a, u32x4 b)
     {
-        return detail::simd128_packus_epi32(a, b);
+        const __m128i mask = _mm_set1_epi32(0xffff);
+        return _mm_packus_epi32(_mm_min_epu32(a, mask), _mm_min_epu32(b, mask));
     }
 
     static inline s8x16 narrow(s16x8 a, s16x8 b)
@@ -689,7 +692,13 @@ namespace detail {
     inline f64x4 convert<f64x4>(u32x4 ui)
     {
         const __m256d bias = _mm256_set1_pd((1ll << 52) * 1.5);
+#if defined(MANGO_ENABLE_AVX2)
         const __m256i xyzw = _mm256_cvtepu32_epi64(ui);
+#else
+        const __m128i xy = _mm_cvtepu32_epi64(ui);
+        const __m128i zw = _mm_cvtepu32_epi64(_mm_unpackhi_epi64(ui, ui));
+        const __m256i xyzw = _mm256_setr_m128i(xy, zw);
+#endif
         __m256d v = _mm256_castsi256_pd(xyzw);
         v = _mm256_or_pd(v, bias);
         v = _mm256_sub_pd(v, bias);
@@ -709,7 +718,8 @@ namespace detail {
         return _mm_castps_si128(xyzw);
     }
 
-    static inline s32x4 s32x4_truncate(f64x4 s)
+    template <>
+    inline s32x4 truncate<s32x4>(f64x4 s)
     {
         return _mm256_cvttpd_epi32(s);
     }
@@ -729,6 +739,8 @@ namespace detail {
     template <>
     inline s64x4 convert<s64x4>(f64x4 v)
     {
+        // the cast truncates; round to nearest like the other float to integer conversions
+        v = round(v);
         s64 x = s64(get_component<0>(v));
         s64 y = s64(get_component<1>(v));
         s64 z = s64(get_component<2>(v));
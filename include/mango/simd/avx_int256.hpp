@@ -1811,7 +1811,8 @@ namespace detail {
 
     static inline u32 get_mask(mask8x32 a)
     {
-        return _mm256_movemask_ps(_mm256_castsi256_ps(a));
+        u32 mask = get_mask(detail::get_low(a)) | (get_mask(detail::get_high(a)) << 16);
+        return mask;
     }
 
     static inline bool none_of(mask8x32 a)
@@ -264,24 +264,33 @@ namespace detail {
 
     static inline u8x16 narrow(u16x8 a, u16x8 b)
     {
+        // the shuffle truncates, saturate first
+        a = __msa_sat_u_h(a, 7);
+        b = __msa_sat_u_h(b, 7);
         const v16i8 control = (v16i8) { 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30 };
         return (v16u8) __msa_vshf_b(control, (v16i8) a, (v16i8) b);
     }
 
     static inline u16x8 narrow(u32x4 a, u32x4 b)
     {
+        a = __msa_sat_u_w(a, 15);
+        b = __msa_sat_u_w(b, 15);
         const v8i16 control = (v8i16) { 0, 2, 4, 6, 8, 10, 12, 14 };
         return (v8u16) __msa_vshf_h(control, (v8i16) a, (v8i16) b);
     }
 
     static inline s8x16 narrow(s16x8 a, s16x8 b)
     {
+        a = __msa_sat_s_h(a, 7);
+        b = __msa_sat_s_h(b, 7);
         const v16i8 control = (v16i8) { 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30 };
         return (v16i8) __msa_vshf_b(control, (v16i8) a, (v16i8) b);
     }
 
     static inline s16x8 narrow(s32x4 a, s32x4 b)
     {
+        a = __msa_sat_s_w(a, 15);
+        b = __msa_sat_s_w(b, 15);
         const v8i16 control = (v8i16) { 0, 2, 4, 6, 8, 10, 12, 14 };
         return (v8i16) __msa_vshf_h(control, (v8i16) a, (v8i16) b);
     }
@@ -571,10 +580,10 @@ namespace detail {
     template <>
     inline s32x4 convert<s32x4>(f64x4 s)
     {
-        s32 x = s32(get_component<0>(s));
-        s32 y = s32(get_component<1>(s));
-        s32 z = s32(get_component<2>(s));
-        s32 w = s32(get_component<3>(s));
+        s32 x = s32(std::nearbyint(get_component<0>(s)));
+        s32 y = s32(std::nearbyint(get_component<1>(s)));
+        s32 z = s32(std::nearbyint(get_component<2>(s)));
+        s32 w = s32(std::nearbyint(get_component<3>(s)));
         return s32x4_set4(x, y, z, w);
     }
 
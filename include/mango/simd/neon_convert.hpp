@@ -619,10 +619,10 @@ namespace detail {
     template <>
     inline s32x4 convert<s32x4>(f64x4 s)
     {
-        s32 x = s32(s.lo.data[0] + 0.5);
-        s32 y = s32(s.lo.data[1] + 0.5);
-        s32 z = s32(s.hi.data[0] + 0.5);
-        s32 w = s32(s.hi.data[1] + 0.5);
+        s32 x = s32(std::nearbyint(s.lo.data[0]));
+        s32 y = s32(std::nearbyint(s.lo.data[1]));
+        s32 z = s32(std::nearbyint(s.hi.data[0]));
+        s32 w = s32(std::nearbyint(s.hi.data[1]));
         return s32x4_set4(x, y, z, w);
     }
 
@@ -679,6 +679,8 @@ namespace detail {
     template <>
     inline s64x4 convert<s64x4>(f64x4 v)
     {
+        // the cast truncates; round to nearest like the other float to integer conversions
+        v = round(v);
         s64 x = s64(get_component<0>(v));
         s64 y = s64(get_component<1>(v));
         s64 z = s64(get_component<2>(v));
@@ -317,8 +317,8 @@ namespace simd {
     static inline f64x2 round(f64x2 s)
     {
         f64x2 v;
-        v.data[0] = std::round(s.data[0]);
-        v.data[1] = std::round(s.data[1]);
+        v.data[0] = std::nearbyint(s.data[0]);
+        v.data[1] = std::nearbyint(s.data[1]);
         return v;
     }
 
@@ -486,7 +486,7 @@ namespace simd {
 
     static inline f32x4 round(f32x4 s)
     {
-        return vrndaq_f32(s);
+        return vrndnq_f32(s);
     }
 
     static inline f32x4 trunc(f32x4 s)
@@ -315,22 +315,24 @@ namespace simd {
     template <>
     inline u32x4 convert<u32x4>(f32x4 s)
     {
+        // round to nearest even, same as the hardware conversions
         u32x4 v;
-        v[0] = u32(s[0] + 0.5f);
-        v[1] = u32(s[1] + 0.5f);
-        v[2] = u32(s[2] + 0.5f);
-        v[3] = u32(s[3] + 0.5f);
+        v[0] = u32(std::nearbyint(s[0]));
+        v[1] = u32(std::nearbyint(s[1]));
+        v[2] = u32(std::nearbyint(s[2]));
+        v[3] = u32(std::nearbyint(s[3]));
         return v;
     }
 
     template <>
     inline s32x4 convert<s32x4>(f32x4 s)
     {
+        // round to nearest even, same as the hardware conversions
         s32x4 v;
-        v[0] = s32(s[0] + 0.5f);
-        v[1] = s32(s[1] + 0.5f);
-        v[2] = s32(s[2] + 0.5f);
-        v[3] = s32(s[3] + 0.5f);
+        v[0] = s32(std::nearbyint(s[0]));
+        v[1] = s32(std::nearbyint(s[1]));
+        v[2] = s32(std::nearbyint(s[2]));
+        v[3] = s32(std::nearbyint(s[3]));
         return v;
     }
 
@@ -498,10 +500,10 @@ namespace simd {
     template <>
     inline s32x4 convert<s32x4>(f64x4 s)
     {
-        s32 x = s32(s.lo[0] + 0.5);
-        s32 y = s32(s.lo[1] + 0.5);
-        s32 z = s32(s.hi[0] + 0.5);
-        s32 w = s32(s.hi[1] + 0.5);
+        s32 x = s32(std::nearbyint(s.lo[0]));
+        s32 y = s32(std::nearbyint(s.lo[1]));
+        s32 z = s32(std::nearbyint(s.hi[0]));
+        s32 w = s32(std::nearbyint(s.hi[1]));
         return s32x4_set4(x, y, z, w);
     }
 
@@ -559,6 +561,8 @@ namespace simd {
     template <>
     inline s64x4 convert<s64x4>(f64x4 v)
     {
+        // the cast truncates; round to nearest like the other float to integer conversions
+        v = round(v);
         s64 x = s64(get_component<0>(v));
         s64 y = s64(get_component<1>(v));
         s64 z = s64(get_component<2>(v));
@@ -317,8 +317,8 @@ namespace simd {
     static inline f64x2 round(f64x2 s)
     {
         f64x2 v;
-        v[0] = std::round(s[0]);
-        v[1] = std::round(s[1]);
+        v[0] = std::nearbyint(s[0]);
+        v[1] = std::nearbyint(s[1]);
         return v;
     }
 
@@ -431,10 +431,10 @@ namespace simd {
     static inline f32x4 round(f32x4 s)
     {
         f32x4 v;
-        v[0] = std::round(s[0]);
-        v[1] = std::round(s[1]);
-        v[2] = std::round(s[2]);
-        v[3] = std::round(s[3]);
+        v[0] = std::nearbyint(s[0]);
+        v[1] = std::nearbyint(s[1]);
+        v[2] = std::nearbyint(s[2]);
+        v[3] = std::nearbyint(s[3]);
         return v;
     }
 
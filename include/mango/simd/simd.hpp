@@ -160,7 +160,12 @@ namespace simd {
 } // namespace simd
 } // namespace mango
 
-#if defined(MANGO_ENABLE_AVX512)
+#if defined(MANGO_DISABLE_SIMD)
+
+    // the SIMD emulation is used regardless of the compiler flags, for example
+    // to test it on a processor which has SIMD instructions
+
+#elif defined(MANGO_ENABLE_AVX512)
 
 namespace mango {
 namespace simd {
@@ -792,7 +797,9 @@ namespace simd {
 #include "msa_convert.hpp"
 #include "common_gather.hpp"
 
-#else
+#endif
+
+#if !defined(MANGO_ENABLE_SIMD)
 
 namespace mango {
 namespace simd {
@@ -235,16 +235,44 @@ namespace detail {
     // narrow
     // -----------------------------------------------------------------
 
+#if defined(MANGO_ENABLE_SSE4_1)
+
+    static inline u8x16 narrow(u16x8 a, u16x8 b)
+    {
+        // packus saturates signed inputs; clamp the unsigned inputs first
+        const __m128i mask = _mm_set1_epi16(0xff);
+        return _mm_packus_epi16(_mm_min_epu16(a, mask), _mm_min_epu16(b, mask));
+    }
+
+    static inline u16x8 narrow(u32x4 a, u32x4 b)
+    {
+        const __m128i mask = _mm_set1_epi32(0xffff);
+        return _mm_packus_epi32(_mm_min_epu32(a, mask), _mm_min_epu32(b, mask));
+    }
+
+#else
+
     static inline u8x16 narrow(u16x8 a, u16x8 b)
     {
+        // packus saturates signed inputs; clamp the unsigned inputs first: a - max(a - 255, 0)
+        const __m128i mask = _mm_set1_epi16(0xff);
+        a = _mm_sub_epi16(a, _mm_subs_epu16(a, mask));
+        b = _mm_sub_epi16(b, _mm_subs_epu16(b, mask));
         return _mm_packus_epi16(a, b);
     }
 
     static inline u16x8 narrow(u32x4 a, u32x4 b)
     {
+        // the emulated pack truncates; set the low 16 bits of the lanes which do not fit
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mask = _mm_set1_epi32(0xffff);
+        a = _mm_or_si128(a, _mm_andnot_si128(_mm_cmpeq_epi32(_mm_srli_epi32(a, 16), zero), mask));
+        b = _mm_or_si128(b, _mm_andnot_si128(_mm_cmpeq_epi32(_mm_srli_epi32(b, 16), zero), mask));
         return detail::simd128_packus_epi32(a, b);
     }
 
+#endif
+
     static inline s8x16 narrow(s16x8 a, s16x8 b)
     {
         return _mm_packs_epi16(a, b);
@@ -610,6 +638,8 @@ namespace detail {
     template <>
     inline s64x4 convert<s64x4>(f64x4 v)
     {
+        // the cast truncates; round to nearest like the other float to integer conversions
+        v = round(v);
         s64 x = s64(get_component<0>(v));
         s64 y = s64(get_component<1>(v));
         s64 z = s64(get_component<2>(v));
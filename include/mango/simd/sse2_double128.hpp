@@ -328,14 +328,29 @@ namespace simd {
 
 #else
 
+    // the 32 bit conversions cannot be used; they overflow at 2^31 while a double can
+    // have a fraction up to 2^52. Adding 2^52 shifts the fraction out of the mantissa.
+
     static inline f64x2 round(f64x2 s)
     {
-        return _mm_cvtepi32_pd(_mm_cvtpd_epi32(s));
+        const __m128d magic = _mm_set1_pd(4503599627370496.0); // 2^52
+        const __m128d sign = _mm_and_pd(s, _mm_set1_pd(-0.0));
+        const __m128d a = _mm_andnot_pd(_mm_set1_pd(-0.0), s);
+        const __m128d result = _mm_or_pd(_mm_sub_pd(_mm_add_pd(a, magic), magic), sign);
+        const __m128d mask = _mm_cmplt_pd(a, magic);
+        return _mm_or_pd(_mm_and_pd(mask, result), _mm_andnot_pd(mask, s));
     }
 
     static inline f64x2 trunc(f64x2 s)
     {
-        return _mm_cvtepi32_pd(_mm_cvttpd_epi32(s));
+        const __m128d magic = _mm_set1_pd(4503599627370496.0); // 2^52
+        const __m128d sign = _mm_and_pd(s, _mm_set1_pd(-0.0));
+        const __m128d a = _mm_andnot_pd(_mm_set1_pd(-0.0), s);
+        __m128d result = _mm_sub_pd(_mm_add_pd(a, magic), magic);
+        result = _mm_sub_pd(result, _mm_and_pd(_mm_cmpgt_pd(result, a), _mm_set1_pd(1.0)));
+        result = _mm_or_pd(result, sign);
+        const __m128d mask = _mm_cmplt_pd(a, magic);
+        return _mm_or_pd(_mm_and_pd(mask, result), _mm_andnot_pd(mask, s));
     }
 
     static inline f64x2 floor(f64x2 s)
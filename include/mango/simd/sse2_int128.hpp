@@ -742,14 +742,27 @@ namespace detail {
 
     static inline u32x4 adds(u32x4 a, u32x4 b)
     {
-  	    const __m128i temp = _mm_add_epi32(a, b);
-  	    return _mm_or_si128(temp, _mm_cmplt_epi32(temp, a));
+#if defined(MANGO_ENABLE_SSE4_1)
+        // a + min(b, ~a) cannot wrap around
+        return _mm_add_epi32(a, _mm_min_epu32(b, detail::simd128_not_si128(a)));
+#else
+        // the sum wrapped around if it is smaller than a (unsigned compare)
+        const __m128i sign = _mm_set1_epi32(0x80000000);
+        const __m128i temp = _mm_add_epi32(a, b);
+        return _mm_or_si128(temp, _mm_cmpgt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(temp, sign)));
+#endif
     }
 
     static inline u32x4 subs(u32x4 a, u32x4 b)
     {
-  	    const __m128i temp = _mm_sub_epi32(a, b);
-  	    return _mm_and_si128(temp, _mm_cmpgt_epi32(a, temp));
+#if defined(MANGO_ENABLE_SSE4_1)
+        return _mm_sub_epi32(_mm_max_epu32(a, b), b);
+#else
+        // the difference wrapped around if b is larger than a (unsigned compare)
+        const __m128i sign = _mm_set1_epi32(0x80000000);
+        const __m128i temp = _mm_sub_epi32(a, b);
+        return _mm_andnot_si128(_mm_cmpgt_epi32(_mm_xor_si128(b, sign), _mm_xor_si128(a, sign)), temp);
+#endif
     }
 
     // bitwise
@@ -1138,9 +1151,9 @@ namespace detail {
         static_assert(Index < 16, "Index out of range.");
         u32 temp = _mm_extract_epi16(a, Index / 2);
         if (Index & 1)
-            temp = (temp & 0x00ff) | u32(s) << 8;
+            temp = (temp & 0x00ff) | u32(u8(s)) << 8;
         else
-            temp = (temp & 0xff00) | u32(s);
+            temp = (temp & 0xff00) | u32(u8(s));
         return _mm_insert_epi16(a, temp, Index / 2);
     }
 
@@ -1217,8 +1230,8 @@ namespace detail {
 #if defined(MANGO_ENABLE_SSSE3)
         return _mm_abs_epi8(a);
 #else
-        const __m128i negative = _mm_cmplt_epi16(a, _mm_setzero_si128());
-        return _mm_sub_epi16(_mm_xor_si128(a, negative), negative);
+        const __m128i negative = _mm_cmplt_epi8(a, _mm_setzero_si128());
+        return _mm_sub_epi8(_mm_xor_si128(a, negative), negative);
 #endif
     }
 
@@ -1785,20 +1798,20 @@ namespace detail {
 
     static inline s32x4 adds(s32x4 a, s32x4 b)
     {
+        // overflow: the operands have the same sign and the result has a different sign
         const __m128i v = _mm_add_epi32(a, b);
-        a = _mm_srai_epi32(a, 31);
-        __m128i temp = _mm_xor_si128(b, v);
-        temp = _mm_xor_si128(temp, _mm_cmpeq_epi32(temp, temp));
-        temp = _mm_or_si128(temp, _mm_xor_si128(a, b));
-        return detail::simd128_select_si128(_mm_cmpgt_epi32(_mm_setzero_si128(), temp), v, a);
+        const __m128i overflow = _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, v), _mm_xor_si128(b, v)), 31);
+        const __m128i saturated = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(0x7fffffff));
+        return detail::simd128_select_si128(overflow, saturated, v);
     }
 
     static inline s32x4 subs(s32x4 a, s32x4 b)
     {
+        // overflow: the operands have different signs and the result has the sign of b
         const __m128i v = _mm_sub_epi32(a, b);
-        a = _mm_srai_epi32(a, 31);
-        __m128i temp = _mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, v));
-        return detail::simd128_select_si128(_mm_cmpgt_epi32(_mm_setzero_si128(), temp), a, v);
+        const __m128i overflow = _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, v)), 31);
+        const __m128i saturated = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(0x7fffffff));
+        return detail::simd128_select_si128(overflow, saturated, v);
     }
 
     // bitwise
@@ -2261,7 +2274,8 @@ namespace detail {
 
     static inline u32 get_mask(mask16x8 a)
     {
-        __m128i temp = _mm_packus_epi16(a, _mm_setzero_si128());
+        // signed saturation keeps the all-ones lanes (-1) intact
+        __m128i temp = _mm_packs_epi16(a, _mm_setzero_si128());
         return _mm_movemask_epi8(temp);
     }
 
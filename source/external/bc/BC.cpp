@@ -1167,7 +1167,7 @@ namespace
             for (int x = 0; x < 4; ++x)
             {
                 const int32x4 v = simd::unpack(image[x]);
-                temp[y * 4 + x] = convert<float32x4>(v);
+                temp[y * 4 + x] = convert<float32x4>(v) * (1.0f / 255.0f);
             }
         }
     }
@@ -73,10 +73,11 @@ static void PackAndFilter(
     const unsigned height = imageData->HeightPixels;
     const unsigned width = imageData->WidthPixels;
 
-    const uint8_t* input = imageData->Buffer.Data;
+    const unsigned stride = imageData->StrideBytes ? imageData->StrideBytes : width * kChannels;
 
     for (unsigned y = 0; y < height; ++y)
     {
+        const uint8_t* input = imageData->Buffer.Data + y * stride;
         uint8_t prev[kChannels] = { 0 };
 
         for (unsigned x = 0; x < width; ++x)
@@ -105,10 +106,11 @@ static void UnpackAndUnfilter(
     const unsigned height = imageData->HeightPixels;
     const unsigned width = imageData->WidthPixels;
 
-    uint8_t* output = imageData->Buffer.Data;
+    const unsigned stride = imageData->StrideBytes ? imageData->StrideBytes : width * kChannels;
 
     for (unsigned y = 0; y < height; ++y)
     {
+        uint8_t* output = imageData->Buffer.Data + y * stride;
         uint8_t prev[kChannels] = { 0 };
 
         for (unsigned x = 0; x < width; ++x)
@@ -142,7 +144,7 @@ void PackAndFilter<3>(
     const unsigned height = imageData->HeightPixels;
     const unsigned width = imageData->WidthPixels;
 
-    const uint8_t* input = imageData->Buffer.Data;
+    const unsigned stride = imageData->StrideBytes ? imageData->StrideBytes : width * kChannels;
 
     // Color plane split
     const unsigned planeBytes = width * height;
@@ -152,6 +154,7 @@ void PackAndFilter<3>(
 
     for (unsigned row = 0; row < height; ++row)
     {
+        const uint8_t* input = imageData->Buffer.Data + row * stride;
         uint8_t prev[kChannels] = { 0 };
 
         for (unsigned x = 0; x < width; ++x)
@@ -193,7 +196,7 @@ void UnpackAndUnfilter<3>(
     const unsigned height = imageData->HeightPixels;
     const unsigned width = imageData->WidthPixels;
 
-    uint8_t* output = imageData->Buffer.Data;
+    const unsigned stride = imageData->StrideBytes ? imageData->StrideBytes : width * kChannels;
 
     // Color plane split
     const unsigned planeBytes = width * height;
@@ -203,6 +206,7 @@ void UnpackAndUnfilter<3>(
 
     for (unsigned row = 0; row < height; ++row)
     {
+        uint8_t* output = imageData->Buffer.Data + row * stride;
         uint8_t prev[kChannels] = { 0 };
 
         for (unsigned x = 0; x < width; ++x)
@@ -249,7 +253,7 @@ void PackAndFilter<4>(
     const unsigned height = imageData->HeightPixels;
     const unsigned width = imageData->WidthPixels;
 
-    const uint8_t* input = imageData->Buffer.Data;
+    const unsigned stride = imageData->StrideBytes ? imageData->StrideBytes : width * kChannels;
 
     // Color plane split
     const unsigned planeBytes = width * height;
@@ -260,6 +264,7 @@ void PackAndFilter<4>(
 
     for (unsigned row = 0; row < height; ++row)
     {
+        const uint8_t* input = imageData->Buffer.Data + row * stride;
         uint8_t prev[kChannels] = { 0 };
 
         for (unsigned x = 0; x < width; ++x)
@@ -305,7 +310,7 @@ void UnpackAndUnfilter<4>(
     const unsigned height = imageData->HeightPixels;
     const unsigned width = imageData->WidthPixels;
 
-    uint8_t* output = imageData->Buffer.Data;
+    const unsigned stride = imageData->StrideBytes ? imageData->StrideBytes : width * kChannels;
 
     // Color plane split
     const unsigned planeBytes = width * height;
@@ -316,6 +321,7 @@ void UnpackAndUnfilter<4>(
 
     for (unsigned row = 0; row < height; ++row)
     {
+        uint8_t* output = imageData->Buffer.Data + row * stride;
         uint8_t prev[kChannels] = { 0 };
 
         for (unsigned x = 0; x < width; ++x)
@@ -354,17 +360,114 @@ void UnpackAndUnfilter<4>(
 
 #endif
 
+static void PackAndFilterSelect(
+    const ZPNG_ImageData* imageData,
+    uint8_t* packing,
+    unsigned pixelBytes
+)
+{
+    switch (pixelBytes)
+    {
+    case 1:
+        PackAndFilter<1>(imageData, packing);
+        break;
+    case 2:
+        PackAndFilter<2>(imageData, packing);
+        break;
+    case 3:
+        PackAndFilter<3>(imageData, packing);
+        break;
+    case 4:
+        PackAndFilter<4>(imageData, packing);
+        break;
+    case 5:
+        PackAndFilter<5>(imageData, packing);
+        break;
+    case 6:
+        PackAndFilter<6>(imageData, packing);
+        break;
+    case 7:
+        PackAndFilter<7>(imageData, packing);
+        break;
+    case 8:
+        PackAndFilter<8>(imageData, packing);
+        break;
+    }
+}
+
+static void UnpackAndUnfilterSelect(
+    const uint8_t* packing,
+    ZPNG_ImageData* imageData,
+    unsigned pixelBytes
+)
+{
+    switch (pixelBytes)
+    {
+    case 1:
+        UnpackAndUnfilter<1>(packing, imageData);
+        break;
+    case 2:
+        UnpackAndUnfilter<2>(packing, imageData);
+        break;
+    case 3:
+        UnpackAndUnfilter<3>(packing, imageData);
+        break;
+    case 4:
+        UnpackAndUnfilter<4>(packing, imageData);
+        break;
+    case 5:
+        UnpackAndUnfilter<5>(packing, imageData);
+        break;
+    case 6:
+        UnpackAndUnfilter<6>(packing, imageData);
+        break;
+    case 7:
+        UnpackAndUnfilter<7>(packing, imageData);
+        break;
+    case 8:
+        UnpackAndUnfilter<8>(packing, imageData);
+        break;
+    }
+}
+
+// Decompress the filtered planes into packing buffer; returns 0 on failure
+static int DecompressPacking(
+    ZSTD_DCtx* context,
+    ZPNG_Buffer buffer,
+    uint8_t* packing,
+    unsigned byteCount
+)
+{
+    const void* src = buffer.Data + ZPNG_HEADER_OVERHEAD_BYTES;
+    const size_t srcBytes = buffer.Bytes - ZPNG_HEADER_OVERHEAD_BYTES;
+
+    const size_t result = context ?
+        ZSTD_decompressDCtx(context, packing, byteCount, src, srcBytes) :
+        ZSTD_decompress(packing, byteCount, src, srcBytes);
+
+    return !ZSTD_isError(result) && result == byteCount;
+}
+
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+
 //------------------------------------------------------------------------------
 // API
 
 ZPNG_Buffer ZPNG_Compress(
     const ZPNG_ImageData* imageData
 )
+{
+    return ZPNG_CompressContext(nullptr, imageData);
+}
+
+ZPNG_Buffer ZPNG_CompressContext(
+    ZSTD_CCtx* context,
+    const ZPNG_ImageData* imageData
+)
 {
     uint8_t* packing = nullptr;
     uint8_t* output = nullptr;
@@ -386,10 +489,6 @@ ZPNG_Buffer ZPNG_Compress(
     packing = (uint8_t*)calloc(1, byteCount);
 
     if (!packing) {
-        if (bufferOutput.Data != output) {
-            free(output);
-        }
-        free(packing);
         return bufferOutput;
     }
 
@@ -399,56 +498,33 @@ ZPNG_Buffer ZPNG_Compress(
     output = (uint8_t*)calloc(1, ZPNG_HEADER_OVERHEAD_BYTES + maxOutputBytes);
 
     if (!output) {
-        if (bufferOutput.Data != output) {
-            free(output);
-        }
         free(packing);
         return bufferOutput;
     }
 
     // Pass 1: Pack and filter data.
 
-    switch (pixelBytes)
-    {
-    case 1:
-        PackAndFilter<1>(imageData, packing);
-        break;
-    case 2:
-        PackAndFilter<2>(imageData, packing);
-        break;
-    case 3:
-        PackAndFilter<3>(imageData, packing);
-        break;
-    case 4:
-        PackAndFilter<4>(imageData, packing);
-        break;
-    case 5:
-        PackAndFilter<5>(imageData, packing);
-        break;
-    case 6:
-        PackAndFilter<6>(imageData, packing);
-        break;
-    case 7:
-        PackAndFilter<7>(imageData, packing);
-        break;
-    case 8:
-        PackAndFilter<8>(imageData, packing);
-        break;
-    }
+    PackAndFilterSelect(imageData, packing, pixelBytes);
 
     // Pass 2: Compress the packed/filtered data.
 
-    const size_t result = ZSTD_compress(
-        output + ZPNG_HEADER_OVERHEAD_BYTES,
-        maxOutputBytes,
-        packing,
-        byteCount,
-        kCompressionLevel);
+    const size_t result = context ?
+        ZSTD_compressCCtx(
+            context,
+            output + ZPNG_HEADER_OVERHEAD_BYTES,
+            maxOutputBytes,
+            packing,
+            byteCount,
+            kCompressionLevel) :
+        ZSTD_compress(
+            output + ZPNG_HEADER_OVERHEAD_BYTES,
+            maxOutputBytes,
+            packing,
+            byteCount,
+            kCompressionLevel);
 
     if (ZSTD_isError(result)) {
-        if (bufferOutput.Data != output) {
-            free(output);
-        }
+        free(output);
         free(packing);
         return bufferOutput;
     }
@@ -465,9 +541,6 @@ ZPNG_Buffer ZPNG_Compress(
     bufferOutput.Data = output;
     bufferOutput.Bytes = ZPNG_HEADER_OVERHEAD_BYTES + (unsigned)result;
 
-    if (bufferOutput.Data != output) {
-        free(output);
-    }
     free(packing);
     return bufferOutput;
 }
@@ -489,19 +562,11 @@ ZPNG_ImageData ZPNG_Decompress(
     imageData.WidthPixels = 0;
 
     if (!buffer.Data || buffer.Bytes < ZPNG_HEADER_OVERHEAD_BYTES) {
-        if (imageData.Buffer.Data != output) {
-            free(output);
-        }
-        free(packing);
         return imageData;
     }
 
     const ZPNG_Header* header = (const ZPNG_Header*)buffer.Data;
     if (header->Magic != ZPNG_HEADER_MAGIC) {
-        if (imageData.Buffer.Data != output) {
-            free(output);
-        }
-        free(packing);
         return imageData;
     }
 
@@ -509,35 +574,23 @@ ZPNG_ImageData ZPNG_Decompress(
     imageData.HeightPixels = header->Height;
     imageData.Channels = header->Channels;
     imageData.BytesPerChannel = header->BytesPerChannel;
-    imageData.StrideBytes = imageData.WidthPixels * imageData.Channels;
 
     const unsigned pixelCount = imageData.WidthPixels * imageData.HeightPixels;
     const unsigned pixelBytes = imageData.BytesPerChannel * imageData.Channels;
     const unsigned byteCount = pixelBytes * pixelCount;
 
+    imageData.StrideBytes = imageData.WidthPixels * pixelBytes;
+
     // Space for packing
     packing = (uint8_t*)calloc(1, byteCount);
 
     if (!packing) {
-        if (imageData.Buffer.Data != output) {
-            free(output);
-        }
-        free(packing);
         return imageData;
     }
 
     // Stage 1: Decompress back to packing buffer
 
-    const size_t result = ZSTD_decompress(
-        packing,
-        byteCount,
-        buffer.Data + ZPNG_HEADER_OVERHEAD_BYTES,
-        buffer.Bytes - ZPNG_HEADER_OVERHEAD_BYTES);
-
-    if (ZSTD_isError(result)) {
-        if (imageData.Buffer.Data != output) {
-            free(output);
-        }
+    if (!DecompressPacking(nullptr, buffer, packing, byteCount)) {
         free(packing);
         return imageData;
     }
@@ -548,9 +601,6 @@ ZPNG_ImageData ZPNG_Decompress(
     output = (uint8_t*)calloc(1, byteCount);
 
     if (!output) {
-        if (imageData.Buffer.Data != output) {
-            free(output);
-        }
         free(packing);
         return imageData;
     }
@@ -558,39 +608,57 @@ ZPNG_ImageData ZPNG_Decompress(
     imageData.Buffer.Data = output;
     imageData.Buffer.Bytes = byteCount;
 
-    switch (pixelBytes)
-    {
-    case 1:
-        UnpackAndUnfilter<1>(packing, &imageData);
-        break;
-    case 2:
-        UnpackAndUnfilter<2>(packing, &imageData);
-        break;
-    case 3:
-        UnpackAndUnfilter<3>(packing, &imageData);
-        break;
-    case 4:
-        UnpackAndUnfilter<4>(packing, &imageData);
-        break;
-    case 5:
-        UnpackAndUnfilter<5>(packing, &imageData);
-        break;
-    case 6:
-        UnpackAndUnfilter<6>(packing, &imageData);
-        break;
-    case 7:
-        UnpackAndUnfilter<7>(packing, &imageData);
-        break;
-    case 8:
-        UnpackAndUnfilter<8>(packing, &imageData);
-        break;
+    UnpackAndUnfilterSelect(packing, &imageData, pixelBytes);
+
+    free(packing);
+    return imageData;
+}
+
+int ZPNG_DecompressInto(
+    ZSTD_DCtx* context,
+    ZPNG_Buffer buffer,
+    const ZPNG_ImageData* imageData
+)
+{
+    if (!buffer.Data || buffer.Bytes < ZPNG_HEADER_OVERHEAD_BYTES || !imageData->Buffer.Data) {
+        return 0;
     }
 
-    if (imageData.Buffer.Data != output) {
-        free(output);
+    const ZPNG_Header* header = (const ZPNG_Header*)buffer.Data;
+    if (header->Magic != ZPNG_HEADER_MAGIC ||
+        header->Width != imageData->WidthPixels ||
+        header->Height != imageData->HeightPixels ||
+        header->Channels != imageData->Channels ||
+        header->BytesPerChannel != imageData->BytesPerChannel) {
+        return 0;
+    }
+
+    const unsigned pixelCount = imageData->WidthPixels * imageData->HeightPixels;
+    const unsigned pixelBytes = imageData->BytesPerChannel * imageData->Channels;
+    const unsigned byteCount = pixelBytes * pixelCount;
+
+    if (pixelBytes > 8) {
+        return 0;
     }
+
+    // Space for packing
+    uint8_t* packing = (uint8_t*)malloc(byteCount);
+
+    if (!packing) {
+        return 0;
+    }
+
+    if (!DecompressPacking(context, buffer, packing, byteCount)) {
+        free(packing);
+        return 0;
+    }
+
+    // Unfilter straight into the caller's pixels
+    ZPNG_ImageData temp = *imageData;
+    UnpackAndUnfilterSelect(packing, &temp, pixelBytes);
+
     free(packing);
-    return imageData;
+    return 1;
 }
 
 void ZPNG_Free(
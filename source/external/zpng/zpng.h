@@ -52,6 +52,7 @@
 */
 
 #include <stdint.h>
+#include "../zstd/zstd.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -107,6 +108,17 @@ ZPNG_Buffer ZPNG_Compress(
     const ZPNG_ImageData* imageData
 );
 
+/**
+    ZPNG_CompressContext()
+
+    Same as ZPNG_Compress() but uses caller-owned zstd context so that it can be
+    reused when compressing many images. The context may be null.
+*/
+ZPNG_Buffer ZPNG_CompressContext(
+    ZSTD_CCtx* context,
+    const ZPNG_ImageData* imageData
+);
+
 /*
     ZPNG_Decompress()
 
@@ -121,6 +133,22 @@ ZPNG_ImageData ZPNG_Decompress(
     ZPNG_Buffer buffer
 );
 
+/*
+    ZPNG_DecompressInto()
+
+    Decompress image into caller-provided pixels described by imageData
+    (Buffer.Data and StrideBytes). The dimensions, channels and bytes per channel
+    must match the compressed image. The zstd context is optional and may be null.
+
+    On success returns non-zero.
+    On failure returns zero.
+*/
+int ZPNG_DecompressInto(
+    ZSTD_DCtx* context,
+    ZPNG_Buffer buffer,
+    const ZPNG_ImageData* imageData
+);
+
 /*
     ZPNG_Free()
 
@@ -2,17 +2,212 @@
     MANGO Multimedia Development Platform
     Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
+#include <algorithm>
+#include <vector>
 #include <mango/core/aes.hpp>
+#include <mango/core/bits.hpp>
+#include <mango/core/endian.hpp>
 #include <mango/core/cpuinfo.hpp>
 #include <mango/core/exception.hpp>
+#include <mango/core/thread.hpp>
 #include "../../external/aes/bc_aes.h"
 
 namespace
 {
     using namespace mango;
 
+    // buffers at least this large are processed in the ThreadPool
+    constexpr size_t aes_parallel_threshold = 1024 * 1024;
+    constexpr size_t aes_parallel_blocks = 16 * 1024;
+
+// ----------------------------------------------------------------------------------------
+// Counter block
+// ----------------------------------------------------------------------------------------
+
+// CTR mode increments the whole 128 bit counter block as big endian integer.
+// GCM increments only the 32 least significant bits, which wrap around.
+
+struct CounterBlock
+{
+    u64 hi;
+    u64 lo;
+    bool wrap32;
+
+    CounterBlock(const u8* iv, bool wrap32)
+        : hi(uload64be(iv + 0))
+        , lo(uload64be(iv + 8))
+        , wrap32(wrap32)
+    {
+    }
+
+    void increment(u64 count)
+    {
+        if (wrap32)
+        {
+            lo = (lo & 0xffffffff00000000ull) | u32(lo + count);
+        }
+        else
+        {
+            const u64 x = lo + count;
+            hi += x < lo;
+            lo = x;
+        }
+    }
+
+    // the counter block as two 64 bit words in little endian memory order
+    void next(u64& w0, u64& w1)
+    {
+        w0 = byteswap(hi);
+        w1 = byteswap(lo);
+        increment(1);
+    }
+
+    void next(u8* block)
+    {
+        ustore64be(block + 0, hi);
+        ustore64be(block + 8, lo);
+        increment(1);
+    }
+};
+
+// ----------------------------------------------------------------------------------------
+// GF(2^128)
+// ----------------------------------------------------------------------------------------
+
+// multiply in the GCM bit order; used for the GHASH key powers
+void gf128_multiply(u8* result, const u8* x, const u8* y)
+{
+    u64 zh = 0;
+    u64 zl = 0;
+    u64 vh = uload64be(y + 0);
+    u64 vl = uload64be(y + 8);
+
+    for (int i = 0; i < 128; ++i)
+    {
+        if ((x[i >> 3] >> (7 - (i & 7))) & 1)
+        {
+            zh ^= vh;
+            zl ^= vl;
+        }
+
+        const u64 mask = 0 - (vl & 1);
+        vl = (vl >> 1) | (vh << 63);
+        vh = (vh >> 1) ^ (mask & 0xe100000000000000ull);
+    }
+
+    ustore64be(result + 0, zh);
+    ustore64be(result + 8, zl);
+}
+
+void gf128_power(u8* result, const u8* h, u64 n)
+{
+    u8 base[16];
+    std::memcpy(base, h, 16);
+
+    u8 x[16] = { 0x80 };
+
+    for ( ; n; n >>= 1)
+    {
+        if (n & 1)
+        {
+            gf128_multiply(x, x, base);
+        }
+        gf128_multiply(base, base, base);
+    }
+
+    std::memcpy(result, x, 16);
+}
+
+// GHASH with 4 bit tables (Shoup's method)
+
+struct GHashTable
+{
+    u64 hh[16];
+    u64 hl[16];
+
+    void init(const u8* h)
+    {
+        u64 vh = uload64be(h + 0);
+        u64 vl = uload64be(h + 8);
+
+        hh[0] = 0;
+        hl[0] = 0;
+        hh[8] = vh;
+        hl[8] = vl;
+
+        for (int i = 4; i > 0; i >>= 1)
+        {
+            const u64 mask = 0 - (vl & 1);
+            vl = (vh << 63) | (vl >> 1);
+            vh = (vh >> 1) ^ (mask & 0xe100000000000000ull);
+            hh[i] = vh;
+            hl[i] = vl;
+        }
+
+        for (int i = 2; i <= 8; i *= 2)
+        {
+            vh = hh[i];
+            vl = hl[i];
+            for (int j = 1; j < i; ++j)
+            {
+                hh[i + j] = vh ^ hh[j];
+                hl[i + j] = vl ^ hl[j];
+            }
+        }
+    }
+
+    void multiply(u8* x) const
+    {
+        static const u64 last4[16] =
+        {
+            0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+            0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+        };
+
+        int n = x[15] & 0xf;
+        u64 zh = hh[n];
+        u64 zl = hl[n];
+
+        for (int i = 15; i >= 0; --i)
+        {
+            if (i != 15)
+            {
+                n = x[i] & 0xf;
+                const int rem = zl & 0xf;
+                zl = (zh << 60) | (zl >> 4);
+                zh = (zh >> 4) ^ (last4[rem] << 48) ^ hh[n];
+                zl ^= hl[n];
+            }
+
+            n = x[i] >> 4;
+            const int rem = zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (last4[rem] << 48) ^ hh[n];
+            zl ^= hl[n];
+        }
+
+        ustore64be(x + 0, zh);
+        ustore64be(x + 8, zl);
+    }
+
+    void update(u8* x, const u8* data, size_t blocks) const
+    {
+        for (size_t i = 0; i < blocks; ++i)
+        {
+            for (int j = 0; j < 16; ++j)
+            {
+                x[j] ^= data[j];
+            }
+            multiply(x);
+            data += 16;
+        }
+    }
+};
+
 #if defined(MANGO_ENABLE_AES)
 
+// ----------------------------------------------------------------------------------------
+
 // ----------------------------------------------------------------------------------------
 // Intel AES-NI
 // ----------------------------------------------------------------------------------------
@@ -223,60 +418,91 @@ inline __m128i aesni_ecb_encrypt_block<14>(__m128i data, const __m128i* schedule
 }
 
 template <int NR>
-inline __m128i aesni_ecb_decrypt_block(__m128i data, const __m128i* schedule);
-
-template <>
-inline __m128i aesni_ecb_decrypt_block<10>(__m128i data, const __m128i* schedule)
-{
-    data = _mm_xor_si128(data, schedule[10]);
-    data = _mm_aesdec_si128(data, schedule[11]);
-    data = _mm_aesdec_si128(data, schedule[12]);
-    data = _mm_aesdec_si128(data, schedule[13]);
-    data = _mm_aesdec_si128(data, schedule[14]);
-    data = _mm_aesdec_si128(data, schedule[15]);
-    data = _mm_aesdec_si128(data, schedule[16]);
-    data = _mm_aesdec_si128(data, schedule[17]);
-    data = _mm_aesdec_si128(data, schedule[18]);
-    data = _mm_aesdec_si128(data, schedule[19]);
+inline __m128i aesni_ecb_decrypt_block(__m128i data, const __m128i* schedule)
+{
+    // decryption schedule follows the encryption schedule
+    data = _mm_xor_si128(data, schedule[NR]);
+    for (int i = NR + 1; i < NR * 2; ++i)
+    {
+        data = _mm_aesdec_si128(data, schedule[i]);
+    }
     return _mm_aesdeclast_si128(data, schedule[0]);
 }
 
-template <>
-inline __m128i aesni_ecb_decrypt_block<12>(__m128i data, const __m128i* schedule)
-{
-    data = _mm_xor_si128(data, schedule[10]);
-    data = _mm_aesdec_si128(data, schedule[11]);
-    data = _mm_aesdec_si128(data, schedule[12]);
-    data = _mm_aesdec_si128(data, schedule[13]);
-    data = _mm_aesdec_si128(data, schedule[14]);
-    data = _mm_aesdec_si128(data, schedule[15]);
-    data = _mm_aesdec_si128(data, schedule[16]);
-    data = _mm_aesdec_si128(data, schedule[17]);
-    data = _mm_aesdec_si128(data, schedule[18]);
-    data = _mm_aesdec_si128(data, schedule[19]);
-    data = _mm_aesdec_si128(data, schedule[20]);
-    data = _mm_aesdec_si128(data, schedule[21]);
-    return _mm_aesdeclast_si128(data, schedule[0]);
+// 8 blocks in flight hide the latency of the AES instructions
+
+template <int NR>
+inline void aesni_encrypt8(__m128i* data, const __m128i* schedule)
+{
+    __m128i key = schedule[0];
+    data[0] = _mm_xor_si128(data[0], key);
+    data[1] = _mm_xor_si128(data[1], key);
+    data[2] = _mm_xor_si128(data[2], key);
+    data[3] = _mm_xor_si128(data[3], key);
+    data[4] = _mm_xor_si128(data[4], key);
+    data[5] = _mm_xor_si128(data[5], key);
+    data[6] = _mm_xor_si128(data[6], key);
+    data[7] = _mm_xor_si128(data[7], key);
+
+    for (int i = 1; i < NR; ++i)
+    {
+        key = schedule[i];
+        data[0] = _mm_aesenc_si128(data[0], key);
+        data[1] = _mm_aesenc_si128(data[1], key);
+        data[2] = _mm_aesenc_si128(data[2], key);
+        data[3] = _mm_aesenc_si128(data[3], key);
+        data[4] = _mm_aesenc_si128(data[4], key);
+        data[5] = _mm_aesenc_si128(data[5], key);
+        data[6] = _mm_aesenc_si128(data[6], key);
+        data[7] = _mm_aesenc_si128(data[7], key);
+    }
+
+    key = schedule[NR];
+    data[0] = _mm_aesenclast_si128(data[0], key);
+    data[1] = _mm_aesenclast_si128(data[1], key);
+    data[2] = _mm_aesenclast_si128(data[2], key);
+    data[3] = _mm_aesenclast_si128(data[3], key);
+    data[4] = _mm_aesenclast_si128(data[4], key);
+    data[5] = _mm_aesenclast_si128(data[5], key);
+    data[6] = _mm_aesenclast_si128(data[6], key);
+    data[7] = _mm_aesenclast_si128(data[7], key);
 }
 
-template <>
-inline __m128i aesni_ecb_decrypt_block<14>(__m128i data, const __m128i* schedule)
-{
-    data = _mm_xor_si128(data, schedule[10]);
-    data = _mm_aesdec_si128(data, schedule[11]);
-    data = _mm_aesdec_si128(data, schedule[12]);
-    data = _mm_aesdec_si128(data, schedule[13]);
-    data = _mm_aesdec_si128(data, schedule[14]);
-    data = _mm_aesdec_si128(data, schedule[15]);
-    data = _mm_aesdec_si128(data, schedule[16]);
-    data = _mm_aesdec_si128(data, schedule[17]);
-    data = _mm_aesdec_si128(data, schedule[18]);
-    data = _mm_aesdec_si128(data, schedule[19]);
-    data = _mm_aesdec_si128(data, schedule[20]);
-    data = _mm_aesdec_si128(data, schedule[21]);
-    data = _mm_aesdec_si128(data, schedule[22]);
-    data = _mm_aesdec_si128(data, schedule[23]);
-    return _mm_aesdeclast_si128(data, schedule[0]);
+template <int NR>
+inline void aesni_decrypt8(__m128i* data, const __m128i* schedule)
+{
+    __m128i key = schedule[NR];
+    data[0] = _mm_xor_si128(data[0], key);
+    data[1] = _mm_xor_si128(data[1], key);
+    data[2] = _mm_xor_si128(data[2], key);
+    data[3] = _mm_xor_si128(data[3], key);
+    data[4] = _mm_xor_si128(data[4], key);
+    data[5] = _mm_xor_si128(data[5], key);
+    data[6] = _mm_xor_si128(data[6], key);
+    data[7] = _mm_xor_si128(data[7], key);
+
+    for (int i = NR + 1; i < NR * 2; ++i)
+    {
+        key = schedule[i];
+        data[0] = _mm_aesdec_si128(data[0], key);
+        data[1] = _mm_aesdec_si128(data[1], key);
+        data[2] = _mm_aesdec_si128(data[2], key);
+        data[3] = _mm_aesdec_si128(data[3], key);
+        data[4] = _mm_aesdec_si128(data[4], key);
+        data[5] = _mm_aesdec_si128(data[5], key);
+        data[6] = _mm_aesdec_si128(data[6], key);
+        data[7] = _mm_aesdec_si128(data[7], key);
+    }
+
+    key = schedule[0];
+    data[0] = _mm_aesdeclast_si128(data[0], key);
+    data[1] = _mm_aesdeclast_si128(data[1], key);
+    data[2] = _mm_aesdeclast_si128(data[2], key);
+    data[3] = _mm_aesdeclast_si128(data[3], key);
+    data[4] = _mm_aesdeclast_si128(data[4], key);
+    data[5] = _mm_aesdeclast_si128(data[5], key);
+    data[6] = _mm_aesdeclast_si128(data[6], key);
+    data[7] = _mm_aesdeclast_si128(data[7], key);
 }
 
 // ECB buffer
@@ -284,22 +510,60 @@ inline __m128i aesni_ecb_decrypt_block<14>(__m128i data, const __m128i* schedule
 template <int NR>
 void aesni_ecb_encrypt(u8* output, const u8* input, size_t blocks, const __m128i* schedule)
 {
+    const __m128i* src = reinterpret_cast<const __m128i *>(input);
+    __m128i* dest = reinterpret_cast<__m128i *>(output);
+
+    for ( ; blocks >= 8; blocks -= 8)
+    {
+        __m128i data[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            data[i] = _mm_loadu_si128(src + i);
+        }
+        aesni_encrypt8<NR>(data, schedule);
+        for (int i = 0; i < 8; ++i)
+        {
+            _mm_storeu_si128(dest + i, data[i]);
+        }
+        src += 8;
+        dest += 8;
+    }
+
     for (size_t i = 0; i < blocks; ++i)
     {
-        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input) + i);
+        __m128i data = _mm_loadu_si128(src + i);
         data = aesni_ecb_encrypt_block<NR>(data, schedule);
-        _mm_storeu_si128(reinterpret_cast<__m128i *>(output) + i, data);
+        _mm_storeu_si128(dest + i, data);
     }
 }
 
 template <int NR>
 void aesni_ecb_decrypt(u8* output, const u8* input, size_t blocks, const __m128i* schedule)
 {
+    const __m128i* src = reinterpret_cast<const __m128i *>(input);
+    __m128i* dest = reinterpret_cast<__m128i *>(output);
+
+    for ( ; blocks >= 8; blocks -= 8)
+    {
+        __m128i data[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            data[i] = _mm_loadu_si128(src + i);
+        }
+        aesni_decrypt8<NR>(data, schedule);
+        for (int i = 0; i < 8; ++i)
+        {
+            _mm_storeu_si128(dest + i, data[i]);
+        }
+        src += 8;
+        dest += 8;
+    }
+
     for (size_t i = 0; i < blocks; ++i)
     {
-        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input) + i);
+        __m128i data = _mm_loadu_si128(src + i);
         data = aesni_ecb_decrypt_block<NR>(data, schedule);
-        _mm_storeu_si128(reinterpret_cast<__m128i *>(output) + i, data);
+        _mm_storeu_si128(dest + i, data);
     }
 }
 
@@ -308,6 +572,7 @@ void aesni_ecb_decrypt(u8* output, const u8* input, size_t blocks, const __m128i
 template <int NR>
 void aesni_cbc_encrypt(u8* output, const u8* input, size_t blocks, __m128i iv, const __m128i* schedule)
 {
+    // each block depends on the previous one so there is nothing to interleave
     for (size_t i = 0; i < blocks; ++i)
     {
         __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input) + i);
@@ -320,21 +585,79 @@ void aesni_cbc_encrypt(u8* output, const u8* input, size_t blocks, __m128i iv, c
 template <int NR>
 void aesni_cbc_decrypt(u8* output, const u8* input, size_t blocks, __m128i iv, const __m128i* schedule)
 {
+    const __m128i* src = reinterpret_cast<const __m128i *>(input);
+    __m128i* dest = reinterpret_cast<__m128i *>(output);
+
+    for ( ; blocks >= 8; blocks -= 8)
+    {
+        __m128i temp[8];
+        __m128i data[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            temp[i] = _mm_loadu_si128(src + i);
+            data[i] = temp[i];
+        }
+        aesni_decrypt8<NR>(data, schedule);
+        _mm_storeu_si128(dest + 0, _mm_xor_si128(data[0], iv));
+        for (int i = 1; i < 8; ++i)
+        {
+            _mm_storeu_si128(dest + i, _mm_xor_si128(data[i], temp[i - 1]));
+        }
+        iv = temp[7];
+        src += 8;
+        dest += 8;
+    }
+
     for (size_t i = 0; i < blocks; ++i)
     {
-        __m128i temp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input) + i);
+        __m128i temp = _mm_loadu_si128(src + i);
         __m128i data = aesni_ecb_decrypt_block<NR>(temp, schedule);
         data = _mm_xor_si128(data, iv);
-        _mm_storeu_si128(reinterpret_cast<__m128i *>(output) + i, data);
+        _mm_storeu_si128(dest + i, data);
         iv = temp;
     }
 }
 
+// CTR buffer
+
+template <int NR>
+void aesni_ctr_encrypt(u8* output, const u8* input, size_t blocks, CounterBlock& counter, const __m128i* schedule)
+{
+    const __m128i* src = reinterpret_cast<const __m128i *>(input);
+    __m128i* dest = reinterpret_cast<__m128i *>(output);
+
+    for ( ; blocks >= 8; blocks -= 8)
+    {
+        __m128i data[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            u64 w0, w1;
+            counter.next(w0, w1);
+            data[i] = _mm_set_epi64x(s64(w1), s64(w0));
+        }
+        aesni_encrypt8<NR>(data, schedule);
+        for (int i = 0; i < 8; ++i)
+        {
+            _mm_storeu_si128(dest + i, _mm_xor_si128(data[i], _mm_loadu_si128(src + i)));
+        }
+        src += 8;
+        dest += 8;
+    }
+
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        u64 w0, w1;
+        counter.next(w0, w1);
+        __m128i data = _mm_set_epi64x(s64(w1), s64(w0));
+        data = aesni_ecb_encrypt_block<NR>(data, schedule);
+        _mm_storeu_si128(dest + i, _mm_xor_si128(data, _mm_loadu_si128(src + i)));
+    }
+}
+
 // EBC selector
 
-void aesni_ecb_encrypt(u8* output, const u8* input, size_t length, const __m128i* schedule, int keybits)
+void aesni_ecb_encrypt(u8* output, const u8* input, size_t blocks, const __m128i* schedule, int keybits)
 {
-    const size_t blocks = (length + 15) / 16;
     switch (keybits)
     {
         case 128:
@@ -351,9 +674,8 @@ void aesni_ecb_encrypt(u8* output, const u8* input, size_t length, const __m128i
     }
 }
 
-void aesni_ecb_decrypt(u8* output, const u8* input, size_t length, const __m128i* schedule, int keybits)
+void aesni_ecb_decrypt(u8* output, const u8* input, size_t blocks, const __m128i* schedule, int keybits)
 {
-    const size_t blocks = (length + 15) / 16;
     switch (keybits)
     {
         case 128:
@@ -372,9 +694,8 @@ void aesni_ecb_decrypt(u8* output, const u8* input, size_t length, const __m128i
 
 // CBC selector
 
-void aesni_cbc_encrypt(u8* output, const u8* input, size_t length, const u8* ivec, const __m128i* schedule, int keybits)
+void aesni_cbc_encrypt(u8* output, const u8* input, size_t blocks, const u8* ivec, const __m128i* schedule, int keybits)
 {
-    const size_t blocks = (length + 15) / 16;
     __m128i iv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ivec));
     switch (keybits)
     {
@@ -392,9 +713,8 @@ void aesni_cbc_encrypt(u8* output, const u8* input, size_t length, const u8* ive
     }
 }
 
-void aesni_cbc_decrypt(u8* output, const u8* input, size_t length, const u8* ivec, const __m128i* schedule, int keybits)
+void aesni_cbc_decrypt(u8* output, const u8* input, size_t blocks, const u8* ivec, const __m128i* schedule, int keybits)
 {
-    const size_t blocks = (length + 15) / 16;
     __m128i iv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ivec));
     switch (keybits)
     {
@@ -412,6 +732,26 @@ void aesni_cbc_decrypt(u8* output, const u8* input, size_t length, const u8* ive
     }
 }
 
+// CTR selector
+
+void aesni_ctr_encrypt(u8* output, const u8* input, size_t blocks, CounterBlock& counter, const __m128i* schedule, int keybits)
+{
+    switch (keybits)
+    {
+        case 128:
+            aesni_ctr_encrypt<10>(output, input, blocks, counter, schedule);
+            break;
+        case 192:
+            aesni_ctr_encrypt<12>(output, input, blocks, counter, schedule);
+            break;
+        case 256:
+            aesni_ctr_encrypt<14>(output, input, blocks, counter, schedule);
+            break;
+        default:
+            break;
+    }
+}
+
 void aesni_key_expand(__m128i* schedule, const u8* key, int bits)
 {
     switch (bits)
@@ -432,157 +772,1035 @@ void aesni_key_expand(__m128i* schedule, const u8* key, int bits)
 
 #endif // defined(MANGO_ENABLE_AES)
 
-} // namespace
+#if defined(MANGO_ENABLE_CLMUL) && defined(MANGO_ENABLE_SSSE3)
 
-namespace mango
+// ----------------------------------------------------------------------------------------
+// Intel PCLMULQDQ GHASH
+// ----------------------------------------------------------------------------------------
+
+// The blocks are byte reversed and multiplied in the bit-reflected domain as described
+// in the Intel carry-less multiplication white paper. Four blocks are multiplied with
+// the powers H^4 .. H^1 and reduced once.
+
+inline __m128i clmul_reverse(__m128i value)
 {
+    const __m128i mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    return _mm_shuffle_epi8(value, mask);
+}
 
-struct KeyScheduleAES
+inline void clmul_multiply(__m128i& lo, __m128i& hi, __m128i a, __m128i b)
 {
-    union
-    {
-#if defined(MANGO_ENABLE_AES)
-        __m128i schedule[28];
-#endif
-        u32 w[60];
-    };
-#if defined(MANGO_ENABLE_AES)
-    bool aes_supported;
-#endif
-};
+    __m128i t0 = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i t1 = _mm_clmulepi64_si128(a, b, 0x10);
+    __m128i t2 = _mm_clmulepi64_si128(a, b, 0x01);
+    __m128i t3 = _mm_clmulepi64_si128(a, b, 0x11);
+    t1 = _mm_xor_si128(t1, t2);
+    lo = _mm_xor_si128(lo, _mm_xor_si128(t0, _mm_slli_si128(t1, 8)));
+    hi = _mm_xor_si128(hi, _mm_xor_si128(t3, _mm_srli_si128(t1, 8)));
+}
 
-AES::AES(const u8* key, int bits)
-    : m_schedule(new KeyScheduleAES())
-    , m_bits(bits)
+inline __m128i clmul_reduce(__m128i lo, __m128i hi)
 {
-    // check key length
-    switch (bits)
-    {
-        case 128:
-        case 192:
-        case 256:
-            break;
-        default:
-            MANGO_EXCEPTION("[AES] Incorrect encryption key length: %d", bits);
-            break;
-    }
+    // shift the 256 bit product left by one bit
+    __m128i t0 = _mm_srli_epi32(lo, 31);
+    __m128i t1 = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i t2 = _mm_srli_si128(t0, 12);
+    t1 = _mm_slli_si128(t1, 4);
+    t0 = _mm_slli_si128(t0, 4);
+    lo = _mm_or_si128(lo, t0);
+    hi = _mm_or_si128(hi, t1);
+    hi = _mm_or_si128(hi, t2);
 
-#if defined(MANGO_ENABLE_AES)
-    m_schedule->aes_supported = (getCPUFlags() & CPU_AES) != 0;
-    if (m_schedule->aes_supported)
-    {
-        aesni_key_expand(m_schedule->schedule, key, bits);
-    }
-    else
-#endif
-    {
-        aes_key_setup(key, m_schedule->w, bits);
-    }
+    // reduce modulo x^128 + x^7 + x^2 + x + 1
+    t0 = _mm_slli_epi32(lo, 31);
+    t1 = _mm_slli_epi32(lo, 30);
+    t2 = _mm_slli_epi32(lo, 25);
+    t0 = _mm_xor_si128(t0, t1);
+    t0 = _mm_xor_si128(t0, t2);
+    t1 = _mm_srli_si128(t0, 4);
+    t0 = _mm_slli_si128(t0, 12);
+    lo = _mm_xor_si128(lo, t0);
+
+    t2 = _mm_srli_epi32(lo, 1);
+    t0 = _mm_srli_epi32(lo, 2);
+    t2 = _mm_xor_si128(t2, t0);
+    t0 = _mm_srli_epi32(lo, 7);
+    t2 = _mm_xor_si128(t2, t0);
+    t2 = _mm_xor_si128(t2, t1);
+    lo = _mm_xor_si128(lo, t2);
+    return _mm_xor_si128(hi, lo);
 }
 
-AES::~AES()
+inline __m128i clmul_multiply(__m128i a, __m128i b)
 {
-    delete m_schedule;
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    clmul_multiply(lo, hi, a, b);
+    return clmul_reduce(lo, hi);
 }
 
-void AES::ecb_block_encrypt(u8* output, const u8* input, size_t length)
+struct GHashCLMUL
 {
-    if (length & 15)
-    {
-        MANGO_EXCEPTION("[AES] The length must be multiple of 16 bytes.");
-    }
+    __m128i h[4]; // H^1 .. H^4
 
-#if defined(MANGO_ENABLE_AES)
-    if (m_schedule->aes_supported)
+    void init(const u8* key)
     {
-        aesni_ecb_encrypt(output, input, length, m_schedule->schedule, m_bits);
+        h[0] = clmul_reverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(key)));
+        h[1] = clmul_multiply(h[0], h[0]);
+        h[2] = clmul_multiply(h[1], h[0]);
+        h[3] = clmul_multiply(h[2], h[0]);
     }
-    else
-#endif
+
+    void update(u8* x, const u8* data, size_t blocks) const
     {
-        for (size_t i = 0; i < length; i += 16)
+        const __m128i* src = reinterpret_cast<const __m128i *>(data);
+        __m128i a = clmul_reverse(_mm_loadu_si128(reinterpret_cast<const __m128i *>(x)));
+
+        for ( ; blocks >= 4; blocks -= 4)
+        {
+            __m128i d0 = clmul_reverse(_mm_loadu_si128(src + 0));
+            __m128i d1 = clmul_reverse(_mm_loadu_si128(src + 1));
+            __m128i d2 = clmul_reverse(_mm_loadu_si128(src + 2));
+            __m128i d3 = clmul_reverse(_mm_loadu_si128(src + 3));
+
+            __m128i lo = _mm_setzero_si128();
+            __m128i hi = _mm_setzero_si128();
+            clmul_multiply(lo, hi, _mm_xor_si128(a, d0), h[3]);
+            clmul_multiply(lo, hi, d1, h[2]);
+            clmul_multiply(lo, hi, d2, h[1]);
+            clmul_multiply(lo, hi, d3, h[0]);
+            a = clmul_reduce(lo, hi);
+            src += 4;
+        }
+
+        for (size_t i = 0; i < blocks; ++i)
         {
-            aes_encrypt(input + i, output + i, m_schedule->w, m_bits);
+            __m128i d = clmul_reverse(_mm_loadu_si128(src + i));
+            a = clmul_multiply(_mm_xor_si128(a, d), h[0]);
         }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(x), clmul_reverse(a));
     }
-}
+};
 
-void AES::ecb_block_decrypt(u8* output, const u8* input, size_t length)
+#endif // defined(MANGO_ENABLE_CLMUL) && defined(MANGO_ENABLE_SSSE3)
+
+#if defined(__ARM_FEATURE_CRYPTO)
+
+// ----------------------------------------------------------------------------------------
+// ARMv8 Crypto
+// ----------------------------------------------------------------------------------------
+
+// AESE does AddRoundKey, SubBytes and ShiftRows; the round key is applied before the
+// substitution so the last round key is added separately. The decryption uses the
+// same equivalent inverse cipher schedule layout as the AES-NI code above.
+
+void arm_key_expand(uint8x16_t* schedule, const u8* key, int bits)
 {
-    if (length & 15)
+    u32 w[60];
+    aes_key_setup(key, w, bits);
+
+    const int NR = bits / 32 + 6;
+
+    // encryption schedule
+    for (int i = 0; i <= NR; ++i)
     {
-        MANGO_EXCEPTION("[AES] The length must be multiple of 16 bytes.");
+        u8 temp[16];
+        ustore32be(temp +  0, w[i * 4 + 0]);
+        ustore32be(temp +  4, w[i * 4 + 1]);
+        ustore32be(temp +  8, w[i * 4 + 2]);
+        ustore32be(temp + 12, w[i * 4 + 3]);
+        schedule[i] = vld1q_u8(temp);
     }
 
-#if defined(MANGO_ENABLE_AES)
-    if (m_schedule->aes_supported)
+    // decryption schedule
+    for (int i = 1; i < NR; ++i)
     {
-        aesni_ecb_decrypt(output, input, length, m_schedule->schedule, m_bits);
+        schedule[NR + i] = vaesimcq_u8(schedule[NR - i]);
     }
-    else
-#endif
+}
+
+template <int NR>
+inline uint8x16_t arm_encrypt_block(uint8x16_t data, const uint8x16_t* schedule)
+{
+    for (int i = 0; i < NR - 1; ++i)
     {
-        for (size_t i = 0; i < length; i += 16)
-        {
-            aes_decrypt(input + i, output + i, m_schedule->w, m_bits);
-        }
+        data = vaesmcq_u8(vaeseq_u8(data, schedule[i]));
     }
+    data = vaeseq_u8(data, schedule[NR - 1]);
+    return veorq_u8(data, schedule[NR]);
 }
 
-void AES::cbc_block_encrypt(u8* output, const u8* input, size_t length, const u8* iv)
+template <int NR>
+inline uint8x16_t arm_decrypt_block(uint8x16_t data, const uint8x16_t* schedule)
 {
-    if (length & 15)
+    data = vaesimcq_u8(vaesdq_u8(data, schedule[NR]));
+    for (int i = NR + 1; i < NR * 2 - 1; ++i)
     {
-        MANGO_EXCEPTION("[AES] The length must be multiple of 16 bytes.");
+        data = vaesimcq_u8(vaesdq_u8(data, schedule[i]));
     }
+    data = vaesdq_u8(data, schedule[NR * 2 - 1]);
+    return veorq_u8(data, schedule[0]);
+}
 
-#if defined(MANGO_ENABLE_AES)
-    if (m_schedule->aes_supported)
+template <int NR>
+inline void arm_encrypt8(uint8x16_t* data, const uint8x16_t* schedule)
+{
+    for (int i = 0; i < NR - 1; ++i)
     {
-        aesni_cbc_encrypt(output, input, length, iv, m_schedule->schedule, m_bits);
+        const uint8x16_t key = schedule[i];
+        data[0] = vaesmcq_u8(vaeseq_u8(data[0], key));
+        data[1] = vaesmcq_u8(vaeseq_u8(data[1], key));
+        data[2] = vaesmcq_u8(vaeseq_u8(data[2], key));
+        data[3] = vaesmcq_u8(vaeseq_u8(data[3], key));
+        data[4] = vaesmcq_u8(vaeseq_u8(data[4], key));
+        data[5] = vaesmcq_u8(vaeseq_u8(data[5], key));
+        data[6] = vaesmcq_u8(vaeseq_u8(data[6], key));
+        data[7] = vaesmcq_u8(vaeseq_u8(data[7], key));
     }
-    else
-#endif
+
+    const uint8x16_t key0 = schedule[NR - 1];
+    const uint8x16_t key1 = schedule[NR];
+    for (int i = 0; i < 8; ++i)
     {
-        aes_encrypt_cbc(input, length, output, m_schedule->w, m_bits, iv);
+        data[i] = veorq_u8(vaeseq_u8(data[i], key0), key1);
     }
 }
 
-void AES::cbc_block_decrypt(u8* output, const u8* input, size_t length, const u8* iv)
+template <int NR>
+inline void arm_decrypt8(uint8x16_t* data, const uint8x16_t* schedule)
 {
-    if (length & 15)
+    uint8x16_t key = schedule[NR];
+    for (int i = 0; i < 8; ++i)
     {
-        MANGO_EXCEPTION("[AES] The length must be multiple of 16 bytes.");
+        data[i] = vaesimcq_u8(vaesdq_u8(data[i], key));
     }
 
-#if defined(MANGO_ENABLE_AES)
-    if (m_schedule->aes_supported)
+    for (int i = NR + 1; i < NR * 2 - 1; ++i)
     {
-        aesni_cbc_decrypt(output, input, length, iv, m_schedule->schedule, m_bits);
+        key = schedule[i];
+        data[0] = vaesimcq_u8(vaesdq_u8(data[0], key));
+        data[1] = vaesimcq_u8(vaesdq_u8(data[1], key));
+        data[2] = vaesimcq_u8(vaesdq_u8(data[2], key));
+        data[3] = vaesimcq_u8(vaesdq_u8(data[3], key));
+        data[4] = vaesimcq_u8(vaesdq_u8(data[4], key));
+        data[5] = vaesimcq_u8(vaesdq_u8(data[5], key));
+        data[6] = vaesimcq_u8(vaesdq_u8(data[6], key));
+        data[7] = vaesimcq_u8(vaesdq_u8(data[7], key));
     }
-    else
+
+    const uint8x16_t key0 = schedule[NR * 2 - 1];
+    const uint8x16_t key1 = schedule[0];
+    for (int i = 0; i < 8; ++i)
+    {
+        data[i] = veorq_u8(vaesdq_u8(data[i], key0), key1);
+    }
+}
+
+inline uint8x16_t arm_counter_block(CounterBlock& counter)
+{
+    u64 w0, w1;
+    counter.next(w0, w1);
+    return vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(w0), vcreate_u64(w1)));
+}
+
+template <int NR>
+void arm_ecb_encrypt(u8* output, const u8* input, size_t blocks, const uint8x16_t* schedule)
+{
+    for ( ; blocks >= 8; blocks -= 8)
+    {
+        uint8x16_t data[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            data[i] = vld1q_u8(input + i * 16);
+        }
+        arm_encrypt8<NR>(data, schedule);
+        for (int i = 0; i < 8; ++i)
+        {
+            vst1q_u8(output + i * 16, data[i]);
+        }
+        input += 128;
+        output += 128;
+    }
+
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        uint8x16_t data = vld1q_u8(input + i * 16);
+        vst1q_u8(output + i * 16, arm_encrypt_block<NR>(data, schedule));
+    }
+}
+
+template <int NR>
+void arm_ecb_decrypt(u8* output, const u8* input, size_t blocks, const uint8x16_t* schedule)
+{
+    for ( ; blocks >= 8; blocks -= 8)
+    {
+        uint8x16_t data[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            data[i] = vld1q_u8(input + i * 16);
+        }
+        arm_decrypt8<NR>(data, schedule);
+        for (int i = 0; i < 8; ++i)
+        {
+            vst1q_u8(output + i * 16, data[i]);
+        }
+        input += 128;
+        output += 128;
+    }
+
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        uint8x16_t data = vld1q_u8(input + i * 16);
+        vst1q_u8(output + i * 16, arm_decrypt_block<NR>(data, schedule));
+    }
+}
+
+template <int NR>
+void arm_cbc_encrypt(u8* output, const u8* input, size_t blocks, uint8x16_t iv, const uint8x16_t* schedule)
+{
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        iv = veorq_u8(vld1q_u8(input + i * 16), iv);
+        iv = arm_encrypt_block<NR>(iv, schedule);
+        vst1q_u8(output + i * 16, iv);
+    }
+}
+
+template <int NR>
+void arm_cbc_decrypt(u8* output, const u8* input, size_t blocks, uint8x16_t iv, const uint8x16_t* schedule)
+{
+    for ( ; blocks >= 8; blocks -= 8)
+    {
+        uint8x16_t temp[8];
+        uint8x16_t data[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            temp[i] = vld1q_u8(input + i * 16);
+            data[i] = temp[i];
+        }
+        arm_decrypt8<NR>(data, schedule);
+        vst1q_u8(output, veorq_u8(data[0], iv));
+        for (int i = 1; i < 8; ++i)
+        {
+            vst1q_u8(output + i * 16, veorq_u8(data[i], temp[i - 1]));
+        }
+        iv = temp[7];
+        input += 128;
+        output += 128;
+    }
+
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        uint8x16_t temp = vld1q_u8(input + i * 16);
+        uint8x16_t data = arm_decrypt_block<NR>(temp, schedule);
+        vst1q_u8(output + i * 16, veorq_u8(data, iv));
+        iv = temp;
+    }
+}
+
+template <int NR>
+void arm_ctr_encrypt(u8* output, const u8* input, size_t blocks, CounterBlock& counter, const uint8x16_t* schedule)
+{
+    for ( ; blocks >= 8; blocks -= 8)
+    {
+        uint8x16_t data[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            data[i] = arm_counter_block(counter);
+        }
+        arm_encrypt8<NR>(data, schedule);
+        for (int i = 0; i < 8; ++i)
+        {
+            vst1q_u8(output + i * 16, veorq_u8(data[i], vld1q_u8(input + i * 16)));
+        }
+        input += 128;
+        output += 128;
+    }
+
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        uint8x16_t data = arm_encrypt_block<NR>(arm_counter_block(counter), schedule);
+        vst1q_u8(output + i * 16, veorq_u8(data, vld1q_u8(input + i * 16)));
+    }
+}
+
+void arm_ecb_encrypt(u8* output, const u8* input, size_t blocks, const uint8x16_t* schedule, int keybits)
+{
+    switch (keybits)
+    {
+        case 128:
+            arm_ecb_encrypt<10>(output, input, blocks, schedule);
+            break;
+        case 192:
+            arm_ecb_encrypt<12>(output, input, blocks, schedule);
+            break;
+        case 256:
+            arm_ecb_encrypt<14>(output, input, blocks, schedule);
+            break;
+        default:
+            break;
+    }
+}
+
+void arm_ecb_decrypt(u8* output, const u8* input, size_t blocks, const uint8x16_t* schedule, int keybits)
+{
+    switch (keybits)
+    {
+        case 128:
+            arm_ecb_decrypt<10>(output, input, blocks, schedule);
+            break;
+        case 192:
+            arm_ecb_decrypt<12>(output, input, blocks, schedule);
+            break;
+        case 256:
+            arm_ecb_decrypt<14>(output, input, blocks, schedule);
+            break;
+        default:
+            break;
+    }
+}
+
+void arm_cbc_encrypt(u8* output, const u8* input, size_t blocks, const u8* ivec, const uint8x16_t* schedule, int keybits)
+{
+    uint8x16_t iv = vld1q_u8(ivec);
+    switch (keybits)
+    {
+        case 128:
+            arm_cbc_encrypt<10>(output, input, blocks, iv, schedule);
+            break;
+        case 192:
+            arm_cbc_encrypt<12>(output, input, blocks, iv, schedule);
+            break;
+        case 256:
+            arm_cbc_encrypt<14>(output, input, blocks, iv, schedule);
+            break;
+        default:
+            break;
+    }
+}
+
+void arm_cbc_decrypt(u8* output, const u8* input, size_t blocks, const u8* ivec, const uint8x16_t* schedule, int keybits)
+{
+    uint8x16_t iv = vld1q_u8(ivec);
+    switch (keybits)
+    {
+        case 128:
+            arm_cbc_decrypt<10>(output, input, blocks, iv, schedule);
+            break;
+        case 192:
+            arm_cbc_decrypt<12>(output, input, blocks, iv, schedule);
+            break;
+        case 256:
+            arm_cbc_decrypt<14>(output, input, blocks, iv, schedule);
+            break;
+        default:
+            break;
+    }
+}
+
+void arm_ctr_encrypt(u8* output, const u8* input, size_t blocks, CounterBlock& counter, const uint8x16_t* schedule, int keybits)
+{
+    switch (keybits)
+    {
+        case 128:
+            arm_ctr_encrypt<10>(output, input, blocks, counter, schedule);
+            break;
+        case 192:
+            arm_ctr_encrypt<12>(output, input, blocks, counter, schedule);
+            break;
+        case 256:
+            arm_ctr_encrypt<14>(output, input, blocks, counter, schedule);
+            break;
+        default:
+            break;
+    }
+}
+
+#if defined(MANGO_CPU_64BIT)
+
+// ----------------------------------------------------------------------------------------
+// ARMv8 PMULL GHASH
+// ----------------------------------------------------------------------------------------
+
+// Reversing the bits in each byte turns the GHASH field elements into ordinary little
+// endian polynomials which are multiplied with PMULL and reduced with x^128 = x^7 + x^2 + x + 1.
+
+inline void pmull_multiply(uint64x2_t& lo, uint64x2_t& hi, uint8x16_t a, uint8x16_t b)
+{
+    const uint64x2_t a64 = vreinterpretq_u64_u8(a);
+    const uint64x2_t b64 = vreinterpretq_u64_u8(b);
+    const poly64_t a0 = poly64_t(vgetq_lane_u64(a64, 0));
+    const poly64_t a1 = poly64_t(vgetq_lane_u64(a64, 1));
+    const poly64_t b0 = poly64_t(vgetq_lane_u64(b64, 0));
+    const poly64_t b1 = poly64_t(vgetq_lane_u64(b64, 1));
+
+    const uint64x2_t t0 = vreinterpretq_u64_p128(vmull_p64(a0, b0));
+    const uint64x2_t t3 = vreinterpretq_u64_p128(vmull_p64(a1, b1));
+    const uint64x2_t t1 = veorq_u64(vreinterpretq_u64_p128(vmull_p64(a0, b1)),
+                                    vreinterpretq_u64_p128(vmull_p64(a1, b0)));
+
+    const uint64x2_t zero = vdupq_n_u64(0);
+    lo = veorq_u64(lo, veorq_u64(t0, vextq_u64(zero, t1, 1)));
+    hi = veorq_u64(hi, veorq_u64(t3, vextq_u64(t1, zero, 1)));
+}
+
+inline uint8x16_t pmull_reduce(uint64x2_t lo, uint64x2_t hi)
+{
+    const poly64_t p = poly64_t(0x87);
+    const uint64x2_t zero = vdupq_n_u64(0);
+
+    // fold the highest 64 bits into bits 64 .. 191
+    uint64x2_t t = vreinterpretq_u64_p128(vmull_p64(poly64_t(vgetq_lane_u64(hi, 1)), p));
+    lo = veorq_u64(lo, vextq_u64(zero, t, 1));
+    const u64 h0 = vgetq_lane_u64(hi, 0) ^ vgetq_lane_u64(t, 1);
+
+    // fold bits 128 .. 191
+    t = vreinterpretq_u64_p128(vmull_p64(poly64_t(h0), p));
+    return vreinterpretq_u8_u64(veorq_u64(lo, t));
+}
+
+inline uint8x16_t pmull_multiply(uint8x16_t a, uint8x16_t b)
+{
+    uint64x2_t lo = vdupq_n_u64(0);
+    uint64x2_t hi = vdupq_n_u64(0);
+    pmull_multiply(lo, hi, a, b);
+    return pmull_reduce(lo, hi);
+}
+
+struct GHashPMULL
+{
+    uint8x16_t h[4]; // H^1 .. H^4
+
+    void init(const u8* key)
+    {
+        h[0] = vrbitq_u8(vld1q_u8(key));
+        h[1] = pmull_multiply(h[0], h[0]);
+        h[2] = pmull_multiply(h[1], h[0]);
+        h[3] = pmull_multiply(h[2], h[0]);
+    }
+
+    void update(u8* x, const u8* data, size_t blocks) const
+    {
+        uint8x16_t a = vrbitq_u8(vld1q_u8(x));
+
+        for ( ; blocks >= 4; blocks -= 4)
+        {
+            uint8x16_t d0 = vrbitq_u8(vld1q_u8(data + 0));
+            uint8x16_t d1 = vrbitq_u8(vld1q_u8(data + 16));
+            uint8x16_t d2 = vrbitq_u8(vld1q_u8(data + 32));
+            uint8x16_t d3 = vrbitq_u8(vld1q_u8(data + 48));
+
+            uint64x2_t lo = vdupq_n_u64(0);
+            uint64x2_t hi = vdupq_n_u64(0);
+            pmull_multiply(lo, hi, veorq_u8(a, d0), h[3]);
+            pmull_multiply(lo, hi, d1, h[2]);
+            pmull_multiply(lo, hi, d2, h[1]);
+            pmull_multiply(lo, hi, d3, h[0]);
+            a = pmull_reduce(lo, hi);
+            data += 64;
+        }
+
+        for (size_t i = 0; i < blocks; ++i)
+        {
+            uint8x16_t d = vrbitq_u8(vld1q_u8(data + i * 16));
+            a = pmull_multiply(veorq_u8(a, d), h[0]);
+        }
+
+        vst1q_u8(x, vrbitq_u8(a));
+    }
+};
+
+#endif // defined(MANGO_CPU_64BIT)
+
+#endif // defined(__ARM_FEATURE_CRYPTO)
+
+} // namespace
+
+namespace mango
+{
+
+struct KeyScheduleAES
+{
+    union
+    {
+#if defined(MANGO_ENABLE_AES)
+        __m128i schedule[28];
+#elif defined(__ARM_FEATURE_CRYPTO)
+        uint8x16_t schedule[28];
+#endif
+        u32 w[60];
+    };
+    int bits;
+    bool aes_supported;
+
+    // GHASH key
+    u8 h[16];
+    GHashTable table;
+#if defined(MANGO_ENABLE_CLMUL) && defined(MANGO_ENABLE_SSSE3)
+    GHashCLMUL clmul;
+    bool clmul_supported;
+#elif defined(__ARM_FEATURE_CRYPTO) && defined(MANGO_CPU_64BIT)
+    GHashPMULL clmul;
+    bool clmul_supported;
+#endif
+
+    KeyScheduleAES(const u8* key, int bits)
+        : bits(bits)
+        , aes_supported(false)
+    {
+#if defined(MANGO_ENABLE_AES)
+        aes_supported = (getCPUFlags() & CPU_AES) != 0;
+        if (aes_supported)
+        {
+            aesni_key_expand(schedule, key, bits);
+        }
+        else
+#elif defined(__ARM_FEATURE_CRYPTO)
+        aes_supported = (getCPUFlags() & CPU_ARM_AES) != 0;
+        if (aes_supported)
+        {
+            arm_key_expand(schedule, key, bits);
+        }
+        else
+#endif
+        {
+            aes_key_setup(key, w, bits);
+        }
+
+        // H = E(K, 0)
+        std::memset(h, 0, 16);
+        ecb_encrypt(h, h, 1);
+        table.init(h);
+
+#if defined(MANGO_ENABLE_CLMUL) && defined(MANGO_ENABLE_SSSE3)
+        clmul_supported = (getCPUFlags() & CPU_CLMUL) != 0;
+        if (clmul_supported)
+        {
+            clmul.init(h);
+        }
+#elif defined(__ARM_FEATURE_CRYPTO) && defined(MANGO_CPU_64BIT)
+        clmul_supported = aes_supported;
+        if (clmul_supported)
+        {
+            clmul.init(h);
+        }
+#endif
+    }
+
+    void ecb_encrypt(u8* output, const u8* input, size_t blocks) const
+    {
+#if defined(MANGO_ENABLE_AES)
+        if (aes_supported)
+        {
+            aesni_ecb_encrypt(output, input, blocks, schedule, bits);
+            return;
+        }
+#elif defined(__ARM_FEATURE_CRYPTO)
+        if (aes_supported)
+        {
+            arm_ecb_encrypt(output, input, blocks, schedule, bits);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < blocks * 16; i += 16)
+        {
+            aes_encrypt(input + i, output + i, w, bits);
+        }
+    }
+
+    void ecb_decrypt(u8* output, const u8* input, size_t blocks) const
+    {
+#if defined(MANGO_ENABLE_AES)
+        if (aes_supported)
+        {
+            aesni_ecb_decrypt(output, input, blocks, schedule, bits);
+            return;
+        }
+#elif defined(__ARM_FEATURE_CRYPTO)
+        if (aes_supported)
+        {
+            arm_ecb_decrypt(output, input, blocks, schedule, bits);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < blocks * 16; i += 16)
+        {
+            aes_decrypt(input + i, output + i, w, bits);
+        }
+    }
+
+    void cbc_encrypt(u8* output, const u8* input, size_t blocks, const u8* iv) const
+    {
+#if defined(MANGO_ENABLE_AES)
+        if (aes_supported)
+        {
+            aesni_cbc_encrypt(output, input, blocks, iv, schedule, bits);
+            return;
+        }
+#elif defined(__ARM_FEATURE_CRYPTO)
+        if (aes_supported)
+        {
+            arm_cbc_encrypt(output, input, blocks, iv, schedule, bits);
+            return;
+        }
+#endif
+        aes_encrypt_cbc(input, blocks * 16, output, w, bits, iv);
+    }
+
+    void cbc_decrypt(u8* output, const u8* input, size_t blocks, const u8* iv) const
+    {
+#if defined(MANGO_ENABLE_AES)
+        if (aes_supported)
+        {
+            aesni_cbc_decrypt(output, input, blocks, iv, schedule, bits);
+            return;
+        }
+#elif defined(__ARM_FEATURE_CRYPTO)
+        if (aes_supported)
+        {
+            arm_cbc_decrypt(output, input, blocks, iv, schedule, bits);
+            return;
+        }
 #endif
+        aes_decrypt_cbc(input, blocks * 16, output, w, bits, iv);
+    }
+
+    void ctr_encrypt(u8* output, const u8* input, size_t blocks, CounterBlock& counter) const
+    {
+#if defined(MANGO_ENABLE_AES)
+        if (aes_supported)
+        {
+            aesni_ctr_encrypt(output, input, blocks, counter, schedule, bits);
+            return;
+        }
+#elif defined(__ARM_FEATURE_CRYPTO)
+        if (aes_supported)
+        {
+            arm_ctr_encrypt(output, input, blocks, counter, schedule, bits);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < blocks * 16; i += 16)
+        {
+            u8 temp[16];
+            counter.next(temp);
+            aes_encrypt(temp, temp, w, bits);
+            for (int j = 0; j < 16; ++j)
+            {
+                output[i + j] = input[i + j] ^ temp[j];
+            }
+        }
+    }
+
+    void ctr_parallel(u8* output, const u8* input, size_t blocks, CounterBlock& counter) const
+    {
+        ConcurrentQueue queue("aes.ctr");
+
+        for (size_t i = 0; i < blocks; i += aes_parallel_blocks)
+        {
+            const size_t count = std::min(aes_parallel_blocks, blocks - i);
+            CounterBlock first = counter;
+            first.increment(i);
+
+            queue.enqueue([this, output, input, i, count, first] () mutable
+            {
+                ctr_encrypt(output + i * 16, input + i * 16, count, first);
+            });
+        }
+
+        queue.wait();
+        counter.increment(blocks);
+    }
+
+    void ghash(u8* x, const u8* data, size_t blocks) const
+    {
+#if (defined(MANGO_ENABLE_CLMUL) && defined(MANGO_ENABLE_SSSE3)) || \
+    (defined(__ARM_FEATURE_CRYPTO) && defined(MANGO_CPU_64BIT))
+        if (clmul_supported)
+        {
+            clmul.update(x, data, blocks);
+            return;
+        }
+#endif
+        table.update(x, data, blocks);
+    }
+
+    void ghash_padded(u8* x, const u8* data, size_t length) const
+    {
+        const size_t blocks = length / 16;
+        const size_t left = length % 16;
+        ghash(x, data, blocks);
+        if (left)
+        {
+            u8 temp[16] = { 0 };
+            std::memcpy(temp, data + blocks * 16, left);
+            ghash(x, temp, 1);
+        }
+    }
+
+    // encrypt or decrypt the full blocks and authenticate the ciphertext
+    void gcm_blocks(u8* x, u8* output, const u8* input, size_t blocks, CounterBlock& counter, bool encrypt) const
+    {
+        if (blocks * 16 < aes_parallel_threshold)
+        {
+            // small slices keep the data in cache between the two passes
+            const size_t slice = 256;
+
+            for (size_t i = 0; i < blocks; i += slice)
+            {
+                const size_t count = std::min(slice, blocks - i);
+                u8* dest = output + i * 16;
+                const u8* src = input + i * 16;
+
+                if (encrypt)
+                {
+                    ctr_encrypt(dest, src, count, counter);
+                    ghash(x, dest, count);
+                }
+                else
+                {
+                    ghash(x, src, count);
+                    ctr_encrypt(dest, src, count, counter);
+                }
+            }
+
+            return;
+        }
+
+        // Each task hashes its ciphertext starting from zero; the partial hashes are
+        // combined in order as X = X * H^n + Y, where n is the number of blocks in the task.
+
+        const size_t tasks = (blocks + aes_parallel_blocks - 1) / aes_parallel_blocks;
+        std::vector<u8> partial(tasks * 16, 0);
+
+        ConcurrentQueue queue("aes.gcm");
+
+        for (size_t task = 0; task < tasks; ++task)
+        {
+            const size_t i = task * aes_parallel_blocks;
+            const size_t count = std::min(aes_parallel_blocks, blocks - i);
+            CounterBlock first = counter;
+            first.increment(i);
+            u8* y = partial.data() + task * 16;
+
+            queue.enqueue([this, output, input, i, count, first, y, encrypt] () mutable
+            {
+                u8* dest = output + i * 16;
+                const u8* src = input + i * 16;
+
+                if (encrypt)
+                {
+                    ctr_encrypt(dest, src, count, first);
+                    ghash(y, dest, count);
+                }
+                else
+                {
+                    ghash(y, src, count);
+                    ctr_encrypt(dest, src, count, first);
+                }
+            });
+        }
+
+        queue.wait();
+        counter.increment(blocks);
+
+        u8 power[16];
+        gf128_power(power, h, aes_parallel_blocks);
+
+        for (size_t task = 0; task < tasks; ++task)
+        {
+            const size_t count = std::min(aes_parallel_blocks, blocks - task * aes_parallel_blocks);
+            if (count != aes_parallel_blocks)
+            {
+                gf128_power(power, h, count);
+            }
+
+            gf128_multiply(x, x, power);
+
+            const u8* y = partial.data() + task * 16;
+            for (int j = 0; j < 16; ++j)
+            {
+                x[j] ^= y[j];
+            }
+        }
+    }
+
+    void gcm(u8* output, const u8* input, size_t length, Memory associated, Memory iv, u8* tag, bool encrypt) const
     {
-        aes_decrypt_cbc(input, length, output, m_schedule->w, m_bits, iv);
+        if (!iv.size)
+        {
+            MANGO_EXCEPTION("[AES] The GCM iv cannot be empty.");
+        }
+
+        // pre-counter block
+        u8 j0[16] = { 0 };
+        if (iv.size == 12)
+        {
+            std::memcpy(j0, iv.address, 12);
+            j0[15] = 1;
+        }
+        else
+        {
+            ghash_padded(j0, iv.address, iv.size);
+            u8 temp[16] = { 0 };
+            ustore64be(temp + 8, u64(iv.size) * 8);
+            ghash(j0, temp, 1);
+        }
+
+        u8 x[16] = { 0 };
+        ghash_padded(x, associated.address, associated.size);
+
+        CounterBlock counter(j0, true);
+        counter.increment(1);
+
+        const size_t blocks = length / 16;
+        const size_t left = length % 16;
+
+        gcm_blocks(x, output, input, blocks, counter, encrypt);
+
+        if (left)
+        {
+            u8 temp[16] = { 0 };
+            std::memcpy(temp, input + blocks * 16, left);
+
+            if (!encrypt)
+            {
+                ghash(x, temp, 1);
+            }
+
+            ctr_encrypt(temp, temp, 1, counter);
+            std::memcpy(output + blocks * 16, temp, left);
+
+            if (encrypt)
+            {
+                std::memset(temp + left, 0, 16 - left);
+                ghash(x, temp, 1);
+            }
+        }
+
+        u8 temp[16];
+        ustore64be(temp + 0, u64(associated.size) * 8);
+        ustore64be(temp + 8, u64(length) * 8);
+        ghash(x, temp, 1);
+
+        ecb_encrypt(temp, j0, 1);
+        for (int i = 0; i < 16; ++i)
+        {
+            tag[i] = temp[i] ^ x[i];
+        }
     }
+};
+
+AES::AES(const u8* key, int bits)
+    : m_schedule(nullptr)
+    , m_bits(bits)
+{
+    // check key length
+    switch (bits)
+    {
+        case 128:
+        case 192:
+        case 256:
+            break;
+        default:
+            MANGO_EXCEPTION("[AES] Incorrect encryption key length: %d", bits);
+            break;
+    }
+
+    m_schedule = new KeyScheduleAES(key, bits);
 }
 
-void AES::ctr_block_encrypt(u8* output, const u8* input, size_t length, const u8* iv)
+AES::~AES()
+{
+    delete m_schedule;
+}
+
+void AES::ecb_block_encrypt(u8* output, const u8* input, size_t length)
 {
     if (length & 15)
     {
         MANGO_EXCEPTION("[AES] The length must be multiple of 16 bytes.");
     }
-    aes_encrypt_ctr(input, length, output, m_schedule->w, m_bits, iv);
+
+    m_schedule->ecb_encrypt(output, input, length / 16);
 }
 
-void AES::ctr_block_decrypt(u8* output, const u8* input, size_t length, const u8* iv)
+void AES::ecb_block_decrypt(u8* output, const u8* input, size_t length)
+{
+    if (length & 15)
+    {
+        MANGO_EXCEPTION("[AES] The length must be multiple of 16 bytes.");
+    }
+
+    m_schedule->ecb_decrypt(output, input, length / 16);
+}
+
+void AES::cbc_block_encrypt(u8* output, const u8* input, size_t length, const u8* iv)
+{
+    if (length & 15)
+    {
+        MANGO_EXCEPTION("[AES] The length must be multiple of 16 bytes.");
+    }
+
+    m_schedule->cbc_encrypt(output, input, length / 16, iv);
+}
+
+void AES::cbc_block_decrypt(u8* output, const u8* input, size_t length, const u8* iv)
+{
+    if (length & 15)
+    {
+        MANGO_EXCEPTION("[AES] The length must be multiple of 16 bytes.");
+    }
+
+    m_schedule->cbc_decrypt(output, input, length / 16, iv);
+}
+
+void AES::ctr_block_encrypt(u8* output, const u8* input, size_t length, const u8* iv)
 {
     if (length & 15)
     {
         MANGO_EXCEPTION("[AES] The length must be multiple of 16 bytes.");
     }
-    aes_decrypt_ctr(input, length, output, m_schedule->w, m_bits, iv);
+
+    CounterBlock counter(iv, false);
+
+    if (length < aes_parallel_threshold)
+    {
+        m_schedule->ctr_encrypt(output, input, length / 16, counter);
+    }
+    else
+    {
+        m_schedule->ctr_parallel(output, input, length / 16, counter);
+    }
+}
+
+void AES::ctr_block_decrypt(u8* output, const u8* input, size_t length, const u8* iv)
+{
+    // CTR decryption is the same operation as encryption
+    ctr_block_encrypt(output, input, length, iv);
+}
+
+void AES::gcm_encrypt(u8* output, const u8* input, size_t length, Memory associated, Memory iv, u8* tag)
+{
+    m_schedule->gcm(output, input, length, associated, iv, tag, true);
+}
+
+bool AES::gcm_decrypt(u8* output, const u8* input, size_t length, Memory associated, Memory iv, const u8* tag)
+{
+    u8 computed[16];
+    m_schedule->gcm(output, input, length, associated, iv, computed, false);
+
+    // constant time comparison
+    u8 diff = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        diff |= computed[i] ^ tag[i];
+    }
+
+    return diff == 0;
 }
 
 void AES::ccm_block_encrypt(Memory output, Memory input, Memory associated, Memory nonce, int mac_length)
@@ -3,6 +3,12 @@
     Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
 #include <mango/core/cpuinfo.hpp>
 
 namespace
@@ -213,6 +219,63 @@ namespace
 
 #endif
 
+	// ----------------------------------------------------------------------------
+	// getCPUFlagsOverride()
+	// ----------------------------------------------------------------------------
+
+    u64 getCPUFlagsOverride(u64 flags)
+    {
+        const char* level = std::getenv("MANGO_CPU_FLAGS");
+        if (!level || !*level)
+        {
+            return flags;
+        }
+
+        // features introduced after each level
+        const u64 sse2 = CPU_SSE3 | CPU_SSSE3 | CPU_SSE4_1 | CPU_SSE4_2 | CPU_SSE4A | CPU_POPCNT;
+        const u64 avx = CPU_AVX | CPU_F16C | CPU_FMA3 | CPU_FMA4 | CPU_XOP;
+        const u64 avx2 = CPU_AVX2 | CPU_BMI1 | CPU_BMI2 | CPU_MOVBE;
+        const u64 avx512 = CPU_AVX512F | CPU_AVX512PFI | CPU_AVX512ERI | CPU_AVX512CDI |
+                           CPU_AVX512BW | CPU_AVX512VL | CPU_AVX512DQ | CPU_AVX512IFMA | CPU_AVX512VBMI;
+
+        u64 mask = ~0ull;
+
+        if (!std::strcmp(level, "none"))
+            mask = 0;
+        else if (!std::strcmp(level, "sse2"))
+            mask &= ~(sse2 | avx | avx2 | avx512);
+        else if (!std::strcmp(level, "sse4"))
+            mask &= ~(avx | avx2 | avx512);
+        else if (!std::strcmp(level, "avx"))
+            mask &= ~(avx2 | avx512);
+        else if (!std::strcmp(level, "avx2"))
+            mask &= ~avx512;
+        else if (!std::strcmp(level, "avx512"))
+        {
+            // nothing is hidden
+        }
+        else
+        {
+            std::fprintf(stderr, "MANGO_CPU_FLAGS: unknown level \"%s\" ignored; "
+                "expected none, sse2, sse4, avx, avx2 or avx512.\n", level);
+        }
+
+        return flags & mask;
+    }
+
+    struct KernelVariants
+    {
+        std::mutex mutex;
+        std::map<std::string, std::string> variants;
+    };
+
+    KernelVariants& getKernelVariantsInstance()
+    {
+        // constructed on first use; kernels may be selected during static initialization
+        static KernelVariants instance;
+        return instance;
+    }
+
 } // namespace
 
 namespace mango
@@ -220,8 +283,29 @@ namespace mango
 
     u64 getCPUFlags()
     {
-        static u64 flags = getCPUFlagsInternal(); // cache the value
+        static u64 flags = getCPUFlagsOverride(getCPUFlagsInternal()); // cache the value
         return flags;
     }
 
+    void setKernelVariant(const std::string& kernel, const std::string& variant)
+    {
+        KernelVariants& kernels = getKernelVariantsInstance();
+        std::lock_guard<std::mutex> lock(kernels.mutex);
+        kernels.variants[kernel] = variant;
+    }
+
+    std::string getKernelVariants()
+    {
+        KernelVariants& kernels = getKernelVariantsInstance();
+        std::lock_guard<std::mutex> lock(kernels.mutex);
+
+        std::stringstream s;
+        for (auto& node : kernels.variants)
+        {
+            s << node.first << ": " << node.second << std::endl;
+        }
+
+        return s.str();
+    }
+
 } // namespace mango
@@ -2,6 +2,7 @@
     MANGO Multimedia Development Platform
     Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
+#include <algorithm>
 #include <mango/core/hash.hpp>
 #include <mango/core/exception.hpp>
 #include <mango/core/bits.hpp>
@@ -505,22 +506,16 @@ namespace {
             state[2] += c;
             state[3] += d;
             state[4] += e;
+
+            block += 64;
         }
     }
 
-} // namespace
-
-namespace mango {
+    using TransformSHA1 = void (*)(u32 state[5], const u8* block, int count);
 
-    void sha1(u32 hash[5], Memory memory)
+    TransformSHA1 getTransformSHA1()
     {
-        hash[0] = 0x67452301;
-        hash[1] = 0xEFCDAB89;
-        hash[2] = 0x98BADCFE;
-        hash[3] = 0x10325476;
-        hash[4] = 0xC3D2E1F0;
-
-        auto transform = generic_sha1_update;
+        TransformSHA1 transform = generic_sha1_update;
 #if defined(__ARM_FEATURE_CRYPTO)
         if ((getCPUFlags() & CPU_ARM_SHA1) != 0)
         {
@@ -532,41 +527,108 @@ namespace mango {
             transform = intel_sha1_update;
         }
 #endif
+        return transform;
+    }
+
+} // namespace
+
+namespace mango {
+
+    // -----------------------------------------------------------------
+    // SHA1
+    // -----------------------------------------------------------------
+
+    SHA1::SHA1()
+        : m_size(0)
+    {
+        m_state[0] = 0x67452301;
+        m_state[1] = 0xEFCDAB89;
+        m_state[2] = 0x98BADCFE;
+        m_state[3] = 0x10325476;
+        m_state[4] = 0xC3D2E1F0;
+    }
+
+    void SHA1::update(Memory memory)
+    {
+        auto transform = getTransformSHA1();
 
-        const u32 len = u32(memory.size);
         const u8* message = memory.address;
+        size_t size = memory.size;
 
-        int block_count = len / 64;
-        transform(hash, message, block_count);
-        message += block_count * 64;
-        u32 i = block_count * 64;
+        size_t used = size_t(m_size % 64);
+        m_size += size;
+
+        if (used)
+        {
+            // complete the buffered block
+            size_t bytes = std::min(size, 64 - used);
+            std::memcpy(m_buffer + used, message, bytes);
+            message += bytes;
+            size -= bytes;
+            used += bytes;
+
+            if (used < 64)
+            {
+                return;
+            }
+
+            transform(m_state, m_buffer, 1);
+        }
+
+        // the block count is passed as int to the transform functions
+        while (size >= 64)
+        {
+            const size_t count = std::min(size / 64, size_t(0x1000000));
+            transform(m_state, message, int(count));
+            message += count * 64;
+            size -= count * 64;
+        }
+
+        std::memcpy(m_buffer, message, size);
+    }
+
+    void SHA1::final(u32 hash[5])
+    {
+        auto transform = getTransformSHA1();
 
         u8 block[64];
-        u32 rem = len - i;
-        memcpy(block, message + i, rem);
+        u32 rem = u32(m_size % 64);
+        std::memcpy(block, m_buffer, rem);
 
         block[rem++] = 0x80;
         if (64 - rem >= 8)
         {
-            memset(block + rem, 0, 56 - rem);
+            std::memset(block + rem, 0, 56 - rem);
         }
         else
         {
-            memset(block + rem, 0, 64 - rem);
-            transform(hash, block, 1);
-            memset(block, 0, 56);
+            std::memset(block + rem, 0, 64 - rem);
+            transform(m_state, block, 1);
+            std::memset(block, 0, 56);
         }
 
-        ustore64be(block + 56, memory.size * 8);
-        transform(hash, block, 1);
+        ustore64be(block + 56, m_size * 8);
+        transform(m_state, block, 1);
 
+        for (int i = 0; i < 5; ++i)
+        {
 #ifdef MANGO_LITTLE_ENDIAN
-        hash[0] = byteswap(hash[0]);
-        hash[1] = byteswap(hash[1]);
-        hash[2] = byteswap(hash[2]);
-        hash[3] = byteswap(hash[3]);
-        hash[4] = byteswap(hash[4]);
+            hash[i] = byteswap(m_state[i]);
+#else
+            hash[i] = m_state[i];
 #endif
+        }
+    }
+
+    // -----------------------------------------------------------------
+    // sha1()
+    // -----------------------------------------------------------------
+
+    void sha1(u32 hash[5], Memory memory)
+    {
+        SHA1 context;
+        context.update(memory);
+        context.final(hash);
     }
 
 } // namespace mango
@@ -139,6 +139,12 @@ namespace mango
 #endif
         info << std::endl;
 
+        std::string kernels = getKernelVariants();
+        if (!kernels.empty())
+        {
+            info << "Kernel Variants:" << std::endl << kernels;
+        }
+
         info << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
         info << "Build: " << __DATE__ << "  " << __TIME__ << std::endl;
 
@@ -28,6 +28,9 @@ namespace filesystem {
         m_filename = filename;
         m_pathname = temp.pathname();
 
+        // the file memory can reference the containers it was mapped from
+        m_container = temp.m_container;
+
         AbstractMapper* mapper = temp;
         if (mapper)
         {
@@ -49,6 +52,9 @@ namespace filesystem {
         m_filename = filename;
         m_pathname = temp.pathname();
 
+        // the file memory can reference the containers it was mapped from
+        m_container = temp.m_container;
+
         AbstractMapper* mapper = temp;
         if (mapper)
         {
@@ -62,8 +68,9 @@ namespace filesystem {
         std::string password;
         Path path(memory, extension, password);
 
-        // use temporary path's mapper
+        // use temporary path's mapper; the file memory can reference it
         m_mapper = path;
+        m_mappers = std::move(path.m_mappers);
 
         // parse and create mappers
         m_pathname = filename;
@@ -103,7 +110,28 @@ namespace filesystem {
 
     size_t File::size() const
     {
-        return getMemory().size;
+        return m_memory ? m_memory->size() : 0;
+    }
+
+    Memory File::acquire(size_t offset, size_t size) const
+    {
+        return m_memory ? m_memory->acquire(offset, size) : Memory(nullptr, 0);
+    }
+
+    void File::advise(VirtualMemory::Access access, size_t offset, size_t size) const
+    {
+        if (m_memory)
+        {
+            m_memory->advise(access, offset, size);
+        }
+    }
+
+    void File::prefetch(size_t offset, size_t size) const
+    {
+        if (m_memory)
+        {
+            m_memory->prefetch(offset, size);
+        }
     }
 
     Memory File::getMemory() const
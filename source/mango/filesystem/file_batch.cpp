@@ -0,0 +1,682 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <vector>
+#include <mutex>
+#include <exception>
+#include <mango/core/thread.hpp>
+#include <mango/core/string.hpp>
+#include <mango/core/exception.hpp>
+#include <mango/filesystem/file.hpp>
+
+#if defined(MANGO_PLATFORM_UNIX)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+#else
+    #include <cstdio>
+    #include <sys/stat.h>
+#endif
+
+#if defined(MANGO_PLATFORM_LINUX) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #define MANGO_ENABLE_IO_URING
+        #include <cerrno>
+        #include <cstring>
+        #include <sys/mman.h>
+        #include <sys/syscall.h>
+        #include <sys/uio.h>
+        #include <linux/io_uring.h>
+    #endif
+#endif
+
+#define ID "[BatchFileReader] "
+
+namespace
+{
+    using namespace mango;
+
+    // -----------------------------------------------------------------
+    // BufferPool
+    // -----------------------------------------------------------------
+
+    struct Buffer
+    {
+        u8* address;
+        size_t capacity;
+    };
+
+    class BufferPool
+    {
+    protected:
+        std::mutex m_mutex;
+        std::vector<Buffer> m_free;
+        size_t m_used { 0 };
+        size_t m_limit;
+
+        enum
+        {
+            ALIGNMENT = 4096,
+            GRANULARITY = 64 * 1024,
+        };
+
+    public:
+        BufferPool(size_t limit)
+            : m_limit(limit)
+        {
+        }
+
+        ~BufferPool()
+        {
+            for (auto& buffer : m_free)
+            {
+                aligned_free(buffer.address);
+            }
+        }
+
+        // returns false if all buffers are in use; the caller does not block here because
+        // the buffers are released by tasks which may have to run on the calling thread
+        bool acquire(Buffer& buffer, size_t size)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            if (m_used >= m_limit)
+            {
+                return false;
+            }
+
+            ++m_used;
+
+            for (size_t i = 0; i < m_free.size(); ++i)
+            {
+                if (m_free[i].capacity >= size)
+                {
+                    buffer = m_free[i];
+                    m_free[i] = m_free.back();
+                    m_free.pop_back();
+                    return true;
+                }
+            }
+
+            if (!m_free.empty())
+            {
+                // none of the free buffers is large enough; replace one of them
+                aligned_free(m_free.back().address);
+                m_free.pop_back();
+            }
+
+            lock.unlock();
+
+            buffer.capacity = std::max(size_t(GRANULARITY), (size + GRANULARITY - 1) & ~size_t(GRANULARITY - 1));
+            buffer.address = reinterpret_cast<u8*>(aligned_malloc(buffer.capacity, ALIGNMENT));
+            return true;
+        }
+
+        void release(const Buffer& buffer)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_free.push_back(buffer);
+            --m_used;
+        }
+    };
+
+    // -----------------------------------------------------------------
+    // file helpers
+    // -----------------------------------------------------------------
+
+    bool get_file_size(const std::string& filename, size_t& size)
+    {
+#if defined(MANGO_PLATFORM_WINDOWS)
+        struct _stati64 s;
+        if (_wstat64(u16_fromBytes(filename).c_str(), &s) != 0 || (s.st_mode & _S_IFDIR) != 0)
+            return false;
+#else
+        struct stat s;
+        if (::stat(filename.c_str(), &s) != 0 || S_ISDIR(s.st_mode))
+            return false;
+#endif
+        size = size_t(s.st_size);
+        return true;
+    }
+
+    // read up to size bytes; returns number of bytes read or zero if the read failed
+    size_t read_file(const std::string& filename, u8* dest, size_t size)
+    {
+        size_t bytes = 0;
+
+#if defined(MANGO_PLATFORM_UNIX)
+        int file = ::open(filename.c_str(), O_RDONLY);
+        if (file != -1)
+        {
+            while (bytes < size)
+            {
+                ssize_t status = ::pread(file, dest + bytes, size - bytes, off_t(bytes));
+                if (status < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    // the data read so far is not delivered as a complete file
+                    bytes = 0;
+                    break;
+                }
+
+                if (status == 0)
+                {
+                    // end of file; the file was truncated after the size was queried
+                    break;
+                }
+
+                bytes += size_t(status);
+            }
+
+            ::close(file);
+        }
+#else
+    #if defined(MANGO_PLATFORM_WINDOWS)
+        FILE* file = _wfopen(u16_fromBytes(filename).c_str(), L"rb");
+    #else
+        FILE* file = std::fopen(filename.c_str(), "rb");
+    #endif
+        if (file)
+        {
+            bytes = std::fread(dest, 1, size, file);
+            if (std::ferror(file))
+            {
+                bytes = 0;
+            }
+            std::fclose(file);
+        }
+#endif
+
+        return bytes;
+    }
+
+#if defined(MANGO_ENABLE_IO_URING)
+
+    // -----------------------------------------------------------------
+    // Ring
+    // -----------------------------------------------------------------
+
+    // Minimal io_uring interface using the raw system calls; the process is the
+    // only producer of submissions and the only consumer of completions.
+
+    class Ring : protected NonCopyable
+    {
+    protected:
+        int m_fd { -1 };
+
+        u8* m_sq_ring { nullptr };
+        u8* m_cq_ring { nullptr };
+        size_t m_sq_ring_size { 0 };
+        size_t m_cq_ring_size { 0 };
+        io_uring_sqe* m_sqes { nullptr };
+        size_t m_sqes_size { 0 };
+
+        unsigned* m_sq_head;
+        unsigned* m_sq_tail;
+        unsigned* m_sq_mask;
+        unsigned* m_sq_array;
+        unsigned m_sq_entries;
+
+        unsigned* m_cq_head;
+        unsigned* m_cq_tail;
+        unsigned* m_cq_mask;
+        io_uring_cqe* m_cqes;
+
+        unsigned m_queued { 0 }; // sqes written but not yet submitted to the kernel
+
+    public:
+        Ring()
+        {
+        }
+
+        ~Ring()
+        {
+            if (m_sqes)
+                ::munmap(m_sqes, m_sqes_size);
+            if (m_cq_ring && m_cq_ring != m_sq_ring)
+                ::munmap(m_cq_ring, m_cq_ring_size);
+            if (m_sq_ring)
+                ::munmap(m_sq_ring, m_sq_ring_size);
+            if (m_fd != -1)
+                ::close(m_fd);
+        }
+
+        bool init(unsigned entries)
+        {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+
+            m_fd = int(::syscall(__NR_io_uring_setup, entries, &params));
+            if (m_fd < 0)
+            {
+                // not supported by the kernel or blocked by a seccomp policy
+                m_fd = -1;
+                return false;
+            }
+
+            m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+#if defined(IORING_FEAT_SINGLE_MMAP)
+            const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#else
+            const bool single = false;
+#endif
+            if (single)
+            {
+                m_sq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+                m_cq_ring_size = m_sq_ring_size;
+            }
+
+            void* sq = ::mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+            if (sq == MAP_FAILED)
+                return false;
+            m_sq_ring = reinterpret_cast<u8*>(sq);
+
+            if (single)
+            {
+                m_cq_ring = m_sq_ring;
+            }
+            else
+            {
+                void* cq = ::mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+                if (cq == MAP_FAILED)
+                    return false;
+                m_cq_ring = reinterpret_cast<u8*>(cq);
+            }
+
+            m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED)
+                return false;
+            m_sqes = reinterpret_cast<io_uring_sqe*>(sqes);
+
+            m_sq_head = reinterpret_cast<unsigned*>(m_sq_ring + params.sq_off.head);
+            m_sq_tail = reinterpret_cast<unsigned*>(m_sq_ring + params.sq_off.tail);
+            m_sq_mask = reinterpret_cast<unsigned*>(m_sq_ring + params.sq_off.ring_mask);
+            m_sq_array = reinterpret_cast<unsigned*>(m_sq_ring + params.sq_off.array);
+            m_sq_entries = params.sq_entries;
+
+            m_cq_head = reinterpret_cast<unsigned*>(m_cq_ring + params.cq_off.head);
+            m_cq_tail = reinterpret_cast<unsigned*>(m_cq_ring + params.cq_off.tail);
+            m_cq_mask = reinterpret_cast<unsigned*>(m_cq_ring + params.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe*>(m_cq_ring + params.cq_off.cqes);
+
+            return true;
+        }
+
+        unsigned capacity() const
+        {
+            return m_sq_entries;
+        }
+
+        void read(int file, struct iovec* iov, u64 offset, u64 user_data)
+        {
+            const unsigned tail = *m_sq_tail;
+            const unsigned index = tail & *m_sq_mask;
+
+            // READV is the oldest read opcode (Linux 5.1)
+            io_uring_sqe* sqe = m_sqes + index;
+            std::memset(sqe, 0, sizeof(io_uring_sqe));
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = file;
+            sqe->addr = u64(reinterpret_cast<uintptr_t>(iov));
+            sqe->len = 1;
+            sqe->off = offset;
+            sqe->user_data = user_data;
+
+            m_sq_array[index] = index;
+            __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+            ++m_queued;
+        }
+
+        // submit the queued reads and wait for at least one completion if requested
+        bool enter(bool wait)
+        {
+            for (;;)
+            {
+                const unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+                int status = int(::syscall(__NR_io_uring_enter, m_fd, m_queued, wait ? 1 : 0, flags, nullptr, 0));
+                if (status < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+
+                m_queued -= unsigned(status);
+                return true;
+            }
+        }
+
+        bool peek(u64& user_data, int& result)
+        {
+            const unsigned head = *m_cq_head;
+            const unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+            if (head == tail)
+            {
+                return false;
+            }
+
+            const io_uring_cqe& cqe = m_cqes[head & *m_cq_mask];
+            user_data = cqe.user_data;
+            result = cqe.res;
+
+            __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+    };
+
+    struct Request
+    {
+        const std::string* filename;
+        int file;
+        Buffer buffer;
+        size_t size;
+        size_t offset;
+        bool failed;
+        struct iovec iov;
+    };
+
+#endif // defined(MANGO_ENABLE_IO_URING)
+
+} // namespace
+
+namespace mango {
+namespace filesystem {
+
+    // -----------------------------------------------------------------
+    // BatchContext
+    // -----------------------------------------------------------------
+
+    struct BatchContext
+    {
+        size_t depth;
+        BufferPool pool;
+#if defined(MANGO_ENABLE_IO_URING)
+        std::unique_ptr<Ring> ring;
+#endif
+
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        BatchContext(size_t depth)
+            : depth(depth)
+            , pool(depth * 2)
+        {
+        }
+
+        // the callback runs in a task; an exception must not escape into the ThreadPool
+        // and the buffer is released in any case. The first exception is rethrown from read().
+        void invoke(const BatchFileReader::Callback& callback, const std::string& filename, Memory memory)
+        {
+            try
+            {
+                callback(filename, memory);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        void finish(ConcurrentQueue& queue)
+        {
+            queue.wait();
+
+            std::exception_ptr e;
+            std::swap(e, error);
+            if (e)
+            {
+                std::rethrow_exception(e);
+            }
+        }
+
+        // acquire a buffer; when the pool is exhausted the queued tasks are processed on
+        // this thread until they have released their buffers. Blocking instead would
+        // deadlock when read() is called from a ThreadPool task or the pool has one thread.
+        void acquire(ConcurrentQueue& queue, Buffer& buffer, size_t size)
+        {
+            while (!pool.acquire(buffer, size))
+            {
+                queue.wait();
+            }
+        }
+
+        void deliver(ConcurrentQueue& queue, const BatchFileReader::Callback& callback,
+                     const std::string& filename, const Buffer& buffer, size_t size)
+        {
+            queue.enqueue([this, &callback, &filename, buffer, size] {
+                invoke(callback, filename, Memory(buffer.address, size));
+                if (buffer.address)
+                {
+                    pool.release(buffer);
+                }
+            });
+        }
+
+        void readSync(const std::vector<std::string>& filenames, const BatchFileReader::Callback& callback)
+        {
+            ConcurrentQueue queue("batch.reader");
+
+            for (auto& filename : filenames)
+            {
+                size_t size;
+                if (!get_file_size(filename, size))
+                {
+                    deliver(queue, callback, filename, Buffer { nullptr, 0 }, 0);
+                    continue;
+                }
+
+                Buffer buffer;
+                acquire(queue, buffer, size);
+
+                queue.enqueue([this, &callback, &filename, buffer, size] {
+                    size_t bytes = read_file(filename, buffer.address, size);
+                    invoke(callback, filename, bytes ? Memory(buffer.address, bytes) : Memory());
+                    pool.release(buffer);
+                });
+            }
+
+            finish(queue);
+        }
+
+#if defined(MANGO_ENABLE_IO_URING)
+
+        void readAsync(const std::vector<std::string>& filenames, const BatchFileReader::Callback& callback)
+        {
+            ConcurrentQueue queue("batch.reader");
+
+            std::vector<Request> requests(std::min(depth, size_t(ring->capacity())));
+            std::vector<size_t> slots;
+
+            for (size_t i = 0; i < requests.size(); ++i)
+            {
+                slots.push_back(i);
+            }
+
+            size_t next = 0;
+            size_t inflight = 0;
+
+            while (next < filenames.size() || inflight > 0)
+            {
+                // keep the ring full
+                while (next < filenames.size() && !slots.empty())
+                {
+                    const std::string& filename = filenames[next];
+
+                    size_t size;
+                    if (!get_file_size(filename, size) || !size)
+                    {
+                        deliver(queue, callback, filename, Buffer { nullptr, 0 }, 0);
+                        ++next;
+                        continue;
+                    }
+
+                    // with reads in flight the completions are reaped first to release
+                    // the buffers; otherwise the delivered files are processed here
+                    Buffer buffer;
+                    if (inflight)
+                    {
+                        if (!pool.acquire(buffer, size))
+                        {
+                            break;
+                        }
+                    }
+                    else
+                    {
+                        acquire(queue, buffer, size);
+                    }
+
+                    int file = ::open(filename.c_str(), O_RDONLY);
+                    if (file == -1)
+                    {
+                        pool.release(buffer);
+                        deliver(queue, callback, filename, Buffer { nullptr, 0 }, 0);
+                        ++next;
+                        continue;
+                    }
+
+                    size_t slot = slots.back();
+                    slots.pop_back();
+
+                    Request& request = requests[slot];
+                    request.filename = &filename;
+                    request.file = file;
+                    request.buffer = buffer;
+                    request.size = size;
+                    request.offset = 0;
+                    request.failed = false;
+                    request.iov.iov_base = buffer.address;
+                    request.iov.iov_len = size;
+
+                    ring->read(file, &request.iov, 0, slot);
+                    ++inflight;
+                    ++next;
+                }
+
+                if (!inflight)
+                {
+                    continue;
+                }
+
+                if (!ring->enter(true))
+                {
+                    MANGO_EXCEPTION(ID"io_uring_enter() failed.");
+                }
+
+                u64 slot;
+                int result;
+
+                while (ring->peek(slot, result))
+                {
+                    Request& request = requests[size_t(slot)];
+
+                    if (result == -EINTR || result == -EAGAIN)
+                    {
+                        ring->read(request.file, &request.iov, request.offset, slot);
+                        continue;
+                    }
+
+                    if (result < 0)
+                    {
+                        // the data read so far is not delivered as a complete file
+                        request.failed = true;
+                    }
+                    else if (result > 0)
+                    {
+                        request.offset += size_t(result);
+                        if (request.offset < request.size)
+                        {
+                            // short read; continue from where it stopped
+                            request.iov.iov_base = request.buffer.address + request.offset;
+                            request.iov.iov_len = request.size - request.offset;
+                            ring->read(request.file, &request.iov, request.offset, slot);
+                            continue;
+                        }
+                    }
+
+                    // done: complete, end of file or error
+                    ::close(request.file);
+                    if (request.offset && !request.failed)
+                    {
+                        deliver(queue, callback, *request.filename, request.buffer, request.offset);
+                    }
+                    else
+                    {
+                        pool.release(request.buffer);
+                        deliver(queue, callback, *request.filename, Buffer { nullptr, 0 }, 0);
+                    }
+
+                    slots.push_back(size_t(slot));
+                    --inflight;
+                }
+            }
+
+            finish(queue);
+        }
+
+#endif // defined(MANGO_ENABLE_IO_URING)
+
+    };
+
+    // -----------------------------------------------------------------
+    // BatchFileReader
+    // -----------------------------------------------------------------
+
+    BatchFileReader::BatchFileReader(size_t depth, bool async)
+    {
+        depth = std::max(depth, size_t(1));
+        m_context = new BatchContext(depth);
+
+#if defined(MANGO_ENABLE_IO_URING)
+        if (async)
+        {
+            std::unique_ptr<Ring> ring(new Ring());
+            if (ring->init(unsigned(depth)))
+            {
+                m_context->ring = std::move(ring);
+            }
+        }
+#else
+        MANGO_UNREFERENCED_PARAMETER(async);
+#endif
+    }
+
+    BatchFileReader::~BatchFileReader()
+    {
+        delete m_context;
+    }
+
+    bool BatchFileReader::isAsync() const
+    {
+#if defined(MANGO_ENABLE_IO_URING)
+        return m_context->ring != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    void BatchFileReader::read(const std::vector<std::string>& filenames, Callback callback)
+    {
+        m_context->error = nullptr;
+
+#if defined(MANGO_ENABLE_IO_URING)
+        if (m_context->ring)
+        {
+            m_context->readAsync(filenames, callback);
+            return;
+        }
+#endif
+        m_context->readSync(filenames, callback);
+    }
+
+} // namespace filesystem
+} // namespace mango
@@ -3,8 +3,14 @@
     Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
 #include <algorithm>
+#include <cctype>
 #include <mango/core/string.hpp>
+#include <mango/core/thread.hpp>
 #include <mango/filesystem/mapper.hpp>
 #include <mango/filesystem/path.hpp>
 
@@ -63,6 +69,176 @@ namespace filesystem {
 #endif
     };
 
+    // -----------------------------------------------------------------
+    // ContainerNode
+    // -----------------------------------------------------------------
+
+    struct ContainerNode
+    {
+        // the members are declared in reverse order of destruction: the mapper
+        // references the memory, which in turn is mapped from the parent container
+        std::shared_ptr<ContainerNode> parent;
+        std::unique_ptr<VirtualMemory> memory;
+        std::unique_ptr<AbstractMapper> mapper;
+        std::string identity;
+
+        u64 size() const
+        {
+            return memory ? (*memory)->size : 0;
+        }
+    };
+
+    // -----------------------------------------------------------------
+    // ContainerCache
+    // -----------------------------------------------------------------
+
+    class ContainerCache
+    {
+    protected:
+        using NodeList = std::list<std::shared_ptr<ContainerNode>>;
+
+        std::mutex m_mutex;
+        NodeList m_nodes; // most recently used first
+        std::unordered_map<std::string, NodeList::iterator> m_lookup;
+        u64 m_budget { 256 * 1024 * 1024 };
+        u64 m_usage { 0 };
+
+        void erase(NodeList::iterator i)
+        {
+            m_usage -= (*i)->size();
+            m_lookup.erase((*i)->identity);
+            m_nodes.erase(i);
+        }
+
+        void evict()
+        {
+            // nodes still referenced by a Mapper (or by a nested container) are
+            // alive regardless so only the idle ones are released
+            for (bool evicted = true; evicted && m_usage > m_budget; )
+            {
+                evicted = false;
+
+                for (auto i = m_nodes.end(); i != m_nodes.begin() && m_usage > m_budget; )
+                {
+                    --i;
+                    if (i->use_count() == 1)
+                    {
+                        auto next = i;
+                        ++next;
+                        erase(i);
+                        i = next;
+                        evicted = true;
+                    }
+                }
+            }
+        }
+
+    public:
+        std::shared_ptr<ContainerNode> acquire(const std::string& identity)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto i = m_lookup.find(identity);
+            if (i == m_lookup.end())
+            {
+                return nullptr;
+            }
+
+            m_nodes.splice(m_nodes.begin(), m_nodes, i->second);
+            return *i->second;
+        }
+
+        std::shared_ptr<ContainerNode> insert(std::shared_ptr<ContainerNode> node)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto i = m_lookup.find(node->identity);
+            if (i != m_lookup.end())
+            {
+                // another thread opened the same container first
+                m_nodes.splice(m_nodes.begin(), m_nodes, i->second);
+                return *i->second;
+            }
+
+            m_nodes.push_front(node);
+            m_lookup[node->identity] = m_nodes.begin();
+            m_usage += node->size();
+
+            evict();
+            return node;
+        }
+
+        void setBudget(u64 bytes)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_budget = bytes;
+            evict();
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_nodes.clear();
+            m_lookup.clear();
+            m_usage = 0;
+        }
+
+        void invalidate(const std::string& prefix)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // nodes still referenced by a Mapper stay alive but are no longer shared
+            for (auto i = m_nodes.begin(); i != m_nodes.end(); )
+            {
+                auto next = i;
+                ++next;
+                if (!(*i)->identity.compare(0, prefix.length(), prefix))
+                {
+                    erase(i);
+                }
+                i = next;
+            }
+        }
+    };
+
+    static ContainerCache& getContainerCache()
+    {
+        static ContainerCache cache;
+        return cache;
+    }
+
+    void setContainerCacheBudget(u64 bytes)
+    {
+        getContainerCache().setBudget(bytes);
+    }
+
+    void clearContainerCache()
+    {
+        getContainerCache().clear();
+    }
+
+    void invalidateContainerCache(const std::string& filename)
+    {
+        // the identity of a file starts with the canonical filename followed by ':'
+        getContainerCache().invalidate(filename + ":");
+    }
+
+    // -----------------------------------------------------------------
+    // solid archive budget
+    // -----------------------------------------------------------------
+
+    static std::atomic<u64> g_solid_archive_budget { 64 * 1024 * 1024 };
+
+    void setSolidArchiveBudget(u64 bytes)
+    {
+        g_solid_archive_budget = bytes;
+    }
+
+    u64 getSolidArchiveBudget()
+    {
+        return g_solid_archive_budget;
+    }
+
     // -----------------------------------------------------------------
     // FileInfo
     // -----------------------------------------------------------------
@@ -120,6 +296,160 @@ namespace filesystem {
         }
     }
 
+    // -----------------------------------------------------------------
+    // IndexFilter
+    // -----------------------------------------------------------------
+
+    bool IndexFilter::isNameAccepted(const char* name, size_t length) const
+    {
+        if (extensions.empty())
+        {
+            return true;
+        }
+
+        for (auto& extension : extensions)
+        {
+            const size_t n = extension.length();
+            if (n <= length)
+            {
+                const char* tail = name + length - n;
+                bool match = true;
+
+                for (size_t i = 0; i < n && match; ++i)
+                {
+                    match = std::tolower(u8(tail[i])) == std::tolower(u8(extension[i]));
+                }
+
+                if (match)
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    bool IndexFilter::isSizeAccepted(u64 size) const
+    {
+        return !sizes || (size >= minimum_size && size <= maximum_size);
+    }
+
+    // -----------------------------------------------------------------
+    // CompactFileIndex
+    // -----------------------------------------------------------------
+
+    void CompactFileIndex::emplace(const char* name, size_t length, u64 size, u32 flags)
+    {
+        Entry entry;
+        entry.offset = m_names.size();
+        entry.length = u32(length);
+        entry.flags = flags;
+        entry.size = size;
+
+        m_names.insert(m_names.end(), name, name + length);
+        m_names.push_back(0);
+        m_entries.push_back(entry);
+    }
+
+    void CompactFileIndex::append(const CompactFileIndex& index)
+    {
+        const size_t base = m_names.size();
+        m_names.insert(m_names.end(), index.m_names.begin(), index.m_names.end());
+
+        for (Entry entry : index.m_entries)
+        {
+            entry.offset += base;
+            m_entries.push_back(entry);
+        }
+    }
+
+    // -----------------------------------------------------------------
+    // AbstractMapper
+    // -----------------------------------------------------------------
+
+    void AbstractMapper::mmapBatchOrdered(const std::vector<std::string>& filenames, const std::vector<u64>& keys,
+                                          const std::function<void(const std::string&, VirtualMemory*)>& callback)
+    {
+        std::vector<size_t> order(filenames.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&keys] (size_t a, size_t b)
+        {
+            return keys[a] < keys[b];
+        });
+
+        ConcurrentQueue queue("mapper.batch");
+
+        for (size_t index : order)
+        {
+            const std::string& filename = filenames[index];
+
+            queue.enqueue([this, &filename, &callback] {
+                VirtualMemory* memory = nullptr;
+
+                try
+                {
+                    memory = mmap(filename);
+
+                    // decompress on this thread instead of on first access
+                    Memory materialized = *memory;
+                    MANGO_UNREFERENCED_PARAMETER(materialized);
+                }
+                catch (...)
+                {
+                    delete memory;
+                    memory = nullptr;
+                }
+
+                callback(filename, memory);
+            });
+        }
+
+        queue.wait();
+    }
+
+    void AbstractMapper::mmapBatch(const std::vector<std::string>& filenames, BatchCallback callback)
+    {
+        // no locality information; keep the given order
+        std::vector<u64> keys(filenames.size(), 0);
+        mmapBatchOrdered(filenames, keys, callback);
+    }
+
+    void AbstractMapper::getIndexRecursive(CompactFileIndex& index, const std::string& pathname, const IndexFilter& filter)
+    {
+        // generic sequential walk using getIndex()
+        std::vector<std::string> folders(1);
+
+        while (!folders.empty())
+        {
+            std::string folder = folders.back();
+            folders.pop_back();
+
+            FileIndex files;
+            getIndex(files, pathname + folder);
+
+            for (auto& file : files)
+            {
+                if (file.isDirectory())
+                {
+                    if (!file.isContainer())
+                    {
+                        folders.push_back(folder + file.name);
+                    }
+                }
+                else if (filter.isNameAccepted(file.name.c_str(), file.name.length()) && filter.isSizeAccepted(file.size))
+                {
+                    const std::string name = folder + file.name;
+                    index.emplace(name.c_str(), name.length(), filter.sizes ? file.size : 0, file.flags);
+                }
+            }
+        }
+    }
+
     // -----------------------------------------------------------------
     // Mapper
     // -----------------------------------------------------------------
@@ -130,7 +460,6 @@ namespace filesystem {
 
     Mapper::~Mapper()
     {
-		delete m_parent_memory;
     }
 
     std::string Mapper::parse(std::string& pathname, const std::string& password)
@@ -177,9 +506,45 @@ namespace filesystem {
 
                 if (m_mapper->isFile(container))
                 {
-                    m_parent_memory = m_mapper->mmap(container);
-                    mapper = extension.createMapper(*m_parent_memory, password);
-                    m_mappers.emplace_back(mapper);
+                    // nested containers are identified through their parent
+                    std::string identity;
+                    if (m_container && m_container->mapper.get() == m_mapper)
+                    {
+                        if (!m_container->identity.empty())
+                        {
+                            identity = m_container->identity + "/" + container;
+                        }
+                    }
+                    else
+                    {
+                        identity = m_mapper->getIdentity(container);
+                    }
+
+                    std::shared_ptr<ContainerNode> node;
+
+                    if (!identity.empty())
+                    {
+                        // the password is part of the key as the mappers decrypt with it
+                        identity += '\n' + password;
+                        node = getContainerCache().acquire(identity);
+                    }
+
+                    if (!node)
+                    {
+                        node = std::make_shared<ContainerNode>();
+                        node->parent = m_container;
+                        node->memory.reset(m_mapper->mmap(container));
+                        node->mapper.reset(extension.createMapper(*node->memory, password));
+                        node->identity = identity;
+
+                        if (!identity.empty())
+                        {
+                            node = getContainerCache().insert(node);
+                        }
+                    }
+
+                    m_container = node;
+                    mapper = node->mapper.get();
                     m_mapper = mapper;
 
                     filename = postfix;
@@ -206,6 +206,123 @@ namespace filesystem {
         }
     };
 
+    // -----------------------------------------------------------------
+    // VirtualMemorySegmentsMGX
+    // -----------------------------------------------------------------
+
+    // Compressed file which is materialized on demand one segment at a time;
+    // the segments overlapping the requested range are decompressed in parallel.
+    // The materialized segments stay resident for the lifetime of the object.
+
+    class VirtualMemorySegmentsMGX : public mango::VirtualMemory
+    {
+    protected:
+        struct Segment
+        {
+            const Block* block;
+            size_t source_offset; // offset in the uncompressed block
+            size_t offset;        // offset in the file
+            size_t size;
+            bool resident;
+        };
+
+        std::mutex m_mutex;
+        std::atomic<bool> m_complete { false };
+        std::vector<Segment> m_segments;
+        size_t m_pending { 0 };
+        u8* m_buffer { nullptr };
+        const u8* m_parent;
+
+        void materialize(size_t offset, size_t size) override
+        {
+            if (m_complete.load(std::memory_order_acquire))
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (!m_buffer)
+            {
+                m_buffer = new u8[m_memory.size];
+                m_memory.address = m_buffer;
+            }
+
+            const size_t end = offset + size;
+            ConcurrentQueue q("mgx.decompressor", Priority::HIGH);
+
+            for (auto& segment : m_segments)
+            {
+                const bool overlap = segment.offset < end && offset < segment.offset + segment.size;
+                if (segment.resident || !overlap)
+                {
+                    continue;
+                }
+
+                u8* dest = m_buffer + segment.offset;
+                const Block& block = *segment.block;
+
+                if (block.method)
+                {
+                    Compressor compressor = getCompressor(Compressor::Method(block.method));
+                    Memory src(const_cast<u8*>(m_parent) + block.offset, size_t(block.compressed));
+                    const Segment* ptr = &segment;
+
+                    q.enqueue([=, &block] {
+                        if (block.uncompressed == ptr->size && ptr->source_offset == 0)
+                        {
+                            // segment is full-block so we can decode directly w/o intermediate buffer
+                            compressor.decompress(Memory(dest, ptr->size), src);
+                        }
+                        else
+                        {
+                            Buffer temp(size_t(block.uncompressed));
+                            compressor.decompress(temp, src);
+                            std::memcpy(dest, Memory(temp).address + ptr->source_offset, ptr->size);
+                        }
+                    });
+                }
+                else
+                {
+                    std::memcpy(dest, m_parent + block.offset + segment.source_offset, segment.size);
+                }
+
+                segment.resident = true;
+                --m_pending;
+            }
+
+            q.wait();
+
+            if (!m_pending)
+            {
+                m_complete.store(true, std::memory_order_release);
+            }
+        }
+
+    public:
+        VirtualMemorySegmentsMGX(const HeaderMGX& header, const FileHeader& file)
+            : m_parent(header.m_memory.address)
+        {
+            size_t offset = 0;
+
+            for (auto& segment : file.segments)
+            {
+                const Block* block = &header.m_blocks[segment.block];
+                m_segments.push_back({ block, segment.offset, offset, segment.size, false });
+                offset += segment.size;
+            }
+
+            m_pending = m_segments.size();
+            m_memory = Memory(nullptr, size_t(file.size));
+        }
+
+        ~VirtualMemorySegmentsMGX()
+        {
+            delete [] m_buffer;
+        }
+
+    };
+
     // -----------------------------------------------------------------
     // MapperMGX
     // -----------------------------------------------------------------
@@ -233,6 +350,21 @@ namespace filesystem {
             return false;
         }
 
+        void mmapBatch(const std::vector<std::string>& filenames, BatchCallback callback) override
+        {
+            // schedule in the order of the first blocks for sequential access to the parent memory
+            std::vector<u64> keys;
+
+            for (auto& filename : filenames)
+            {
+                const FileHeader* ptrHeader = m_header.m_folders.getHeader(filename);
+                const bool valid = ptrHeader && !ptrHeader->segments.empty();
+                keys.push_back(valid ? m_header.m_blocks[ptrHeader->segments[0].block].offset : ~u64(0));
+            }
+
+            mmapBatchOrdered(filenames, keys, callback);
+        }
+
         void getIndex(FileIndex& index, const std::string& pathname) override
         {
             const Indexer<FileHeader>::Folder* ptrFolder = m_header.m_folders.getFolder(pathname);
@@ -312,50 +444,8 @@ namespace filesystem {
                 }
             }
 
-            // generic compression case
-
-            u8* ptr = new u8[file.size];
-            u8* x = ptr;
-
-            ConcurrentQueue q("mgx.decompessor", Priority::HIGH);
-
-            for (auto &segment : file.segments)
-            {
-                const Block& block = m_header.m_blocks[segment.block];
-
-                if (block.method)
-                {
-                    Compressor compressor = getCompressor(Compressor::Method(block.method));
-                    Memory src(m_header.m_memory.address + block.offset, block.compressed);
-
-                    q.enqueue([=, &block, &segment] {
-                        if (block.uncompressed == segment.size && segment.offset == 0)
-                        {
-                            // segment is full-block so we can decode directly w/o intermediate buffer
-                            Memory dest(x, block.uncompressed);
-                            compressor.decompress(dest, src);
-                        }
-                        else
-                        {
-                            Buffer dest(block.uncompressed);
-                            compressor.decompress(dest, src);
-                            std::memcpy(x, Memory(dest).address + segment.offset, segment.size);
-                        }
-                    });
-
-                    x += segment.size;
-                }
-                else
-                {
-                    std::memcpy(x, m_header.m_memory.address + block.offset + segment.offset, segment.size);
-                    x += segment.size;
-                }
-            }
-
-            q.wait();
-
-            VirtualMemoryMGX* vm = new VirtualMemoryMGX(ptr, ptr, file.size);
-            return vm;
+            // generic compression case; the segments are decompressed on demand
+            return new VirtualMemorySegmentsMGX(m_header, file);
         }
     };
 
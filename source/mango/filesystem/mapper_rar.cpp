@@ -6,6 +6,11 @@
     RAR decompression code: Alexander L. Roshal / unRAR library.
 */
 #include <map>
+#include <list>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <algorithm>
 #include <mango/core/string.hpp>
 #include <mango/core/exception.hpp>
@@ -27,6 +32,7 @@ namespace
     // -----------------------------------------------------------------
 
     using mango::Memory;
+    using mango::SharedMemory;
     using mango::VirtualMemory;
     using mango::filesystem::Indexer;
 
@@ -77,6 +83,229 @@ namespace
         return true;
     }
 
+    // -----------------------------------------------------------------
+    // solid stream
+    // -----------------------------------------------------------------
+
+    // Files in a solid archive are compressed as one continuous stream; a file can only
+    // be decoded with the window and tables left behind by the files before it in the
+    // same solid group. The decoders are kept alive between files so that accessing the
+    // files in archive order decodes every byte once, and the decoded files are cached
+    // so that the files skipped to reach a later file are not decoded again.
+
+    class VirtualMemorySolidRAR : public mango::VirtualMemory
+    {
+    protected:
+        SharedMemory m_shared;
+
+    public:
+        VirtualMemorySolidRAR(SharedMemory shared)
+            : m_shared(shared)
+        {
+            m_memory = shared;
+        }
+    };
+
+    struct SolidDecoder
+    {
+        ComprDataIO io;
+        Unpack unpack;
+        size_t group;
+        size_t next; // next entry in the stream
+        u64 stamp;
+
+        SolidDecoder(size_t group)
+            : unpack(&io)
+            , group(group)
+            , next(group)
+            , stamp(0)
+        {
+            io.Init();
+            unpack.Init();
+        }
+    };
+
+    class SolidStream
+    {
+    protected:
+        struct Entry
+        {
+            u8* data;
+            u64 packed_size;
+            u64 unpacked_size;
+            u8 version;
+            size_t group; // first entry in the solid group
+        };
+
+        struct CacheEntry
+        {
+            SharedMemory memory;
+            std::list<size_t>::iterator lru;
+        };
+
+        // every live decoder holds a 4 MB window
+        static constexpr size_t max_decoders = 2;
+
+        std::vector<Entry> m_entries;
+        std::vector<std::unique_ptr<SolidDecoder>> m_decoders;
+        std::unordered_map<size_t, CacheEntry> m_cache;
+        std::list<size_t> m_lru;
+        u64 m_usage { 0 };
+        u64 m_stamp { 0 };
+        std::mutex m_mutex;
+
+        SolidDecoder* getDecoder(size_t index)
+        {
+            const size_t group = m_entries[index].group;
+
+            // closest decoder which has not yet passed the entry
+            SolidDecoder* decoder = nullptr;
+
+            for (auto& d : m_decoders)
+            {
+                if (d->group == group && d->next <= index)
+                {
+                    if (!decoder || d->next > decoder->next)
+                    {
+                        decoder = d.get();
+                    }
+                }
+            }
+
+            if (!decoder)
+            {
+                // restart from the beginning of the solid group
+                if (m_decoders.size() < max_decoders)
+                {
+                    m_decoders.emplace_back(new SolidDecoder(group));
+                    decoder = m_decoders.back().get();
+                }
+                else
+                {
+                    auto oldest = std::min_element(m_decoders.begin(), m_decoders.end(),
+                        [] (const std::unique_ptr<SolidDecoder>& a, const std::unique_ptr<SolidDecoder>& b)
+                    {
+                        return a->stamp < b->stamp;
+                    });
+                    oldest->reset(new SolidDecoder(group));
+                    decoder = oldest->get();
+                }
+            }
+
+            decoder->stamp = ++m_stamp;
+            return decoder;
+        }
+
+        SharedMemory decodeNext(SolidDecoder& decoder)
+        {
+            const size_t index = decoder.next++;
+            const Entry& entry = m_entries[index];
+
+            SharedMemory memory(size_t(entry.unpacked_size));
+
+            if (entry.packed_size)
+            {
+                Memory output = memory;
+                ComprDataIO& io = decoder.io;
+                io.Init();
+
+                io.UnpackToMemory = true;
+                io.UnpackToMemorySize = output.size;
+                io.UnpackToMemoryAddr = output.address;
+
+                io.UnpackFromMemory = true;
+                io.UnpackFromMemorySize = static_cast<size_t>(entry.packed_size);
+                io.UnpackFromMemoryAddr = entry.data;
+
+                io.UnpPackedSize = entry.packed_size;
+                decoder.unpack.SetDestSize(entry.unpacked_size);
+
+                // the first entry of the group initializes the decoder state
+                decoder.unpack.DoUnpack(entry.version, index != entry.group);
+            }
+
+            insert(index, memory);
+            return memory;
+        }
+
+        void insert(size_t index, SharedMemory memory)
+        {
+            const u64 budget = mango::filesystem::getSolidArchiveBudget();
+            const u64 size = m_entries[index].unpacked_size;
+
+            if (size > budget || m_cache.find(index) != m_cache.end())
+            {
+                return;
+            }
+
+            m_lru.push_front(index);
+            m_cache.emplace(index, CacheEntry { memory, m_lru.begin() });
+            m_usage += size;
+
+            while (m_usage > budget)
+            {
+                size_t last = m_lru.back();
+                m_lru.pop_back();
+                m_usage -= m_entries[last].unpacked_size;
+                m_cache.erase(last);
+            }
+        }
+
+    public:
+        SolidStream() = default;
+        ~SolidStream() = default;
+
+        size_t append(u8* data, u64 packed_size, u64 unpacked_size, u8 version, bool solid)
+        {
+            const size_t index = m_entries.size();
+            const size_t group = (solid && index) ? m_entries.back().group : index;
+            m_entries.push_back(Entry { data, packed_size, unpacked_size, version, group });
+            return index;
+        }
+
+        // stand-alone entries do not depend on the other entries and are decoded directly
+        bool isSolid(size_t index) const
+        {
+            const size_t group = m_entries[index].group;
+            const size_t next = index + 1;
+            return group != index || (next < m_entries.size() && m_entries[next].group == group);
+        }
+
+        SharedMemory decode(size_t index)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto i = m_cache.find(index);
+            if (i != m_cache.end())
+            {
+                m_lru.splice(m_lru.begin(), m_lru, i->second.lru);
+                return i->second.memory;
+            }
+
+            SolidDecoder* decoder = getDecoder(index);
+
+            try
+            {
+                while (decoder->next < index)
+                {
+                    decodeNext(*decoder);
+                }
+
+                return decodeNext(*decoder);
+            }
+            catch (...)
+            {
+                // the decoder has advanced past a partially decoded entry; its state is not usable
+                m_decoders.erase(std::find_if(m_decoders.begin(), m_decoders.end(),
+                    [decoder] (const std::unique_ptr<SolidDecoder>& d)
+                {
+                    return d.get() == decoder;
+                }));
+                throw;
+            }
+        }
+    };
+
     // -----------------------------------------------------------------
     // RAR unicode filename conversion code
     // -----------------------------------------------------------------
@@ -357,11 +586,16 @@ namespace
         u8   version;
         u8   method;
         bool    is_rar5;
+        bool    solid { false };
         std::string filename;
 
         bool folder;
         u8* data;
 
+        // entry in the solid stream
+        static constexpr size_t NO_STREAM = ~size_t(0);
+        size_t stream { NO_STREAM };
+
         bool compressed() const
         {
             if (is_rar5)
@@ -414,10 +648,13 @@ namespace filesystem {
         std::string m_password;
         std::vector<FileHeader> m_files;
         Indexer<FileHeader> m_folders;
+        SolidStream m_stream;
+        u8* m_base;
         bool is_encrypted { false };
 
         MapperRAR(Memory parent, const std::string& password)
             : m_password(password)
+            , m_base(parent.address)
         {
             u8* start = parent.address;
             u8* end = parent.address + parent.size;
@@ -495,6 +732,7 @@ namespace filesystem {
                             file.version = header.version;
                             file.method  = header.method;
                             file.is_rar5 = false;
+                            file.solid = (header.flags & LHD_SOLID) != 0;
 
                             int dict_flags = (header.flags >> 5) & 7;
                             file.folder = (dict_flags == 7);
@@ -505,6 +743,11 @@ namespace filesystem {
                             {
                                 file.filename += "/";
                             }
+                            else if (file.compressed())
+                            {
+                                file.stream = m_stream.append(file.data, file.packed_size,
+                                    file.unpacked_size, file.version, file.solid);
+                            }
                             m_files.push_back(file);
                         }
                         else
@@ -585,7 +828,7 @@ namespace filesystem {
 
             if (is_solid)
             {
-                // solid archives are unsupported at this time
+                // solid streams require RAR 5.0 decompression, which is not supported
                 return;
             }
 
@@ -738,8 +981,28 @@ namespace filesystem {
             }
 
             const FileHeader& header = *ptrHeader;
+
+            if (header.stream != FileHeader::NO_STREAM && m_stream.isSolid(header.stream))
+            {
+                return new VirtualMemorySolidRAR(m_stream.decode(header.stream));
+            }
+
             return header.mmap();
         }
+
+        void mmapBatch(const std::vector<std::string>& filenames, BatchCallback callback) override
+        {
+            // schedule in archive order so that solid files are decoded sequentially
+            std::vector<u64> keys;
+
+            for (auto& filename : filenames)
+            {
+                const FileHeader* ptrHeader = m_folders.getHeader(filename);
+                keys.push_back(ptrHeader ? u64(ptrHeader->data - m_base) : ~u64(0));
+            }
+
+            mmapBatchOrdered(filenames, keys, callback);
+        }
     };
 
     // -----------------------------------------------------------------
@@ -2,16 +2,27 @@
     MANGO Multimedia Development Platform
     Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
+#include <map>
+#include <mutex>
+#include <atomic>
 #include <mango/core/pointer.hpp>
 #include <mango/core/string.hpp>
 #include <mango/core/exception.hpp>
 #include <mango/core/compress.hpp>
+#include <mango/core/endian.hpp>
+#include <mango/core/hash.hpp>
+#include <mango/core/aes.hpp>
 #include <mango/filesystem/mapper.hpp>
 #include <mango/filesystem/path.hpp>
 #include "indexer.hpp"
 
 #include "../../external/miniz/miniz.h"
 
+#if defined(MANGO_PLATFORM_UNIX)
+    #include <unistd.h>
+    #include <sys/mman.h>
+#endif
+
 #define ID "[mapper.zip] "
 
 /*
@@ -38,6 +49,9 @@ namespace
 
     enum { DCKEYSIZE = 12 };
 
+    // deflated entries at least this large are inflated on demand
+    constexpr size_t zip_lazy_threshold = 1024 * 1024;
+
     enum Encryption : u8
     {
         ENCRYPTION_NONE = 0,
@@ -58,7 +72,8 @@ namespace
         COMPRESSION_LZMA = 14,
         COMPRESSION_JPEG = 96,
         COMPRESSION_AES = 99,
-        COMPRESSION_XZ = 95
+        COMPRESSION_XZ = 95,
+        COMPRESSION_ZSTD = 93
     };
 
     u32 getSaltLength(Encryption encryption)
@@ -179,6 +194,7 @@ namespace
         std::string filename;      // filename is stored after the header
         bool        is_folder;     // if the last character of filename is "/", it is a folder
         Encryption  encryption;
+        u16         aesVersion;    // 1: AE-1 (crc is stored), 2: AE-2 (crc is not used), 0: not AES
 
 		bool read(LittleEndianPointer& p)
 		{
@@ -221,6 +237,7 @@ namespace
 
             filename = std::string(s, filenameLen);
             encryption = flags & 1 ? ENCRYPTION_CLASSIC : ENCRYPTION_NONE;
+            aesVersion = 0;
 
             // read extra fields
             u8* ext = p;
@@ -268,6 +285,8 @@ namespace
                             MANGO_EXCEPTION(ID"Incorrect AES header.");
                         }
 
+                        aesVersion = version;
+
                         // select encryption mode
                         switch (mode)
                         {
@@ -488,6 +507,26 @@ namespace
 		return true;
 	}
 
+    void zip_inflate_error(int zcode)
+    {
+        const char* msg = ID"Internal error.";
+        switch (zcode)
+        {
+            case Z_MEM_ERROR:
+                msg = ID"Memory error.";
+                break;
+
+            case Z_BUF_ERROR:
+                msg = ID"Buffer error.";
+                break;
+
+            case Z_DATA_ERROR:
+                msg = ID"Data error.";
+                break;
+        }
+        MANGO_EXCEPTION(msg);
+    }
+
 	u64 zip_decompress(u8* compressed, u8* uncompressed, u64 compressedLen, u64 uncompressedLen)
 	{
 		z_stream zstream;
@@ -508,22 +547,7 @@ namespace
     	int zcode = inflate(&zstream, Z_FINISH);
 		if (zcode != Z_STREAM_END)
         {
-            const char* msg = ID"Internal error.";
-            switch (zcode)
-            {
-                case Z_MEM_ERROR:
-                    msg = ID"Memory error.";
-                    break;
-
-                case Z_BUF_ERROR:
-                    msg = ID"Buffer error.";
-                    break;
-
-                case Z_DATA_ERROR:
-                    msg = ID"Data error.";
-                    break;
-            }
-            MANGO_EXCEPTION(msg);
+            zip_inflate_error(zcode);
         }
 
 		if (inflateEnd(&zstream) != Z_OK)
@@ -534,6 +558,251 @@ namespace
 		return zstream.total_out;
     }
 
+    // -----------------------------------------------------------------
+    // WinZip AES (AE-1 and AE-2)
+    // -----------------------------------------------------------------
+
+    // The encrypted data is stored as: salt, password verification value,
+    // AES-CTR encrypted data and the first 10 bytes of HMAC-SHA1 computed
+    // from the encrypted data. The keys are derived with PBKDF2-HMAC-SHA1.
+
+    enum
+    {
+        AES_PWVERIFYSIZE = 2,
+        AES_MACSIZE = 10,
+        AES_ITERATIONS = 1000,
+        AES_CHUNKSIZE = 64 * 1024
+    };
+
+    class HMAC_SHA1
+    {
+    protected:
+        SHA1 m_inner;
+        SHA1 m_outer;
+
+    public:
+        HMAC_SHA1(const u8* key, size_t length)
+        {
+            u8 temp[64] = { 0 };
+            if (length > 64)
+            {
+                u32 hash[5];
+                sha1(hash, Memory(const_cast<u8*>(key), length));
+                std::memcpy(temp, hash, 20);
+            }
+            else
+            {
+                std::memcpy(temp, key, length);
+            }
+
+            u8 pad[64];
+
+            for (int i = 0; i < 64; ++i)
+            {
+                pad[i] = temp[i] ^ 0x36;
+            }
+            m_inner.update(Memory(pad, 64));
+
+            for (int i = 0; i < 64; ++i)
+            {
+                pad[i] = temp[i] ^ 0x5c;
+            }
+            m_outer.update(Memory(pad, 64));
+        }
+
+        void update(const u8* data, size_t size)
+        {
+            m_inner.update(Memory(const_cast<u8*>(data), size));
+        }
+
+        void final(u8* digest)
+        {
+            u32 hash[5];
+            m_inner.final(hash);
+            m_outer.update(Memory(reinterpret_cast<u8*>(hash), 20));
+            m_outer.final(hash);
+            std::memcpy(digest, hash, 20);
+        }
+    };
+
+    void pbkdf2_sha1(u8* output, size_t length, const std::string& password, const u8* salt, size_t salt_length, int iterations)
+    {
+        // the keyed state is computed once and copied for every iteration
+        const HMAC_SHA1 prf(reinterpret_cast<const u8*>(password.data()), password.length());
+
+        for (u32 index = 1; length > 0; ++index)
+        {
+            u8 counter[4];
+            ustore32be(counter, index);
+
+            HMAC_SHA1 hmac = prf;
+            hmac.update(salt, salt_length);
+            hmac.update(counter, 4);
+
+            u8 u[20];
+            hmac.final(u);
+
+            u8 t[20];
+            std::memcpy(t, u, 20);
+
+            for (int i = 1; i < iterations; ++i)
+            {
+                hmac = prf;
+                hmac.update(u, 20);
+                hmac.final(u);
+
+                for (int j = 0; j < 20; ++j)
+                {
+                    t[j] ^= u[j];
+                }
+            }
+
+            const size_t bytes = std::min(length, size_t(20));
+            std::memcpy(output, t, bytes);
+            output += bytes;
+            length -= bytes;
+        }
+    }
+
+    struct KeyAES
+    {
+        int bits;
+        u8 key[32];
+        u8 mac[32];
+        u8 verify[AES_PWVERIFYSIZE];
+
+        KeyAES(const std::string& password, const u8* salt, u32 salt_length)
+        {
+            // the salt is half of the key length
+            const int length = salt_length * 2;
+            bits = length * 8;
+
+            u8 temp[32 * 2 + AES_PWVERIFYSIZE];
+            pbkdf2_sha1(temp, length * 2 + AES_PWVERIFYSIZE, password, salt, salt_length, AES_ITERATIONS);
+
+            std::memcpy(key, temp, length);
+            std::memcpy(mac, temp + length, length);
+            std::memcpy(verify, temp + length * 2, AES_PWVERIFYSIZE);
+        }
+    };
+
+    class DecryptorAES
+    {
+    protected:
+        AES m_aes;
+        HMAC_SHA1 m_hmac;
+        u64 m_counter;
+        std::vector<u8> m_keystream;
+
+    public:
+        DecryptorAES(const KeyAES& key)
+            : m_aes(key.key, key.bits)
+            , m_hmac(key.mac, key.bits / 8)
+            , m_counter(1)
+            , m_keystream(AES_CHUNKSIZE)
+        {
+        }
+
+        // size must be a multiple of 16 bytes except in the last call
+        void decrypt(u8* output, const u8* input, size_t size)
+        {
+            // authenticate before decrypting so that output can be same as input
+            m_hmac.update(input, size);
+
+            while (size > 0)
+            {
+                const size_t bytes = std::min(size, m_keystream.size());
+                const size_t blocks = (bytes + 15) / 16;
+                u8* keystream = m_keystream.data();
+
+                // WinZip uses a little endian counter starting from one
+                for (size_t i = 0; i < blocks; ++i)
+                {
+                    ustore64le(keystream + i * 16 + 0, m_counter++);
+                    ustore64le(keystream + i * 16 + 8, 0);
+                }
+
+                m_aes.ecb_block_encrypt(keystream, keystream, blocks * 16);
+
+                for (size_t i = 0; i < bytes; ++i)
+                {
+                    output[i] = input[i] ^ keystream[i];
+                }
+
+                output += bytes;
+                input += bytes;
+                size -= bytes;
+            }
+        }
+
+        bool verify(const u8* mac)
+        {
+            u8 digest[20];
+            m_hmac.final(digest);
+
+            // constant time comparison; the time does not tell how many bytes matched
+            u8 difference = 0;
+            for (int i = 0; i < AES_MACSIZE; ++i)
+            {
+                difference |= digest[i] ^ mac[i];
+            }
+
+            return difference == 0;
+        }
+    };
+
+    // decrypt and inflate in chunks so that the decrypted data is never stored in full
+    u64 zip_decompress_aes(DecryptorAES& decryptor, const u8* compressed, u8* uncompressed, u64 compressedLen, u64 uncompressedLen)
+    {
+		z_stream zstream;
+		std::memset(&zstream, 0, sizeof(zstream));
+
+        if (inflateInit2(&zstream, -MAX_WBITS) != Z_OK)
+		{
+            MANGO_EXCEPTION(ID"InflateInit failed.");
+		}
+
+        std::vector<u8> buffer(AES_CHUNKSIZE);
+
+		zstream.next_out = uncompressed;
+        int zcode = Z_OK;
+
+        while (compressedLen > 0)
+        {
+            const size_t bytes = size_t(std::min(compressedLen, u64(AES_CHUNKSIZE)));
+            decryptor.decrypt(buffer.data(), compressed, bytes);
+            compressed += bytes;
+            compressedLen -= bytes;
+
+            // the rest of the data is still authenticated if the stream ends early
+            zstream.next_in = buffer.data();
+            zstream.avail_in = uInt(bytes);
+
+            while (zcode == Z_OK && zstream.avail_in > 0)
+            {
+                if (!zstream.avail_out)
+                {
+                    // the output is given to inflate in 1 GB pieces to support 64 bit files
+                    const uInt size = uInt(std::min(uncompressedLen, u64(0x40000000)));
+                    zstream.avail_out = size;
+                    uncompressedLen -= size;
+                }
+
+                zcode = inflate(&zstream, Z_NO_FLUSH);
+            }
+        }
+
+        const u64 total = zstream.total_out;
+        inflateEnd(&zstream);
+
+		if (zcode != Z_STREAM_END)
+        {
+            zip_inflate_error(zcode);
+        }
+
+		return total;
+    }
+
 } // namespace
 
 namespace mango {
@@ -561,6 +830,269 @@ namespace filesystem {
         }
     };
 
+    // -----------------------------------------------------------------
+    // inflate pages
+    // -----------------------------------------------------------------
+
+    // The inflated entry is kept in pages from the operating system so that a released
+    // range can be given back without changing the address of the buffer.
+
+    size_t getPageSize()
+    {
+#if defined(MANGO_PLATFORM_WINDOWS)
+        static size_t size = [] {
+            SYSTEM_INFO info;
+            ::GetSystemInfo(&info);
+            return size_t(info.dwPageSize);
+        } ();
+        return size;
+#elif defined(MANGO_PLATFORM_UNIX)
+        static size_t size = size_t(::sysconf(_SC_PAGESIZE));
+        return size;
+#else
+        return 4096;
+#endif
+    }
+
+    u8* allocatePages(size_t size)
+    {
+#if defined(MANGO_PLATFORM_WINDOWS)
+        void* address = ::VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!address)
+        {
+            throw std::bad_alloc();
+        }
+        return reinterpret_cast<u8*>(address);
+#elif defined(MANGO_PLATFORM_UNIX)
+        void* address = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        return reinterpret_cast<u8*>(address);
+#else
+        return new u8[size];
+#endif
+    }
+
+    void freePages(u8* address, size_t size)
+    {
+#if defined(MANGO_PLATFORM_WINDOWS)
+        MANGO_UNREFERENCED_PARAMETER(size);
+        ::VirtualFree(address, 0, MEM_RELEASE);
+#elif defined(MANGO_PLATFORM_UNIX)
+        ::munmap(address, size);
+#else
+        MANGO_UNREFERENCED_PARAMETER(size);
+        delete [] address;
+#endif
+    }
+
+    // the pages stay mapped at the same address; the contents are undefined afterwards
+    void discardPages(u8* address, size_t size)
+    {
+        if (!size)
+        {
+            return;
+        }
+
+#if defined(MANGO_PLATFORM_WINDOWS)
+        ::VirtualAlloc(address, size, MEM_RESET, PAGE_READWRITE);
+#elif defined(MANGO_PLATFORM_UNIX)
+        ::madvise(address, size, MADV_DONTNEED);
+#else
+        MANGO_UNREFERENCED_PARAMETER(address);
+#endif
+    }
+
+    // -----------------------------------------------------------------
+    // VirtualMemoryInflate
+    // -----------------------------------------------------------------
+
+    // Deflate streams cannot be decoded from the middle so the entry is inflated
+    // sequentially up to the end of the requested range and the progress is kept.
+    //
+    // advise(DONTNEED) gives back the pages from the start of the released range to the
+    // end of the inflated data; the earlier data stays resident because the stream would
+    // have to be decoded again from the beginning to reach the released range. The
+    // address of the memory never changes so pointers handed out earlier stay valid to
+    // dereference, but the released contents are only defined again after the range has
+    // been acquired again.
+
+    class VirtualMemoryInflate : public mango::VirtualMemory
+    {
+    protected:
+        std::mutex m_mutex;
+        std::atomic<size_t> m_resident { 0 };
+        z_stream m_stream;
+        bool m_active { false };
+        u8* m_buffer { nullptr };
+        size_t m_buffer_size { 0 };
+        Memory m_compressed;
+        u8* m_delete_address;
+
+        enum { MINIMUM_STEP = 256 * 1024 };
+
+        size_t alignPage(size_t offset) const
+        {
+            const size_t mask = getPageSize() - 1;
+            return (offset + mask) & ~mask;
+        }
+
+        void initStream(size_t resident)
+        {
+            std::memset(&m_stream, 0, sizeof(m_stream));
+            m_stream.next_in = m_compressed.address;
+            m_stream.avail_in = uInt(m_compressed.size);
+
+            if (inflateInit2(&m_stream, -MAX_WBITS) != Z_OK)
+            {
+                MANGO_EXCEPTION(ID"InflateInit failed.");
+            }
+
+            m_active = true;
+
+            // the stream was restarted after a release; the resident data is decoded again
+            // into a scratch buffer to restore the decoder state (zlib keeps its own window)
+            std::vector<u8> scratch(std::min(resident, size_t(64 * 1024)));
+            size_t skipped = 0;
+
+            while (skipped < resident)
+            {
+                m_stream.next_out = scratch.data();
+                m_stream.avail_out = uInt(std::min(resident - skipped, scratch.size()));
+
+                int zcode = inflate(&m_stream, Z_NO_FLUSH);
+                skipped += size_t(m_stream.next_out - scratch.data());
+
+                if (zcode != Z_OK)
+                {
+                    zip_inflate_error(zcode == Z_STREAM_END ? Z_DATA_ERROR : zcode);
+                }
+            }
+        }
+
+        void materialize(size_t offset, size_t size) override
+        {
+            const size_t end = offset + size;
+            if (end <= m_resident.load(std::memory_order_acquire))
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            size_t resident = m_resident.load(std::memory_order_relaxed);
+            if (end <= resident)
+            {
+                return;
+            }
+
+            if (!m_buffer)
+            {
+                m_buffer_size = alignPage(m_memory.size);
+                m_buffer = allocatePages(m_buffer_size);
+                m_memory.address = m_buffer;
+            }
+
+            if (!m_active)
+            {
+                initStream(resident);
+            }
+
+            // inflate in reasonably large steps to amortize the calls for small ranges
+            const size_t target = std::min(m_memory.size, std::max(end, resident + MINIMUM_STEP));
+            bool finished = false;
+
+            while (resident < target)
+            {
+                m_stream.next_out = m_buffer + resident;
+                m_stream.avail_out = uInt(std::min(target - resident, size_t(1) << 30));
+
+                int zcode = inflate(&m_stream, Z_NO_FLUSH);
+                resident = size_t(m_stream.next_out - m_buffer);
+
+                if (zcode == Z_STREAM_END)
+                {
+                    finished = true;
+                    break;
+                }
+
+                if (zcode != Z_OK)
+                {
+                    zip_inflate_error(zcode);
+                }
+            }
+
+            if (finished || resident >= m_memory.size)
+            {
+                // the stream is complete
+                inflateEnd(&m_stream);
+                m_active = false;
+
+                if (resident != m_memory.size)
+                {
+                    MANGO_EXCEPTION(ID"Incorrect decompressed size.");
+                }
+            }
+
+            m_resident.store(resident, std::memory_order_release);
+        }
+
+    public:
+        VirtualMemoryInflate(Memory compressed, u8* delete_address, size_t size)
+            : m_compressed(compressed)
+            , m_delete_address(delete_address)
+        {
+            m_memory = Memory(nullptr, size);
+        }
+
+        ~VirtualMemoryInflate()
+        {
+            if (m_active)
+            {
+                inflateEnd(&m_stream);
+            }
+
+            if (m_buffer)
+            {
+                freePages(m_buffer, m_buffer_size);
+            }
+
+            delete [] m_delete_address;
+        }
+
+        void advise(Access access, size_t offset, size_t size) override
+        {
+            if (access != DONTNEED)
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            const size_t resident = m_resident.load(std::memory_order_relaxed);
+            offset = std::min(offset, m_memory.size);
+            const size_t end = size ? std::min(offset + size, m_memory.size) : m_memory.size;
+            const size_t start = alignPage(offset);
+
+            // only the tail of the inflated data can be given back (see above)
+            if (!m_buffer || end < resident || start >= resident)
+            {
+                return;
+            }
+
+            if (m_active)
+            {
+                inflateEnd(&m_stream);
+                m_active = false;
+            }
+
+            discardPages(m_buffer + start, alignPage(resident) - start);
+            m_resident.store(start, std::memory_order_release);
+        }
+    };
+
     // -----------------------------------------------------------------
     // MapperZIP
     // -----------------------------------------------------------------
@@ -572,6 +1104,10 @@ namespace filesystem {
         std::string m_password;
         Indexer<FileHeader> m_folders;
 
+        // the AES key derivation is slow by design so the keys are cached
+        std::map<std::string, KeyAES> m_keys;
+        std::mutex m_keys_mutex;
+
         MapperZIP(Memory parent, const std::string& password)
             : m_parent_memory(parent)
             , m_password(password)
@@ -611,6 +1147,23 @@ namespace filesystem {
         {
         }
 
+        KeyAES getKeyAES(const std::string& password, const u8* salt, u32 salt_length)
+        {
+            std::string id(1, char(salt_length));
+            id.append(reinterpret_cast<const char*>(salt), salt_length);
+            id.append(password);
+
+            std::lock_guard<std::mutex> lock(m_keys_mutex);
+
+            auto i = m_keys.find(id);
+            if (i == m_keys.end())
+            {
+                i = m_keys.emplace(id, KeyAES(password, salt, salt_length)).first;
+            }
+
+            return i->second;
+        }
+
         VirtualMemory* mmap(const FileHeader& header, u8* start, const std::string& password)
         {
             LittleEndianPointer p = start + header.localOffset;
@@ -628,6 +1181,10 @@ namespace filesystem {
 
             u8* buffer = nullptr; // remember allocated memory
 
+            // the encryption headers are not part of the compressed data
+            u64 compressed_size = header.compressedSize;
+            u16 compression = header.compression;
+
             //printf("[ZIP] compression: %d, encryption: %d \n", header.compression, header.encryption);
 
             switch (header.encryption)
@@ -640,12 +1197,12 @@ namespace filesystem {
                     // decryption header
                     u8* dcheader = address;
                     address += DCKEYSIZE;
+                    compressed_size -= DCKEYSIZE;
 
                     // NOTE: decryption capability reduced on 32 bit platforms
-                    const size_t compressed_size = size_t(header.compressedSize);
-                    buffer = new u8[compressed_size];
+                    buffer = new u8[size_t(compressed_size)];
 
-                    bool status = zip_decrypt(buffer, address, header.compressedSize, dcheader,
+                    bool status = zip_decrypt(buffer, address, compressed_size, dcheader,
                                             header.versionUsed & 0xff, header.crc, password);
                     if (!status)
                     {
@@ -661,31 +1218,74 @@ namespace filesystem {
                 case ENCRYPTION_AES192:
                 case ENCRYPTION_AES256:
                 {
-                    u32 salt_length = getSaltLength(header.encryption);
-                    MANGO_UNREFERENCED_PARAMETER(salt_length);
-                    MANGO_EXCEPTION(ID"AES encryption is not yet supported.");
-#if 0                
-                    u8* saltvalue = address;
+                    const u32 salt_length = getSaltLength(header.encryption);
+                    if (compressed_size < salt_length + AES_PWVERIFYSIZE + AES_MACSIZE)
+                    {
+                        MANGO_EXCEPTION(ID"Incorrect AES data.");
+                    }
+
+                    const u8* salt = address;
                     address += salt_length;
 
-                    u8* passverify = address;
+                    const u8* passverify = address;
                     address += AES_PWVERIFYSIZE;
 
-                    address += HMAC_LENGTH;
-
-                    size_t compressed_size = size_t(header.compressedSize);
                     compressed_size -= salt_length;
                     compressed_size -= AES_PWVERIFYSIZE;
-                    compressed_size -= HMAC_LENGTH;
+                    compressed_size -= AES_MACSIZE;
+
+                    const u8* mac = address + compressed_size;
+
+                    const KeyAES key = getKeyAES(password, salt, salt_length);
+                    if (std::memcmp(key.verify, passverify, AES_PWVERIFYSIZE))
+                    {
+                        MANGO_EXCEPTION(ID"Decryption failed (probably incorrect password).");
+                    }
+
+                    DecryptorAES decryptor(key);
+
+                    if (compression == COMPRESSION_DEFLATE)
+                    {
+                        // decrypt and inflate directly into the output buffer
+                        buffer = new u8[size_t(header.uncompressedSize)];
+
+                        u64 outsize = 0;
+                        try
+                        {
+                            outsize = zip_decompress_aes(decryptor, address, buffer, compressed_size, header.uncompressedSize);
+                        }
+                        catch (...)
+                        {
+                            delete[] buffer;
+                            throw;
+                        }
+
+                        if (outsize != header.uncompressedSize)
+                        {
+                            delete[] buffer;
+                            MANGO_EXCEPTION(ID"Incorrect decompressed size.");
+                        }
+
+                        compression = COMPRESSION_NONE;
+                    }
+                    else
+                    {
+                        buffer = new u8[size_t(compressed_size)];
+                        decryptor.decrypt(buffer, address, size_t(compressed_size));
+                    }
+
+                    if (!decryptor.verify(mac))
+                    {
+                        delete[] buffer;
+                        MANGO_EXCEPTION(ID"Decryption failed (authentication code does not match).");
+                    }
 
-                    // TODO: password + salt --> key
-                    // TODO: decrypt using the generated key
-#endif                
+                    address = buffer;
                     break;
                 }
             }
 
-            switch (header.compression)
+            switch (compression)
             {
                 case COMPRESSION_NONE:
                     size = header.uncompressedSize;
@@ -694,9 +1294,16 @@ namespace filesystem {
                 case COMPRESSION_DEFLATE:
                 {
                     const size_t uncompressed_size = size_t(header.uncompressedSize);
+
+                    if (uncompressed_size >= zip_lazy_threshold)
+                    {
+                        // large entries are inflated on demand
+                        return new VirtualMemoryInflate(Memory(address, size_t(compressed_size)), buffer, uncompressed_size);
+                    }
+
                     u8* uncompressed_buffer = new u8[uncompressed_size];
 
-                    u64 outsize = zip_decompress(address, uncompressed_buffer, header.compressedSize, header.uncompressedSize);
+                    u64 outsize = zip_decompress(address, uncompressed_buffer, compressed_size, header.uncompressedSize);
 
                     delete[] buffer;
                     buffer = uncompressed_buffer;
@@ -729,9 +1336,7 @@ namespace filesystem {
                         MANGO_EXCEPTION(ID"Incorrect LZMA header.");
                     }
                     address = p;
-                    u64 compressed_size = header.compressedSize - 4;
-
-                    lzma::decompress(Memory(uncompressed_buffer, size_t(header.uncompressedSize)), Memory(address, size_t(compressed_size)));
+                    lzma::decompress(Memory(uncompressed_buffer, size_t(header.uncompressedSize)), Memory(address, size_t(compressed_size - 4)));
 
                     delete[] buffer;
                     buffer = uncompressed_buffer;
@@ -747,7 +1352,7 @@ namespace filesystem {
                     const std::size_t uncompressed_size = static_cast<std::size_t>(header.uncompressedSize);
                     u8* uncompressed_buffer = new u8[uncompressed_size];
 
-                    ppmd8::decompress(Memory(uncompressed_buffer, size_t(header.uncompressedSize)), Memory(address, size_t(header.compressedSize)));
+                    ppmd8::decompress(Memory(uncompressed_buffer, size_t(header.uncompressedSize)), Memory(address, size_t(compressed_size)));
 
                     delete[] buffer;
                     buffer = uncompressed_buffer;
@@ -763,7 +1368,24 @@ namespace filesystem {
                     const std::size_t uncompressed_size = static_cast<std::size_t>(header.uncompressedSize);
                     u8* uncompressed_buffer = new u8[uncompressed_size];
 
-                    bzip2::decompress(Memory(uncompressed_buffer, size_t(header.uncompressedSize)), Memory(address, size_t(header.compressedSize)));
+                    bzip2::decompress(Memory(uncompressed_buffer, size_t(header.uncompressedSize)), Memory(address, size_t(compressed_size)));
+
+                    delete[] buffer;
+                    buffer = uncompressed_buffer;
+
+                    // use decode_buffer as memory map
+                    address = buffer;
+                    size = header.uncompressedSize;
+                    break;
+                }
+
+#ifdef MANGO_ENABLE_LICENSE_BSD
+                case COMPRESSION_ZSTD:
+                {
+                    const std::size_t uncompressed_size = static_cast<std::size_t>(header.uncompressedSize);
+                    u8* uncompressed_buffer = new u8[uncompressed_size];
+
+                    zstd::decompress(Memory(uncompressed_buffer, size_t(header.uncompressedSize)), Memory(address, size_t(compressed_size)));
 
                     delete[] buffer;
                     buffer = uncompressed_buffer;
@@ -773,16 +1395,27 @@ namespace filesystem {
                     size = header.uncompressedSize;
                     break;
                 }
+#endif
 
                 case COMPRESSION_DEFLATE64:
                 case COMPRESSION_WAVPACK:
                 case COMPRESSION_JPEG:
                 case COMPRESSION_AES:
                 case COMPRESSION_XZ:
-                    MANGO_EXCEPTION(ID"Unsupported compression algorithm (%d).", header.compression);
+                    MANGO_EXCEPTION(ID"Unsupported compression algorithm (%d).", compression);
                     break;
             }
 
+            if (header.aesVersion == 1)
+            {
+                // AE-1 stores the crc of the plaintext in addition to the authentication code
+                if (u32(crc32(0, address, size_t(size))) != header.crc)
+                {
+                    delete[] buffer;
+                    MANGO_EXCEPTION(ID"Decryption failed (crc does not match).");
+                }
+            }
+
             VirtualMemory* memory;
             if (buffer)
             {
@@ -806,6 +1439,20 @@ namespace filesystem {
             return false;
         }
 
+        void mmapBatch(const std::vector<std::string>& filenames, BatchCallback callback) override
+        {
+            // schedule in the order of the local headers for sequential access to the parent memory
+            std::vector<u64> keys;
+
+            for (auto& filename : filenames)
+            {
+                const FileHeader* ptrHeader = m_folders.getHeader(filename);
+                keys.push_back(ptrHeader ? ptrHeader->localOffset : ~u64(0));
+            }
+
+            mmapBatchOrdered(filenames, keys, callback);
+        }
+
         void getIndex(FileIndex& index, const std::string& pathname) override
         {
             const Indexer<FileHeader>::Folder* ptrFolder = m_folders.getFolder(pathname);
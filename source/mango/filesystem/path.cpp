@@ -36,6 +36,7 @@ namespace filesystem {
     {
         // use parent's mapper
         m_mapper = path.m_mapper;
+        m_container = path.m_container;
 
 		// parse and create mappers
         std::string temp = path.m_basepath + pathname;
@@ -68,6 +69,14 @@ namespace filesystem {
     {
     }
 
+    void Path::getIndexRecursive(CompactFileIndex& index, const IndexFilter& filter) const
+    {
+        if (m_mapper)
+        {
+            m_mapper->getIndexRecursive(index, m_basepath, filter);
+        }
+    }
+
     // -----------------------------------------------------------------
     // filename manipulation functions
     // -----------------------------------------------------------------
@@ -16,7 +16,11 @@
 // -----------------------------------------------------------------
 
 #include <thread>
+#include <string>
+#include <unordered_map>
 #include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
 #include <unistd.h>
 #include <limits.h>
 
@@ -26,7 +30,8 @@ namespace filesystem {
     enum
     {
         EVENT_SIZE  = sizeof(inotify_event),
-        BUFFER_SIZE = (EVENT_SIZE + PATH_MAX + 1) * 32
+        BUFFER_SIZE = (EVENT_SIZE + PATH_MAX + 1) * 32,
+        EVENT_MASK  = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY
     };
 
 	struct FileObserverState
@@ -34,113 +39,213 @@ namespace filesystem {
         FileObserver* m_observer;
 		int m_notify;
 		int m_watch;
+        std::string m_pathname;
+        bool m_recursive;
+
+        // watched folders relative to m_pathname; only the observer thread
+        // modifies the map once it has been started
+        std::unordered_map<int, std::string> m_folders;
+
         std::thread m_thread;
 
-        FileObserverState(FileObserver* observer, int notify, int watch)
+        FileObserverState(FileObserver* observer, int notify, const std::string& pathname, bool recursive)
             : m_observer(observer)
             , m_notify(notify)
-            , m_watch(watch)
+            , m_watch(-1)
+            , m_pathname(pathname)
+            , m_recursive(recursive)
         {
+            if (!m_pathname.empty() && m_pathname.back() != '/')
+            {
+                m_pathname += '/';
+            }
+
+            m_watch = addWatch("");
+            if (m_watch < 0)
+            {
+                close(m_notify);
+                MANGO_EXCEPTION("[FileObserver] inotify_add_watch() failed.");
+            }
+
             // launch inotify handler in it's own thread
-            m_thread = std::thread([] (FileObserver* observer, int notify, int watch)
+            m_thread = std::thread([this]
             {
-                for (;;)
-                {
-                    char buffer[BUFFER_SIZE];
+                run();
+            });
+        }
 
-                    // read events (this call is blocking and the reason why the observer is threaded)
-                    int length = read(notify, buffer, BUFFER_SIZE);
-                    if (length < 0)
+        ~FileObserverState()
+        {
+            inotify_rm_watch(m_notify, m_watch);
+            m_thread.join();
+            close(m_notify);
+        }
+
+        int addWatch(const std::string& folder)
+        {
+            const std::string pathname = m_pathname + folder;
+
+            int watch = inotify_add_watch(m_notify, pathname.c_str(), EVENT_MASK);
+            if (watch < 0)
+            {
+                return watch;
+            }
+
+            m_folders[watch] = folder;
+
+            if (m_recursive)
+            {
+                DIR* dir = opendir(pathname.c_str());
+                if (dir)
+                {
+                    while (dirent* dp = readdir(dir))
                     {
-                        return;
+                        const std::string name = dp->d_name;
+                        if (name == "." || name == "..")
+                        {
+                            continue;
+                        }
+
+                        bool is_directory = dp->d_type == DT_DIR;
+                        if (dp->d_type == DT_UNKNOWN)
+                        {
+                            struct stat s;
+                            is_directory = !lstat((pathname + name).c_str(), &s) && S_ISDIR(s.st_mode);
+                        }
+
+                        if (is_directory)
+                        {
+                            addWatch(folder + name + "/");
+                        }
                     }
+                    closedir(dir);
+                }
+            }
 
-                    char* ptr = buffer;
-                    char* end = buffer + length;
+            return watch;
+        }
 
-                    while (ptr < end)
+        void removeWatches(const std::string& folder)
+        {
+            for (auto i = m_folders.begin(); i != m_folders.end(); )
+            {
+                if (!i->second.compare(0, folder.length(), folder))
+                {
+                    inotify_rm_watch(m_notify, i->first);
+                    i = m_folders.erase(i);
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+
+        void run()
+        {
+            FileObserver* observer = m_observer;
+
+            for (;;)
+            {
+                char buffer[BUFFER_SIZE];
+
+                // read events (this call is blocking and the reason why the observer is threaded)
+                int length = read(m_notify, buffer, BUFFER_SIZE);
+                if (length < 0)
+                {
+                    return;
+                }
+
+                char* ptr = buffer;
+                char* end = buffer + length;
+
+                while (ptr < end)
+                {
+                    // extract one event
+                    inotify_event* event = (inotify_event *)ptr;
+                    ptr += (EVENT_SIZE + event->len);
+
+                    if (event->mask & IN_Q_OVERFLOW)
                     {
-                        // extract one event
-                        inotify_event* event = (inotify_event *)ptr;
-                        ptr += (EVENT_SIZE + event->len);
+                        // events were lost; report a change notification
+                        observer->onEvent(0, "");
+                        continue;
+                    }
 
-                        if (event->mask & IN_IGNORED)
+                    if (event->mask & IN_IGNORED)
+                    {
+                        if (event->wd == m_watch)
                         {
                             // watch was deleted
                             return;
                         }
 
-                        // process event
-                        if (event->len)
+                        // watched sub-folder was deleted
+                        m_folders.erase(event->wd);
+                        continue;
+                    }
+
+                    // process event
+                    if (event->len)
+                    {
+                        // events can still arrive for a watch which was removed with its folder
+                        auto folder = m_folders.find(event->wd);
+                        if (folder == m_folders.end())
                         {
-                            std::string filename = event->name;
-                            u32 flags = 0;
+                            continue;
+                        }
 
-                            if (event->mask & IN_ISDIR)
-                            {
-                                flags |= FileObserver::DIRECTORY;
-                            }
-                            else
-                            {
-                                flags |= FileObserver::FILE;
-                            }
+                        std::string filename = folder->second + event->name;
+                        u32 flags = 0;
 
-                            if (event->mask & IN_CREATE)
-                            {
-                                flags |= FileObserver::CREATED;
-                                observer->onEvent(flags, filename);
-                            }
-                            else if (event->mask & IN_DELETE)
-                            {
-                                flags |= FileObserver::DELETED;
-                                observer->onEvent(flags, filename);
-                            }
-                            else if (event->mask & IN_MOVED_FROM)
-                            {
-                                flags |= FileObserver::DELETED;
-                                observer->onEvent(flags, filename);
-                            }
-                            else if (event->mask & IN_MOVED_TO)
-                            {
-                                flags |= FileObserver::CREATED;
-                                observer->onEvent(flags, filename);
-                            }
-                            else if (event->mask & IN_MODIFY)
-                            {
-                                flags |= FileObserver::MODIFIED;
-                                observer->onEvent(flags, filename);
-                            }
-#if 0
-                            else if (event->mask & IN_OPEN)
-                            {
-                            }
-                            else if (event->mask & IN_CLOSE)
-                            {
-                            }
-                            else if (event->mask & IN_ACCESS)
-                            {
-                            }
-                            else if (event->mask & IN_ATTRIB)
-                            {
-                            }
-                            else if (event->mask & IN_DELETE_SELF)
+                        if (event->mask & IN_ISDIR)
+                        {
+                            flags |= FileObserver::DIRECTORY;
+
+                            if (m_recursive && event->mask & IN_MOVED_FROM)
                             {
+                                // the watches follow the folder; a folder moved inside the tree is watched again
+                                removeWatches(filename + "/");
                             }
-                            else if (event->mask & IN_MOVE_SELF)
+
+                            if (m_recursive && event->mask & (IN_CREATE | IN_MOVED_TO))
                             {
+                                addWatch(filename + "/");
                             }
-#endif
+                        }
+                        else
+                        {
+                            flags |= FileObserver::FILE;
+                        }
+
+                        if (event->mask & IN_CREATE)
+                        {
+                            flags |= FileObserver::CREATED;
+                            observer->onEvent(flags, filename);
+                        }
+                        else if (event->mask & IN_DELETE)
+                        {
+                            flags |= FileObserver::DELETED;
+                            observer->onEvent(flags, filename);
+                        }
+                        else if (event->mask & IN_MOVED_FROM)
+                        {
+                            flags |= FileObserver::DELETED;
+                            observer->onEvent(flags, filename);
+                        }
+                        else if (event->mask & IN_MOVED_TO)
+                        {
+                            flags |= FileObserver::CREATED;
+                            observer->onEvent(flags, filename);
+                        }
+                        else if (event->mask & IN_MODIFY)
+                        {
+                            flags |= FileObserver::MODIFIED;
+                            observer->onEvent(flags, filename);
                         }
                     }
                 }
-            }, m_observer, m_notify, m_watch);
-        }
-
-        ~FileObserverState()
-        {
-            inotify_rm_watch(m_notify, m_watch);
-            m_thread.join();
-            close(m_notify);
+            }
         }
 	};
 
@@ -158,7 +263,7 @@ namespace filesystem {
         stop();
 	}
 
-    void FileObserver::start(const std::string& pathname)
+    void FileObserver::start(const std::string& pathname, bool recursive)
     {
         stop();
 
@@ -168,13 +273,7 @@ namespace filesystem {
             MANGO_EXCEPTION("[FileObserver] inotify_init() failed.");
         }
 
-        int watch = inotify_add_watch(notify, pathname.c_str(), IN_ALL_EVENTS);
-        if (watch < 0)
-        {
-            MANGO_EXCEPTION("[FileObserver] inotify_init() failed.");
-        }
-
-        m_state = new FileObserverState(this, notify, watch);
+        m_state = new FileObserverState(this, notify, pathname, recursive);
     }
 
     void FileObserver::stop()
@@ -274,8 +373,11 @@ namespace filesystem {
         stop();
     }
 
-    void FileObserver::start(const std::string& pathname)
+    void FileObserver::start(const std::string& pathname, bool recursive)
     {
+        // kqueue does not report the filenames; sub-folders are not watched
+        MANGO_UNREFERENCED_PARAMETER(recursive);
+
         stop();
         m_state = new FileObserverState(pathname, this);
     }
@@ -312,9 +414,10 @@ namespace filesystem {
     {
     }
 
-    void FileObserver::start(const std::string& pathname)
+    void FileObserver::start(const std::string& pathname, bool recursive)
     {
         MANGO_UNREFERENCED_PARAMETER(pathname);
+        MANGO_UNREFERENCED_PARAMETER(recursive);
     }
 
     void FileObserver::stop()
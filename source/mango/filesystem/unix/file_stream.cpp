@@ -6,11 +6,19 @@
 #define _FILE_OFFSET_BITS 64 /* LFS: 64 bit off_t */
 #endif
 #include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
 #include <mango/core/string.hpp>
 #include <mango/core/exception.hpp>
+#include <mango/core/thread.hpp>
 #include <mango/filesystem/file.hpp>
 
 #define ID "[FileStream] "
@@ -24,54 +32,552 @@ namespace filesystem {
 
 	struct FileHandle
 	{
-		FILE* m_file;
         std::string m_filename;
 
-        FileHandle(const std::string& filename, const char* mode)
-            : m_file(std::fopen(filename.c_str(), mode))
-            , m_filename(filename)
-		{
-		}
+        FileHandle(const std::string& filename)
+            : m_filename(filename)
+        {
+        }
 
-		~FileHandle()
-		{
-            std::fclose(m_file);
-		}
+        virtual ~FileHandle()
+        {
+        }
 
         const std::string& filename() const
         {
             return m_filename;
         }
 
-        u64 size() const
+        virtual u64 size() const = 0;
+        virtual u64 offset() const = 0;
+        virtual void seek(u64 distance, int method) = 0;
+        virtual void read(void* dest, size_t size) = 0;
+        virtual void write(const void* data, size_t size) = 0;
+	};
+
+    // -----------------------------------------------------------------
+	// StdioFileHandle
+    // -----------------------------------------------------------------
+
+	struct StdioFileHandle : FileHandle
+	{
+		FILE* m_file;
+
+        // tracked so that size() and offset() do not need system calls
+        u64 m_size { 0 };
+        u64 m_offset { 0 };
+
+        StdioFileHandle(const std::string& filename, const char* mode)
+            : FileHandle(filename)
+            , m_file(std::fopen(filename.c_str(), mode))
 		{
             struct stat sb;
-            int fd = ::fileno(m_file);
-            ::fflush(m_file);
-            ::fstat(fd, &sb);
-            return sb.st_size;
+            if (m_file && !::fstat(::fileno(m_file), &sb))
+            {
+                m_size = sb.st_size;
+            }
+		}
+
+		~StdioFileHandle()
+		{
+            std::fclose(m_file);
+		}
+
+        u64 size() const override
+		{
+            return m_size;
 		}
 
-		u64 offset() const
+		u64 offset() const override
 		{
-	        return ftello(m_file);
+	        return m_offset;
 		}
 
-		void seek(u64 distance, int method)
+		void seek(u64 distance, int method) override
 		{
 	        fseeko(m_file, distance, method);
+
+            switch (method)
+            {
+                case SEEK_SET:
+                    m_offset = distance;
+                    break;
+                case SEEK_CUR:
+                    m_offset += distance;
+                    break;
+                case SEEK_END:
+                    m_offset = m_size + distance;
+                    break;
+            }
 		}
 
-	    void read(void* dest, size_t size)
+	    void read(void* dest, size_t size) override
 	    {
     	    size_t status = std::fread(dest, 1, size, m_file);
-	        MANGO_UNREFERENCED_PARAMETER(status);
+            m_offset += status;
 	    }
 
-	    void write(const void* data, size_t size)
+	    void write(const void* data, size_t size) override
 	    {
 	        size_t status = std::fwrite(data, 1, size, m_file);
-	        MANGO_UNREFERENCED_PARAMETER(status);
+            m_offset += status;
+            m_size = std::max(m_size, m_offset);
+	    }
+	};
+
+    // -----------------------------------------------------------------
+	// AsyncFileHandle
+    // -----------------------------------------------------------------
+
+    /*
+        The file is transferred in large aligned blocks by a SerialQueue. Writes fill
+        a block and hand it to the queue for pwrite() while the caller continues with
+        the next block; reads consume blocks which the queue has read ahead with pread().
+        With O_DIRECT the blocks bypass the page cache; a block which cannot satisfy
+        the O_DIRECT alignment rules (after a seek) turns the flag off for the file.
+    */
+
+	struct AsyncFileHandle : FileHandle
+	{
+        enum
+        {
+            BLOCK_SIZE = 4 * 1024 * 1024,
+            BLOCK_COUNT = 3,
+            ALIGNMENT = 4096
+        };
+
+        struct Block
+        {
+            u8* data;
+            u64 offset;
+            size_t size;
+            bool ready;
+        };
+
+        int m_file;
+        bool m_write;
+        bool m_direct;
+        bool m_truncate { false };
+
+        u64 m_size { 0 };
+        u64 m_offset { 0 };
+
+        Block m_blocks[BLOCK_COUNT];
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        int m_pending { 0 };
+        int m_error { 0 };
+
+        // write-behind
+        std::deque<Block*> m_free;
+        Block* m_current { nullptr };
+
+        // read-ahead
+        size_t m_index { 0 };
+        u64 m_next { 0 };
+
+        SerialQueue m_queue;
+
+        AsyncFileHandle(const std::string& filename, bool write, bool direct)
+            : FileHandle(filename)
+            , m_write(write)
+            , m_direct(false)
+            , m_queue("file.stream")
+        {
+            int flags = write ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY;
+
+            m_file = -1;
+
+#if defined(O_DIRECT)
+            if (direct)
+            {
+                m_file = ::open(filename.c_str(), flags | O_DIRECT, 0644);
+                m_direct = m_file != -1;
+            }
+#endif
+
+            if (m_file == -1)
+            {
+                // O_DIRECT is not supported by all filesystems
+                m_file = ::open(filename.c_str(), flags, 0644);
+            }
+
+            if (m_file == -1)
+            {
+                MANGO_EXCEPTION(ID"Cannot open \"%s\" (%s).", filename.c_str(), std::strerror(errno));
+            }
+
+#if defined(F_NOCACHE)
+            if (direct)
+            {
+                ::fcntl(m_file, F_NOCACHE, 1);
+            }
+#endif
+
+            for (auto& block : m_blocks)
+            {
+                block.data = reinterpret_cast<u8*>(aligned_malloc(BLOCK_SIZE, ALIGNMENT));
+                block.offset = 0;
+                block.size = 0;
+                block.ready = true;
+            }
+
+            if (m_write)
+            {
+                for (auto& block : m_blocks)
+                {
+                    m_free.push_back(&block);
+                }
+            }
+            else
+            {
+                struct stat sb;
+                if (!::fstat(m_file, &sb))
+                {
+                    m_size = sb.st_size;
+                }
+
+                start(0);
+            }
+        }
+
+        ~AsyncFileHandle()
+        {
+            if (m_write)
+            {
+                flush(true);
+
+                if (m_truncate)
+                {
+                    // remove the padding of the last O_DIRECT block
+                    int status = ::ftruncate(m_file, m_size);
+                    MANGO_UNREFERENCED_PARAMETER(status);
+                }
+            }
+            else
+            {
+                drain();
+            }
+
+            ::close(m_file);
+
+            for (auto& block : m_blocks)
+            {
+                aligned_free(block.data);
+            }
+        }
+
+        void drain()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_pending == 0; });
+        }
+
+        void complete(Block* block, int error)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (error && !m_error)
+            {
+                m_error = error;
+            }
+            block->ready = true;
+            if (m_write)
+            {
+                m_free.push_back(block);
+            }
+            --m_pending;
+            m_condition.notify_all();
+        }
+
+        void checkError()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_error)
+            {
+                MANGO_EXCEPTION(ID"I/O error in \"%s\" (%s).", m_filename.c_str(), std::strerror(m_error));
+            }
+        }
+
+        // -------------------------------------------------------------
+        // write-behind
+        // -------------------------------------------------------------
+
+        void submit(bool last)
+        {
+            Block* block = m_current;
+            m_current = nullptr;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                block->ready = false;
+                ++m_pending;
+            }
+
+            // only a block which ends the file can be padded; padding any other block
+            // would overwrite the data after it, for example after seeking back to patch a header
+            const bool tail = last && block->offset + block->size >= m_size;
+
+            m_queue.enqueue([this, block, tail]
+            {
+                size_t size = block->size;
+
+                if (m_direct)
+                {
+                    const bool aligned = (block->offset % ALIGNMENT) == 0;
+
+                    if (tail && aligned)
+                    {
+                        // pad the tail; the file is truncated when it is closed
+                        size_t padded = (size + ALIGNMENT - 1) & ~size_t(ALIGNMENT - 1);
+                        std::memset(block->data + size, 0, padded - size);
+                        m_truncate = padded != size;
+                        size = padded;
+                    }
+                    else if (!aligned || (size % ALIGNMENT) != 0)
+                    {
+#if defined(O_DIRECT)
+                        ::fcntl(m_file, F_SETFL, ::fcntl(m_file, F_GETFL) & ~O_DIRECT);
+#endif
+                        m_direct = false;
+                    }
+                }
+
+                int error = 0;
+
+                for (size_t done = 0; done < size; )
+                {
+                    ssize_t bytes = ::pwrite(m_file, block->data + done, size - done, off_t(block->offset + done));
+                    if (bytes < 0)
+                    {
+                        if (errno == EINTR)
+                            continue;
+                        error = errno;
+                        break;
+                    }
+                    done += size_t(bytes);
+                }
+
+                complete(block, error);
+            });
+        }
+
+        void flush(bool last)
+        {
+            if (m_current)
+            {
+                if (m_current->size)
+                {
+                    submit(last);
+                }
+                else
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_free.push_back(m_current);
+                    m_current = nullptr;
+                }
+            }
+
+            drain();
+        }
+
+        // -------------------------------------------------------------
+        // read-ahead
+        // -------------------------------------------------------------
+
+        void schedule(Block* block, u64 offset)
+        {
+            block->offset = offset;
+            block->size = 0;
+
+            if (offset >= m_size)
+            {
+                block->ready = true;
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                block->ready = false;
+                ++m_pending;
+            }
+
+            m_queue.enqueue([this, block]
+            {
+                int error = 0;
+                size_t done = 0;
+
+                // stop at the end of file; O_DIRECT would reject the unaligned offset
+                while (done < BLOCK_SIZE && block->offset + done < m_size)
+                {
+                    ssize_t bytes = ::pread(m_file, block->data + done, BLOCK_SIZE - done, off_t(block->offset + done));
+                    if (bytes < 0)
+                    {
+                        if (errno == EINTR)
+                            continue;
+                        error = errno;
+                        break;
+                    }
+                    if (!bytes)
+                        break;
+                    done += size_t(bytes);
+                }
+
+                block->size = done;
+                complete(block, error);
+            });
+        }
+
+        void start(u64 offset)
+        {
+            drain();
+
+            const u64 base = offset - offset % BLOCK_SIZE;
+
+            for (size_t i = 0; i < BLOCK_COUNT; ++i)
+            {
+                schedule(&m_blocks[i], base + i * BLOCK_SIZE);
+            }
+
+            m_index = 0;
+            m_next = base + BLOCK_COUNT * BLOCK_SIZE;
+        }
+
+        // -------------------------------------------------------------
+        // FileHandle
+        // -------------------------------------------------------------
+
+        u64 size() const override
+		{
+            return m_size;
+		}
+
+		u64 offset() const override
+		{
+	        return m_offset;
+		}
+
+		void seek(u64 distance, int method) override
+		{
+            u64 offset = m_offset;
+
+            switch (method)
+            {
+                case SEEK_SET:
+                    offset = distance;
+                    break;
+                case SEEK_CUR:
+                    offset += distance;
+                    break;
+                case SEEK_END:
+                    offset = m_size + distance;
+                    break;
+            }
+
+            if (offset == m_offset)
+            {
+                return;
+            }
+
+            if (m_write)
+            {
+                flush(false);
+            }
+            else
+            {
+                const Block& block = m_blocks[m_index];
+                if (offset < block.offset || offset >= block.offset + BLOCK_SIZE)
+                {
+                    start(offset);
+                }
+            }
+
+            m_offset = offset;
+		}
+
+	    void read(void* dest, size_t size) override
+	    {
+            if (m_write)
+            {
+                MANGO_EXCEPTION(ID"The stream is not readable.");
+            }
+
+            u8* output = reinterpret_cast<u8*>(dest);
+
+            while (size > 0 && m_offset < m_size)
+            {
+                Block* block = &m_blocks[m_index];
+
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_condition.wait(lock, [block] { return block->ready; });
+                }
+
+                checkError();
+
+                const u64 end = block->offset + block->size;
+                if (m_offset >= end)
+                {
+                    if (block->size < BLOCK_SIZE)
+                    {
+                        // end of file
+                        break;
+                    }
+
+                    // the block has been consumed; read ahead into it
+                    schedule(block, m_next);
+                    m_next += BLOCK_SIZE;
+                    m_index = (m_index + 1) % BLOCK_COUNT;
+                    continue;
+                }
+
+                size_t bytes = size_t(std::min(u64(size), end - m_offset));
+                std::memcpy(output, block->data + (m_offset - block->offset), bytes);
+
+                output += bytes;
+                size -= bytes;
+                m_offset += bytes;
+            }
+	    }
+
+	    void write(const void* data, size_t size) override
+	    {
+            if (!m_write)
+            {
+                MANGO_EXCEPTION(ID"The stream is not writable.");
+            }
+
+            checkError();
+
+            const u8* source = reinterpret_cast<const u8*>(data);
+
+            while (size > 0)
+            {
+                if (!m_current)
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_condition.wait(lock, [this] { return !m_free.empty(); });
+
+                    m_current = m_free.front();
+                    m_free.pop_front();
+                    m_current->offset = m_offset;
+                    m_current->size = 0;
+                }
+
+                size_t bytes = std::min(size, BLOCK_SIZE - m_current->size);
+                std::memcpy(m_current->data + m_current->size, source, bytes);
+
+                m_current->size += bytes;
+                source += bytes;
+                size -= bytes;
+                m_offset += bytes;
+
+                if (m_current->size == BLOCK_SIZE)
+                {
+                    submit(false);
+                }
+            }
+
+            m_size = std::max(m_size, m_offset);
 	    }
 	};
 
@@ -79,7 +585,7 @@ namespace filesystem {
     // FileStream
     // -----------------------------------------------------------------
 
-    FileStream::FileStream(const std::string& filename, OpenMode openmode)
+    FileStream::FileStream(const std::string& filename, OpenMode openmode, Buffering buffering)
         : m_handle(nullptr)
     {
 		const char* mode;
@@ -99,7 +605,14 @@ namespace filesystem {
                 break;
         }
 
-		m_handle = new FileHandle(filename, mode);
+        if (buffering == STDIO)
+        {
+		    m_handle = new StdioFileHandle(filename, mode);
+        }
+        else
+        {
+		    m_handle = new AsyncFileHandle(filename, openmode == WRITE, buffering == DIRECT);
+        }
     }
 
     FileStream::~FileStream()
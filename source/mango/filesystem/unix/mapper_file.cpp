@@ -4,11 +4,17 @@
 */
 #include <mango/core/exception.hpp>
 #include <mango/core/string.hpp>
+#include <mango/core/thread.hpp>
 #include <mango/filesystem/mapper.hpp>
 #include <mango/filesystem/path.hpp>
 
 #define ID "[mapper.file] "
 
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <functional>
+#include <cerrno>
 #include <dirent.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -42,6 +48,47 @@ namespace
         int m_file;
 		size_t m_size;
 		void* m_address;
+        std::unique_ptr<ConcurrentQueue> m_prefetch;
+
+        bool getRange(u8*& address, size_t& length, size_t offset, size_t size) const
+        {
+            if (offset >= m_memory.size)
+            {
+                return false;
+            }
+
+            size = size ? std::min(size, m_memory.size - offset) : m_memory.size - offset;
+
+            // madvise() requires page aligned address
+            const uintptr_t mask = uintptr_t(get_pagesize() - 1);
+            uintptr_t begin = uintptr_t(m_memory.address + offset) & ~mask;
+            uintptr_t end = uintptr_t(m_memory.address + offset + size);
+
+            address = reinterpret_cast<u8*>(begin);
+            length = size_t(end - begin);
+            return true;
+        }
+
+        void populate(u8* address, size_t length) const
+        {
+#ifdef MADV_POPULATE_READ
+            if (::madvise(address, length, MADV_POPULATE_READ) == 0)
+            {
+                return;
+            }
+#endif
+            // fallback for kernels older than 5.14: start read-ahead and touch every page
+            ::madvise(address, length, MADV_WILLNEED);
+
+            const size_t page_size = size_t(get_pagesize());
+            volatile const u8* p = address;
+            u8 sum = 0;
+            for (size_t i = 0; i < length; i += page_size)
+            {
+                sum += p[i];
+            }
+            MANGO_UNREFERENCED_PARAMETER(sum);
+        }
 
     public:
         FileMemory(const std::string& filename, u64 _offset, u64 _size)
@@ -107,6 +154,13 @@ namespace
 
         ~FileMemory()
         {
+            if (m_prefetch)
+            {
+                // pending prefetches must not touch the memory after it has been unmapped
+                m_prefetch->cancel();
+                m_prefetch.reset();
+            }
+
             if (m_address)
             {
                 ::munmap(m_address, m_size);
@@ -117,37 +171,144 @@ namespace
                 ::close(m_file);
             }
         }
+
+        void advise(Access access, size_t offset, size_t size) override
+        {
+            u8* address;
+            size_t length;
+
+            if (!getRange(address, length, offset, size))
+            {
+                return;
+            }
+
+            switch (access)
+            {
+                case NORMAL:
+                    ::madvise(address, length, MADV_NORMAL);
+                    break;
+                case SEQUENTIAL:
+                    ::madvise(address, length, MADV_SEQUENTIAL);
+                    break;
+                case RANDOM:
+                    ::madvise(address, length, MADV_RANDOM);
+                    break;
+                case WILLNEED:
+                    ::madvise(address, length, MADV_WILLNEED);
+                    break;
+                case DONTNEED:
+                    ::madvise(address, length, MADV_DONTNEED);
+                    break;
+                case POPULATE:
+                    populate(address, length);
+                    break;
+                case HUGEPAGE:
+#ifdef MADV_HUGEPAGE
+                    ::madvise(address, length, MADV_HUGEPAGE);
+#endif
+                    break;
+            }
+        }
+
+        void prefetch(size_t offset, size_t size) override
+        {
+            u8* address;
+            size_t length;
+
+            if (!getRange(address, length, offset, size))
+            {
+                return;
+            }
+
+            // kick off the kernel read-ahead immediately
+            ::madvise(address, length, MADV_WILLNEED);
+
+            if (!m_prefetch)
+            {
+                m_prefetch.reset(new ConcurrentQueue("file.prefetch", Priority::LOW));
+            }
+
+            // populate in slices so that the remaining work can be cancelled
+            const size_t slice = 4 * 1024 * 1024;
+
+            for (size_t i = 0; i < length; i += slice)
+            {
+                u8* ptr = address + i;
+                size_t bytes = std::min(slice, length - i);
+                m_prefetch->enqueue([this, ptr, bytes] {
+                    populate(ptr, bytes);
+                });
+            }
+        }
     };
 
     // -----------------------------------------------------------------
-    // FileMapper
+    // DirectoryEntry
     // -----------------------------------------------------------------
 
-    class FileMapper : public AbstractMapper
+    struct DirectoryEntry
     {
-    protected:
-        std::string m_basepath;
+        bool directory { false };
+        bool link { false };
+        bool sized { false };
+        u64 size { 0 };
 
-        void emplace_helper(FileIndex& index, const std::string& pathname, std::string filename)
+        bool stat(int dir, const dirent* dp)
         {
-            const std::string testname = pathname + filename;
-
-            struct stat s;
-            if (::stat(testname.c_str(), &s) != -1)
+            if (!sized)
             {
-                filename = removePrefix(filename, m_basepath);
-
-                if ((s.st_mode & S_IFDIR) == 0)
+                struct stat s;
+                if (::fstatat(dir, dp->d_name, &s, 0) != 0)
                 {
-                    size_t size = size_t(s.st_size);
-                    index.emplace(filename, size, 0);
-                }
-                else
-                {
-                    index.emplace(filename + "/", 0, FileInfo::DIRECTORY);
+                    return false;
                 }
+
+                directory = S_ISDIR(s.st_mode);
+                size = directory ? 0 : u64(s.st_size);
+                sized = true;
+            }
+
+            return true;
+        }
+
+        // the type comes from readdir() when the filesystem provides it; fstatat() is
+        // called only for the file size or when the type is unknown or a symbolic link
+        bool resolve(int dir, const dirent* dp, bool query_size)
+        {
+            const char* name = dp->d_name;
+            if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+            {
+                // skip "." and ".."
+                return false;
+            }
+
+            switch (dp->d_type)
+            {
+                case DT_DIR:
+                    directory = true;
+                    return true;
+
+                case DT_LNK:
+                    link = true;
+                    return stat(dir, dp);
+
+                case DT_UNKNOWN:
+                    return stat(dir, dp);
+
+                default:
+                    return query_size ? stat(dir, dp) : true;
             }
         }
+    };
+
+    // -----------------------------------------------------------------
+    // FileMapper
+    // -----------------------------------------------------------------
+
+    class FileMapper : public AbstractMapper
+    {
+    protected:
+        std::string m_basepath;
 
     public:
         FileMapper(const std::string& basepath)
@@ -173,67 +334,135 @@ namespace
             return is;
         }
 
-#if defined(MANGO_PLATFORM_OSX) || defined(MANGO_PLATFORM_IOS) || defined(MANGO_PLATFORM_BSD)
-
         void getIndex(FileIndex& index, const std::string& pathname) override
         {
-            struct dirent** namelist = NULL;
             std::string fullname = m_basepath + pathname;
-
-            const int n = ::scandir(fullname.c_str(), &namelist, [] (const struct dirent* e)
-            {
-                // filter out "." and ".."
-                if (!std::strcmp(e->d_name, ".") || !std::strcmp(e->d_name, ".."))
-                    return 0;
-                return 1;
-            }, 0);
-            if (n < 0)
+            DIR* dirp = ::opendir(fullname.c_str());
+            if (!dirp)
             {
                 // Unable to open directory.
-                ::free(namelist);
                 return;
             }
 
-            for (int i = 0; i < n; ++i)
+            const int dir = ::dirfd(dirp);
+
+            while (const dirent* dp = ::readdir(dirp))
             {
-                const std::string filename(namelist[i]->d_name);
-                ::free(namelist[i]);
-                emplace_helper(index, fullname, filename);
+                DirectoryEntry entry;
+                if (entry.resolve(dir, dp, true))
+                {
+                    if (entry.directory)
+                    {
+                        index.emplace(std::string(dp->d_name) + "/", 0, FileInfo::DIRECTORY);
+                    }
+                    else
+                    {
+                        index.emplace(dp->d_name, entry.size, 0);
+                    }
+                }
             }
 
-            ::free(namelist);
+            ::closedir(dirp);
         }
 
-#else
-
-        void getIndex(FileIndex& index, const std::string& pathname) override
+        void getIndexRecursive(CompactFileIndex& index, const std::string& pathname, const IndexFilter& filter) override
         {
-            std::string fullname = m_basepath + pathname;
-            DIR* dirp = ::opendir(fullname.c_str());
-            if (!dirp)
+            std::mutex mutex;
+            ConcurrentQueue queue("index.recursive");
+
+            // each folder is scanned in its own task; the folder name is relative to pathname
+            std::function<void(const std::string&)> scan = [&] (const std::string& folder)
             {
-                // Unable to open directory.
-                return;
-            }
+                std::string fullname = m_basepath + pathname + folder;
+                DIR* dirp = ::opendir(fullname.c_str());
+                if (!dirp)
+                {
+                    return;
+                }
 
-            dirent* dp;
+                const int dir = ::dirfd(dirp);
 
-            while ((dp = ::readdir(dirp)))
-            {
-                std::string filename(dp->d_name);
+                CompactFileIndex local;
+                std::string name = folder;
 
-                // skip "." and ".."
-                if (filename != "." && filename != "..")
+                while (const dirent* dp = ::readdir(dirp))
                 {
-                    emplace_helper(index, fullname, filename);
+                    const size_t length = std::strlen(dp->d_name);
+
+                    DirectoryEntry entry;
+                    if (!entry.resolve(dir, dp, false))
+                    {
+                        continue;
+                    }
+
+                    name.resize(folder.length());
+                    name.append(dp->d_name, length);
+
+                    if (entry.directory)
+                    {
+                        // symbolic links to folders are not followed to avoid cycles
+                        if (!entry.link)
+                        {
+                            name.push_back('/');
+                            queue.enqueue([&scan, name] {
+                                scan(name);
+                            });
+                        }
+                    }
+                    else if (filter.isNameAccepted(dp->d_name, length))
+                    {
+                        // the size is queried only for the files which pass the name filter
+                        if (filter.sizes && !entry.stat(dir, dp))
+                        {
+                            continue;
+                        }
+
+                        if (filter.isSizeAccepted(entry.size))
+                        {
+                            local.emplace(name.c_str(), name.length(), entry.size, 0);
+                        }
+                    }
                 }
-            }
 
-            ::closedir(dirp);
+                ::closedir(dirp);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                index.append(local);
+            };
+
+            scan("");
+            queue.wait();
         }
 
+        std::string getIdentity(const std::string& filename) const override
+        {
+            std::string testname = m_basepath + filename;
+
+            struct stat s;
+            if (::stat(testname.c_str(), &s) != 0)
+            {
+                return std::string();
+            }
+
+            char* canonical = ::realpath(testname.c_str(), nullptr);
+            if (canonical)
+            {
+                testname = canonical;
+                ::free(canonical);
+            }
+
+#if defined(MANGO_PLATFORM_LINUX)
+            const u64 mtime = u64(s.st_mtim.tv_sec) * 1000000000 + u64(s.st_mtim.tv_nsec);
+#else
+            const u64 mtime = u64(s.st_mtime);
 #endif
 
+            // the file is identified by canonical name, inode, size and modification time
+            return makeString("%s:%llx:%llx:%llx:%llx", testname.c_str(),
+                (unsigned long long)s.st_dev, (unsigned long long)s.st_ino,
+                (unsigned long long)s.st_size, (unsigned long long)mtime);
+        }
+
         VirtualMemory* mmap(const std::string& filename) override
         {
             VirtualMemory* memory = new FileMemory(m_basepath + filename, 0, 0);
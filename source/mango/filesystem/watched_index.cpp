@@ -0,0 +1,452 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <mango/core/string.hpp>
+#include <mango/core/exception.hpp>
+#include <mango/filesystem/path.hpp>
+#include <mango/filesystem/fileobserver.hpp>
+
+#if defined(MANGO_PLATFORM_WINDOWS)
+    #include <sys/stat.h>
+#else
+    #include <cstdlib>
+    #include <sys/stat.h>
+#endif
+
+namespace
+{
+    using namespace mango;
+
+    enum class Status
+    {
+        MISSING,
+        FILE,
+        DIRECTORY
+    };
+
+    Status getStatus(const std::string& filename, u64& size)
+    {
+#if defined(MANGO_PLATFORM_WINDOWS)
+        struct _stati64 s;
+        if (_wstat64(u16_fromBytes(filename).c_str(), &s) != 0)
+        {
+            return Status::MISSING;
+        }
+        size = u64(s.st_size);
+        return (s.st_mode & _S_IFDIR) ? Status::DIRECTORY : Status::FILE;
+#else
+        struct stat s;
+        if (::stat(filename.c_str(), &s) != 0)
+        {
+            return Status::MISSING;
+        }
+        size = u64(s.st_size);
+        return S_ISDIR(s.st_mode) ? Status::DIRECTORY : Status::FILE;
+#endif
+    }
+
+    std::string getCanonicalPath(const std::string& pathname)
+    {
+        std::string canonical = pathname;
+
+#if defined(MANGO_PLATFORM_WINDOWS)
+        wchar_t buffer[MAX_PATH];
+        if (_wfullpath(buffer, u16_fromBytes(pathname).c_str(), MAX_PATH))
+        {
+            canonical = u16_toBytes(buffer);
+        }
+        const char separator = '\\';
+#else
+        char* buffer = ::realpath(pathname.c_str(), nullptr);
+        if (buffer)
+        {
+            canonical = buffer;
+            ::free(buffer);
+        }
+        const char separator = '/';
+#endif
+
+        if (!canonical.empty() && canonical.back() != separator)
+        {
+            canonical += separator;
+        }
+
+        return canonical;
+    }
+
+} // namespace
+
+namespace mango {
+namespace filesystem {
+
+    // -----------------------------------------------------------------
+    // WatchedIndexState
+    // -----------------------------------------------------------------
+
+    struct WatchedIndexState : FileObserver
+    {
+        std::string m_pathname;
+        std::string m_canonical;
+        IndexFilter m_filter;
+        std::chrono::milliseconds m_debounce;
+
+        // index
+        mutable std::mutex m_index_mutex;
+        std::map<std::string, u64> m_files; // ordered so that folders are contiguous ranges
+        std::atomic<u64> m_version { 0 };
+
+        std::mutex m_callback_mutex;
+        WatchedIndex::Callback m_callback;
+
+        // pending events, coalesced per filename
+        std::mutex m_event_mutex;
+        std::condition_variable m_condition;
+        std::map<std::string, u32> m_pending;
+        bool m_rescan { false };
+        bool m_stop { false };
+        std::chrono::steady_clock::time_point m_last_event;
+
+        std::thread m_thread;
+
+        WatchedIndexState(const std::string& pathname, const IndexFilter& filter, u32 debounce)
+            : m_pathname(pathname)
+            , m_filter(filter)
+            , m_debounce(debounce)
+        {
+            if (!m_pathname.empty() && m_pathname.back() != '/')
+            {
+                m_pathname += '/';
+            }
+
+            m_canonical = getCanonicalPath(m_pathname);
+
+            // start observing before the initial scan so that no change is missed
+            start(m_pathname, true);
+
+            std::map<std::string, u64> files;
+            scan(files, "");
+            m_files.swap(files);
+
+            m_thread = std::thread([this]
+            {
+                run();
+            });
+        }
+
+        ~WatchedIndexState()
+        {
+            // the observer thread calls onEvent() so it must stop before the members are destroyed
+            stop();
+
+            {
+                std::lock_guard<std::mutex> lock(m_event_mutex);
+                m_stop = true;
+            }
+
+            m_condition.notify_one();
+            m_thread.join();
+        }
+
+        void onEvent(u32 flags, const std::string& filename) override
+        {
+            std::lock_guard<std::mutex> lock(m_event_mutex);
+
+            if (filename.empty())
+            {
+                m_rescan = true;
+            }
+            else
+            {
+                // only the latest state of the file matters; it is queried when the events are applied
+                m_pending[filename] |= flags;
+            }
+
+            m_last_event = std::chrono::steady_clock::now();
+            m_condition.notify_one();
+        }
+
+        void scan(std::map<std::string, u64>& files, const std::string& folder) const
+        {
+            CompactFileIndex index;
+
+            try
+            {
+                Path path(m_pathname + folder);
+                path.getIndexRecursive(index, m_filter);
+            }
+            catch (const std::exception&)
+            {
+                // the folder was removed while it was being indexed; the events will tell
+            }
+
+            for (size_t i = 0; i < index.size(); ++i)
+            {
+                files[folder + index.getName(i)] = index.getSize(i);
+            }
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(m_event_mutex);
+
+            for (;;)
+            {
+                m_condition.wait(lock, [this]
+                {
+                    return m_stop || m_rescan || !m_pending.empty();
+                });
+
+                // wait until the events have stopped; a continuous stream of events
+                // is applied at least every ten debounce intervals
+                const auto deadline = std::chrono::steady_clock::now() + m_debounce * 10;
+
+                while (!m_stop)
+                {
+                    auto timeout = std::min(m_last_event + m_debounce, deadline);
+                    if (std::chrono::steady_clock::now() >= timeout)
+                    {
+                        break;
+                    }
+                    m_condition.wait_until(lock, timeout);
+                }
+
+                if (m_stop)
+                {
+                    break;
+                }
+
+                std::map<std::string, u32> pending;
+                pending.swap(m_pending);
+
+                bool rescan = m_rescan;
+                m_rescan = false;
+
+                lock.unlock();
+                apply(pending, rescan);
+                lock.lock();
+            }
+        }
+
+        // modified: the file was reported by an event, otherwise only a different size is a change
+        void update(std::vector<WatchedIndex::Change>& changes, const std::string& filename, u64 size, bool modified)
+        {
+            auto i = m_files.find(filename);
+            if (i == m_files.end())
+            {
+                m_files.emplace(filename, size);
+                changes.push_back({ FileObserver::CREATED, filename });
+            }
+            else if (modified || i->second != size)
+            {
+                i->second = size;
+                changes.push_back({ FileObserver::MODIFIED, filename });
+            }
+        }
+
+        void erase(std::vector<WatchedIndex::Change>& changes, const std::string& filename)
+        {
+            auto i = m_files.find(filename);
+            if (i != m_files.end())
+            {
+                m_files.erase(i);
+                changes.push_back({ FileObserver::DELETED, filename });
+            }
+        }
+
+        // erase the files in the folder which are not in the given files
+        void eraseFolder(std::vector<WatchedIndex::Change>& changes, const std::string& folder,
+                         const std::map<std::string, u64>& files)
+        {
+            auto i = m_files.lower_bound(folder);
+
+            while (i != m_files.end() && !i->first.compare(0, folder.length(), folder))
+            {
+                if (files.find(i->first) == files.end())
+                {
+                    changes.push_back({ FileObserver::DELETED, i->first });
+                    i = m_files.erase(i);
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+
+        void apply(const std::map<std::string, u32>& pending, bool rescan)
+        {
+            std::vector<WatchedIndex::Change> changes;
+
+            if (rescan)
+            {
+                std::map<std::string, u64> files;
+                scan(files, "");
+
+                std::lock_guard<std::mutex> lock(m_index_mutex);
+
+                for (auto& file : m_files)
+                {
+                    auto i = files.find(file.first);
+                    if (i == files.end())
+                    {
+                        changes.push_back({ FileObserver::DELETED, file.first });
+                    }
+                    else if (i->second != file.second)
+                    {
+                        changes.push_back({ FileObserver::MODIFIED, file.first });
+                    }
+                }
+
+                for (auto& file : files)
+                {
+                    if (m_files.find(file.first) == m_files.end())
+                    {
+                        changes.push_back({ FileObserver::CREATED, file.first });
+                    }
+                }
+
+                // a change notification does not tell which files were modified
+                // without changing the size; the pending events still do
+                m_files.swap(files);
+            }
+
+            for (auto& event : pending)
+            {
+                const std::string& filename = event.first;
+
+                u64 size = 0;
+                Status status = getStatus(m_pathname + filename, size);
+
+                std::map<std::string, u64> files;
+
+                if (status == Status::DIRECTORY)
+                {
+                    // created or moved in folder
+                    scan(files, filename + "/");
+                }
+
+                std::lock_guard<std::mutex> lock(m_index_mutex);
+
+                switch (status)
+                {
+                    case Status::MISSING:
+                        erase(changes, filename);
+                        eraseFolder(changes, filename + "/", files);
+                        break;
+
+                    case Status::FILE:
+                        if (m_filter.isNameAccepted(filename.c_str(), filename.length()) && m_filter.isSizeAccepted(size))
+                        {
+                            update(changes, filename, size, true);
+                        }
+                        else
+                        {
+                            erase(changes, filename);
+                        }
+
+                        // a folder was replaced by a file with the same name
+                        eraseFolder(changes, filename + "/", files);
+                        break;
+
+                    case Status::DIRECTORY:
+                        erase(changes, filename);
+                        eraseFolder(changes, filename + "/", files);
+                        for (auto& file : files)
+                        {
+                            update(changes, file.first, file.second, false);
+                        }
+                        break;
+                }
+            }
+
+            if (changes.empty())
+            {
+                return;
+            }
+
+            // the same file can be reported by both the rescan and the events
+            std::stable_sort(changes.begin(), changes.end(), [] (const WatchedIndex::Change& a, const WatchedIndex::Change& b)
+            {
+                return a.filename < b.filename;
+            });
+
+            changes.erase(std::unique(changes.begin(), changes.end(), [] (const WatchedIndex::Change& a, const WatchedIndex::Change& b)
+            {
+                return a.filename == b.filename;
+            }), changes.end());
+
+            for (auto& change : changes)
+            {
+                if (change.flags != FileObserver::CREATED)
+                {
+                    invalidateContainerCache(m_canonical + change.filename);
+                }
+            }
+
+            ++m_version;
+
+            // the callback is called without the lock so that it can call setCallback()
+            WatchedIndex::Callback callback;
+            {
+                std::lock_guard<std::mutex> lock(m_callback_mutex);
+                callback = m_callback;
+            }
+
+            if (callback)
+            {
+                callback(changes);
+            }
+        }
+    };
+
+    // -----------------------------------------------------------------
+    // WatchedIndex
+    // -----------------------------------------------------------------
+
+    WatchedIndex::WatchedIndex(const std::string& pathname, const IndexFilter& filter, u32 debounce)
+    {
+        m_state = new WatchedIndexState(pathname, filter, debounce);
+    }
+
+    WatchedIndex::~WatchedIndex()
+    {
+        delete m_state;
+    }
+
+    void WatchedIndex::setCallback(Callback callback)
+    {
+        std::lock_guard<std::mutex> lock(m_state->m_callback_mutex);
+        m_state->m_callback = callback;
+    }
+
+    u64 WatchedIndex::version() const
+    {
+        return m_state->m_version;
+    }
+
+    void WatchedIndex::getIndex(CompactFileIndex& index) const
+    {
+        std::lock_guard<std::mutex> lock(m_state->m_index_mutex);
+
+        for (auto& file : m_state->m_files)
+        {
+            index.emplace(file.first.c_str(), file.first.length(), file.second, 0);
+        }
+    }
+
+    bool WatchedIndex::isFile(const std::string& filename) const
+    {
+        std::lock_guard<std::mutex> lock(m_state->m_index_mutex);
+        return m_state->m_files.find(filename) != m_state->m_files.end();
+    }
+
+} // namespace filesystem
+} // namespace mango
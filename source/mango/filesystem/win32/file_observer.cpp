@@ -8,6 +8,7 @@
 #include <mango/filesystem/fileobserver.hpp>
 
 #include <thread>
+#include <algorithm>
 
 namespace mango {
 namespace filesystem {
@@ -50,7 +51,8 @@ namespace filesystem {
             {
                 // Extract and convert the filename to UTF-8
                 const std::wstring u16filename(notify->FileName, notify->FileNameLength / 2);
-                const std::string filename = u16_toBytes(u16filename);
+                std::string filename = u16_toBytes(u16filename);
+                std::replace(filename.begin(), filename.end(), '\\', '/');
 
                 // Generate event
                 observer->onEvent(flags | flags0, filename);
@@ -100,7 +102,7 @@ namespace filesystem {
                 CloseHandle(m_handle[2]);
         }
 
-        FileObserverState(FileObserver* observer, const std::string& u8pathname)
+        FileObserverState(FileObserver* observer, const std::string& u8pathname, bool recursive)
             : m_started(false)
         {
             m_directory[0] = INVALID_HANDLE_VALUE;
@@ -141,10 +143,12 @@ namespace filesystem {
             {
                 const DWORD filter[] =
                 {
-                    FILE_NOTIFY_CHANGE_FILE_NAME,
+                    FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
                     FILE_NOTIFY_CHANGE_DIR_NAME
                 };
 
+                const BOOL subtree = recursive ? TRUE : FALSE;
+
                 const u32 flags[] =
                 {
                     FileObserver::FILE,
@@ -158,12 +162,12 @@ namespace filesystem {
                 DWORD buffer[BUFFER_SIZE * 2];
                 DWORD bytes;
 
-                if (!ReadDirectoryChangesW(m_directory[0], buffer + 0 * BUFFER_SIZE, BUFFER_BYTES, FALSE, filter[0], &bytes, &overlapped[0], NULL))
+                if (!ReadDirectoryChangesW(m_directory[0], buffer + 0 * BUFFER_SIZE, BUFFER_BYTES, subtree, filter[0], &bytes, &overlapped[0], NULL))
                 {
                     return;
                 }
 
-                if (!ReadDirectoryChangesW(m_directory[1], buffer + 1 * BUFFER_SIZE, BUFFER_BYTES, FALSE, filter[1], &bytes, &overlapped[1], NULL))
+                if (!ReadDirectoryChangesW(m_directory[1], buffer + 1 * BUFFER_SIZE, BUFFER_BYTES, subtree, filter[1], &bytes, &overlapped[1], NULL))
                 {
                     return;
                 }
@@ -184,9 +188,14 @@ namespace filesystem {
                                 {
                                     processNotify(observer, (BYTE*)(buffer + index * BUFFER_SIZE), bytes, flags[index]);
                                 }
+                                else
+                                {
+                                    // the buffer overflowed; report a change notification
+                                    observer->onEvent(0, "");
+                                }
 
                                 // Restart the read directory
-                                if (!ReadDirectoryChangesW(m_directory[index], buffer + index * BUFFER_SIZE, BUFFER_BYTES, FALSE, filter[index], &bytes, &overlapped[index], NULL))
+                                if (!ReadDirectoryChangesW(m_directory[index], buffer + index * BUFFER_SIZE, BUFFER_BYTES, subtree, filter[index], &bytes, &overlapped[index], NULL))
                                 {
                                     looping = false;
                                 }
@@ -235,10 +244,10 @@ namespace filesystem {
         stop();
     }
 
-    void FileObserver::start(const std::string& pathname)
+    void FileObserver::start(const std::string& pathname, bool recursive)
     {
         stop();
-        m_state = new FileObserverState(this, pathname);
+        m_state = new FileObserverState(this, pathname, recursive);
     }
 
     void FileObserver::stop()
@@ -81,7 +81,7 @@ namespace filesystem {
     // FileStream
     // -----------------------------------------------------------------
 
-    FileStream::FileStream(const std::string& filename, OpenMode mode)
+    FileStream::FileStream(const std::string& filename, OpenMode mode, Buffering buffering)
         : m_handle(nullptr)
     {
         DWORD access;
@@ -104,6 +104,12 @@ namespace filesystem {
                 break;
         }
 
+        if (buffering != STDIO)
+        {
+            // the background queue is implemented for unix only
+            MANGO_EXCEPTION(ID"ASYNC and DIRECT buffering are not supported.");
+        }
+
         // TODO: mode parameter
         HANDLE handle = CreateFileW(u16_fromBytes(filename).c_str(), access, 0, NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
         if (handle == INVALID_HANDLE_VALUE)
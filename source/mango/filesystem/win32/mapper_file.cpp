@@ -119,6 +119,47 @@ namespace
                 CloseHandle(m_file);
             }
         }
+
+        void advise(Access access, size_t offset, size_t size) override
+        {
+            if (offset >= m_memory.size)
+            {
+                return;
+            }
+
+            size = size ? std::min(size, m_memory.size - offset) : m_memory.size - offset;
+            u8* address = m_memory.address + offset;
+
+            // only the read-ahead hints have a counterpart in the Windows API
+            switch (access)
+            {
+                case WILLNEED:
+                case POPULATE:
+                {
+#if _WIN32_WINNT >= 0x0602
+                    WIN32_MEMORY_RANGE_ENTRY range;
+                    range.VirtualAddress = address;
+                    range.NumberOfBytes = size;
+                    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+                    if (access == POPULATE)
+                    {
+                        SYSTEM_INFO info;
+                        ::GetSystemInfo(&info);
+                        volatile const u8* p = address;
+                        u8 sum = 0;
+                        for (size_t i = 0; i < size; i += info.dwPageSize)
+                        {
+                            sum += p[i];
+                        }
+                        MANGO_UNREFERENCED_PARAMETER(sum);
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
     };
 
     // -----------------------------------------------------------------
@@ -154,6 +195,27 @@ namespace
             return is;
         }
 
+        std::string getIdentity(const std::string& filename) const override
+        {
+            std::wstring testname = u16_fromBytes(m_basepath + filename);
+
+            struct _stati64 s;
+            if (_wstat64(testname.c_str(), &s) != 0)
+            {
+                return std::string();
+            }
+
+            wchar_t canonical[MAX_PATH];
+            if (_wfullpath(canonical, testname.c_str(), MAX_PATH))
+            {
+                testname = canonical;
+            }
+
+            // the file is identified by canonical name, size and modification time
+            return makeString("%s:%llx:%llx", u16_toBytes(testname).c_str(),
+                (unsigned long long)s.st_size, (unsigned long long)s.st_mtime);
+        }
+
         void getIndex(FileIndex& index, const std::string& pathname) override
         {
             std::wstring filespec = u16_fromBytes(m_basepath + pathname + "*");
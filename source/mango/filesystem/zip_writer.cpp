@@ -0,0 +1,503 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <ctime>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <mango/core/thread.hpp>
+#include <mango/core/string.hpp>
+#include <mango/core/exception.hpp>
+#include <mango/core/compress.hpp>
+#include <mango/core/crc32.hpp>
+#include <mango/core/buffer.hpp>
+#include <mango/filesystem/file.hpp>
+#include <mango/filesystem/zipwriter.hpp>
+
+// the zlib compatible macros would collide with the mango compression functions
+#define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
+#include "../../external/miniz/miniz.h"
+
+#define ID "[ZipWriter] "
+
+namespace
+{
+    using namespace mango;
+    using mango::filesystem::ZipWriter;
+
+    enum : u16
+    {
+        COMPRESSION_NONE = 0,
+        COMPRESSION_DEFLATE = 8,
+        COMPRESSION_BZIP2 = 12,
+        COMPRESSION_LZMA = 14,
+        COMPRESSION_ZSTD = 93
+    };
+
+    enum : u16
+    {
+        FLAG_UTF8 = 0x0800
+    };
+
+    enum : u16
+    {
+        EXTRA_ZIP64 = 0x0001,
+        EXTRA_ALIGNMENT = 0xd935 // zipalign / apksigner padding
+    };
+
+    const u32 zip64_limit = 0xffffffff;
+
+    bool isCompressedFormat(const std::string& name)
+    {
+        static const char* extensions[] =
+        {
+            ".jpg", ".jpeg", ".png", ".gif", ".webp", ".heic", ".avif", ".jp2", ".jxl",
+            ".zip", ".cbz", ".apk", ".rar", ".cbr", ".7z", ".gz", ".tgz", ".bz2", ".xz",
+            ".zst", ".lz4", ".mp3", ".mp4", ".m4a", ".aac", ".ogg", ".opus", ".mkv", ".webm"
+        };
+
+        const std::string extension = toLower(filesystem::getExtension(name));
+        for (auto e : extensions)
+        {
+            if (extension == e)
+                return true;
+        }
+        return false;
+    }
+
+    u16 getVersionNeeded(u16 method, bool zip64)
+    {
+        u16 version = 10;
+        switch (method)
+        {
+            case COMPRESSION_DEFLATE:
+                version = 20;
+                break;
+            case COMPRESSION_BZIP2:
+                version = 46;
+                break;
+            case COMPRESSION_LZMA:
+            case COMPRESSION_ZSTD:
+                version = 63;
+                break;
+        }
+        return zip64 ? std::max(version, u16(45)) : version;
+    }
+
+    // -----------------------------------------------------------------
+    // compression
+    // -----------------------------------------------------------------
+
+    struct CompressedEntry
+    {
+        u16 method;
+        u32 crc;
+        u64 uncompressed_size;
+        Memory data;
+        std::unique_ptr<u8[]> buffer;
+    };
+
+    size_t zip_deflate(Memory dest, Memory source, int level)
+    {
+        // raw deflate stream without the zlib wrapper
+        level = std::max(0, std::min(level, 10));
+        int flags = tdefl_create_comp_flags_from_zip_params(level, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+
+        size_t size = tdefl_compress_mem_to_mem(dest.address, dest.size, source.address, source.size, flags);
+        if (!size)
+        {
+            MANGO_EXCEPTION(ID"Deflate failed.");
+        }
+
+        return size;
+    }
+
+    size_t zip_lzma(Memory dest, Memory source, int level)
+    {
+        // LZMA SDK version and the properties size precede the LZMA stream
+        dest.address[0] = 18;
+        dest.address[1] = 5;
+        dest.address[2] = 5;
+        dest.address[3] = 0;
+
+        size_t size = lzma::compress(Memory(dest.address + 4, dest.size - 4), source, level);
+        return size + 4;
+    }
+
+    void compress(CompressedEntry& entry, Memory source, ZipWriter::Method method, int level, const std::string& name)
+    {
+        entry.crc = crc32(0, source);
+        entry.uncompressed_size = source.size;
+        entry.method = COMPRESSION_NONE;
+        entry.data = source;
+
+        if (method == ZipWriter::AUTO)
+        {
+            method = isCompressedFormat(name) ? ZipWriter::STORE : ZipWriter::DEFLATE;
+        }
+
+#ifndef MANGO_ENABLE_LICENSE_ZLIB
+        if (method == ZipWriter::BZIP2)
+            method = ZipWriter::DEFLATE;
+#endif
+
+#ifndef MANGO_ENABLE_LICENSE_BSD
+        if (method == ZipWriter::ZSTD)
+            method = ZipWriter::DEFLATE;
+#endif
+
+        if (method == ZipWriter::STORE || !source.size)
+        {
+            return;
+        }
+
+        size_t bound = 0;
+        u16 zip_method = COMPRESSION_NONE;
+
+        switch (method)
+        {
+            case ZipWriter::DEFLATE:
+                bound = miniz::bound(source.size);
+                zip_method = COMPRESSION_DEFLATE;
+                break;
+#ifdef MANGO_ENABLE_LICENSE_ZLIB
+            case ZipWriter::BZIP2:
+                bound = bzip2::bound(source.size);
+                zip_method = COMPRESSION_BZIP2;
+                break;
+#endif
+            case ZipWriter::LZMA:
+                bound = lzma::bound(source.size) + 4;
+                zip_method = COMPRESSION_LZMA;
+                break;
+#ifdef MANGO_ENABLE_LICENSE_BSD
+            case ZipWriter::ZSTD:
+                bound = zstd::bound(source.size);
+                zip_method = COMPRESSION_ZSTD;
+                break;
+#endif
+            default:
+                return;
+        }
+
+        std::unique_ptr<u8[]> buffer(new u8[bound]);
+        Memory dest(buffer.get(), bound);
+        size_t size = 0;
+
+        switch (zip_method)
+        {
+            case COMPRESSION_DEFLATE:
+                size = zip_deflate(dest, source, level);
+                break;
+#ifdef MANGO_ENABLE_LICENSE_ZLIB
+            case COMPRESSION_BZIP2:
+                size = bzip2::compress(dest, source, level);
+                break;
+#endif
+            case COMPRESSION_LZMA:
+                size = zip_lzma(dest, source, level);
+                break;
+#ifdef MANGO_ENABLE_LICENSE_BSD
+            case COMPRESSION_ZSTD:
+                size = zstd::compress(dest, source, level);
+                break;
+#endif
+        }
+
+        if (size < source.size)
+        {
+            entry.method = zip_method;
+            entry.data = Memory(buffer.get(), size);
+            entry.buffer = std::move(buffer);
+        }
+        else
+        {
+            // incompressible data is stored
+        }
+    }
+
+} // namespace
+
+namespace mango {
+namespace filesystem {
+
+    // -----------------------------------------------------------------
+    // ZipContext
+    // -----------------------------------------------------------------
+
+    struct ZipContext
+    {
+        Stream& output;
+        u64 base;
+        int level;
+        u32 alignment;
+        u16 time;
+        u16 date;
+
+        std::mutex mutex;
+        Buffer central;
+        u64 count { 0 };
+        std::string error;
+        bool closed { false };
+
+        ConcurrentQueue queue;
+
+        ZipContext(Stream& output, int level, u32 alignment)
+            : output(output)
+            , base(output.offset())
+            , level(level)
+            , alignment(std::min(alignment, u32(0x8000)))
+            , queue("zip.writer")
+        {
+            std::time_t t = std::time(nullptr);
+            std::tm* tm = std::localtime(&t);
+
+            // MS-DOS date and time
+            time = u16((tm->tm_hour << 11) | (tm->tm_min << 5) | (tm->tm_sec >> 1));
+            date = u16(((std::max(tm->tm_year, 80) - 80) << 9) | ((tm->tm_mon + 1) << 5) | tm->tm_mday);
+        }
+
+        void process(const std::string& name, Memory memory, ZipWriter::Method method)
+        {
+            CompressedEntry entry;
+            compress(entry, memory, method, level, name);
+            write(name, entry);
+        }
+
+        void setError(const std::string& name, const char* message)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (error.empty())
+            {
+                // the first error is reported by close()
+                error = makeString("\"%s\": %s", name.c_str(), message);
+            }
+        }
+
+        void write(const std::string& name, const CompressedEntry& entry)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            const u64 position = output.offset();
+            const u64 offset = position - base;
+            const u64 compressed_size = entry.data.size;
+            const u64 uncompressed_size = entry.uncompressed_size;
+            const bool zip64 = compressed_size >= zip64_limit || uncompressed_size >= zip64_limit;
+            const u16 version = getVersionNeeded(entry.method, zip64 || offset >= zip64_limit);
+
+            // local header extra fields
+            Buffer extra;
+            LittleEndianStream e(extra);
+
+            if (zip64)
+            {
+                e.write16(EXTRA_ZIP64);
+                e.write16(16);
+                e.write64(uncompressed_size);
+                e.write64(compressed_size);
+            }
+
+            if (entry.method == COMPRESSION_NONE && alignment > 1)
+            {
+                // pad the local header so that the stored data is aligned
+                u64 header_end = position + 30 + name.length() + extra.size() + 6;
+                u32 padding = u32((alignment - header_end % alignment) % alignment);
+
+                e.write16(EXTRA_ALIGNMENT);
+                e.write16(u16(2 + padding));
+                e.write16(u16(alignment));
+                for (u32 i = 0; i < padding; ++i)
+                {
+                    e.write8(0);
+                }
+            }
+
+            LittleEndianStream s(output);
+
+            s.write32(0x04034b50);
+            s.write16(version);
+            s.write16(FLAG_UTF8);
+            s.write16(entry.method);
+            s.write16(time);
+            s.write16(date);
+            s.write32(entry.crc);
+            s.write32(zip64 ? zip64_limit : u32(compressed_size));
+            s.write32(zip64 ? zip64_limit : u32(uncompressed_size));
+            s.write16(u16(name.length()));
+            s.write16(u16(extra.size()));
+            s.write(name.data(), name.length());
+            s.write(extra);
+            s.write(entry.data);
+
+            // central directory record; the ZIP64 field has only the values which overflow
+            Buffer central_extra;
+            LittleEndianStream c(central_extra);
+
+            const bool zip64_uncompressed = uncompressed_size >= zip64_limit;
+            const bool zip64_compressed = compressed_size >= zip64_limit;
+            const bool zip64_offset = offset >= zip64_limit;
+
+            if (zip64_uncompressed || zip64_compressed || zip64_offset)
+            {
+                c.write16(EXTRA_ZIP64);
+                c.write16(u16((zip64_uncompressed + zip64_compressed + zip64_offset) * 8));
+                if (zip64_uncompressed)
+                    c.write64(uncompressed_size);
+                if (zip64_compressed)
+                    c.write64(compressed_size);
+                if (zip64_offset)
+                    c.write64(offset);
+            }
+
+            LittleEndianStream d(central);
+
+            d.write32(0x02014b50);
+            d.write16(version);
+            d.write16(version);
+            d.write16(FLAG_UTF8);
+            d.write16(entry.method);
+            d.write16(time);
+            d.write16(date);
+            d.write32(entry.crc);
+            d.write32(zip64_compressed ? zip64_limit : u32(compressed_size));
+            d.write32(zip64_uncompressed ? zip64_limit : u32(uncompressed_size));
+            d.write16(u16(name.length()));
+            d.write16(u16(central_extra.size()));
+            d.write16(0); // comment
+            d.write16(0); // disk
+            d.write16(0); // internal attributes
+            d.write32(0); // external attributes
+            d.write32(zip64_offset ? zip64_limit : u32(offset));
+            d.write(name.data(), name.length());
+            d.write(central_extra);
+
+            ++count;
+        }
+
+        void close()
+        {
+            queue.wait();
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (closed)
+            {
+                return;
+            }
+
+            closed = true;
+
+            const u64 directory_offset = output.offset() - base;
+            const u64 directory_size = central.size();
+
+            LittleEndianStream s(output);
+            s.write(central);
+
+            const bool zip64 = count >= 0xffff ||
+                               directory_offset >= zip64_limit ||
+                               directory_size >= zip64_limit;
+
+            if (zip64)
+            {
+                const u64 record_offset = output.offset() - base;
+
+                // ZIP64 end of central directory record
+                s.write32(0x06064b50);
+                s.write64(44);
+                s.write16(45);
+                s.write16(45);
+                s.write32(0);
+                s.write32(0);
+                s.write64(count);
+                s.write64(count);
+                s.write64(directory_size);
+                s.write64(directory_offset);
+
+                // ZIP64 end of central directory locator
+                s.write32(0x07064b50);
+                s.write32(0);
+                s.write64(record_offset);
+                s.write32(1);
+            }
+
+            // end of central directory record
+            s.write32(0x06054b50);
+            s.write16(0);
+            s.write16(0);
+            s.write16(zip64 ? 0xffff : u16(count));
+            s.write16(zip64 ? 0xffff : u16(count));
+            s.write32(zip64 ? zip64_limit : u32(directory_size));
+            s.write32(zip64 ? zip64_limit : u32(directory_offset));
+            s.write16(0);
+
+            if (!error.empty())
+            {
+                MANGO_EXCEPTION(ID"%s", error.c_str());
+            }
+        }
+    };
+
+    // -----------------------------------------------------------------
+    // ZipWriter
+    // -----------------------------------------------------------------
+
+    ZipWriter::ZipWriter(Stream& output, int level, u32 alignment)
+    {
+        m_context = new ZipContext(output, level, alignment);
+    }
+
+    ZipWriter::~ZipWriter()
+    {
+        try
+        {
+            m_context->close();
+        }
+        catch (const std::exception&)
+        {
+            // the error is reported by close() when it is called explicitly
+        }
+
+        delete m_context;
+    }
+
+    void ZipWriter::add(const std::string& name, Memory memory, Method method)
+    {
+        ZipContext* context = m_context;
+        context->queue.enqueue([=]
+        {
+            try
+            {
+                context->process(name, memory, method);
+            }
+            catch (const std::exception& e)
+            {
+                context->setError(name, e.what());
+            }
+        });
+    }
+
+    void ZipWriter::addFile(const std::string& name, const std::string& filename, Method method)
+    {
+        ZipContext* context = m_context;
+        context->queue.enqueue([=]
+        {
+            try
+            {
+                File file(filename);
+                context->process(name, file, method);
+            }
+            catch (const std::exception& e)
+            {
+                context->setError(name, e.what());
+            }
+        });
+    }
+
+    void ZipWriter::close()
+    {
+        m_context->close();
+    }
+
+} // namespace filesystem
+} // namespace mango
@@ -748,5 +748,12 @@ namespace framebuffer {
         m_context->present();
     }
 
+    void Framebuffer::present(const std::vector<Rect>& rects)
+    {
+        // the view is redrawn as a whole
+        MANGO_UNREFERENCED_PARAMETER(rects);
+        m_context->present();
+    }
+
 } // namespace framebuffer
 } // namespace mango
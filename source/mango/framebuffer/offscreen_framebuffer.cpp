@@ -0,0 +1,251 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <mango/framebuffer/framebuffer.hpp>
+#include <mango/core/exception.hpp>
+#include <mango/core/string.hpp>
+#include <mango/core/thread.hpp>
+#include <mango/image/encoder.hpp>
+
+#define ID "[OffscreenFramebuffer] "
+
+namespace mango {
+namespace framebuffer {
+
+	// -------------------------------------------------------------------
+	// OffscreenContext
+	// -------------------------------------------------------------------
+
+    struct OffscreenContext
+    {
+        int width;
+        int height;
+        Format format;
+
+        Bitmap buffer;
+
+        // capture ring; a slot is busy from present() until the encoder has written it.
+        // The bitmaps are allocated on the first capture into the slot.
+        std::vector<Bitmap*> ring;
+        std::vector<bool> busy;
+        int next { 0 };
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        SerialQueue queue { "framebuffer.capture" };
+
+        std::string prefix;
+        std::string extension;
+        float quality { 1.0f };
+        int frame { 0 };
+
+        Timer timer;
+        u64 lock_time { 0 };
+        std::vector<OffscreenFramebuffer::FrameStats> stats;
+
+        bool looping { false };
+
+        OffscreenContext(int width, int height, int buffers)
+            : width(width)
+            , height(height)
+            , format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8)
+            , buffer(width, height, format)
+        {
+            buffers = std::max(1, buffers);
+            ring.resize(buffers, nullptr);
+            busy.resize(buffers, false);
+
+            std::memset(buffer.image, 0, buffer.stride * height);
+            timer.reset();
+        }
+
+        ~OffscreenContext()
+        {
+            queue.wait();
+
+            for (auto bitmap : ring)
+            {
+                delete bitmap;
+            }
+        }
+
+        Surface lock()
+        {
+            lock_time = timer.us();
+            return buffer;
+        }
+
+        void release(int index)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy[index] = false;
+            condition.notify_one();
+        }
+
+        void capture()
+        {
+            const int index = next;
+            next = (next + 1) % int(ring.size());
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&] { return !busy[index]; });
+                busy[index] = true;
+            }
+
+            Bitmap* slot = ring[index];
+
+            try
+            {
+                if (!slot)
+                {
+                    slot = new Bitmap(width, height, format);
+                    ring[index] = slot;
+                }
+
+                slot->blit(0, 0, buffer);
+
+                std::string filename = makeString("%s%06d%s", prefix.c_str(), frame++, extension.c_str());
+                float q = quality;
+
+                queue.enqueue([this, slot, index, filename, q]
+                {
+                    try
+                    {
+                        slot->save(filename, q);
+                    }
+                    catch (...)
+                    {
+                        // capture is best effort; keep rendering
+                    }
+
+                    release(index);
+                });
+            }
+            catch (...)
+            {
+                // the slot was not handed to the encoder
+                release(index);
+                throw;
+            }
+        }
+
+        void present()
+        {
+            const u64 time = timer.us();
+
+            if (!prefix.empty())
+            {
+                capture();
+            }
+
+            OffscreenFramebuffer::FrameStats frame;
+            frame.time = time;
+            frame.render = time - std::min(time, lock_time);
+            frame.stall = timer.us() - time;
+            stats.push_back(frame);
+        }
+    };
+
+	// -------------------------------------------------------------------
+	// OffscreenFramebuffer
+	// -------------------------------------------------------------------
+
+    OffscreenFramebuffer::OffscreenFramebuffer(int width, int height, int buffers)
+    {
+        m_context = new OffscreenContext(width, height, buffers);
+    }
+
+    OffscreenFramebuffer::~OffscreenFramebuffer()
+    {
+        delete m_context;
+    }
+
+    int2 OffscreenFramebuffer::getWindowSize() const
+    {
+        return int2(m_context->width, m_context->height);
+    }
+
+    Surface OffscreenFramebuffer::lock()
+    {
+        return m_context->lock();
+    }
+
+    void OffscreenFramebuffer::unlock()
+    {
+    }
+
+    void OffscreenFramebuffer::present()
+    {
+        m_context->present();
+    }
+
+    void OffscreenFramebuffer::present(const std::vector<Framebuffer::Rect>& rects)
+    {
+        // the captured frames are always complete images
+        MANGO_UNREFERENCED_PARAMETER(rects);
+        m_context->present();
+    }
+
+    void OffscreenFramebuffer::setCapture(const std::string& prefix, const std::string& extension, float quality)
+    {
+        if (!prefix.empty() && !isImageEncoder(extension))
+        {
+            MANGO_EXCEPTION(ID"No encoder for \"%s\".", extension.c_str());
+        }
+
+        m_context->queue.wait();
+        m_context->prefix = prefix;
+        m_context->extension = extension;
+        m_context->quality = quality;
+        m_context->frame = 0;
+    }
+
+    void OffscreenFramebuffer::flush()
+    {
+        m_context->queue.wait();
+    }
+
+    const std::vector<OffscreenFramebuffer::FrameStats>& OffscreenFramebuffer::getFrameStats() const
+    {
+        return m_context->stats;
+    }
+
+    void OffscreenFramebuffer::resetFrameStats()
+    {
+        m_context->stats.clear();
+    }
+
+    void OffscreenFramebuffer::enterEventLoop()
+    {
+        m_context->looping = true;
+
+        // a window is drawn when it is shown; there are no expose events after that
+        onDraw();
+
+        while (m_context->looping)
+        {
+            onIdle();
+        }
+    }
+
+    void OffscreenFramebuffer::breakEventLoop()
+    {
+        m_context->looping = false;
+    }
+
+    void OffscreenFramebuffer::onIdle()
+    {
+    }
+
+    void OffscreenFramebuffer::onDraw()
+    {
+    }
+
+} // namespace framebuffer
+} // namespace mango
@@ -115,5 +115,12 @@ namespace framebuffer {
         m_context->present();
     }
 
+    void Framebuffer::present(const std::vector<Rect>& rects)
+    {
+        // the backbuffer is presented as a whole
+        MANGO_UNREFERENCED_PARAMETER(rects);
+        m_context->present();
+    }
+
 } // namespace framebuffer
 } // namespace mango
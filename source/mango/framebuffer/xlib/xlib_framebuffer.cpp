@@ -2,12 +2,120 @@
     MANGO Multimedia Development Platform
     Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
+#include <algorithm>
+#include <cstring>
+#include <vector>
 #include <mango/framebuffer/framebuffer.hpp>
 #include <mango/core/exception.hpp>
 #include "../../window/xlib/xlib_handle.hpp"
 
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+
 #define ID "[Framebuffer] "
 
+namespace
+{
+    using namespace mango;
+    using mango::framebuffer::Framebuffer;
+
+    // XShmAttach() reports failure asynchronously (for example, when the X server
+    // is on a different host) so the error is caught with a temporary handler.
+    bool g_shm_error = false;
+
+    int shm_error_handler(::Display* display, XErrorEvent* event)
+    {
+        MANGO_UNREFERENCED_PARAMETER(display);
+        MANGO_UNREFERENCED_PARAMETER(event);
+        g_shm_error = true;
+        return 0;
+    }
+
+    struct SharedImage
+    {
+        XShmSegmentInfo shminfo;
+        XImage* image { nullptr };
+        unsigned long serial { 0 }; // request which is reading the image; zero when idle
+
+        bool create(::Display* display, Visual* visual, int depth, int width, int height)
+        {
+            image = XShmCreateImage(display, visual, depth, ZPixmap, NULL, &shminfo, width, height);
+            if (!image)
+                return false;
+
+            shminfo.shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height, IPC_CREAT | 0600);
+            if (shminfo.shmid < 0)
+            {
+                XDestroyImage(image);
+                image = nullptr;
+                return false;
+            }
+
+            shminfo.shmaddr = reinterpret_cast<char*>(shmat(shminfo.shmid, 0, 0));
+            image->data = shminfo.shmaddr;
+            shminfo.readOnly = False;
+
+            if (shminfo.shmaddr == reinterpret_cast<char*>(-1))
+            {
+                shmctl(shminfo.shmid, IPC_RMID, 0);
+                image->data = NULL;
+                XDestroyImage(image);
+                image = nullptr;
+                return false;
+            }
+
+            XSync(display, False);
+            g_shm_error = false;
+            XErrorHandler handler = XSetErrorHandler(shm_error_handler);
+            XShmAttach(display, &shminfo);
+            XSync(display, False);
+            XSetErrorHandler(handler);
+
+            // the segment is destroyed automatically when both sides have detached
+            shmctl(shminfo.shmid, IPC_RMID, 0);
+
+            if (g_shm_error)
+            {
+                shmdt(shminfo.shmaddr);
+                image->data = NULL;
+                XDestroyImage(image);
+                image = nullptr;
+                return false;
+            }
+
+            return true;
+        }
+
+        void destroy(::Display* display)
+        {
+            if (image)
+            {
+                XShmDetach(display, &shminfo);
+                XSync(display, False);
+                shmdt(shminfo.shmaddr);
+                image->data = NULL;
+                XDestroyImage(image);
+                image = nullptr;
+            }
+        }
+    };
+
+    bool clip(Framebuffer::Rect& rect, int width, int height)
+    {
+        const int x0 = std::max(0, rect.x);
+        const int y0 = std::max(0, rect.y);
+        const int x1 = std::min(width, rect.x + rect.width);
+        const int y1 = std::min(height, rect.y + rect.height);
+        rect.x = x0;
+        rect.y = y0;
+        rect.width = x1 - x0;
+        rect.height = y1 - y0;
+        return rect.width > 0 && rect.height > 0;
+    }
+
+} // namespace
+
 namespace mango {
 namespace framebuffer {
 
@@ -16,45 +124,181 @@ namespace framebuffer {
         const WindowHandle& handle;
         int width;
         int height;
-        Bitmap buffer;
+        Format format;
 
         GC gc;
-        XImage* image;
 
-        FramebufferContext(int screen, int depth, int width, int height, const WindowHandle& handle)
+        // MIT-SHM: two shared images so that the next frame can be rendered while
+        // the X server is still reading the previous one
+        SharedImage shared[2];
+        int back { 0 };
+        bool shm { false };
+
+        // damage from the latest present(); the back buffer is brought up to date
+        // by copying these from the front buffer when it is locked
+        std::vector<Framebuffer::Rect> damage;
+
+        // fallback: XPutImage() from client memory
+        Bitmap* buffer { nullptr };
+        XImage* image { nullptr };
+
+        FramebufferContext(int screen, int depth, Visual* visual, int width, int height, const WindowHandle& handle)
             : handle(handle)
             , width(width)
             , height(height)
-            , buffer(width, height, Format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8))
+            , format(32, Format::UNORM, Format::BGRA, 8, 8, 8, 8)
         {
-            gc = DefaultGC(handle.display, screen);
-            image = XCreateImage(handle.display, CopyFromParent, depth, ZPixmap, 0, NULL, width, height, 32, width * 4);
-            if (!image)
+            ::Display* display = handle.display;
+
+            gc = DefaultGC(display, screen);
+
+            if (XShmQueryExtension(display))
             {
-                MANGO_EXCEPTION(ID"XCreateImage failed.");
+                shm = shared[0].create(display, visual, depth, width, height) &&
+                      shared[1].create(display, visual, depth, width, height);
+                if (!shm)
+                {
+                    shared[0].destroy(display);
+                    shared[1].destroy(display);
+                }
+            }
+
+            if (!shm)
+            {
+                buffer = new Bitmap(width, height, format);
+                image = XCreateImage(display, CopyFromParent, depth, ZPixmap, 0, NULL, width, height, 32, width * 4);
+                if (!image)
+                {
+                    delete buffer;
+                    MANGO_EXCEPTION(ID"XCreateImage failed.");
+                }
             }
         }
 
         ~FramebufferContext()
         {
-            image->data = NULL;
-            XDestroyImage(image);
+            if (shm)
+            {
+                shared[0].destroy(handle.display);
+                shared[1].destroy(handle.display);
+            }
+            else
+            {
+                image->data = NULL;
+                XDestroyImage(image);
+                delete buffer;
+            }
+        }
+
+        Surface surface(int index) const
+        {
+            XImage* image = shared[index].image;
+            return Surface(width, height, format, image->bytes_per_line, reinterpret_cast<u8*>(image->data));
+        }
+
+        void wait(SharedImage& target)
+        {
+            if (target.serial)
+            {
+                // the completion event (or any later reply) updates the processed request
+                // counter; round-trip only when the server has not reached the request yet
+                if (LastKnownRequestProcessed(handle.display) < target.serial)
+                {
+                    XSync(handle.display, False);
+                }
+
+                target.serial = 0;
+            }
         }
 
         Surface lock()
         {
-            return buffer;
+            if (!shm)
+            {
+                return *buffer;
+            }
+
+            SharedImage& target = shared[back];
+            wait(target);
+
+            // bring the back buffer up to date with the frame presented last
+            Surface dest = surface(back);
+            Surface source = surface(back ^ 1);
+
+            for (auto rect : damage)
+            {
+                for (int y = 0; y < rect.height; ++y)
+                {
+                    std::memcpy(dest.address<u8>(rect.x, rect.y + y),
+                                source.address<u8>(rect.x, rect.y + y), rect.width * 4);
+                }
+            }
+
+            damage.clear();
+
+            return dest;
         }
 
         void unlock()
         {
         }
 
+        void put(const Framebuffer::Rect* rects, int count)
+        {
+            ::Display* display = handle.display;
+
+            if (shm)
+            {
+                SharedImage& target = shared[back];
+
+                for (int i = 0; i < count; ++i)
+                {
+                    const Framebuffer::Rect& rect = rects[i];
+                    // no completion events; the request serial tells when the image can be reused
+                    XShmPutImage(display, handle.window, gc, target.image,
+                                 rect.x, rect.y, rect.x, rect.y, rect.width, rect.height, False);
+                }
+
+                target.serial = count ? NextRequest(display) - 1 : 0;
+                damage.assign(rects, rects + count);
+
+                // swap; next frame is rendered into the other image while this one is presented
+                back ^= 1;
+            }
+            else
+            {
+                image->data = buffer->address<char>();
+
+                for (int i = 0; i < count; ++i)
+                {
+                    const Framebuffer::Rect& rect = rects[i];
+                    XPutImage(display, handle.window, gc, image,
+                              rect.x, rect.y, rect.x, rect.y, rect.width, rect.height);
+                }
+            }
+
+            XFlush(display);
+        }
+
         void present()
         {
-            image->data = buffer.address<char>();
-            XPutImage(handle.display, handle.window, gc, image, 0, 0, 0, 0, width, height);
-            XFlush(handle.display);
+            Framebuffer::Rect rect { 0, 0, width, height };
+            put(&rect, 1);
+        }
+
+        void present(const std::vector<Framebuffer::Rect>& rects)
+        {
+            std::vector<Framebuffer::Rect> clipped;
+
+            for (auto rect : rects)
+            {
+                if (clip(rect, width, height))
+                {
+                    clipped.push_back(rect);
+                }
+            }
+
+            put(clipped.data(), int(clipped.size()));
         }
     };
 
@@ -75,7 +319,7 @@ namespace framebuffer {
             MANGO_EXCEPTION(ID"Window creation failed.");
         }
 
-        m_context = new FramebufferContext(screen, depth, width, height, *m_handle);
+        m_context = new FramebufferContext(screen, depth, visual, width, height, *m_handle);
     }
 
     Framebuffer::~Framebuffer()
@@ -98,5 +342,10 @@ namespace framebuffer {
         m_context->present();
     }
 
+    void Framebuffer::present(const std::vector<Rect>& rects)
+    {
+        m_context->present(rects);
+    }
+
 } // namespace framebuffer
 } // namespace mango
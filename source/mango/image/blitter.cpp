@@ -364,6 +364,8 @@ namespace
         if (sf.alpha())
             alphaMask = 0;
 
+        const int step = sf.bits / (sizeof(SourceType) * 8);
+
         for (int y = 0; y < rect.height; ++y)
         {
             const SourceType* src = reinterpret_cast<const SourceType*>(source);
@@ -381,7 +383,7 @@ namespace
                     case 1: v |= packFloat(mask[0], src[offset[0]]);
                 }
 
-                src += components;
+                src += step;
                 dst[x] = DestType(v);
             }
 
@@ -395,11 +397,28 @@ namespace
     template <typename DestType, typename SourceType>
     void convert_template_fp_unorm_fpu(const Blitter& blitter, const BlitRect& rect)
     {
-        MANGO_UNREFERENCED_PARAMETER(blitter);
-
         u8* source = rect.srcImage;
         u8* dest = rect.destImage;
 
+        const Format& sf = blitter.srcFormat;
+        const Format& df = blitter.destFormat;
+
+        u32 mask[4];
+        float scale[4];
+        int offset[4];
+
+        for (int i = 0; i < 4; ++i)
+        {
+            mask[i] = sf.mask(i);
+            scale[i] = mask[i] ? 1.0f / float(mask[i]) : 0.0f;
+            offset[i] = df.size[i] ? df.offset[i] / (sizeof(DestType) * 8) : -1;
+        }
+
+        // default alpha is 1.0; the default color is 0.0
+        const float constant[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+        const int step = df.bits / (sizeof(DestType) * 8);
+
         for (int y = 0; y < rect.height; ++y)
         {
             const SourceType* src = reinterpret_cast<const SourceType*>(source);
@@ -407,9 +426,18 @@ namespace
 
             for (int x = 0; x < rect.width; ++x)
             {
-                // TODO
-                MANGO_UNREFERENCED_PARAMETER(src);
-                MANGO_UNREFERENCED_PARAMETER(dst);
+                const u32 s = src[x];
+
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (offset[i] >= 0)
+                    {
+                        const float v = mask[i] ? float(s & mask[i]) * scale[i] : constant[i];
+                        dst[offset[i]] = DestType(v);
+                    }
+                }
+
+                dst += step;
             }
 
             source += rect.srcStride;
@@ -425,52 +453,42 @@ namespace
         u8* source = rect.srcImage;
         u8* dest = rect.destImage;
 
-        SourceType constant[4];
-        const SourceType* input[4];
-        int stride[4];
+        const Format& sf = blitter.srcFormat;
+        const Format& df = blitter.destFormat;
 
-        const int components = std::min(4, blitter.components);
+        int input[4];
+        int output[4];
 
-        // TODO: initialize blitter variables; they are not configured for FP formats in the code yet!
-        for (int i = 0; i < components; ++i)
+        for (int i = 0; i < 4; ++i)
         {
-            int offset = blitter.component[i].offset;
-            if (offset < 0)
-            {
-                constant[i] = SourceType(blitter.component[i].constant);
-                input[i] = &constant[i];
-                stride[i] = 0;
-            }
-            else
-            {
-                stride[i] = blitter.sampleSize;
-            }
+            input[i] = sf.size[i] ? sf.offset[i] / (sizeof(SourceType) * 8) : -1;
+            output[i] = df.size[i] ? df.offset[i] / (sizeof(DestType) * 8) : -1;
         }
 
+        // default alpha is 1.0; the default color is 0.0
+        const float constant[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+        const int srcStep = sf.bits / (sizeof(SourceType) * 8);
+        const int destStep = df.bits / (sizeof(DestType) * 8);
+
         for (int y = 0; y < rect.height; ++y)
         {
             const SourceType* src = reinterpret_cast<const SourceType*>(source);
             DestType* dst = reinterpret_cast<DestType*>(dest);
 
-            for (int i = 0; i < components; ++i)
-            {
-                int offset = blitter.component[i].offset;
-                if (offset >= 0)
-                {
-                    input[i] = src + offset;
-                }
-            }
-
             for (int x = 0; x < rect.width; ++x)
             {
-                switch (components)
+                for (int i = 0; i < 4; ++i)
                 {
-                    case 4: dst[3] = *input[3]; input[3] += stride[3];
-                    case 3: dst[2] = *input[2]; input[2] += stride[2];
-                    case 2: dst[1] = *input[1]; input[1] += stride[1];
-                    case 1: dst[0] = *input[0]; input[0] += stride[0];
+                    if (output[i] >= 0)
+                    {
+                        const float v = input[i] >= 0 ? float(src[input[i]]) : constant[i];
+                        dst[output[i]] = DestType(v);
+                    }
                 }
-                dst += components;
+
+                src += srcStep;
+                dst += destStep;
             }
 
             source += rect.srcStride;
@@ -933,6 +951,28 @@ namespace
         }
     }
 
+    void blit_rgba32f_from_rgba8888(u8* dest, const u8* src, int count)
+    {
+        INIT_POINTERS(float32x4, u32);
+        for (int x = 0; x < count; ++x)
+        {
+            const u32 v = s[x];
+            float32x4 f(float(v & 0xff), float((v >> 8) & 0xff), float((v >> 16) & 0xff), float(v >> 24));
+            d[x] = f * (1.0f / 255.0f);
+        }
+    }
+
+    void blit_rgba32f_from_bgra8888(u8* dest, const u8* src, int count)
+    {
+        INIT_POINTERS(float32x4, u32);
+        for (int x = 0; x < count; ++x)
+        {
+            const u32 v = s[x];
+            float32x4 f(float((v >> 16) & 0xff), float((v >> 8) & 0xff), float(v & 0xff), float(v >> 24));
+            d[x] = f * (1.0f / 255.0f);
+        }
+    }
+
     void blit_rgba16f_from_rgba32f(u8* dest, const u8* src, int count)
     {
         INIT_POINTERS(float16x4, float32x4);
@@ -1001,6 +1041,8 @@ namespace
         { FORMAT_B8G8R8A8, FORMAT_RGBA16F,    0, blit_bgra8888_from_rgba16f },
         { FORMAT_R8G8B8A8, FORMAT_RGBA32F,    0, blit_rgba8888_from_rgba32f },
         { FORMAT_B8G8R8A8, FORMAT_RGBA32F,    0, blit_bgra8888_from_rgba32f },
+        { FORMAT_RGBA32F,  FORMAT_R8G8B8A8,   0, blit_rgba32f_from_rgba8888 },
+        { FORMAT_RGBA32F,  FORMAT_B8G8R8A8,   0, blit_rgba32f_from_bgra8888 },
         { FORMAT_RGBA16F,  FORMAT_RGBA32F,    0, blit_rgba16f_from_rgba32f },
         { FORMAT_RGBA32F,  FORMAT_RGBA16F,    0, blit_rgba32f_from_rgba16f },
     };
@@ -554,6 +554,23 @@ namespace mango
                     Surface source(surface, x * width, y * height, width, height);
                     temp.blit(0, 0, source);
 
+                    // replicate the edge texels into the parts of the block outside the surface
+                    const int pixelSize = format.bytes();
+
+                    for (int i = 0; i < source.height; ++i)
+                    {
+                        u8* scan = temp.address<u8>(0, i);
+                        for (int j = source.width; j < width; ++j)
+                        {
+                            std::memcpy(scan + j * pixelSize, scan + (source.width - 1) * pixelSize, pixelSize);
+                        }
+                    }
+
+                    for (int i = source.height; i < height; ++i)
+                    {
+                        std::memcpy(temp.address<u8>(0, i), temp.address<u8>(0, source.height - 1), width * pixelSize);
+                    }
+
                     u8* image = temp.address<u8>();
                     encode(*this, data, image, temp.stride);
                     data += bytes;
@@ -5,6 +5,8 @@
 #include <map>
 #include <mango/core/string.hpp>
 #include <mango/core/timer.hpp>
+#include <mango/core/exception.hpp>
+#include <mango/filesystem/file.hpp>
 #include <mango/image/image.hpp>
 
 namespace mango
@@ -198,6 +200,36 @@ namespace mango
         }
     }
 
+    ImageHeader getImageHeader(const std::string& filename)
+    {
+        const std::string extension = filesystem::getExtension(filename);
+        filesystem::File file(filename);
+
+        // the headers are at the start of the file; probing only the start does not
+        // decompress the whole file when it is a compressed entry in a container
+        const size_t probe_size = 64 * 1024;
+
+        if (file.size() > probe_size)
+        {
+            try
+            {
+                ImageDecoder decoder(file.acquire(0, probe_size), extension);
+                ImageHeader header = decoder.header();
+                if (header.width > 0 && header.height > 0)
+                {
+                    return header;
+                }
+            }
+            catch (Exception&)
+            {
+                // the header did not fit in the probe
+            }
+        }
+
+        ImageDecoder decoder(file, extension);
+        return decoder.header();
+    }
+
     // ----------------------------------------------------------------------------
     // ImageEncoder
     // ----------------------------------------------------------------------------
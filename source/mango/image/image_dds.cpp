@@ -5,6 +5,7 @@
 #include <mango/core/pointer.hpp>
 #include <mango/core/exception.hpp>
 #include <mango/image/image.hpp>
+#include "texture.hpp"
 
 #define ID "[ImageDecoder.DDS] "
 
@@ -178,7 +179,7 @@ namespace
     {
         u32 fourcc;
         Format format;
-        bool srgb; // NOTE: this is not used anywhere yet
+        bool srgb; // used only by the encoder
         const char* name;
     };
 
@@ -429,6 +430,12 @@ namespace
         DDSCAPS2_VOLUME             = 0x00200000
     };
 
+    enum
+    {
+        D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3,
+        D3D10_RESOURCE_MISC_TEXTURECUBE = 0x00000004
+    };
+
     struct FormatDDS
     {
         u32 size;
@@ -940,6 +947,60 @@ namespace
         return x;
     }
 
+    // ------------------------------------------------------------
+    // ImageEncoder
+    // ------------------------------------------------------------
+
+    // Select DXGI format for uncompressed storage; the format is changed to the
+    // closest supported one when there is no exact match.
+    u32 selectFormatDXGI(Format& format)
+    {
+        const bool srgb = format.type == Format::SRGB;
+
+        Format linear = format;
+        if (srgb)
+        {
+            linear.type = Format::UNORM;
+        }
+
+        if (linear.type == Format::UNORM || linear.type == Format::FP16 || linear.type == Format::FP32)
+        {
+            for (int i = 0; i < g_dxgi_table_size; ++i)
+            {
+                const FormatDXGI& dxgi = g_dxgi_table[i];
+                if (!dxgi.fourcc && dxgi.format == linear && dxgi.srgb == srgb)
+                {
+                    return u32(i);
+                }
+            }
+        }
+
+        switch (format.type)
+        {
+            case Format::FP16:
+            case Format::FP32:
+            case Format::FP64:
+                format = FORMAT_RGBA32F;
+                return DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+            case Format::SRGB:
+                format = Format(32, Format::SRGB, Format::RGBA, 8, 8, 8, 8);
+                return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+
+            default:
+                format = FORMAT_R8G8B8A8;
+                return DXGI_FORMAT_R8G8B8A8_UNORM;
+        }
+    }
+
+    void imageEncode(Stream& stream, const Surface& surface, float quality)
+    {
+        MANGO_UNREFERENCED_PARAMETER(quality);
+
+        TextureEncoderOptions options;
+        encodeTextureDDS(stream, &surface, 1, options);
+    }
+
 } // namespace
 
 namespace mango
@@ -948,6 +1009,95 @@ namespace mango
     void registerImageDecoderDDS()
     {
         registerImageDecoder(createInterface, ".dds");
+        registerImageEncoder(imageEncode, ".dds");
+    }
+
+    void encodeTextureDDS(Stream& output, const Surface* faces, int count, const TextureEncoderOptions& options)
+    {
+        if (count != 1 && count != 6)
+        {
+            MANGO_EXCEPTION(ID"Incorrect number of faces.");
+        }
+
+        Format format = faces[0].format;
+        u32 dxgiFormat = 0;
+
+        if (options.compression != TextureCompression::NONE)
+        {
+            dxgiFormat = directx::getTextureFormat(options.compression);
+            if (!dxgiFormat)
+            {
+                MANGO_EXCEPTION(ID"Compression format is not supported.");
+            }
+        }
+        else
+        {
+            dxgiFormat = selectFormatDXGI(format);
+        }
+
+        TextureEncoder encoder(faces, count, options, format);
+
+        const bool compressed = options.compression != TextureCompression::NONE;
+        const bool cubemap = count == 6;
+        const int levels = encoder.levels();
+
+        u32 flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+        flags |= compressed ? DDSD_LINEARSIZE : DDSD_PITCH;
+
+        u32 caps = DDSCAPS_TEXTURE;
+        if (levels > 1)
+            caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+        if (cubemap)
+            caps |= DDSCAPS_COMPLEX;
+
+        const u32 caps2 = cubemap ? DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES : 0;
+        const u32 pitch = u32(compressed ? encoder.bytes(0) : encoder.width() * format.bytes());
+
+        LittleEndianStream s(output);
+
+        s.write32(FOURCC_DDS);
+        s.write32(124);
+        s.write32(flags);
+        s.write32(encoder.height());
+        s.write32(encoder.width());
+        s.write32(pitch);
+        s.write32(0); // depth
+        s.write32(levels);
+
+        for (int i = 0; i < 11; ++i)
+        {
+            s.write32(0); // reserved
+        }
+
+        // pixel format
+        s.write32(32);
+        s.write32(DDPF_FOURCC);
+        s.write32(FOURCC_DX10);
+        s.write32(0); // rgbBitCount
+        s.write32(0); // rBitMask
+        s.write32(0); // gBitMask
+        s.write32(0); // bBitMask
+        s.write32(0); // aBitMask
+
+        s.write32(caps);
+        s.write32(caps2);
+        s.write32(0); // caps3
+        s.write32(0); // caps4
+        s.write32(0); // reserved
+
+        // DX10 header
+        s.write32(dxgiFormat);
+        s.write32(D3D10_RESOURCE_DIMENSION_TEXTURE2D);
+        s.write32(cubemap ? D3D10_RESOURCE_MISC_TEXTURECUBE : 0);
+        s.write32(1); // arraySize
+        s.write32(0); // miscFlags2
+
+        encoder.encode(TextureEncoder::FACE_MAJOR, [&] (int face, int level, Memory memory)
+        {
+            MANGO_UNREFERENCED_PARAMETER(face);
+            MANGO_UNREFERENCED_PARAMETER(level);
+            output.write(memory);
+        });
     }
 
 } // namespace mango
@@ -9,6 +9,7 @@
 #include <mango/core/exception.hpp>
 #include <mango/core/system.hpp>
 #include <mango/image/image.hpp>
+#include <mango/image/gif.hpp>
 
 #define ID "[ImageDecoderGIF] "
 
@@ -100,18 +101,36 @@ namespace
 		int  color_table_size()  const { return 1 << ((field & 0x07) + 1); }
 	};
 
-	u8* readBits(u8*& data, int width, int height)
+	void skip_blocks(u8*& data, u8* end)
+	{
+		u8* p = data;
+
+		while (p < end)
+		{
+			u8 size = *p++;
+			if (!size) break;
+			p += size;
+		}
+
+		data = p;
+	}
+
+	void readBits(u8* q_buffer, u8*& data, u8* end, int width, int height)
 	{
         u8* p = data;
 
 		// initialize gif data stream decoder
 		const int samples = width * height;
-		u8* q_buffer = new u8[samples];
 		u8* q_buffer_end = q_buffer + samples;
 
 		const int MaxStackSize = 4096;
 
 		u8 data_size = *p++;
+		if (data_size > 11)
+		{
+			// the codes would exceed the 12 bit code size limit (MaxStackSize)
+			MANGO_EXCEPTION(ID"Incorrect LZW minimum code size.");
+		}
 
 		int clear = 1 << data_size;
 		int end_of_information = clear + 1;
@@ -143,6 +162,8 @@ namespace
 		u8 packet[256];
 		u8* c = NULL;
 
+		bool terminated = false;
+
 		while (q < q_buffer_end)
 		{
 			if (top_stack == pixel_stack)
@@ -153,16 +174,17 @@ namespace
 					if (!count)
 					{
 						// read a new data block
-						u8 block_size = *p++;
+						u8 block_size = p < end ? *p++ : 0;
 						count = block_size;
 
-						if (count > 0)
+						if (count > 0 && count <= end - p)
 						{
 							std::memcpy(packet, p, count);
 							p += count;
 						}
 						else
 						{
+							terminated = true;
 							break;
 						}
 
@@ -244,19 +266,14 @@ namespace
 			*q++ = *(--top_stack);
 		}
 
-		// read the terminator
-		u8 terminator = *p++;
-
-        data = p;
-
-        if (terminator != 0)
+		// skip to the terminator; the stream can have trailing blocks after the last
+		// sample which must be consumed before the next frame can be read
+		if (!terminated)
 		{
-			// Disable terminator check for animated gif files
-            //delete[] q_buffer;
-			//MANGO_EXCEPTION(ID"Terminator missing from the gif stream.");
+			skip_blocks(p, end);
 		}
 
-		return q_buffer;
+        data = p;
 	}
 
 	void deinterlace(u8* dest, u8* buffer, int width, int height)
@@ -334,7 +351,8 @@ namespace
         int height = image_desc.height;
 
 		// decode gif bit stream
-		u8* bits = readBits(data, width, height);
+		u8* bits = new u8[width * height];
+		readBits(bits, data, end, width, height);
 
         // deinterlace
 		if (image_desc.interlaced())
@@ -376,18 +394,12 @@ namespace
 		delete[] bits;
     }
 
-	void read_extension(u8*& data)
+	void read_extension(u8*& data, u8* end)
 	{
         u8* p = data;
 
 		++p;
-
-		for (;;)
-		{
-			u8 size = *p++;
-			p += size;
-			if (!size) break;
-		}
+		skip_blocks(p, end);
 
         data = p;
 	}
@@ -417,18 +429,13 @@ namespace
 			switch (chunkID)
 			{
 				case GIF_EXTENSION:
-					read_extension(data);
+					read_extension(data, end);
 					break;
 
 				case GIF_IMAGE:
 				{
-                    // TODO: Support animation / multiple frames. No random-access to individual frames
-                    //       would be practical so the efficient API would be "decode_next_frame()" but
-                    //       we don't really intend this interface to be for animations so it's all good. :)
-                    // NOTE: Multi-frame GIFs can also store RGB images as 16x16 image_descs with unique palette.
-                    //       This requires the decoding target to be unchanged between frames. The "animation"
-                    //       will progressively fill the screen_desc. This is a curiosity we don't feel pressed to
-                    //       support at this time.
+                    // NOTE: The ImageDecoder interface decodes the first frame; animations are
+                    //       decoded and composited frame by frame with GifDecoder.
                     read_image(data, end, screen_desc, surface, ptr_palette);
                     return;
 				}
@@ -439,6 +446,121 @@ namespace
 		}
     }
 
+	// ------------------------------------------------------------
+	// frame parser
+	// ------------------------------------------------------------
+
+	struct gif_graphic_control
+	{
+		int disposal = 0;
+		int delay = 0;
+		int transparent = -1;
+
+		void read(const u8* data, const u8* end)
+		{
+			// data points to the block size following the 0xf9 label
+			if (end - data >= 5 && data[0] >= 4)
+			{
+				u8 packed = data[1];
+				disposal = (packed >> 2) & 0x07;
+				delay = uload16le(data + 2);
+				transparent = (packed & 0x01) ? data[4] : -1;
+			}
+		}
+	};
+
+	// parse chunks up to and including the next image descriptor; the data pointer is
+	// left at the start of the LZW stream
+	bool read_frame_header(u8*& data, u8* end, gif_image_descriptor& image_desc, gif_graphic_control& control)
+	{
+		while (data < end)
+		{
+			u8 chunkID = *data++;
+
+			switch (chunkID)
+			{
+				case GIF_EXTENSION:
+					if (data < end && *data == 0xf9)
+					{
+						control = gif_graphic_control();
+						control.read(data + 1, end);
+					}
+					read_extension(data, end);
+					break;
+
+				case GIF_IMAGE:
+					image_desc.read(data, end);
+					return data < end;
+
+				case GIF_TERMINATE:
+					data = end;
+					return false;
+			}
+		}
+
+		return false;
+	}
+
+	void set_frame(GifDecoder::Frame& frame, const gif_image_descriptor& image_desc, const gif_graphic_control& control)
+	{
+		frame.left = image_desc.left;
+		frame.top = image_desc.top;
+		frame.width = image_desc.width;
+		frame.height = image_desc.height;
+		frame.delay = control.delay;
+		frame.disposal = control.disposal;
+	}
+
+	u8* gif_read_screen(Memory memory, gif_logical_screen_descriptor& screen_desc)
+	{
+		u8* data = memory.address;
+		u8* end = data + memory.size;
+
+		read_magic(data, end);
+		screen_desc.read(data, end);
+
+		if (!screen_desc.width || !screen_desc.height)
+		{
+			MANGO_EXCEPTION(ID"Incorrect logical screen dimensions.");
+		}
+
+		return data;
+	}
+
+	u8* gif_read_screen(Memory memory, int& width, int& height, Palette& palette)
+	{
+		gif_logical_screen_descriptor screen_desc;
+		u8* data = gif_read_screen(memory, screen_desc);
+
+		width = screen_desc.width;
+		height = screen_desc.height;
+
+		if (screen_desc.color_table_flag())
+		{
+			palette.size = screen_desc.color_table_size();
+
+			for (u32 i = 0; i < palette.size; ++i)
+			{
+				u32 r = screen_desc.palette[i * 3 + 0];
+				u32 g = screen_desc.palette[i * 3 + 1];
+				u32 b = screen_desc.palette[i * 3 + 2];
+				palette[i] = ColorBGRA(r, g, b, 0xff);
+			}
+		}
+
+		return data;
+	}
+
+	// clip frame rectangle to the canvas
+	bool clip_frame(const GifDecoder::Frame& frame, const Surface& canvas, int& x0, int& y0, int& x1, int& y1)
+	{
+		x0 = std::max(0, frame.left);
+		y0 = std::max(0, frame.top);
+		x1 = std::min(canvas.width, frame.left + frame.width);
+		y1 = std::min(canvas.height, frame.top + frame.height);
+		return x0 < x1 && y0 < y1;
+	}
+
     // ------------------------------------------------------------
     // ImageDecoder
     // ------------------------------------------------------------
@@ -512,4 +634,214 @@ namespace mango
         registerImageDecoder(createInterface, ".gif");
     }
 
+    // ------------------------------------------------------------
+    // GifDecoder
+    // ------------------------------------------------------------
+
+    GifDecoder::GifDecoder(Memory memory)
+        : m_memory(memory)
+        , m_width(0)
+        , m_height(0)
+        , m_start(gif_read_screen(memory, m_width, m_height, m_palette))
+        , m_canvas(m_width, m_height, FORMAT_B8G8R8A8)
+    {
+        rewind();
+    }
+
+    GifDecoder::~GifDecoder()
+    {
+    }
+
+    int GifDecoder::width() const
+    {
+        return m_width;
+    }
+
+    int GifDecoder::height() const
+    {
+        return m_height;
+    }
+
+    const Surface& GifDecoder::canvas() const
+    {
+        return m_canvas;
+    }
+
+    void GifDecoder::rewind()
+    {
+        m_current = m_start;
+        m_last = Frame();
+
+        for (int y = 0; y < m_height; ++y)
+        {
+            std::memset(m_canvas.address<u8>(0, y), 0, m_width * 4);
+        }
+    }
+
+    bool GifDecoder::next(Frame* frame)
+    {
+        Frame temp;
+        return read(frame ? *frame : temp, true);
+    }
+
+    bool GifDecoder::skip(Frame* frame)
+    {
+        Frame temp;
+        return read(frame ? *frame : temp, false);
+    }
+
+    void GifDecoder::dispose()
+    {
+        int x0, y0, x1, y1;
+
+        if (clip_frame(m_last, m_canvas, x0, y0, x1, y1))
+        {
+            const int count = x1 - x0;
+
+            if (m_last.disposal == DISPOSE_BACKGROUND)
+            {
+                for (int y = y0; y < y1; ++y)
+                {
+                    std::memset(m_canvas.address<u32>(x0, y), 0, count * 4);
+                }
+            }
+            else if (m_last.disposal == DISPOSE_PREVIOUS)
+            {
+                const u32* src = m_previous.data();
+                for (int y = y0; y < y1; ++y)
+                {
+                    std::memcpy(m_canvas.address<u32>(x0, y), src, count * 4);
+                    src += count;
+                }
+            }
+        }
+
+        m_last = Frame();
+    }
+
+    bool GifDecoder::read(Frame& frame, bool decode)
+    {
+        u8* end = m_memory.address + m_memory.size;
+
+        gif_image_descriptor image_desc;
+        gif_graphic_control control;
+
+        if (!read_frame_header(m_current, end, image_desc, control))
+        {
+            return false;
+        }
+
+        set_frame(frame, image_desc, control);
+
+        if (!decode)
+        {
+            // skip the LZW minimum code size and the data sub-blocks
+            ++m_current;
+            skip_blocks(m_current, end);
+            m_last = Frame();
+            return true;
+        }
+
+        // apply previous frame's disposal method before drawing over the canvas
+        dispose();
+
+        const int width = image_desc.width;
+        const int height = image_desc.height;
+
+        Palette palette = m_palette;
+
+        if (image_desc.local_color_table())
+        {
+            palette.size = image_desc.color_table_size();
+
+            for (u32 i = 0; i < palette.size; ++i)
+            {
+                u32 r = image_desc.palette[i * 3 + 0];
+                u32 g = image_desc.palette[i * 3 + 1];
+                u32 b = image_desc.palette[i * 3 + 2];
+                palette[i] = ColorBGRA(r, g, b, 0xff);
+            }
+        }
+
+        m_bits.resize(width * height);
+        readBits(m_bits.data(), m_current, end, width, height);
+
+        const u8* bits = m_bits.data();
+
+        if (image_desc.interlaced())
+        {
+            m_deinterlace.resize(width * height);
+            deinterlace(m_deinterlace.data(), m_bits.data(), width, height);
+            bits = m_deinterlace.data();
+        }
+
+        int x0, y0, x1, y1;
+
+        if (clip_frame(frame, m_canvas, x0, y0, x1, y1))
+        {
+            const int count = x1 - x0;
+
+            if (frame.disposal == DISPOSE_PREVIOUS)
+            {
+                // store the area under the frame so that it can be restored
+                m_previous.resize(count * (y1 - y0));
+                u32* dest = m_previous.data();
+                for (int y = y0; y < y1; ++y)
+                {
+                    std::memcpy(dest, m_canvas.address<u32>(x0, y), count * 4);
+                    dest += count;
+                }
+            }
+
+            const int transparent = control.transparent;
+
+            for (int y = y0; y < y1; ++y)
+            {
+                const u8* src = bits + (y - frame.top) * width + (x0 - frame.left);
+                u32* dest = m_canvas.address<u32>(x0, y);
+
+                for (int x = 0; x < count; ++x)
+                {
+                    const int index = src[x];
+                    if (index != transparent)
+                    {
+                        dest[x] = palette[index];
+                    }
+                }
+            }
+        }
+
+        m_last = frame;
+
+        return true;
+    }
+
+    std::vector<GifDecoder::Frame> GifDecoder::index(Memory memory)
+    {
+        std::vector<Frame> frames;
+
+        gif_logical_screen_descriptor screen_desc;
+        u8* data = gif_read_screen(memory, screen_desc);
+        u8* end = memory.address + memory.size;
+
+        gif_image_descriptor image_desc;
+        gif_graphic_control control;
+
+        while (read_frame_header(data, end, image_desc, control))
+        {
+            Frame frame;
+            set_frame(frame, image_desc, control);
+            frames.push_back(frame);
+
+            // skip the LZW minimum code size and the data sub-blocks
+            ++data;
+            skip_blocks(data, end);
+
+            control = gif_graphic_control();
+            image_desc = gif_image_descriptor();
+        }
+
+        return frames;
+    }
+
 } // namespace mango
@@ -3,11 +3,16 @@
     Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #include <cmath>
+#include <algorithm>
 #include <mango/core/pointer.hpp>
 #include <mango/core/buffer.hpp>
 #include <mango/core/exception.hpp>
+#include <mango/core/string.hpp>
 #include <mango/core/system.hpp>
+#include <mango/core/thread.hpp>
 #include <mango/image/image.hpp>
+#include <mango/image/blitter.hpp>
+#include <mango/math/vector.hpp>
 
 #define ID "[ImageDecoder.HDR] "
 
@@ -117,15 +122,6 @@ namespace
     // decoder
     // ------------------------------------------------------------
 
-	void write_rgbe(float* buffer, u8 r, u8 g, u8 b, u8 e)
-	{
-		float v = e ? std::ldexp(1.0f, e - 136) : 0;
-		buffer[0] = r * v;
-		buffer[1] = g * v;
-		buffer[2] = b * v;
-		buffer[3] = 1.0f;
-	}
-
 	struct radheader
 	{
 		enum radformat
@@ -231,77 +227,257 @@ namespace
 		}
 	};
 
-    void hdr_decode(Surface& surface, const u8* data)
+    // RGBE is (r, g, b) * 2^(e - 136); the scale is constructed directly
+    // into the floating-point exponent so no ldexp() is needed per pixel.
+
+    inline float32x4 rgbe_to_float(u32 rgbe)
     {
-        Buffer buffer(surface.width * 4);
+        int32x4 i;
+        i.unpack(rgbe);
+        int32x4 e = i.wwww;
+
+        float32x4 scale = reinterpret<float32x4>((e - 1) << 23);
+        float32x4 f = convert<float32x4>(i) * (scale * (1.0f / 256.0f));
+        f = select(e == 0, float32x4(0.0f), f);
+        f.w = 1.0f;
+        return f;
+    }
 
-		for (int y = 0; y < surface.height; ++y)
-		{
-			if (data[0] != 2 || data[1] != 2 || data[2] & 0x80)
-			{
-				MANGO_EXCEPTION(ID"Incorrect rle_rgbe stream (wrong header).");
-			}
+    void rgbe_to_rgba32f(u8* dest, const u32* src, int count)
+    {
+        float32x4* d = reinterpret_cast<float32x4*>(dest);
+        for (int x = 0; x < count; ++x)
+        {
+            d[x] = rgbe_to_float(src[x]);
+        }
+    }
 
-			if (((data[2] << 8) | data[3]) != surface.width)
-			{
-				MANGO_EXCEPTION(ID"Incorrect rle_rgbe stream (wrong scan).");
-			}
+    void rgbe_to_rgba16f(u8* dest, const u32* src, int count)
+    {
+        float16x4* d = reinterpret_cast<float16x4*>(dest);
+        for (int x = 0; x < count; ++x)
+        {
+            d[x] = convert<float16x4>(rgbe_to_float(src[x]));
+        }
+    }
 
-			data += 4;
-			u8* p = buffer;
+    struct rgbe_scanline
+    {
+        const u8* data;
+        bool rle;
+    };
 
-			for (int i = 0; i < 4; ++i)
-			{
-				u8* end = buffer + (i + 1) * surface.width;
+    // Walk the stream once without decoding to locate the scanlines; all validation
+    // is done here so that the scanlines can be decoded independently in any order.
+    std::vector<rgbe_scanline> hdr_scan(const u8* data, const u8* end, int width, int height)
+    {
+        std::vector<rgbe_scanline> scanlines(height);
 
-				while (p < end)
-				{
-					int count = data[0];
-					int value = data[1];
+        const bool rle_width = width >= 8 && width <= 0x7fff;
+
+        for (int y = 0; y < height; ++y)
+        {
+            if (end - data < 4)
+            {
+                MANGO_EXCEPTION(ID"Incorrect rle_rgbe stream (out of data).");
+            }
+
+            const bool rle = rle_width && data[0] == 2 && data[1] == 2 && !(data[2] & 0x80);
+
+            scanlines[y].data = data;
+            scanlines[y].rle = rle;
+
+            if (rle)
+            {
+                if (((data[2] << 8) | data[3]) != width)
+                {
+                    MANGO_EXCEPTION(ID"Incorrect rle_rgbe stream (wrong scan).");
+                }
+
+                data += 4;
+
+                for (int i = 0; i < 4; ++i)
+                {
+                    for (int x = 0; x < width; )
+                    {
+                        if (end - data < 2)
+                        {
+                            MANGO_EXCEPTION(ID"Incorrect rle_rgbe stream (out of data).");
+                        }
+
+                        int count = data[0];
+                        if (count > 128)
+                        {
+                            count -= 128;
+                            data += 2;
+                        }
+                        else
+                        {
+                            data += 1 + count;
+                        }
+
+                        if (!count || count > width - x)
+                        {
+                            MANGO_EXCEPTION(ID"Incorrect rle_rgbe stream (rle count).");
+                        }
+
+                        x += count;
+                    }
+                }
+
+                if (data > end)
+                {
+                    MANGO_EXCEPTION(ID"Incorrect rle_rgbe stream (out of data).");
+                }
+            }
+            else
+            {
+                if (end - data < width * 4)
+                {
+                    MANGO_EXCEPTION(ID"Incorrect rle_rgbe stream (out of data).");
+                }
+
+                for (int x = 0; x < width; ++x)
+                {
+                    if (data[0] == 1 && data[1] == 1 && data[2] == 1)
+                    {
+                        MANGO_EXCEPTION(ID"Unsupported rle_rgbe stream (old rle).");
+                    }
+
+                    data += 4;
+                }
+            }
+        }
+
+        return scanlines;
+    }
+
+    void hdr_decode_scanline(u32* dest, u8* temp, const rgbe_scanline& scanline, int width)
+    {
+        const u8* data = scanline.data;
+
+        if (!scanline.rle)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                dest[x] = uload32le(data + x * 4);
+            }
+
+            return;
+        }
+
+        data += 4;
+        u8* p = temp;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            u8* end = temp + (i + 1) * width;
+
+            while (p < end)
+            {
+                int count = data[0];
+                int value = data[1];
+
+                if (count > 128)
+                {
+                    count -= 128;
+                    std::memset(p, value, count);
+                    p += count;
                     data += 2;
+                }
+                else
+                {
+                    std::memcpy(p, data + 1, count);
+                    p += count;
+                    data += 1 + count;
+                }
+            }
+        }
 
-					if (count > 128)
-					{
-						count -= 128;
-						if (!count || count > (end - p))
-						{
-							MANGO_EXCEPTION(ID"Incorrect rle_rgbe stream (rle count).");
-						}
-
-						std::memset(p, value, count);
-						p += count;
-					}
-					else
-					{
-						if (!count || count > (end - p))
-						{
-							MANGO_EXCEPTION(ID"Incorrect rle_rgbe stream (rle count).");
-						}
-
-						*p++ = static_cast<u8>(value);
-
-						if (--count > 0)
-						{
-							std::memcpy(p, data, count);
-							data += count;
-							p += count;
-						}
-					}
-				}
-			}
+        const u8* r = temp + width * 0;
+        const u8* g = temp + width * 1;
+        const u8* b = temp + width * 2;
+        const u8* e = temp + width * 3;
 
-            float* image = surface.address<float>(0, y);
+        for (int x = 0; x < width; ++x)
+        {
+            dest[x] = r[x] | (g[x] << 8) | (b[x] << 16) | (e[x] << 24);
+        }
+    }
 
-			for (int x = 0; x < surface.width; ++x)
-			{
-				u8 r = buffer[x + surface.width * 0];
-				u8 g = buffer[x + surface.width * 1];
-				u8 b = buffer[x + surface.width * 2];
-				u8 e = buffer[x + surface.width * 3];
-				write_rgbe(image, r, g, b, e);
-				image += 4;
-			}
-		}
+    void hdr_decode(Surface& dest, const std::vector<rgbe_scanline>& scanlines, int width)
+    {
+        const int height = std::min(dest.height, int(scanlines.size()));
+        const int count = std::min(dest.width, width);
+
+        const bool rgba32f = dest.format == FORMAT_RGBA32F;
+        const bool rgba16f = dest.format == FORMAT_RGBA16F;
+
+        // other formats are expanded to FP32 one scanline at a time and converted in-place
+        Blitter blitter(dest.format, FORMAT_RGBA32F);
+
+        ConcurrentQueue queue("hdr.decoder", Priority::HIGH);
+
+        // a few tasks per thread to even out the load between simple and complex scanlines
+        const int N = std::max(1, std::min(height, ThreadPool::getInstanceSize() * 4));
+        const int section = height / N;
+
+        int ypos = 0;
+
+        for (int i = 0; i < N; ++i)
+        {
+            const bool last = (i == (N - 1));
+            const int y0 = ypos;
+            const int y1 = last ? height : ypos + section;
+
+            queue.enqueue([=, &dest, &scanlines, &blitter]
+            {
+                std::vector<u32> rgbe(width);
+                std::vector<u8> temp(width * 4);
+                std::vector<float32x4> row;
+
+                if (!rgba32f && !rgba16f)
+                {
+                    row.resize(width);
+                }
+
+                for (int y = y0; y < y1; ++y)
+                {
+                    hdr_decode_scanline(rgbe.data(), temp.data(), scanlines[y], width);
+
+                    u8* image = dest.address<u8>(0, y);
+
+                    if (rgba32f)
+                    {
+                        rgbe_to_rgba32f(image, rgbe.data(), count);
+                    }
+                    else if (rgba16f)
+                    {
+                        rgbe_to_rgba16f(image, rgbe.data(), count);
+                    }
+                    else
+                    {
+                        u8* src = reinterpret_cast<u8*>(row.data());
+                        rgbe_to_rgba32f(src, rgbe.data(), count);
+
+                        BlitRect rect;
+
+                        rect.srcImage = src;
+                        rect.srcStride = count * 16;
+                        rect.destImage = image;
+                        rect.destStride = dest.stride;
+                        rect.width = count;
+                        rect.height = 1;
+
+                        blitter.convert(rect);
+                    }
+                }
+            });
+
+            ypos += section;
+        }
+
+        queue.wait();
     }
 
     // ------------------------------------------------------------
@@ -312,6 +488,7 @@ namespace
     {
         radheader m_header;
         const u8* m_data;
+        const u8* m_end;
 
         Interface(Memory memory)
         {
@@ -319,6 +496,7 @@ namespace
             const u8* end = memory.address + memory.size;
             m_header.parse(data, end);
             m_data = data;
+            m_end = end;
         }
 
         ~Interface()
@@ -348,25 +526,215 @@ namespace
             MANGO_UNREFERENCED_PARAMETER(depth);
             MANGO_UNREFERENCED_PARAMETER(face);
 
-            const Format decoder_format = FORMAT_RGBA32F;
+            std::vector<rgbe_scanline> scanlines = hdr_scan(m_data, m_end, m_header.width, m_header.height);
+            hdr_decode(dest, scanlines, m_header.width);
+        }
+    };
 
-            if (dest.format == decoder_format)
+    ImageDecoderInterface* createInterface(Memory memory)
+    {
+        ImageDecoderInterface* x = new Interface(memory);
+        return x;
+    }
+
+    // ------------------------------------------------------------
+    // ImageEncoder
+    // ------------------------------------------------------------
+
+    u32 float_to_rgbe(const float* rgb)
+    {
+        const float v = std::max(rgb[0], std::max(rgb[1], rgb[2]));
+        if (v < 1e-32f)
+        {
+            return 0;
+        }
+
+        int e;
+        const float scale = std::frexp(v, &e) * 256.0f / v;
+        if (e > 127)
+        {
+            // out of representable range; saturate to the largest value
+            return 0xffffffff;
+        }
+
+        u32 r = u32(std::max(rgb[0], 0.0f) * scale);
+        u32 g = u32(std::max(rgb[1], 0.0f) * scale);
+        u32 b = u32(std::max(rgb[2], 0.0f) * scale);
+        return r | (g << 8) | (b << 16) | (u32(e + 128) << 24);
+    }
+
+    // run-length encode one channel of a scanline (runs of at least 4 bytes)
+    void rle_encode_channel(Buffer& buffer, const u8* data, int count)
+    {
+        constexpr int min_run = 4;
+
+        int cur = 0;
+
+        while (cur < count)
+        {
+            int run_begin = cur;
+            int run_count = 0;
+            int old_run_count = 0;
+
+            // find next run of sufficient length
+            while (run_count < min_run && run_begin < count)
             {
-                hdr_decode(dest, m_data);
+                run_begin += run_count;
+                old_run_count = run_count;
+                run_count = 1;
+
+                while (run_begin + run_count < count && run_count < 127 &&
+                       data[run_begin] == data[run_begin + run_count])
+                {
+                    ++run_count;
+                }
             }
-            else
+
+            // short run immediately before the long one
+            if (old_run_count > 1 && old_run_count == run_begin - cur)
+            {
+                u8 temp[] = { u8(128 + old_run_count), data[cur] };
+                buffer.write(temp, 2);
+                cur = run_begin;
+            }
+
+            // literals up to the run
+            while (cur < run_begin)
             {
-                Bitmap temp(m_header.width, m_header.height, decoder_format);
-                hdr_decode(temp, m_data);
-                dest.blit(0, 0, temp);
+                u8 literals = u8(std::min(128, run_begin - cur));
+                buffer.write(&literals, 1);
+                buffer.write(data + cur, literals);
+                cur += literals;
+            }
+
+            if (run_count >= min_run)
+            {
+                u8 temp[] = { u8(128 + run_count), data[run_begin] };
+                buffer.write(temp, 2);
+                cur += run_count;
             }
         }
-    };
+    }
 
-    ImageDecoderInterface* createInterface(Memory memory)
+    void hdr_encode_scanline(Buffer& buffer, u8* temp, const float* image, int width)
     {
-        ImageDecoderInterface* x = new Interface(memory);
-        return x;
+        const bool rle = width >= 8 && width <= 0x7fff;
+
+        if (!rle)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                u8 rgbe[4];
+                ustore32le(rgbe, float_to_rgbe(image + x * 4));
+                buffer.write(rgbe, 4);
+            }
+
+            return;
+        }
+
+        for (int x = 0; x < width; ++x)
+        {
+            u32 rgbe = float_to_rgbe(image + x * 4);
+            temp[x + width * 0] = u8(rgbe >> 0);
+            temp[x + width * 1] = u8(rgbe >> 8);
+            temp[x + width * 2] = u8(rgbe >> 16);
+            temp[x + width * 3] = u8(rgbe >> 24);
+        }
+
+        u8 header[] = { 2, 2, u8(width >> 8), u8(width) };
+        buffer.write(header, 4);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            rle_encode_channel(buffer, temp + width * i, width);
+        }
+    }
+
+    void imageEncode(Stream& stream, const Surface& surface, float quality)
+    {
+        MANGO_UNREFERENCED_PARAMETER(quality);
+
+        const int width = surface.width;
+        const int height = surface.height;
+
+        std::string header = makeString("#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %d +X %d\n", height, width);
+        stream.write(header.c_str(), header.length());
+
+        const bool rgba32f = surface.format == FORMAT_RGBA32F;
+        const bool rgba16f = surface.format == FORMAT_RGBA16F;
+
+        Blitter blitter(FORMAT_RGBA32F, surface.format);
+
+        ConcurrentQueue queue("hdr.encoder", Priority::HIGH);
+
+        const int N = std::max(1, std::min(height, ThreadPool::getInstanceSize() * 4));
+        const int section = height / N;
+
+        // each task encodes into it's own buffer which are written in order at the end
+        std::vector<Buffer> buffers(N);
+
+        int ypos = 0;
+
+        for (int i = 0; i < N; ++i)
+        {
+            const bool last = (i == (N - 1));
+            const int y0 = ypos;
+            const int y1 = last ? height : ypos + section;
+
+            queue.enqueue([=, &surface, &blitter, &buffers]
+            {
+                std::vector<u8> temp(width * 4);
+                std::vector<float32x4> row;
+
+                if (!rgba32f)
+                {
+                    row.resize(width);
+                }
+
+                for (int y = y0; y < y1; ++y)
+                {
+                    const float* image = surface.address<float>(0, y);
+
+                    if (rgba16f)
+                    {
+                        const float16x4* src = surface.address<float16x4>(0, y);
+                        for (int x = 0; x < width; ++x)
+                        {
+                            row[x] = convert<float32x4>(src[x]);
+                        }
+
+                        image = reinterpret_cast<const float*>(row.data());
+                    }
+                    else if (!rgba32f)
+                    {
+                        BlitRect rect;
+
+                        rect.srcImage = surface.address<u8>(0, y);
+                        rect.srcStride = surface.stride;
+                        rect.destImage = reinterpret_cast<u8*>(row.data());
+                        rect.destStride = width * sizeof(float32x4);
+                        rect.width = width;
+                        rect.height = 1;
+
+                        blitter.convert(rect);
+
+                        image = reinterpret_cast<const float*>(row.data());
+                    }
+
+                    hdr_encode_scanline(buffers[i], temp.data(), image, width);
+                }
+            });
+
+            ypos += section;
+        }
+
+        queue.wait();
+
+        for (int i = 0; i < N; ++i)
+        {
+            Memory memory = buffers[i];
+            stream.write(memory.address, memory.size);
+        }
     }
 
 } // namespace
@@ -377,6 +745,7 @@ namespace mango
     void registerImageDecoderHDR()
     {
         registerImageDecoder(createInterface, ".hdr");
+        registerImageEncoder(imageEncode, ".hdr");
     }
 
 } // namespace mango
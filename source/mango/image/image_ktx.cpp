@@ -7,6 +7,7 @@
 #include <mango/core/exception.hpp>
 #include <mango/image/image.hpp>
 #include <mango/opengl/opengl.hpp>
+#include "texture.hpp"
 
 #define ID "[ImageDecoder.KTX] "
 
@@ -158,6 +159,43 @@ glBaseInternalFormat:
 
 #endif
 
+    // ----------------------------------------------------------------------------
+    // formats
+    // ----------------------------------------------------------------------------
+
+    enum
+    {
+        KTX_UNSIGNED_BYTE     = 0x1401,
+        KTX_FLOAT             = 0x1406,
+        KTX_HALF_FLOAT        = 0x140b,
+        KTX_RED               = 0x1903,
+        KTX_RGB               = 0x1907,
+        KTX_RGBA              = 0x1908,
+        KTX_RG                = 0x8227,
+        KTX_RGBA8             = 0x8058,
+        KTX_SRGB8_ALPHA8      = 0x8c43,
+        KTX_RGBA16F           = 0x881a,
+        KTX_RGBA32F           = 0x8814
+    };
+
+    struct FormatKTX
+    {
+        Format format;
+        u32 glType;
+        u32 glTypeSize;
+        u32 glFormat;
+        u32 glInternalFormat;
+    };
+
+    // uncompressed storage formats
+    const FormatKTX g_ktx_format_table[] =
+    {
+        { FORMAT_R8G8B8A8, KTX_UNSIGNED_BYTE, 1, KTX_RGBA, KTX_RGBA8 },
+        { Format(32, Format::SRGB, Format::RGBA, 8, 8, 8, 8), KTX_UNSIGNED_BYTE, 1, KTX_RGBA, KTX_SRGB8_ALPHA8 },
+        { FORMAT_RGBA16F, KTX_HALF_FLOAT, 2, KTX_RGBA, KTX_RGBA16F },
+        { FORMAT_RGBA32F, KTX_FLOAT, 4, KTX_RGBA, KTX_RGBA32F },
+    };
+
     // ----------------------------------------------------------------------------
     // header
     // ----------------------------------------------------------------------------
@@ -267,6 +305,16 @@ glBaseInternalFormat:
 #endif
                 {
                     format = FORMAT_NONE;
+
+                    // the formats written by the encoder
+                    for (const auto& node : g_ktx_format_table)
+                    {
+                        if (node.glInternalFormat == glInternalFormat && node.glType == glType)
+                        {
+                            format = node.format;
+                            break;
+                        }
+                    }
                 }
             }
 
@@ -378,6 +426,45 @@ glBaseInternalFormat:
         return x;
     }
 
+    // ------------------------------------------------------------
+    // ImageEncoder
+    // ------------------------------------------------------------
+
+    // The format is changed to the closest supported one when there is no exact match.
+    const FormatKTX& selectFormatKTX(Format& format)
+    {
+        for (const auto& node : g_ktx_format_table)
+        {
+            if (node.format == format)
+                return node;
+        }
+
+        switch (format.type)
+        {
+            case Format::FP16:
+            case Format::FP32:
+            case Format::FP64:
+                format = g_ktx_format_table[3].format;
+                return g_ktx_format_table[3];
+
+            case Format::SRGB:
+                format = g_ktx_format_table[1].format;
+                return g_ktx_format_table[1];
+
+            default:
+                format = g_ktx_format_table[0].format;
+                return g_ktx_format_table[0];
+        }
+    }
+
+    void imageEncode(Stream& stream, const Surface& surface, float quality)
+    {
+        MANGO_UNREFERENCED_PARAMETER(quality);
+
+        TextureEncoderOptions options;
+        encodeTextureKTX(stream, &surface, 1, options);
+    }
+
 } // namespace
 
 namespace mango
@@ -386,6 +473,92 @@ namespace mango
     void registerImageDecoderKTX()
     {
         registerImageDecoder(createInterface, ".ktx");
+        registerImageEncoder(imageEncode, ".ktx");
+    }
+
+    void encodeTextureKTX(Stream& output, const Surface* faces, int count, const TextureEncoderOptions& options)
+    {
+        if (count != 1 && count != 6)
+        {
+            MANGO_EXCEPTION(ID"Incorrect number of faces.");
+        }
+
+        Format format = faces[0].format;
+
+        u32 glType = 0;
+        u32 glTypeSize = 1;
+        u32 glFormat = 0;
+        u32 glInternalFormat = 0;
+        u32 glBaseInternalFormat = 0;
+
+        if (options.compression != TextureCompression::NONE)
+        {
+            TextureCompressionInfo info(options.compression);
+
+            glInternalFormat = opengl::getTextureFormat(options.compression);
+            if (!glInternalFormat)
+            {
+                MANGO_EXCEPTION(ID"Compression format is not supported.");
+            }
+
+            if (info.getCompressionFormat() == TextureCompressionInfo::RGTC)
+            {
+                glBaseInternalFormat = info.bytes == 8 ? KTX_RED : KTX_RG;
+            }
+            else
+            {
+                glBaseInternalFormat = info.getCompressionFlags() & TextureCompressionInfo::ALPHA ? KTX_RGBA : KTX_RGB;
+            }
+        }
+        else
+        {
+            const FormatKTX& node = selectFormatKTX(format);
+            glType = node.glType;
+            glTypeSize = node.glTypeSize;
+            glFormat = node.glFormat;
+            glInternalFormat = node.glInternalFormat;
+            glBaseInternalFormat = node.glFormat;
+        }
+
+        TextureEncoder encoder(faces, count, options, format);
+
+        const u8 identifier[] =
+        {
+            0xab, 0x4b, 0x54, 0x58, 0x20, 0x31,
+            0x31, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a
+        };
+
+        LittleEndianStream s(output);
+
+        s.write(identifier, 12);
+        s.write32(0x04030201);
+        s.write32(glType);
+        s.write32(glTypeSize);
+        s.write32(glFormat);
+        s.write32(glInternalFormat);
+        s.write32(glBaseInternalFormat);
+        s.write32(encoder.width());
+        s.write32(encoder.height());
+        s.write32(0); // pixelDepth
+        s.write32(0); // numberOfArrayElements
+        s.write32(encoder.faces());
+        s.write32(encoder.levels());
+        s.write32(0); // bytesOfKeyValueData
+
+        encoder.encode(TextureEncoder::LEVEL_MAJOR, [&] (int face, int level, Memory memory)
+        {
+            if (!face)
+            {
+                // the size of one face for cube maps
+                s.write32(u32(encoder.bytes(level)));
+            }
+
+            output.write(memory);
+
+            // cube and mip padding
+            const u8 zero[4] = { 0, 0, 0, 0 };
+            s.write(zero, (4 - memory.size) & 3);
+        });
     }
 
 } // namespace mango
@@ -2,6 +2,8 @@
     MANGO Multimedia Development Platform
     Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
+#include <memory>
+#include <vector>
 #include <mango/core/core.hpp>
 #include <mango/image/image.hpp>
 #include "../../external/zpng/zpng.h"
@@ -60,11 +62,206 @@ namespace
         return format;
     }
     
+    bool resolve_layout(const Format& format, int& channels, int& bytes_per_channel)
+    {
+        // inverse of resolve_format(); formats which can be compressed without conversion
+        const struct
+        {
+            int channels;
+            int bytes_per_channel;
+        }
+        layouts[] = { { 1, 1 }, { 3, 1 }, { 4, 1 }, { 1, 2 }, { 3, 2 }, { 4, 2 } };
+
+        for (auto layout : layouts)
+        {
+            if (format == resolve_format(layout.channels, layout.bytes_per_channel))
+            {
+                channels = layout.channels;
+                bytes_per_channel = layout.bytes_per_channel;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // ------------------------------------------------------------
+    // tiled container
+    // ------------------------------------------------------------
+
+    /*
+        The tiled variant splits the image into horizontal tiles which are complete
+        ZPNG streams and can be (de)compressed concurrently.
+
+        u16le  magic (0xfbf9)
+        u16le  width
+        u16le  height
+        u8     channels
+        u8     bytes_per_channel
+        u32le  tile_height
+        u32le  tile_count
+        u32le  tile_bytes[tile_count]
+        u8     tiles[]
+    */
+
+    constexpr u16 zpng_tiled_magic = 0xfbf9;
+    constexpr int zpng_tile_height = 128;
+
+    struct zpng_tiled_header
+    {
+        zpng_header header;
+        int tile_height;
+        int tile_count;
+        std::vector<ZPNG_Buffer> tiles;
+
+        void read(Memory memory)
+        {
+            LittleEndianPointer p = memory.address;
+            const u8* end = memory.address + memory.size;
+
+            if (memory.size < 16)
+            {
+                MANGO_EXCEPTION(ID"Out of data.");
+            }
+
+            header.magic = p.read16();
+            header.width = p.read16();
+            header.height = p.read16();
+            header.channels = p.read8();
+            header.bytes_per_channel = p.read8();
+            tile_height = p.read32();
+            tile_count = p.read32();
+
+            if (tile_height < 1 || tile_count != (header.height + tile_height - 1) / tile_height ||
+                (end - p) / 4 < tile_count)
+            {
+                MANGO_EXCEPTION(ID"Incorrect tile header.");
+            }
+
+            tiles.resize(tile_count);
+
+            u8* data = p + tile_count * 4;
+
+            for (int i = 0; i < tile_count; ++i)
+            {
+                u32 bytes = p.read32();
+                if (u32(end - data) < bytes)
+                {
+                    MANGO_EXCEPTION(ID"Out of data.");
+                }
+
+                tiles[i].Data = data;
+                tiles[i].Bytes = bytes;
+                data += bytes;
+            }
+        }
+    };
+
+    void decode_tiled(Surface& dest, const zpng_tiled_header& tiled)
+    {
+        const int width = tiled.header.width;
+        const int height = tiled.header.height;
+        const int channels = tiled.header.channels;
+        const int bytes_per_channel = tiled.header.bytes_per_channel;
+        const Format format = resolve_format(channels, bytes_per_channel);
+
+        const bool direct = dest.format == format && dest.width == width && dest.height == height;
+
+        Blitter blitter(dest.format, format);
+
+        ConcurrentQueue queue("zpng.decoder", Priority::HIGH);
+        std::atomic<bool> failed { false };
+
+        const int N = std::min(tiled.tile_count, ThreadPool::getInstanceSize());
+
+        for (int task = 0; task < N; ++task)
+        {
+            queue.enqueue([=, &dest, &tiled, &blitter, &failed]
+            {
+                // the zstd context is reused for every tile the task decompresses
+                ZSTD_DCtx* context = ZSTD_createDCtx();
+                std::vector<u8> temp;
+
+                for (int i = task; i < tiled.tile_count; i += N)
+                {
+                    const int y0 = i * tiled.tile_height;
+                    const int y1 = std::min(height, y0 + tiled.tile_height);
+
+                    if (direct)
+                    {
+                        ZPNG_ImageData z;
+
+                        z.Buffer.Data = dest.address<u8>(0, y0);
+                        z.Buffer.Bytes = 0;
+                        z.BytesPerChannel = bytes_per_channel;
+                        z.Channels = channels;
+                        z.WidthPixels = width;
+                        z.HeightPixels = y1 - y0;
+                        z.StrideBytes = dest.stride;
+
+                        if (!ZPNG_DecompressInto(context, tiled.tiles[i], &z))
+                        {
+                            failed = true;
+                        }
+                    }
+                    else
+                    {
+                        const int stride = width * channels * bytes_per_channel;
+                        temp.resize(size_t(stride) * (y1 - y0));
+
+                        ZPNG_ImageData z;
+
+                        z.Buffer.Data = temp.data();
+                        z.Buffer.Bytes = 0;
+                        z.BytesPerChannel = bytes_per_channel;
+                        z.Channels = channels;
+                        z.WidthPixels = width;
+                        z.HeightPixels = y1 - y0;
+                        z.StrideBytes = stride;
+
+                        if (ZPNG_DecompressInto(context, tiled.tiles[i], &z))
+                        {
+                            BlitRect rect;
+
+                            rect.srcImage = temp.data();
+                            rect.srcStride = stride;
+                            rect.destImage = dest.address<u8>(0, std::min(dest.height, y0));
+                            rect.destStride = dest.stride;
+                            rect.width = std::min(dest.width, width);
+                            rect.height = std::max(0, std::min(dest.height, y1) - y0);
+
+                            blitter.convert(rect);
+                        }
+                        else
+                        {
+                            failed = true;
+                        }
+                    }
+                }
+
+                ZSTD_freeDCtx(context);
+            });
+        }
+
+        queue.wait();
+
+        if (failed)
+        {
+            MANGO_EXCEPTION(ID"Incorrect tile data.");
+        }
+    }
+
+	// ------------------------------------------------------------
+	// ImageDecoder
+	// ------------------------------------------------------------
+
     struct Interface : ImageDecoderInterface
     {
         ZPNG_Buffer m_buffer;
+        Memory m_memory;
 
         Interface(Memory memory)
+            : m_memory(memory)
         {
             m_buffer.Data = memory.address;
             m_buffer.Bytes = static_cast<unsigned int>(memory.size);
@@ -76,8 +273,13 @@ namespace
 
         ImageHeader header() override
         {
+            if (m_memory.size < sizeof(zpng_header))
+            {
+                MANGO_EXCEPTION(ID"Out of data.");
+            }
+
             zpng_header *zheader = reinterpret_cast<zpng_header *>(m_buffer.Data);
-            if (zheader->magic != 0xfbf8)
+            if (zheader->magic != 0xfbf8 && zheader->magic != zpng_tiled_magic)
             {
                 MANGO_EXCEPTION(ID"Incorrect identifier.");
             }
@@ -108,30 +310,44 @@ namespace
             MANGO_UNREFERENCED_PARAMETER(depth);
             MANGO_UNREFERENCED_PARAMETER(face);
 
-            ZPNG_ImageData z = ZPNG_Decompress(m_buffer);
-            if (z.Buffer.Data)
-            {
-                Format format = resolve_format(z.Channels, z.BytesPerChannel);
-
-                /*
-                Bitmap temp(z.WidthPixels, z.HeightPixels, format);
+            ImageHeader header = this->header();
+            zpng_header *zheader = reinterpret_cast<zpng_header *>(m_buffer.Data);
 
-                u8* d = temp.image;
-                u8* s = z.Buffer.Data;
-                int bytes = temp.width * format.bytes();
+            if (zheader->magic == zpng_tiled_magic)
+            {
+                zpng_tiled_header tiled;
+                tiled.read(m_memory);
+                decode_tiled(dest, tiled);
+                return;
+            }
 
-                for (int y = 0; y < temp.height; ++y)
+            if (dest.format == header.format && dest.width == header.width && dest.height == header.height)
+            {
+                // decompress directly into the destination surface
+                ZPNG_ImageData z;
+
+                z.Buffer.Data = dest.image;
+                z.Buffer.Bytes = 0;
+                z.BytesPerChannel = zheader->bytes_per_channel;
+                z.Channels = zheader->channels;
+                z.WidthPixels = header.width;
+                z.HeightPixels = header.height;
+                z.StrideBytes = dest.stride;
+
+                if (!ZPNG_DecompressInto(nullptr, m_buffer, &z))
                 {
-                    std::memcpy(d, s, bytes);
-                    d += temp.stride;
-                    s += z.StrideBytes;
+                    MANGO_EXCEPTION(ID"Decompression failed.");
                 }
-                */
 
+                return;
+            }
+
+            ZPNG_ImageData z = ZPNG_Decompress(m_buffer);
+            if (z.Buffer.Data)
+            {
+                Format format = resolve_format(z.Channels, z.BytesPerChannel);
                 Surface temp(z.WidthPixels, z.HeightPixels, format, z.StrideBytes, z.Buffer.Data);
-                
                 dest.blit(0, 0, temp);
-                
                 ZPNG_Free(&z.Buffer);
             }
         }
@@ -151,23 +367,42 @@ namespace
     {
         MANGO_UNREFERENCED_PARAMETER(quality);
 
-        // TODO: optimize encoder
-        Bitmap temp(surface.width, surface.height, Format(32, Format::UNORM, Format::RGBA, 8, 8, 8, 8));
-        temp.blit(0, 0, surface);
-
         ZPNG_ImageData z;
 
-        z.Buffer.Data = temp.image;
         z.Buffer.Bytes = 0;
-
-        z.BytesPerChannel = 1;
-        z.Channels = 4;
         z.WidthPixels = surface.width;
         z.HeightPixels = surface.height;
-        z.StrideBytes = temp.stride;
+
+        int channels;
+        int bytes_per_channel;
+
+        std::unique_ptr<Bitmap> temp;
+
+        if (resolve_layout(surface.format, channels, bytes_per_channel))
+        {
+            // compress directly from the source surface
+            z.Buffer.Data = surface.image;
+            z.BytesPerChannel = bytes_per_channel;
+            z.Channels = channels;
+            z.StrideBytes = surface.stride;
+        }
+        else
+        {
+            temp.reset(new Bitmap(surface.width, surface.height, FORMAT_R8G8B8A8));
+            temp->blit(0, 0, surface);
+
+            z.Buffer.Data = temp->image;
+            z.BytesPerChannel = 1;
+            z.Channels = 4;
+            z.StrideBytes = temp->stride;
+        }
 
         // compress image
         ZPNG_Buffer buf = ZPNG_Compress(&z);
+        if (!buf.Data)
+        {
+            MANGO_EXCEPTION(ID"Compression failed.");
+        }
 
         // write compressed bytes into the result stream
         stream.write(buf.Data, buf.Bytes);
@@ -176,6 +411,125 @@ namespace
         ZPNG_Free(&buf);
     }
 
+    void imageEncodeTiled(Stream& stream, const Surface& surface, float quality)
+    {
+        MANGO_UNREFERENCED_PARAMETER(quality);
+
+        const int width = surface.width;
+        const int height = surface.height;
+
+        int channels;
+        int bytes_per_channel;
+
+        const bool direct = resolve_layout(surface.format, channels, bytes_per_channel);
+        if (!direct)
+        {
+            channels = 4;
+            bytes_per_channel = 1;
+        }
+
+        const Format format = resolve_format(channels, bytes_per_channel);
+
+        const int tile_count = (height + zpng_tile_height - 1) / zpng_tile_height;
+        std::vector<ZPNG_Buffer> tiles(tile_count);
+
+        Blitter blitter(format, surface.format);
+
+        ConcurrentQueue queue("zpng.encoder", Priority::HIGH);
+
+        const int N = std::min(tile_count, ThreadPool::getInstanceSize());
+
+        for (int task = 0; task < N; ++task)
+        {
+            queue.enqueue([=, &surface, &tiles, &blitter]
+            {
+                // the zstd context is reused for every tile the task compresses
+                ZSTD_CCtx* context = ZSTD_createCCtx();
+
+                for (int i = task; i < tile_count; i += N)
+                {
+                    const int y0 = i * zpng_tile_height;
+                    const int y1 = std::min(height, y0 + zpng_tile_height);
+
+                    Surface source(surface, 0, y0, width, y1 - y0);
+
+                    std::unique_ptr<Bitmap> temp;
+                    if (!direct)
+                    {
+                        temp.reset(new Bitmap(source.width, source.height, format));
+
+                        BlitRect rect;
+
+                        rect.srcImage = source.image;
+                        rect.srcStride = source.stride;
+                        rect.destImage = temp->image;
+                        rect.destStride = temp->stride;
+                        rect.width = source.width;
+                        rect.height = source.height;
+
+                        blitter.convert(rect);
+                    }
+
+                    const Surface& s = direct ? source : *temp;
+
+                    ZPNG_ImageData z;
+
+                    z.Buffer.Data = s.image;
+                    z.Buffer.Bytes = 0;
+                    z.BytesPerChannel = bytes_per_channel;
+                    z.Channels = channels;
+                    z.WidthPixels = s.width;
+                    z.HeightPixels = s.height;
+                    z.StrideBytes = s.stride;
+
+                    tiles[i] = ZPNG_CompressContext(context, &z);
+                }
+
+                ZSTD_freeCCtx(context);
+            });
+        }
+
+        queue.wait();
+
+        bool failed = false;
+
+        for (auto& tile : tiles)
+        {
+            failed |= tile.Data == nullptr;
+        }
+
+        if (failed)
+        {
+            for (auto& tile : tiles)
+            {
+                ZPNG_Free(&tile);
+            }
+
+            MANGO_EXCEPTION(ID"Compression failed.");
+        }
+
+        LittleEndianStream s = stream;
+
+        s.write16(zpng_tiled_magic);
+        s.write16(u16(width));
+        s.write16(u16(height));
+        s.write8(u8(channels));
+        s.write8(u8(bytes_per_channel));
+        s.write32(zpng_tile_height);
+        s.write32(tile_count);
+
+        for (auto& tile : tiles)
+        {
+            s.write32(tile.Bytes);
+        }
+
+        for (auto& tile : tiles)
+        {
+            s.write(tile.Data, tile.Bytes);
+            ZPNG_Free(&tile);
+        }
+    }
+
 } // namespace
 
 namespace mango
@@ -185,6 +539,10 @@ namespace mango
     {
         registerImageDecoder(createInterface, ".zpng");
         registerImageEncoder(imageEncode, ".zpng");
+
+        // tiled variant which is (de)compressed in parallel
+        registerImageDecoder(createInterface, ".zpngt");
+        registerImageEncoder(imageEncodeTiled, ".zpngt");
     }
 
 } // namespace mango
@@ -0,0 +1,270 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <algorithm>
+#include <mango/core/thread.hpp>
+#include <mango/math/math.hpp>
+#include <mango/image/image.hpp>
+#include <mango/image/resample.hpp>
+#include <mango/image/mipmap.hpp>
+
+namespace
+{
+    using namespace mango;
+
+    using FloatImage = std::vector<float32x4, AlignedAllocator<float32x4>>;
+
+    constexpr int ParallelThreshold = 64 * 1024; // pixels
+    constexpr int BlockSize = 16 * 1024; // pixels
+
+    // Calls func(first, last) for consecutive row ranges which cover [0, height).
+    template <typename Func>
+    void process(int width, int height, Func func)
+    {
+        if (width * height < ParallelThreshold)
+        {
+            func(0, height);
+            return;
+        }
+
+        ConcurrentQueue queue("image.mipmap");
+
+        const int rows = std::max(1, BlockSize / width);
+
+        for (int first = 0; first < height; first += rows)
+        {
+            const int last = std::min(height, first + rows);
+            queue.enqueue([=]
+            {
+                func(first, last);
+            });
+        }
+
+        queue.wait();
+    }
+
+    // ------------------------------------------------------------------
+    // color space
+    // ------------------------------------------------------------------
+
+    struct ColorSpace
+    {
+        bool srgb;
+        MipmapAlpha alpha;
+
+        // stored color -> filtered color
+        float32x4 decode(float32x4 color) const
+        {
+            const float a = color.w;
+
+            if (srgb)
+            {
+                color = srgb_to_linear(clamp(color, float32x4(0.0f), float32x4(1.0f)));
+            }
+
+            if (alpha == MipmapAlpha::WEIGHTED)
+            {
+                color = color * a;
+            }
+
+            color.w = a;
+            return color;
+        }
+
+        // filtered color -> stored color
+        float32x4 encode(float32x4 color) const
+        {
+            float a = color.w;
+
+            if (alpha != MipmapAlpha::STRAIGHT)
+            {
+                // the negative lobes of the sinc filters can take alpha out of range
+                a = clamp(a, 0.0f, 1.0f);
+            }
+
+            if (alpha == MipmapAlpha::WEIGHTED)
+            {
+                color = a > 0.0f ? color / a : float32x4(0.0f);
+            }
+
+            if (srgb)
+            {
+                color = linear_to_srgb(clamp(color, float32x4(0.0f), float32x4(1.0f)));
+            }
+
+            if (alpha == MipmapAlpha::PREMULTIPLIED)
+            {
+                color = clamp(color, float32x4(0.0f), float32x4(a));
+            }
+
+            color.w = a;
+            return color;
+        }
+    };
+
+    template <typename Func>
+    void convert_pixels(FloatImage& dest, const FloatImage& source, int width, int height, Func func)
+    {
+        dest.resize(width * height);
+
+        process(width, height, [&] (int first, int last)
+        {
+            for (int i = first * width; i < last * width; ++i)
+            {
+                dest[i] = func(source[i]);
+            }
+        });
+    }
+
+    // surface with the SRGB type replaced with UNORM; the blitter converts the encoded values
+    Surface encodedSurface(const Surface& surface)
+    {
+        Format format = surface.format;
+        if (format.type == Format::SRGB)
+        {
+            format.type = Format::UNORM;
+        }
+
+        return Surface(surface.width, surface.height, format, surface.stride, surface.image);
+    }
+
+    Surface floatSurface(const FloatImage& image, int width, int height)
+    {
+        u8* address = reinterpret_cast<u8*>(const_cast<float32x4*>(image.data()));
+        return Surface(width, height, FORMAT_RGBA32F, width * sizeof(float32x4), address);
+    }
+
+} // namespace
+
+namespace mango
+{
+
+    // ----------------------------------------------------------------------------
+    // MipmapChain
+    // ----------------------------------------------------------------------------
+
+    MipmapChain::MipmapChain()
+    {
+    }
+
+    MipmapChain::MipmapChain(MipmapChain&& chain)
+        : m_buffer(std::move(chain.m_buffer))
+        , m_levels(std::move(chain.m_levels))
+    {
+    }
+
+    MipmapChain::~MipmapChain()
+    {
+    }
+
+    MipmapChain& MipmapChain::operator = (MipmapChain&& chain)
+    {
+        m_buffer = std::move(chain.m_buffer);
+        m_levels = std::move(chain.m_levels);
+        return *this;
+    }
+
+    int MipmapChain::levels() const
+    {
+        return int(m_levels.size());
+    }
+
+    const Surface& MipmapChain::operator [] (int level) const
+    {
+        return m_levels[level];
+    }
+
+    Memory MipmapChain::memory() const
+    {
+        return Memory(const_cast<u8*>(m_buffer.data()), m_buffer.size());
+    }
+
+    // ----------------------------------------------------------------------------
+    // generateMipmaps()
+    // ----------------------------------------------------------------------------
+
+    MipmapChain generateMipmaps(const Surface& source, const MipmapOptions& options)
+    {
+        MipmapChain chain;
+
+        const Format& format = source.format;
+        if (!source.width || !source.height || !format.bits)
+            return chain;
+
+        // compute the layout
+        int levels = 0;
+        size_t bytes = 0;
+
+        for (int w = source.width, h = source.height; ; w = std::max(1, w / 2), h = std::max(1, h / 2))
+        {
+            bytes += size_t(w) * h * format.bytes();
+            ++levels;
+
+            if (levels == options.levels || (w == 1 && h == 1))
+                break;
+        }
+
+        chain.m_buffer.resize(bytes);
+
+        u8* image = chain.m_buffer.data();
+
+        for (int level = 0, w = source.width, h = source.height; level < levels; ++level)
+        {
+            const int stride = w * format.bytes();
+            chain.m_levels.emplace_back(w, h, format, stride, image);
+            image += size_t(stride) * h;
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+
+        const Surface& top = chain.m_levels[0];
+        encodedSurface(top).blit(0, 0, encodedSurface(source));
+
+        if (levels == 1)
+            return chain;
+
+        ColorSpace space;
+        space.srgb = format.type == Format::SRGB || (format.type == Format::UNORM && options.srgb);
+        space.alpha = format.alpha() ? options.alpha : MipmapAlpha::STRAIGHT;
+
+        FloatImage current;
+        FloatImage next;
+        FloatImage temp;
+
+        // level 0 in filtering color space
+        int width = top.width;
+        int height = top.height;
+
+        current.resize(width * height);
+        floatSurface(current, width, height).blit(0, 0, encodedSurface(top));
+        convert_pixels(current, current, width, height, [&] (float32x4 color)
+        {
+            return space.decode(color);
+        });
+
+        for (int level = 1; level < levels; ++level)
+        {
+            const Surface& surface = chain.m_levels[level];
+
+            Resampler resampler(surface.width, surface.height, width, height, options.filter);
+            next.resize(surface.width * surface.height);
+            resampler.resample(floatSurface(next, surface.width, surface.height), floatSurface(current, width, height));
+            std::swap(current, next);
+
+            width = surface.width;
+            height = surface.height;
+
+            // the unfiltered level is still needed for the next level
+            convert_pixels(temp, current, width, height, [&] (float32x4 color)
+            {
+                return space.encode(color);
+            });
+
+            encodedSurface(surface).blit(0, 0, floatSurface(temp, width, height));
+        }
+
+        return chain;
+    }
+
+} // namespace mango
@@ -0,0 +1,714 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <mango/core/exception.hpp>
+#include <mango/core/thread.hpp>
+#include <mango/math/math.hpp>
+#include <mango/image/image.hpp>
+#include <mango/image/resample.hpp>
+
+#define ID "[Resampler] "
+
+namespace
+{
+    using namespace mango;
+
+    using FloatRow = std::vector<float32x4, AlignedAllocator<float32x4>>;
+
+    constexpr int ParallelThreshold = 64 * 1024; // destination pixels
+    constexpr int BandSize = 16 * 1024; // destination pixels
+
+    // ------------------------------------------------------------------
+    // filters
+    // ------------------------------------------------------------------
+
+    float sinc(float x)
+    {
+        x *= float(math::pi);
+        return x ? std::sin(x) / x : 1.0f;
+    }
+
+    float bessel_i0(float x)
+    {
+        // power series; converges quickly for the small arguments used here
+        const float y = x * x * 0.25f;
+        float sum = 1.0f;
+        float term = 1.0f;
+
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= y / float(k * k);
+            sum += term;
+            if (term < sum * 1e-8f)
+                break;
+        }
+
+        return sum;
+    }
+
+    float box(float x)
+    {
+        return (x > -0.5f && x <= 0.5f) ? 1.0f : 0.0f;
+    }
+
+    float triangle(float x)
+    {
+        x = std::abs(x);
+        return x < 1.0f ? 1.0f - x : 0.0f;
+    }
+
+    float mitchell(float x)
+    {
+        const float B = 1.0f / 3.0f;
+        const float C = 1.0f / 3.0f;
+
+        x = std::abs(x);
+        const float x2 = x * x;
+        const float x3 = x2 * x;
+
+        if (x < 1.0f)
+        {
+            return ((12 - 9 * B - 6 * C) * x3 + (-18 + 12 * B + 6 * C) * x2 + (6 - 2 * B)) / 6.0f;
+        }
+        else if (x < 2.0f)
+        {
+            return ((-B - 6 * C) * x3 + (6 * B + 30 * C) * x2 + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6.0f;
+        }
+
+        return 0.0f;
+    }
+
+    float kaiser(float x)
+    {
+        const float width = 3.0f;
+        const float alpha = 4.0f;
+
+        const float t = x / width;
+        if (t * t >= 1.0f)
+            return 0.0f;
+
+        return sinc(x) * bessel_i0(alpha * std::sqrt(1.0f - t * t)) / bessel_i0(alpha);
+    }
+
+    float lanczos(float x)
+    {
+        const float width = 3.0f;
+
+        if (std::abs(x) >= width)
+            return 0.0f;
+
+        return sinc(x) * sinc(x / width);
+    }
+
+    struct Filter
+    {
+        float (*function)(float);
+        float radius;
+    };
+
+    Filter getFilter(ResampleFilter filter)
+    {
+        switch (filter)
+        {
+            case ResampleFilter::BILINEAR:
+                return { triangle, 1.0f };
+            case ResampleFilter::MITCHELL:
+                return { mitchell, 2.0f };
+            case ResampleFilter::KAISER:
+                return { kaiser, 3.0f };
+            case ResampleFilter::LANCZOS:
+                return { lanczos, 3.0f };
+            case ResampleFilter::BOX:
+            default:
+                return { box, 0.5f };
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // Weights
+    // ------------------------------------------------------------------
+
+    // Normalized filter taps for one axis. Every destination sample has the same,
+    // even, number of taps; the source indices are clamped to the edge of the image.
+    // The fixed point weights have 14 fractional bits and sum to exactly 1.0.
+
+    struct Weights
+    {
+        int taps;
+        std::vector<int> index;
+        std::vector<float> weight;
+        std::vector<s16> fixed;
+
+        Weights(const Filter& filter, int source, int dest)
+        {
+            const float scale = float(source) / float(dest);
+
+            // the filter is stretched when minifying and sampled at texel rate when magnifying
+            const float width = std::max(1.0f, scale);
+            const float support = filter.radius * width;
+
+            taps = int(std::ceil(support * 2.0f)) + 1;
+            index.resize(dest * taps);
+            weight.resize(dest * taps);
+
+            for (int i = 0; i < dest; ++i)
+            {
+                const float center = (i + 0.5f) * scale;
+                const int first = int(std::ceil(center - support - 0.5f));
+
+                int* pi = &index[i * taps];
+                float* pw = &weight[i * taps];
+                float sum = 0.0f;
+
+                for (int j = 0; j < taps; ++j)
+                {
+                    const int x = first + j;
+                    const float w = filter.function((x + 0.5f - center) / width);
+                    pi[j] = clamp(x, 0, source - 1);
+                    pw[j] = w;
+                    sum += w;
+                }
+
+                if (sum)
+                {
+                    for (int j = 0; j < taps; ++j)
+                    {
+                        pw[j] /= sum;
+                    }
+                }
+                else
+                {
+                    // the filter is too narrow to hit any source sample; use the nearest one
+                    std::fill(pw, pw + taps, 0.0f);
+                    pi[0] = clamp(int(center), 0, source - 1);
+                    pw[0] = 1.0f;
+                }
+            }
+
+            // drop the taps which have zero weight for every destination sample
+            int count = taps;
+            while (count > 1)
+            {
+                bool zero = true;
+                for (int i = 0; i < dest; ++i)
+                {
+                    zero &= weight[i * taps + count - 1] == 0.0f;
+                }
+                if (!zero)
+                    break;
+                --count;
+            }
+
+            // the fixed point kernels process the taps in groups of four
+            count = (count + 3) & ~3;
+
+            std::vector<int> temp_index(dest * count);
+            std::vector<float> temp_weight(dest * count);
+
+            for (int i = 0; i < dest; ++i)
+            {
+                for (int j = 0; j < count; ++j)
+                {
+                    // the padding continues the run of indices so that the taps stay contiguous
+                    const bool valid = j < taps;
+                    const int last = index[i * taps + taps - 1];
+                    temp_index[i * count + j] = valid ? index[i * taps + j] : std::min(last + j - taps + 1, source - 1);
+                    temp_weight[i * count + j] = valid ? weight[i * taps + j] : 0.0f;
+                }
+            }
+
+            taps = count;
+            index.swap(temp_index);
+            weight.swap(temp_weight);
+
+            fixed.resize(dest * taps);
+
+            for (int i = 0; i < dest; ++i)
+            {
+                const float* pw = &weight[i * taps];
+                s16* pf = &fixed[i * taps];
+
+                int sum = 0;
+                int largest = 0;
+
+                for (int j = 0; j < taps; ++j)
+                {
+                    pf[j] = s16(std::round(pw[j] * 16384.0f));
+                    sum += pf[j];
+                    if (std::abs(pw[j]) > std::abs(pw[largest]))
+                        largest = j;
+                }
+
+                // rounding error goes to the largest weight
+                pf[largest] += s16(16384 - sum);
+            }
+        }
+
+        // range of source samples used by destination samples [first, last)
+        void range(int& low, int& high, int first, int last) const
+        {
+            auto minmax = std::minmax_element(&index[first * taps], &index[last * taps]);
+            low = *minmax.first;
+            high = *minmax.second + 1;
+        }
+    };
+
+    // ------------------------------------------------------------------
+    // float kernels
+    // ------------------------------------------------------------------
+
+    void filter_horizontal(float32x4* dest, int width, const float32x4* source, const Weights& weights)
+    {
+        const int taps = weights.taps;
+        const int* index = weights.index.data();
+        const float* weight = weights.weight.data();
+
+        for (int x = 0; x < width; ++x)
+        {
+            float32x4 sum = source[index[0]] * weight[0];
+
+            for (int i = 1; i < taps; ++i)
+            {
+                sum = madd(sum, source[index[i]], float32x4(weight[i]));
+            }
+
+            dest[x] = sum;
+            index += taps;
+            weight += taps;
+        }
+    }
+
+    void filter_vertical(float32x4* dest, int width, const float32x4* source, int origin, int y, const Weights& weights)
+    {
+        const int taps = weights.taps;
+        const int* index = &weights.index[y * taps];
+        const float* weight = &weights.weight[y * taps];
+
+        // accumulate whole rows to keep the memory access sequential
+        const float32x4* s = source + (index[0] - origin) * width;
+        const float32x4 w0(weight[0]);
+
+        for (int x = 0; x < width; ++x)
+        {
+            dest[x] = s[x] * w0;
+        }
+
+        for (int i = 1; i < taps; ++i)
+        {
+            s = source + (index[i] - origin) * width;
+            const float32x4 w(weight[i]);
+
+            for (int x = 0; x < width; ++x)
+            {
+                dest[x] = madd(dest[x], s[x], w);
+            }
+        }
+    }
+
+    void premultiply_alpha(float32x4* data, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            float32x4 color = data[i];
+            const float a = color.w;
+            color = color * a;
+            color.w = a;
+            data[i] = color;
+        }
+    }
+
+    void unpremultiply_alpha(float32x4* data, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            float32x4 color = data[i];
+            const float a = color.w;
+            color = a > 0.0f ? color / a : float32x4(0.0f);
+            color.w = a;
+            data[i] = color;
+        }
+    }
+
+    // ------------------------------------------------------------------
+    // fixed point kernels
+    // ------------------------------------------------------------------
+
+#if defined(MANGO_ENABLE_SSE2)
+
+    // The intermediate rows store the components as s16 with 4 fractional bits.
+
+    void filter_horizontal_8888(s16* dest, int width, const u32* source, const Weights& weights)
+    {
+        const int taps = weights.taps;
+        const int* index = weights.index.data();
+        const s16* weight = weights.fixed.data();
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi32(1 << 9);
+
+        for (int x = 0; x < width; ++x)
+        {
+            __m128i sum = _mm_setzero_si128();
+
+            if (index[taps - 1] - index[0] == taps - 1)
+            {
+                // contiguous taps: four texels per load
+                const u32* s = source + index[0];
+
+                for (int i = 0; i < taps; i += 4)
+                {
+                    // t0 t2 t1 t3 -> interleave the components of the pairs (t0, t1) and (t2, t3)
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+                    v = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0));
+                    v = _mm_unpacklo_epi8(v, _mm_srli_si128(v, 8));
+
+                    const __m128i w01 = _mm_set1_epi32(uload32(weight + i + 0));
+                    const __m128i w23 = _mm_set1_epi32(uload32(weight + i + 2));
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), w01));
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), w23));
+                }
+            }
+            else
+            {
+                // the taps are clamped to the edge of the image
+                for (int i = 0; i < taps; i += 2)
+                {
+                    // interleave two texels: c0 c1 for each component
+                    __m128i a = _mm_cvtsi32_si128(source[index[i + 0]]);
+                    __m128i b = _mm_cvtsi32_si128(source[index[i + 1]]);
+                    __m128i v = _mm_unpacklo_epi8(_mm_unpacklo_epi8(a, b), zero);
+
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(v, _mm_set1_epi32(uload32(weight + i))));
+                }
+            }
+
+            sum = _mm_srai_epi32(_mm_add_epi32(sum, round), 10);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + x * 4), _mm_packs_epi32(sum, sum));
+
+            index += taps;
+            weight += taps;
+        }
+    }
+
+    void filter_vertical_8888(u32* dest, int width, const s16* source, int origin, int y, const Weights& weights)
+    {
+        const int taps = weights.taps;
+        const int* index = &weights.index[y * taps];
+        const s16* weight = &weights.fixed[y * taps];
+        const int stride = width * 4;
+
+        const __m128i round = _mm_set1_epi32(1 << 17);
+
+        int x = 0;
+
+        for ( ; x <= width - 4; x += 4)
+        {
+            __m128i sum0 = _mm_setzero_si128();
+            __m128i sum1 = _mm_setzero_si128();
+            __m128i sum2 = _mm_setzero_si128();
+            __m128i sum3 = _mm_setzero_si128();
+
+            for (int i = 0; i < taps; i += 2)
+            {
+                const s16* s0 = source + (index[i + 0] - origin) * stride + x * 4;
+                const s16* s1 = source + (index[i + 1] - origin) * stride + x * 4;
+                __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s0 + 0));
+                __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s0 + 8));
+                __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s1 + 0));
+                __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s1 + 8));
+
+                const __m128i w = _mm_set1_epi32(uload32(weight + i));
+                sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi16(a0, b0), w));
+                sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi16(a0, b0), w));
+                sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpacklo_epi16(a1, b1), w));
+                sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(_mm_unpackhi_epi16(a1, b1), w));
+            }
+
+            sum0 = _mm_srai_epi32(_mm_add_epi32(sum0, round), 18);
+            sum1 = _mm_srai_epi32(_mm_add_epi32(sum1, round), 18);
+            sum2 = _mm_srai_epi32(_mm_add_epi32(sum2, round), 18);
+            sum3 = _mm_srai_epi32(_mm_add_epi32(sum3, round), 18);
+            __m128i v = _mm_packus_epi16(_mm_packs_epi32(sum0, sum1), _mm_packs_epi32(sum2, sum3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x), v);
+        }
+
+        for ( ; x <= width - 2; x += 2)
+        {
+            __m128i sum0 = _mm_setzero_si128();
+            __m128i sum1 = _mm_setzero_si128();
+
+            for (int i = 0; i < taps; i += 2)
+            {
+                const s16* s0 = source + (index[i + 0] - origin) * stride + x * 4;
+                const s16* s1 = source + (index[i + 1] - origin) * stride + x * 4;
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s0));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s1));
+
+                const __m128i w = _mm_set1_epi32(uload32(weight + i));
+                sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+                sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+            }
+
+            sum0 = _mm_srai_epi32(_mm_add_epi32(sum0, round), 18);
+            sum1 = _mm_srai_epi32(_mm_add_epi32(sum1, round), 18);
+            __m128i v = _mm_packs_epi32(sum0, sum1);
+            v = _mm_packus_epi16(v, v);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + x), v);
+        }
+
+        for ( ; x < width; ++x)
+        {
+            __m128i sum = _mm_setzero_si128();
+
+            for (int i = 0; i < taps; i += 2)
+            {
+                const s16* s0 = source + (index[i + 0] - origin) * stride + x * 4;
+                const s16* s1 = source + (index[i + 1] - origin) * stride + x * 4;
+                __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s0));
+                __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s1));
+
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), _mm_set1_epi32(uload32(weight + i))));
+            }
+
+            sum = _mm_srai_epi32(_mm_add_epi32(sum, round), 18);
+            __m128i v = _mm_packs_epi32(sum, sum);
+            v = _mm_packus_epi16(v, v);
+            dest[x] = _mm_cvtsi128_si32(v);
+        }
+    }
+
+    bool isFixedPoint(const Format& dest, const Format& source)
+    {
+        if (dest != source || dest.bits != 32)
+            return false;
+
+        if (dest.type != Format::UNORM && dest.type != Format::SRGB)
+            return false;
+
+        // the padding component is filtered like the others
+        return dest.size[0] == 8 && dest.size[1] == 8 && dest.size[2] == 8 &&
+               (dest.size[3] == 8 || dest.size[3] == 0);
+    }
+
+#else
+
+    bool isFixedPoint(const Format& dest, const Format& source)
+    {
+        MANGO_UNREFERENCED_PARAMETER(dest);
+        MANGO_UNREFERENCED_PARAMETER(source);
+        return false;
+    }
+
+#endif
+
+    bool isFloatRGBA(const Surface& surface)
+    {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(surface.image);
+        return surface.format == FORMAT_RGBA32F && !(address & 15) && !(surface.stride & 15);
+    }
+
+} // namespace
+
+namespace mango
+{
+
+    // ----------------------------------------------------------------------------
+    // Resampler
+    // ----------------------------------------------------------------------------
+
+    struct ResamplerContext
+    {
+        int destWidth;
+        int destHeight;
+        int sourceWidth;
+        int sourceHeight;
+        Weights horizontal;
+        Weights vertical;
+
+        ResamplerContext(int destWidth, int destHeight, int sourceWidth, int sourceHeight, const Filter& filter)
+            : destWidth(destWidth)
+            , destHeight(destHeight)
+            , sourceWidth(sourceWidth)
+            , sourceHeight(sourceHeight)
+            , horizontal(filter, sourceWidth, destWidth)
+            , vertical(filter, sourceHeight, destHeight)
+        {
+        }
+
+        void resample_fixed(const Surface& dest, const Surface& source, int first, int last) const
+        {
+#if defined(MANGO_ENABLE_SSE2)
+            int low;
+            int high;
+            vertical.range(low, high, first, last);
+
+            std::vector<s16> band((high - low) * destWidth * 4);
+
+            for (int y = low; y < high; ++y)
+            {
+                s16* d = band.data() + (y - low) * destWidth * 4;
+                filter_horizontal_8888(d, destWidth, source.address<u32>(0, y), horizontal);
+            }
+
+            for (int y = first; y < last; ++y)
+            {
+                filter_vertical_8888(dest.address<u32>(0, y), destWidth, band.data(), low, y, vertical);
+            }
+#else
+            MANGO_UNREFERENCED_PARAMETER(dest);
+            MANGO_UNREFERENCED_PARAMETER(source);
+            MANGO_UNREFERENCED_PARAMETER(first);
+            MANGO_UNREFERENCED_PARAMETER(last);
+#endif
+        }
+
+        void resample_float(const Surface& dest, const Surface& source, const Blitter& decoder,
+                            const Blitter& encoder, bool premultiply, int first, int last) const
+        {
+            int low;
+            int high;
+            vertical.range(low, high, first, last);
+
+            const bool direct_source = isFloatRGBA(source) && !premultiply;
+            const bool direct_dest = isFloatRGBA(dest) && !premultiply;
+
+            FloatRow band((high - low) * destWidth);
+            FloatRow row(std::max(sourceWidth, destWidth));
+
+            BlitRect rect;
+
+            rect.width = sourceWidth;
+            rect.height = 1;
+            rect.srcStride = source.stride;
+            rect.destStride = sourceWidth * sizeof(float32x4);
+
+            for (int y = low; y < high; ++y)
+            {
+                const float32x4* s;
+
+                if (direct_source)
+                {
+                    s = source.address<float32x4>(0, y);
+                }
+                else
+                {
+                    rect.srcImage = source.address<u8>(0, y);
+                    rect.destImage = reinterpret_cast<u8*>(row.data());
+                    decoder.convert(rect);
+
+                    if (premultiply)
+                    {
+                        premultiply_alpha(row.data(), sourceWidth);
+                    }
+
+                    s = row.data();
+                }
+
+                filter_horizontal(band.data() + (y - low) * destWidth, destWidth, s, horizontal);
+            }
+
+            rect.width = destWidth;
+            rect.srcStride = destWidth * sizeof(float32x4);
+            rect.destStride = dest.stride;
+
+            for (int y = first; y < last; ++y)
+            {
+                if (direct_dest)
+                {
+                    filter_vertical(dest.address<float32x4>(0, y), destWidth, band.data(), low, y, vertical);
+                }
+                else
+                {
+                    filter_vertical(row.data(), destWidth, band.data(), low, y, vertical);
+
+                    if (premultiply)
+                    {
+                        unpremultiply_alpha(row.data(), destWidth);
+                    }
+
+                    rect.srcImage = reinterpret_cast<u8*>(row.data());
+                    rect.destImage = dest.address<u8>(0, y);
+                    encoder.convert(rect);
+                }
+            }
+        }
+    };
+
+    Resampler::Resampler(int destWidth, int destHeight, int sourceWidth, int sourceHeight, ResampleFilter filter)
+        : m_context(nullptr)
+    {
+        if (destWidth < 1 || destHeight < 1 || sourceWidth < 1 || sourceHeight < 1)
+        {
+            MANGO_EXCEPTION(ID"Incorrect dimensions.");
+        }
+
+        m_context = new ResamplerContext(destWidth, destHeight, sourceWidth, sourceHeight, getFilter(filter));
+    }
+
+    Resampler::~Resampler()
+    {
+        delete m_context;
+    }
+
+    void Resampler::resample(const Surface& dest, const Surface& source, bool premultiply) const
+    {
+        const ResamplerContext& context = *m_context;
+
+        if (dest.width != context.destWidth || dest.height != context.destHeight ||
+            source.width != context.sourceWidth || source.height != context.sourceHeight)
+        {
+            MANGO_EXCEPTION(ID"Surface dimensions do not match.");
+        }
+
+        const bool fixed = !premultiply && isFixedPoint(dest.format, source.format);
+
+        Blitter decoder(FORMAT_RGBA32F, source.format);
+        Blitter encoder(dest.format, FORMAT_RGBA32F);
+
+        auto band = [&] (int first, int last)
+        {
+            if (fixed)
+                context.resample_fixed(dest, source, first, last);
+            else
+                context.resample_float(dest, source, decoder, encoder, premultiply, first, last);
+        };
+
+        const int width = context.destWidth;
+        const int height = context.destHeight;
+
+        if (width * height < ParallelThreshold)
+        {
+            band(0, height);
+            return;
+        }
+
+        ConcurrentQueue queue("image.resample");
+
+        // bands have to be tall enough that the rows shared with the neighbours are a small overhead;
+        // the source rows of a band are at least four times the rows shared with the next band
+        const int shared = context.vertical.taps * height / context.sourceHeight;
+        const int rows = std::max({ BandSize / width, 16, shared * 4 });
+
+        for (int first = 0; first < height; first += rows)
+        {
+            const int last = std::min(height, first + rows);
+            queue.enqueue([=]
+            {
+                band(first, last);
+            });
+        }
+
+        queue.wait();
+    }
+
+    void resample(const Surface& dest, const Surface& source, ResampleFilter filter, bool premultiply)
+    {
+        Resampler resampler(dest.width, dest.height, source.width, source.height, filter);
+        resampler.resample(dest, source, premultiply);
+    }
+
+} // namespace mango
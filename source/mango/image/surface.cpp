@@ -203,6 +203,7 @@ namespace
     {
         const std::string extension = filesystem::getExtension(filename);
         filesystem::File file(filename);
+        file.advise(VirtualMemory::WILLNEED);
         Surface surface = load_surface(file, extension, format);
         return surface;
     }
@@ -242,6 +243,7 @@ namespace
     {
         const std::string extension = filesystem::getExtension(filename);
         filesystem::File file(filename);
+        file.advise(VirtualMemory::WILLNEED);
         Surface surface = load_palette_surface(file, extension, palette);
         return surface;
     }
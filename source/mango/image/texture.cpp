@@ -0,0 +1,204 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <algorithm>
+#include <mango/core/exception.hpp>
+#include <mango/core/thread.hpp>
+#include "texture.hpp"
+
+#define ID "[TextureEncoder] "
+
+namespace mango
+{
+
+    TextureEncoder::TextureEncoder(const Surface* faces, int count, const TextureEncoderOptions& options, const Format& format)
+        : m_info(options.compression)
+        , m_format(format)
+    {
+        if (count != 1 && count != 6)
+        {
+            MANGO_EXCEPTION(ID"Incorrect number of faces.");
+        }
+
+        if (options.compression != TextureCompression::NONE && !m_info.encode)
+        {
+            MANGO_EXCEPTION(ID"Compression format does not have an encoder.");
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            if (faces[i].width != faces[0].width || faces[i].height != faces[0].height)
+            {
+                MANGO_EXCEPTION(ID"Faces have different dimensions.");
+            }
+
+            if (faces[i].width < 1 || faces[i].height < 1)
+            {
+                MANGO_EXCEPTION(ID"Incorrect dimensions.");
+            }
+        }
+
+        m_faces.assign(faces, faces + count);
+
+        m_mipmap = options.mipmap;
+        m_mipmap.levels = std::max(0, options.levels);
+
+        // same number of levels as generateMipmaps()
+        m_levels = 0;
+
+        for (int w = faces[0].width, h = faces[0].height; ; w = std::max(1, w / 2), h = std::max(1, h / 2))
+        {
+            ++m_levels;
+
+            if (m_levels == m_mipmap.levels || (w == 1 && h == 1))
+                break;
+        }
+    }
+
+    TextureEncoder::~TextureEncoder()
+    {
+    }
+
+    int TextureEncoder::width() const
+    {
+        return m_faces[0].width;
+    }
+
+    int TextureEncoder::height() const
+    {
+        return m_faces[0].height;
+    }
+
+    int TextureEncoder::levels() const
+    {
+        return m_levels;
+    }
+
+    int TextureEncoder::faces() const
+    {
+        return int(m_faces.size());
+    }
+
+    const TextureCompressionInfo& TextureEncoder::info() const
+    {
+        return m_info;
+    }
+
+    const Format& TextureEncoder::format() const
+    {
+        return m_format;
+    }
+
+    size_t TextureEncoder::bytes(int level) const
+    {
+        const int w = std::max(1, width() >> level);
+        const int h = std::max(1, height() >> level);
+
+        if (m_info.compression != TextureCompression::NONE)
+        {
+            const int xblocks = round_to_next(w, m_info.width);
+            const int yblocks = round_to_next(h, m_info.height);
+            return size_t(xblocks) * yblocks * m_info.bytes;
+        }
+
+        return size_t(w) * h * m_format.bytes();
+    }
+
+    void TextureEncoder::encode(Order order, WriteFunc write) const
+    {
+        struct Image
+        {
+            int face;
+            int level;
+            Memory memory;
+            std::vector<u8> buffer;
+        };
+
+        const int count = faces() * levels();
+
+        std::vector<Image> images(count);
+        std::vector<MipmapChain> chains(faces());
+        std::vector<int> final(faces()); // last image of the face in file order
+
+        for (int i = 0; i < count; ++i)
+        {
+            Image& image = images[i];
+            if (order == FACE_MAJOR)
+            {
+                image.face = i / levels();
+                image.level = i % levels();
+            }
+            else
+            {
+                image.face = i % faces();
+                image.level = i / faces();
+            }
+
+            final[image.face] = i;
+        }
+
+        // limit the number of encoded images waiting to be written
+        const int batch = std::max(2, ThreadPool::getInstanceSize() * 2);
+
+        for (int first = 0; first < count; first += batch)
+        {
+            const int last = std::min(count, first + batch);
+
+            ConcurrentQueue queue("image.texture");
+
+            for (int i = first; i < last; ++i)
+            {
+                Image& image = images[i];
+                MipmapChain& chain = chains[image.face];
+
+                if (!chain.levels())
+                {
+                    chain = generateMipmaps(m_faces[image.face], m_mipmap);
+                }
+
+                const Surface& surface = chain[image.level];
+
+                if (m_info.compression == TextureCompression::NONE && surface.format == m_format)
+                {
+                    // the mipmap chain is already in the storage format
+                    image.memory = Memory(surface.image, bytes(image.level));
+                    continue;
+                }
+
+                queue.enqueue([this, &image, &surface]
+                {
+                    image.buffer.resize(bytes(image.level));
+                    image.memory = Memory(image.buffer.data(), image.buffer.size());
+
+                    if (m_info.compression != TextureCompression::NONE)
+                    {
+                        m_info.compress(image.memory, surface);
+                    }
+                    else
+                    {
+                        Surface temp(surface.width, surface.height, m_format, surface.width * m_format.bytes(), image.memory.address);
+                        temp.blit(0, 0, surface);
+                    }
+                });
+            }
+
+            queue.wait();
+
+            for (int i = first; i < last; ++i)
+            {
+                Image& image = images[i];
+                write(image.face, image.level, image.memory);
+
+                // release the memory as soon as the image is written
+                std::vector<u8>().swap(image.buffer);
+
+                if (final[image.face] == i)
+                {
+                    chains[image.face] = MipmapChain();
+                }
+            }
+        }
+    }
+
+} // namespace mango
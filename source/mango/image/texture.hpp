@@ -0,0 +1,57 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <mango/core/object.hpp>
+#include <mango/image/image.hpp>
+
+namespace mango
+{
+
+    // Face and mipmap level images of a texture in the storage format of a container.
+    // The container writers only deal with the headers and the file order.
+    // The mipmap chain of a face is generated when its first image is encoded and released
+    // after its last image has been written, so the faces must stay valid until encode() returns.
+
+    class TextureEncoder : protected NonCopyable
+    {
+    public:
+        enum Order
+        {
+            FACE_MAJOR,  // all levels of a face, then the next face (DDS)
+            LEVEL_MAJOR  // all faces of a level, then the next level (KTX)
+        };
+
+        using WriteFunc = std::function<void(int face, int level, Memory memory)>;
+
+        // the format is the storage format of uncompressed textures
+        TextureEncoder(const Surface* faces, int count, const TextureEncoderOptions& options, const Format& format);
+        ~TextureEncoder();
+
+        int width() const;
+        int height() const;
+        int levels() const;
+        int faces() const;
+
+        const TextureCompressionInfo& info() const;
+        const Format& format() const;
+
+        // bytes in one face image
+        size_t bytes(int level) const;
+
+        // write is called from the calling thread in file order
+        void encode(Order order, WriteFunc write) const;
+
+    protected:
+        std::vector<Surface> m_faces;
+        MipmapOptions m_mipmap;
+        int m_levels;
+        TextureCompressionInfo m_info;
+        Format m_format;
+    };
+
+} // namespace mango
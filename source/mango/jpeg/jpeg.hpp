@@ -29,7 +29,8 @@
         #define JPEG_ENABLE_SSE2
     #endif
 
-    #if defined(MANGO_ENABLE_AVX2)
+    #if defined(MANGO_ENABLE_AVX2) || (defined(MANGO_ENABLE_SSE2) && defined(MANGO_ENABLE_TARGET_DISPATCH))
+        // AVX2 kernels are selected at runtime when not enabled at compile time
         #define JPEG_ENABLE_AVX2
     #endif
 
@@ -442,6 +443,13 @@ namespace jpeg
     void process_YCbCr_16x16_sse2   (u8* dest, int stride, const BlockType* data, ProcessState* state, int width, int height);
 #endif
 
+#if defined(JPEG_ENABLE_AVX2)
+    void process_YCbCr_8x8_avx2     (u8* dest, int stride, const BlockType* data, ProcessState* state, int width, int height);
+    void process_YCbCr_8x16_avx2    (u8* dest, int stride, const BlockType* data, ProcessState* state, int width, int height);
+    void process_YCbCr_16x8_avx2    (u8* dest, int stride, const BlockType* data, ProcessState* state, int width, int height);
+    void process_YCbCr_16x16_avx2   (u8* dest, int stride, const BlockType* data, ProcessState* state, int width, int height);
+#endif
+
 	void EncodeImage(Stream& stream, const Surface& surface, float quality);
 
 } // namespace jpeg
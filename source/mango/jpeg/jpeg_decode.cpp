@@ -3,6 +3,7 @@
     Copyright (C) 2012-2018 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 #include <cmath>
+#include <mutex>
 #include <mango/core/endian.hpp>
 #include <mango/core/cpuinfo.hpp>
 #include <mango/core/thread.hpp>
@@ -246,9 +247,13 @@ namespace jpeg
 
         u64 cpuFlags = getCPUFlags();
 
+        const char* idct_variant = "generic";
+        const char* color_variant = "generic";
+
 #if defined(JPEG_ENABLE_SIMD) && !defined(JPEG_ENABLE_NEON)
         decodeState.zigzagTable = g_zigzag_table_variant;
         processState.idct = idct_simd;
+        idct_variant = "simd";
 #endif
 
 #if defined(JPEG_ENABLE_SSE2)
@@ -261,11 +266,30 @@ namespace jpeg
             processState.process_YCbCr_8x16  = process_YCbCr_8x16_sse2;
             processState.process_YCbCr_16x8  = process_YCbCr_16x8_sse2;
             processState.process_YCbCr_16x16 = process_YCbCr_16x16_sse2;
+            idct_variant = "sse2";
+            color_variant = "sse2";
+        }
+#endif
+
+#if defined(JPEG_ENABLE_AVX2)
+        if (cpuFlags & CPU_AVX2)
+        {
+            processState.process_YCbCr_8x8   = process_YCbCr_8x8_avx2;
+            processState.process_YCbCr_8x16  = process_YCbCr_8x16_avx2;
+            processState.process_YCbCr_16x8  = process_YCbCr_16x8_avx2;
+            processState.process_YCbCr_16x16 = process_YCbCr_16x16_avx2;
+            color_variant = "avx2";
         }
 #endif
 
         MANGO_UNREFERENCED_PARAMETER(cpuFlags);
 
+        static std::once_flag report;
+        std::call_once(report, [=] {
+            setKernelVariant("jpeg.idct", idct_variant);
+            setKernelVariant("jpeg.ycbcr", color_variant);
+        });
+
         for (int i = 0; i < JPEG_MAX_COMPS_IN_SCAN; ++i)
         {
             quantTable[i].table = &quantTableVector[i * 64];
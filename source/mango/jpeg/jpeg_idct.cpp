@@ -160,11 +160,12 @@ namespace jpeg
         float32x4 b1 = x1 + y1;
         b1 = b1.wzyx;
 
+        // narrow() saturates unsigned values; clamp the negative values to zero first
         int16x8 c0 = simd::narrow(convert<int32x4>(a0).m, convert<int32x4>(b0).m);
-        uint16x8 d0 = reinterpret<uint16x8>(c0);
+        uint16x8 d0 = reinterpret<uint16x8>(max(c0, int16x8(0)));
 
         int16x8 c1 = simd::narrow(convert<int32x4>(a1).m, convert<int32x4>(b1).m);
-        uint16x8 d1 = reinterpret<uint16x8>(c1);
+        uint16x8 d1 = reinterpret<uint16x8>(max(c1, int16x8(0)));
 
         return simd::narrow(d0.m, d1.m);
     }
@@ -678,6 +678,221 @@ void process_YCbCr_16x16(u8* dest, int stride, const BlockType* data, ProcessSta
         MANGO_UNREFERENCED_PARAMETER(height);
     }
 
+#if defined(JPEG_ENABLE_AVX2)
+
+    // ------------------------------------------------------------------------------------------------
+    // AVX2 implementation
+    // ------------------------------------------------------------------------------------------------
+
+    // These are compiled with MANGO_TARGET_AVX2 so that they are available in SSE builds;
+    // the decoder selects them only when the CPU supports AVX2.
+
+#define JPEG_CONST_AVX2(x, y)  _mm256_setr_epi16(x, y, x, y, x, y, x, y, x, y, x, y, x, y, x, y)
+
+    struct ycbcr_constants_avx2
+    {
+        __m256i s0;
+        __m256i s1;
+        __m256i s2;
+        __m256i rounding;
+        __m256i tosigned;
+    };
+
+    static inline MANGO_TARGET_AVX2
+    ycbcr_constants_avx2 get_ycbcr_constants_avx2()
+    {
+        ycbcr_constants_avx2 c;
+        c.s0 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.40200));
+        c.s1 = JPEG_CONST_AVX2(JPEG_FIXED( 1.00000), JPEG_FIXED( 1.77200));
+        c.s2 = JPEG_CONST_AVX2(JPEG_FIXED(-0.34414), JPEG_FIXED(-0.71414));
+        c.rounding = _mm256_set1_epi32(1 << (JPEG_PREC - 1));
+        c.tosigned = _mm256_set1_epi16(-128);
+        return c;
+    }
+
+    static inline MANGO_TARGET_AVX2
+    __m256i load_16x1_avx2(const u8* p0, const u8* p1)
+    {
+        // two 8-sample rows into 16 x 16 bit samples
+        __m128i v0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p0));
+        __m128i v1 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p1));
+        return _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(v0, v1));
+    }
+
+    static inline MANGO_TARGET_AVX2
+    __m256i load_chroma_2x1_avx2(const u8* p, const ycbcr_constants_avx2& c)
+    {
+        // one 8-sample row upsampled horizontally into 16 signed samples
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+        return _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v, v)), c.tosigned);
+    }
+
+    static inline MANGO_TARGET_AVX2
+    void convert_ycbcr_16x1_avx2(u8* dest0, u8* dest1, __m256i y, __m256i cb, __m256i cr, const ycbcr_constants_avx2& c)
+    {
+        // the unpack and pack instructions work within 128 bit lanes: the low lane has samples 0..7
+        // and the high lane samples 8..15 all the way through so that the lanes can be stored separately
+        __m256i zero = _mm256_setzero_si256();
+
+        __m256i r_l = _mm256_madd_epi16(_mm256_unpacklo_epi16(y, cr), c.s0);
+        __m256i r_h = _mm256_madd_epi16(_mm256_unpackhi_epi16(y, cr), c.s0);
+
+        __m256i b_l = _mm256_madd_epi16(_mm256_unpacklo_epi16(y, cb), c.s1);
+        __m256i b_h = _mm256_madd_epi16(_mm256_unpackhi_epi16(y, cb), c.s1);
+
+        __m256i g_l = _mm256_madd_epi16(_mm256_unpacklo_epi16(cb, cr), c.s2);
+        __m256i g_h = _mm256_madd_epi16(_mm256_unpackhi_epi16(cb, cr), c.s2);
+
+        g_l = _mm256_add_epi32(g_l, _mm256_slli_epi32(_mm256_unpacklo_epi16(y, zero), JPEG_PREC));
+        g_h = _mm256_add_epi32(g_h, _mm256_slli_epi32(_mm256_unpackhi_epi16(y, zero), JPEG_PREC));
+
+        r_l = _mm256_srai_epi32(_mm256_add_epi32(r_l, c.rounding), JPEG_PREC);
+        r_h = _mm256_srai_epi32(_mm256_add_epi32(r_h, c.rounding), JPEG_PREC);
+
+        b_l = _mm256_srai_epi32(_mm256_add_epi32(b_l, c.rounding), JPEG_PREC);
+        b_h = _mm256_srai_epi32(_mm256_add_epi32(b_h, c.rounding), JPEG_PREC);
+
+        g_l = _mm256_srai_epi32(_mm256_add_epi32(g_l, c.rounding), JPEG_PREC);
+        g_h = _mm256_srai_epi32(_mm256_add_epi32(g_h, c.rounding), JPEG_PREC);
+
+        __m256i r = _mm256_packs_epi32(r_l, r_h);
+        __m256i g = _mm256_packs_epi32(g_l, g_h);
+        __m256i b = _mm256_packs_epi32(b_l, b_h);
+
+        r = _mm256_packus_epi16(r, r);
+        g = _mm256_packus_epi16(g, g);
+        b = _mm256_packus_epi16(b, b);
+
+        __m256i ra = _mm256_unpacklo_epi8(r, _mm256_cmpeq_epi8(r, r));
+        __m256i bg = _mm256_unpacklo_epi8(b, g);
+
+        __m256i bgra0 = _mm256_unpacklo_epi16(bg, ra);
+        __m256i bgra1 = _mm256_unpackhi_epi16(bg, ra);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest0), _mm256_permute2x128_si256(bgra0, bgra1, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest1), _mm256_permute2x128_si256(bgra0, bgra1, 0x31));
+    }
+
+    MANGO_TARGET_AVX2
+    void process_YCbCr_8x8_avx2(u8* dest, int stride, const BlockType* data, ProcessState* state, int width, int height)
+    {
+        u8 result[64 * 3];
+
+        state->idct(result +   0, data +   0, state->block[0].qt); // Y
+        state->idct(result +  64, data +  64, state->block[1].qt); // Cb
+        state->idct(result + 128, data + 128, state->block[2].qt); // Cr
+
+        const ycbcr_constants_avx2 c = get_ycbcr_constants_avx2();
+
+        // two rows at a time
+        for (int y = 0; y < 8; y += 2)
+        {
+            const u8* s = result + y * 8;
+            __m256i yy = load_16x1_avx2(s +   0, s +   8);
+            __m256i cb = _mm256_add_epi16(load_16x1_avx2(s +  64, s +  72), c.tosigned);
+            __m256i cr = _mm256_add_epi16(load_16x1_avx2(s + 128, s + 136), c.tosigned);
+
+            convert_ycbcr_16x1_avx2(dest, dest + stride, yy, cb, cr, c);
+            dest += stride * 2;
+        }
+
+        MANGO_UNREFERENCED_PARAMETER(width);
+        MANGO_UNREFERENCED_PARAMETER(height);
+    }
+
+    MANGO_TARGET_AVX2
+    void process_YCbCr_8x16_avx2(u8* dest, int stride, const BlockType* data, ProcessState* state, int width, int height)
+    {
+        u8 result[64 * 4];
+
+        state->idct(result +   0, data +   0, state->block[0].qt); // Y0
+        state->idct(result +  64, data +  64, state->block[1].qt); // Y1
+        state->idct(result + 128, data + 128, state->block[2].qt); // Cb
+        state->idct(result + 192, data + 192, state->block[3].qt); // Cr
+
+        const ycbcr_constants_avx2 c = get_ycbcr_constants_avx2();
+
+        // two rows sharing one chroma row at a time
+        for (int y = 0; y < 16; y += 2)
+        {
+            const u8* s = result + y * 8;
+            const u8* t = result + y * 4;
+            __m256i yy = load_16x1_avx2(s, s + 8);
+            __m256i cb = _mm256_add_epi16(load_16x1_avx2(t + 128, t + 128), c.tosigned);
+            __m256i cr = _mm256_add_epi16(load_16x1_avx2(t + 192, t + 192), c.tosigned);
+
+            convert_ycbcr_16x1_avx2(dest, dest + stride, yy, cb, cr, c);
+            dest += stride * 2;
+        }
+
+        MANGO_UNREFERENCED_PARAMETER(width);
+        MANGO_UNREFERENCED_PARAMETER(height);
+    }
+
+    MANGO_TARGET_AVX2
+    void process_YCbCr_16x8_avx2(u8* dest, int stride, const BlockType* data, ProcessState* state, int width, int height)
+    {
+        u8 result[64 * 4];
+
+        state->idct(result +   0, data +   0, state->block[0].qt); // Y0
+        state->idct(result +  64, data +  64, state->block[1].qt); // Y1
+        state->idct(result + 128, data + 128, state->block[2].qt); // Cb
+        state->idct(result + 192, data + 192, state->block[3].qt); // Cr
+
+        const ycbcr_constants_avx2 c = get_ycbcr_constants_avx2();
+
+        for (int y = 0; y < 8; ++y)
+        {
+            const u8* s = result + y * 8;
+            __m256i yy = load_16x1_avx2(s, s + 64);
+            __m256i cb = load_chroma_2x1_avx2(s + 128, c);
+            __m256i cr = load_chroma_2x1_avx2(s + 192, c);
+
+            convert_ycbcr_16x1_avx2(dest, dest + 32, yy, cb, cr, c);
+            dest += stride;
+        }
+
+        MANGO_UNREFERENCED_PARAMETER(width);
+        MANGO_UNREFERENCED_PARAMETER(height);
+    }
+
+    MANGO_TARGET_AVX2
+    void process_YCbCr_16x16_avx2(u8* dest, int stride, const BlockType* data, ProcessState* state, int width, int height)
+    {
+        u8 result[64 * 6];
+
+        // left blocks (Y0, Y2) and right blocks (Y1, Y3) are stored as 8x16 columns
+        state->idct(result +   0, data +   0, state->block[0].qt); // Y0
+        state->idct(result + 128, data +  64, state->block[1].qt); // Y1
+        state->idct(result +  64, data + 128, state->block[2].qt); // Y2
+        state->idct(result + 192, data + 192, state->block[3].qt); // Y3
+        state->idct(result + 256, data + 256, state->block[4].qt); // Cb
+        state->idct(result + 320, data + 320, state->block[5].qt); // Cr
+
+        const ycbcr_constants_avx2 c = get_ycbcr_constants_avx2();
+
+        for (int y = 0; y < 16; y += 2)
+        {
+            const u8* s = result + y * 8;
+            const u8* t = result + y * 4;
+            __m256i cb = load_chroma_2x1_avx2(t + 256, c);
+            __m256i cr = load_chroma_2x1_avx2(t + 320, c);
+
+            convert_ycbcr_16x1_avx2(dest, dest + 32, load_16x1_avx2(s + 0, s + 128), cb, cr, c);
+            dest += stride;
+
+            convert_ycbcr_16x1_avx2(dest, dest + 32, load_16x1_avx2(s + 8, s + 136), cb, cr, c);
+            dest += stride;
+        }
+
+        MANGO_UNREFERENCED_PARAMETER(width);
+        MANGO_UNREFERENCED_PARAMETER(height);
+    }
+
+#undef JPEG_CONST_AVX2
+
+#endif // JPEG_ENABLE_AVX2
+
 #endif // JPEG_ENABLE_SSE2
 
 } // namespace jpeg
@@ -0,0 +1,845 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mango/core/exception.hpp>
+#include <mango/core/thread.hpp>
+#include <mango/math/bvh.hpp>
+
+#define ID "[BVH] "
+
+namespace
+{
+    using namespace mango;
+
+    constexpr int BinCount = 16;
+    constexpr u32 ParallelThreshold = 4096; // smaller subtrees are built serially
+    constexpr int MaxSahDepth = 48; // object median split below this depth bounds the tree height
+    constexpr int StackSize = 256;
+
+    float area(const Box& box)
+    {
+        const float3 s = box.size();
+        return s.x * s.y + s.y * s.z + s.z * s.x;
+    }
+
+    Box triangleBounds(const Triangle& triangle)
+    {
+        Box box(triangle.position[0], triangle.position[1]);
+        box.extend(triangle.position[2]);
+        return box;
+    }
+
+    u32 leafCode(u32 first, u32 count)
+    {
+        return BVH::LEAF | (first << 4) | (count - 1);
+    }
+
+    u32 leafFirst(u32 code)
+    {
+        return (code & ~BVH::LEAF) >> 4;
+    }
+
+    u32 leafCount(u32 code)
+    {
+        return (code & 15) + 1;
+    }
+
+    // ------------------------------------------------------------------
+    // quantization
+    // ------------------------------------------------------------------
+
+    float dequantize(float origin, float scale, u8 q)
+    {
+        return origin + float(q) * scale;
+    }
+
+    void encode(BVH::Node& node, Box& bounds, const Box* boxes, const u32* codes, int count)
+    {
+        bounds = Box();
+        for (int i = 0; i < count; ++i)
+        {
+            bounds.extend(boxes[i]);
+        }
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float origin = bounds.corner[0][axis];
+            const float extent = bounds.corner[1][axis] - origin;
+
+            // 255 steps must cover the whole extent after rounding
+            float scale = extent / 255.0f;
+            while (dequantize(origin, scale, 255) < bounds.corner[1][axis])
+            {
+                scale = std::nextafter(scale, std::numeric_limits<float>::max());
+            }
+
+            node.origin[axis] = origin;
+            node.scale[axis] = scale;
+
+            for (int i = 0; i < 4; ++i)
+            {
+                int q0 = 0;
+                int q1 = 0;
+
+                if (i < count && scale > 0.0f)
+                {
+                    const float cmin = boxes[i].corner[0][axis];
+                    const float cmax = boxes[i].corner[1][axis];
+
+                    q0 = std::max(0, std::min(255, int(std::floor((cmin - origin) / scale))));
+                    q1 = std::max(0, std::min(255, int(std::ceil((cmax - origin) / scale))));
+
+                    // the quantized bounds must contain the child
+                    while (q0 > 0 && dequantize(origin, scale, u8(q0)) > cmin)
+                        --q0;
+                    while (q1 < 255 && dequantize(origin, scale, u8(q1)) < cmax)
+                        ++q1;
+                }
+
+                node.qmin[axis][i] = u8(q0);
+                node.qmax[axis][i] = u8(q1);
+            }
+        }
+
+        for (int i = 0; i < 4; ++i)
+        {
+            node.child[i] = i < count ? codes[i] : BVH::EMPTY;
+        }
+    }
+
+    struct NodeBounds
+    {
+        float32x4 minimum[3];
+        float32x4 maximum[3];
+
+        NodeBounds(const BVH::Node& node)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const u8* q0 = node.qmin[axis];
+                const u8* q1 = node.qmax[axis];
+                const float32x4 origin(node.origin[axis]);
+                const float32x4 scale(node.scale[axis]);
+                minimum[axis] = origin + float32x4(q0[0], q0[1], q0[2], q0[3]) * scale;
+                maximum[axis] = origin + float32x4(q1[0], q1[1], q1[2], q1[3]) * scale;
+            }
+        }
+    };
+
+    u32 validChildren(const BVH::Node& node)
+    {
+        u32 mask = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            mask |= u32(node.child[i] != BVH::EMPTY) << i;
+        }
+        return mask;
+    }
+
+    // ------------------------------------------------------------------
+    // builder
+    // ------------------------------------------------------------------
+
+    struct BuildNode
+    {
+        Box box;
+        u32 left; // zero for leaves; the root is never a child
+        u32 first;
+        u32 count;
+    };
+
+    struct Builder
+    {
+        const std::vector<Box>& boxes;
+        std::vector<float3> centers;
+        std::vector<u32>& indices;
+        std::vector<BuildNode> nodes;
+        std::atomic<u32> allocated { 1 };
+        ConcurrentQueue queue;
+
+        Builder(const std::vector<Box>& boxes, std::vector<u32>& indices)
+            : boxes(boxes)
+            , indices(indices)
+            , nodes(std::max(size_t(1), boxes.size() * 2))
+            , queue("bvh.build")
+        {
+            const size_t count = boxes.size();
+
+            centers.resize(count);
+            indices.resize(count);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                centers[i] = boxes[i].center();
+                indices[i] = u32(i);
+            }
+        }
+
+        u32 findSplit(const BuildNode& node, const Box& cbox, int depth)
+        {
+            const u32 first = node.first;
+            const u32 count = node.count;
+            u32* begin = indices.data() + first;
+            u32* end = begin + count;
+
+            int bestAxis = -1;
+            int bestBin = 0;
+            float bestCost = std::numeric_limits<float>::max();
+
+            const float3 extent = cbox.size();
+
+            if (depth < MaxSahDepth)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    if (extent[axis] <= 0.0f)
+                        continue;
+
+                    Box bins[BinCount];
+                    u32 counts[BinCount] = { 0 };
+
+                    const float scale = BinCount * 0.9999f / extent[axis];
+                    const float origin = cbox.corner[0][axis];
+
+                    for (u32* i = begin; i < end; ++i)
+                    {
+                        const int bin = std::min(BinCount - 1, int((centers[*i][axis] - origin) * scale));
+                        bins[bin].extend(boxes[*i]);
+                        ++counts[bin];
+                    }
+
+                    // right side areas and counts for splits after bin i
+                    float rightArea[BinCount];
+                    u32 rightCount[BinCount];
+
+                    Box right;
+                    u32 rcount = 0;
+
+                    for (int i = BinCount - 1; i > 0; --i)
+                    {
+                        if (counts[i])
+                        {
+                            right.extend(bins[i]);
+                            rcount += counts[i];
+                        }
+                        rightArea[i - 1] = rcount ? area(right) : 0.0f;
+                        rightCount[i - 1] = rcount;
+                    }
+
+                    Box left;
+                    u32 lcount = 0;
+
+                    for (int i = 0; i < BinCount - 1; ++i)
+                    {
+                        if (counts[i])
+                        {
+                            left.extend(bins[i]);
+                            lcount += counts[i];
+                        }
+
+                        if (lcount && rightCount[i])
+                        {
+                            const float cost = area(left) * lcount + rightArea[i] * rightCount[i];
+                            if (cost < bestCost)
+                            {
+                                bestCost = cost;
+                                bestAxis = axis;
+                                bestBin = i;
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (bestAxis >= 0)
+            {
+                // compare to the cost of a leaf with unit traversal and intersection costs
+                const float sah = 1.0f + bestCost / std::max(area(node.box), std::numeric_limits<float>::min());
+                if (count <= BVH::MAX_LEAF_SIZE && sah >= float(count))
+                    return 0;
+
+                const float scale = BinCount * 0.9999f / extent[bestAxis];
+                const float origin = cbox.corner[0][bestAxis];
+
+                u32* middle = std::partition(begin, end, [&] (u32 index)
+                {
+                    const int bin = std::min(BinCount - 1, int((centers[index][bestAxis] - origin) * scale));
+                    return bin <= bestBin;
+                });
+
+                const u32 split = u32(middle - begin);
+                if (split > 0 && split < count)
+                    return split;
+            }
+
+            if (count <= BVH::MAX_LEAF_SIZE)
+                return 0;
+
+            // object median along the largest centroid axis
+            const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+            u32* middle = begin + count / 2;
+            std::nth_element(begin, middle, end, [&] (u32 a, u32 b)
+            {
+                return centers[a][axis] < centers[b][axis];
+            });
+
+            return count / 2;
+        }
+
+        void split(u32 index, u32 first, u32 count, int depth)
+        {
+            BuildNode& node = nodes[index];
+
+            Box cbox;
+            node.box = Box();
+            node.left = 0;
+            node.first = first;
+            node.count = count;
+
+            for (u32 i = first; i < first + count; ++i)
+            {
+                node.box.extend(boxes[indices[i]]);
+                cbox.extend(centers[indices[i]]);
+            }
+
+            if (count <= 2)
+                return;
+
+            const u32 middle = findSplit(node, cbox, depth);
+            if (!middle)
+                return;
+
+            const u32 left = allocated.fetch_add(2);
+            node.left = left;
+
+            if (count > ParallelThreshold)
+            {
+                queue.enqueue([=]
+                {
+                    split(left, first, middle, depth + 1);
+                });
+            }
+            else
+            {
+                split(left, first, middle, depth + 1);
+            }
+
+            split(left + 1, first + middle, count - middle, depth + 1);
+        }
+
+        void build()
+        {
+            split(0, 0, u32(boxes.size()), 0);
+            queue.wait();
+        }
+
+        // collapse the binary tree into 4-wide nodes
+        u32 emit(BVH::NodeArray& output, std::vector<Box>& bounds, u32 index) const
+        {
+            const u32 result = u32(output.size());
+            output.emplace_back();
+            bounds.emplace_back();
+
+            u32 children[4];
+            int count = 0;
+
+            if (nodes[index].left)
+            {
+                children[count++] = nodes[index].left;
+                children[count++] = nodes[index].left + 1;
+            }
+            else
+            {
+                children[count++] = index;
+            }
+
+            // open the largest inner children until the node is full
+            while (count < 4)
+            {
+                int best = -1;
+                float bestArea = -1.0f;
+
+                for (int i = 0; i < count; ++i)
+                {
+                    const BuildNode& child = nodes[children[i]];
+                    if (child.left && area(child.box) > bestArea)
+                    {
+                        bestArea = area(child.box);
+                        best = i;
+                    }
+                }
+
+                if (best < 0)
+                    break;
+
+                const u32 left = nodes[children[best]].left;
+                children[best] = left;
+                children[count++] = left + 1;
+            }
+
+            Box childBounds[4];
+            u32 codes[4];
+
+            for (int i = 0; i < count; ++i)
+            {
+                // a root which is a leaf becomes the only child of the root node
+                const BuildNode& child = nodes[children[i]];
+                childBounds[i] = child.box;
+                codes[i] = child.left ? emit(output, bounds, children[i]) : leafCode(child.first, child.count);
+            }
+
+            encode(output[result], bounds[result], childBounds, codes, count);
+
+            return result;
+        }
+    };
+
+    // ------------------------------------------------------------------
+    // traversal
+    // ------------------------------------------------------------------
+
+    // Visits the leaves hit by the ray front to back. The leaf function returns true
+    // to terminate; it can shorten tmax to prune the remaining nodes.
+    template <typename Leaf>
+    void traverse(const BVH::NodeArray& nodes, const FastRay& ray, float& tmax, Leaf leaf)
+    {
+        if (nodes.empty())
+            return;
+
+        struct Entry
+        {
+            u32 code;
+            float t;
+        };
+
+        Entry stack[StackSize];
+        int sp = 0;
+
+        stack[sp++] = { 0, 0.0f };
+
+        const float32x4 ox(ray.origin.x);
+        const float32x4 oy(ray.origin.y);
+        const float32x4 oz(ray.origin.z);
+        const float32x4 ix(ray.invdir.x);
+        const float32x4 iy(ray.invdir.y);
+        const float32x4 iz(ray.invdir.z);
+
+        while (sp > 0)
+        {
+            const Entry entry = stack[--sp];
+            if (entry.t > tmax)
+                continue;
+
+            if (entry.code & BVH::LEAF)
+            {
+                if (leaf(leafFirst(entry.code), leafCount(entry.code)))
+                    return;
+                continue;
+            }
+
+            const BVH::Node& node = nodes[entry.code];
+            const NodeBounds bounds(node);
+
+            const float32x4 x0 = (bounds.minimum[0] - ox) * ix;
+            const float32x4 x1 = (bounds.maximum[0] - ox) * ix;
+            const float32x4 y0 = (bounds.minimum[1] - oy) * iy;
+            const float32x4 y1 = (bounds.maximum[1] - oy) * iy;
+            const float32x4 z0 = (bounds.minimum[2] - oz) * iz;
+            const float32x4 z1 = (bounds.maximum[2] - oz) * iz;
+
+            const float32x4 t0 = max(max(max(min(x0, x1), min(y0, y1)), min(z0, z1)), float32x4(0.0f));
+            const float32x4 t1 = min(min(min(max(x0, x1), max(y0, y1)), max(z0, z1)), float32x4(tmax));
+
+            u32 mask = maskToInt(t0 <= t1) & validChildren(node);
+            if (!mask)
+                continue;
+
+            float tnear[4];
+            simd::f32x4_ustore(tnear, t0);
+
+            // push the hits far to near so that the nearest child is visited first
+            Entry hits[4];
+            int count = 0;
+
+            for ( ; mask; mask &= mask - 1)
+            {
+                const int i = u32_tzcnt(mask);
+                Entry hit = { node.child[i], tnear[i] };
+
+                int j = count++;
+                for ( ; j > 0 && hits[j - 1].t < hit.t; --j)
+                {
+                    hits[j] = hits[j - 1];
+                }
+                hits[j] = hit;
+            }
+
+            for (int i = 0; i < count; ++i)
+            {
+                stack[sp++] = hits[i];
+            }
+        }
+    }
+
+    float planeDistance(const Plane& plane, const Box& box, int corner)
+    {
+        // corner 1 selects the vertex furthest along the normal, 0 the nearest
+        const float x = box.corner[corner ^ (plane.normal.x < 0)].x;
+        const float y = box.corner[corner ^ (plane.normal.y < 0)].y;
+        const float z = box.corner[corner ^ (plane.normal.z < 0)].z;
+        return plane.normal.x * x + plane.normal.y * y + plane.normal.z * z - plane.dist;
+    }
+
+    bool visible(const Frustum& frustum, const Box& box)
+    {
+        for (const Plane& plane : frustum.plane)
+        {
+            if (planeDistance(plane, box, 1) < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+} // namespace
+
+namespace mango
+{
+
+    // ------------------------------------------------------------------
+    // BVH
+    // ------------------------------------------------------------------
+
+    BVH::BVH()
+        : m_type(NONE)
+    {
+    }
+
+    BVH::BVH(const Triangle* triangles, size_t count)
+        : m_type(NONE)
+    {
+        build(triangles, count);
+    }
+
+    BVH::BVH(const Box* boxes, size_t count)
+        : m_type(NONE)
+    {
+        build(boxes, count);
+    }
+
+    BVH::~BVH()
+    {
+    }
+
+    void BVH::build(const Triangle* triangles, size_t count)
+    {
+        std::vector<Box> boxes(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            boxes[i] = triangleBounds(triangles[i]);
+        }
+
+        build(boxes);
+
+        m_type = TRIANGLES;
+        m_boxes.clear();
+        m_triangles.resize(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            m_triangles[i] = triangles[m_indices[i]];
+        }
+    }
+
+    void BVH::build(const Box* boxes, size_t count)
+    {
+        std::vector<Box> temp(boxes, boxes + count);
+
+        build(temp);
+
+        m_type = BOXES;
+        m_triangles.clear();
+        m_boxes.resize(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            m_boxes[i] = boxes[m_indices[i]];
+        }
+    }
+
+    void BVH::build(const std::vector<Box>& boxes)
+    {
+        if (boxes.size() >= MAX_PRIMITIVES)
+        {
+            MANGO_EXCEPTION(ID"Too many primitives.");
+        }
+
+        m_nodes.clear();
+        m_bounds.clear();
+        m_indices.clear();
+
+        if (boxes.empty())
+            return;
+
+        Builder builder(boxes, m_indices);
+        builder.build();
+
+        m_nodes.reserve(builder.allocated / 2 + 1);
+        m_bounds.reserve(builder.allocated / 2 + 1);
+        builder.emit(m_nodes, m_bounds, 0);
+    }
+
+    void BVH::refit(const Triangle* triangles)
+    {
+        if (m_type != TRIANGLES)
+        {
+            MANGO_EXCEPTION(ID"The hierarchy was not built from triangles.");
+        }
+
+        for (size_t i = 0; i < m_triangles.size(); ++i)
+        {
+            m_triangles[i] = triangles[m_indices[i]];
+        }
+
+        refit();
+    }
+
+    void BVH::refit(const Box* boxes)
+    {
+        if (m_type != BOXES)
+        {
+            MANGO_EXCEPTION(ID"The hierarchy was not built from boxes.");
+        }
+
+        for (size_t i = 0; i < m_boxes.size(); ++i)
+        {
+            m_boxes[i] = boxes[m_indices[i]];
+        }
+
+        refit();
+    }
+
+    void BVH::refit()
+    {
+        // children are always stored after their parent
+        for (size_t i = m_nodes.size(); i-- > 0; )
+        {
+            Node& node = m_nodes[i];
+
+            Box boxes[4];
+            u32 codes[4];
+            int count = 0;
+
+            for (int j = 0; j < 4; ++j)
+            {
+                const u32 code = node.child[j];
+                if (code == EMPTY)
+                    continue;
+
+                boxes[count] = (code & LEAF) ? leafBounds(code) : m_bounds[code];
+                codes[count] = code;
+                ++count;
+            }
+
+            encode(node, m_bounds[i], boxes, codes, count);
+        }
+    }
+
+    Box BVH::leafBounds(u32 code) const
+    {
+        const u32 first = leafFirst(code);
+        const u32 last = first + leafCount(code);
+
+        Box box;
+        for (u32 i = first; i < last; ++i)
+        {
+            box.extend(m_type == TRIANGLES ? triangleBounds(m_triangles[i]) : m_boxes[i]);
+        }
+
+        return box;
+    }
+
+    bool BVH::intersect(IntersectBarycentric& result, u32& index, const Ray& ray) const
+    {
+        if (m_type != TRIANGLES)
+            return false;
+
+        float tmax = std::numeric_limits<float>::max();
+        bool hit = false;
+
+        traverse(m_nodes, FastRay(ray), tmax, [&] (u32 first, u32 count)
+        {
+            for (u32 i = first; i < first + count; ++i)
+            {
+                IntersectBarycentric is;
+                if (is.intersect(ray, m_triangles[i]) && is.t0 > 0.0f && is.t0 < tmax)
+                {
+                    tmax = is.t0;
+                    result = is;
+                    index = m_indices[i];
+                    hit = true;
+                }
+            }
+            return false;
+        });
+
+        return hit;
+    }
+
+    bool BVH::intersect(IntersectRange& result, u32& index, const Ray& ray) const
+    {
+        if (m_type != BOXES)
+            return false;
+
+        float tmax = std::numeric_limits<float>::max();
+        bool hit = false;
+
+        traverse(m_nodes, FastRay(ray), tmax, [&] (u32 first, u32 count)
+        {
+            for (u32 i = first; i < first + count; ++i)
+            {
+                IntersectRange is;
+                if (is.intersect(ray, m_boxes[i]))
+                {
+                    const float t = std::max(is.t0, 0.0f);
+                    if (t < tmax)
+                    {
+                        tmax = t;
+                        result = is;
+                        index = m_indices[i];
+                        hit = true;
+                    }
+                }
+            }
+            return false;
+        });
+
+        return hit;
+    }
+
+    bool BVH::occluded(const Ray& ray, float distance) const
+    {
+        float tmax = distance;
+        bool hit = false;
+
+        traverse(m_nodes, FastRay(ray), tmax, [&] (u32 first, u32 count)
+        {
+            for (u32 i = first; i < first + count; ++i)
+            {
+                if (m_type == TRIANGLES)
+                {
+                    IntersectBarycentric is;
+                    hit = is.intersect(ray, m_triangles[i]) && is.t0 > 0.0f && is.t0 < distance;
+                }
+                else
+                {
+                    IntersectRange is;
+                    hit = is.intersect(ray, m_boxes[i]) && std::max(is.t0, 0.0f) < distance;
+                }
+
+                if (hit)
+                    break;
+            }
+            return hit;
+        });
+
+        return hit;
+    }
+
+    void BVH::intersect(std::vector<u32>& indices, const Frustum& frustum) const
+    {
+        indices.clear();
+
+        if (m_nodes.empty())
+            return;
+
+        struct Entry
+        {
+            u32 code;
+            bool inside; // the whole subtree is inside the frustum
+        };
+
+        Entry stack[StackSize];
+        int sp = 0;
+
+        stack[sp++] = { 0, false };
+
+        while (sp > 0)
+        {
+            const Entry entry = stack[--sp];
+
+            if (entry.code & LEAF)
+            {
+                const u32 first = leafFirst(entry.code);
+                const u32 last = first + leafCount(entry.code);
+
+                for (u32 i = first; i < last; ++i)
+                {
+                    if (entry.inside || visible(frustum, m_type == TRIANGLES ? triangleBounds(m_triangles[i]) : m_boxes[i]))
+                    {
+                        indices.push_back(m_indices[i]);
+                    }
+                }
+                continue;
+            }
+
+            const Node& node = m_nodes[entry.code];
+            u32 visibleMask = validChildren(node);
+            u32 insideMask = entry.inside ? visibleMask : 0;
+
+            if (!entry.inside)
+            {
+                const NodeBounds bounds(node);
+                insideMask = visibleMask;
+
+                for (const Plane& plane : frustum.plane)
+                {
+                    const float32x4 nx(plane.normal.x);
+                    const float32x4 ny(plane.normal.y);
+                    const float32x4 nz(plane.normal.z);
+                    const float32x4 dist(plane.dist);
+
+                    const int sx = plane.normal.x < 0;
+                    const int sy = plane.normal.y < 0;
+                    const int sz = plane.normal.z < 0;
+
+                    // furthest and nearest corners along the plane normal
+                    const float32x4 far = (sx ? bounds.minimum[0] : bounds.maximum[0]) * nx +
+                                          (sy ? bounds.minimum[1] : bounds.maximum[1]) * ny +
+                                          (sz ? bounds.minimum[2] : bounds.maximum[2]) * nz;
+                    const float32x4 near = (sx ? bounds.maximum[0] : bounds.minimum[0]) * nx +
+                                           (sy ? bounds.maximum[1] : bounds.minimum[1]) * ny +
+                                           (sz ? bounds.maximum[2] : bounds.minimum[2]) * nz;
+
+                    visibleMask &= maskToInt(far >= dist);
+                    insideMask &= maskToInt(near >= dist);
+                }
+            }
+
+            for ( ; visibleMask; visibleMask &= visibleMask - 1)
+            {
+                const int i = u32_tzcnt(visibleMask);
+                stack[sp++] = { node.child[i], ((insideMask >> i) & 1) != 0 };
+            }
+        }
+    }
+
+    size_t BVH::size() const
+    {
+        return m_indices.size();
+    }
+
+    Box BVH::bounds() const
+    {
+        return m_bounds.empty() ? Box() : m_bounds[0];
+    }
+
+    const BVH::NodeArray& BVH::nodes() const
+    {
+        return m_nodes;
+    }
+
+} // namespace mango
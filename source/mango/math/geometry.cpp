@@ -3,9 +3,299 @@
     Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
 */
 
+#include <algorithm>
 #include <cmath>
+#include <mango/core/bits.hpp>
 #include <mango/math/geometry.hpp>
 
+namespace
+{
+    using namespace mango;
+
+    // The batch queries use the widest vector the build natively supports;
+    // the batches are padded to 16 elements so any of these widths divides them.
+#if defined(MANGO_ENABLE_AVX512)
+    using BatchFloat = float32x16;
+#elif defined(MANGO_ENABLE_AVX)
+    using BatchFloat = float32x8;
+#else
+    using BatchFloat = float32x4;
+#endif
+
+    constexpr size_t BatchPadding = 16;
+
+    template <typename T>
+    T uload(const float* source);
+
+    template <>
+    inline float32x4 uload<float32x4>(const float* source)
+    {
+        return simd::f32x4_uload(source);
+    }
+
+    template <>
+    inline float32x8 uload<float32x8>(const float* source)
+    {
+        return simd::f32x8_uload(source);
+    }
+
+    template <>
+    inline float32x16 uload<float32x16>(const float* source)
+    {
+        return simd::f32x16_uload(source);
+    }
+
+    inline void ustore(float* dest, float32x4 v)
+    {
+        simd::f32x4_ustore(dest, v);
+    }
+
+    inline void ustore(float* dest, float32x8 v)
+    {
+        simd::f32x8_ustore(dest, v);
+    }
+
+    inline void ustore(float* dest, float32x16 v)
+    {
+        simd::f32x16_ustore(dest, v);
+    }
+
+    inline size_t padded(size_t count)
+    {
+        return (count + BatchPadding - 1) & ~(BatchPadding - 1);
+    }
+
+    inline void grow(BatchArray& array, size_t size)
+    {
+        // new elements are zero; the queries mask out lanes past the batch size
+        if (size >= array.size())
+        {
+            array.resize(array.size() + BatchPadding, 0.0f);
+        }
+    }
+
+    // bits for the lanes of a block starting at index which are inside the batch
+    inline u32 valid_lanes(size_t index, size_t size, int lanes)
+    {
+        const size_t count = std::min(size - index, size_t(lanes));
+        return count >= 32 ? 0xffffffff : (1u << count) - 1;
+    }
+
+    // ------------------------------------------------------------------
+    // SIMD kernels shared by the packet and batch queries
+    // ------------------------------------------------------------------
+
+    template <typename T>
+    inline u32 kernel_box(T& t0, T& t1, const T* origin, const T* invdir,
+                          T minx, T miny, T minz, T maxx, T maxy, T maxz)
+    {
+        const T x0 = (minx - origin[0]) * invdir[0];
+        const T x1 = (maxx - origin[0]) * invdir[0];
+        const T y0 = (miny - origin[1]) * invdir[1];
+        const T y1 = (maxy - origin[1]) * invdir[1];
+        const T z0 = (minz - origin[2]) * invdir[2];
+        const T z1 = (maxz - origin[2]) * invdir[2];
+
+        t0 = max(max(min(x0, x1), min(y0, y1)), min(z0, z1));
+        t1 = min(min(max(x0, x1), max(y0, y1)), max(z0, z1));
+
+        return maskToInt(t1 >= max(t0, T(0.0f)));
+    }
+
+    template <typename T>
+    inline u32 kernel_sphere(T& t0, T& t1, const T* origin, const T* direction,
+                             T cx, T cy, T cz, T radius)
+    {
+        const T dx = origin[0] - cx;
+        const T dy = origin[1] - cy;
+        const T dz = origin[2] - cz;
+
+        const T b = dx * direction[0] + dy * direction[1] + dz * direction[2];
+        const T c = dx * dx + dy * dy + dz * dz - radius * radius;
+        const T d = b * b - c;
+        const T s = sqrt(max(d, T(0.0f)));
+
+        t0 = -b - s;
+        t1 = -b + s;
+
+        return maskToInt(d >= T(0.0f));
+    }
+
+    template <typename T>
+    inline u32 kernel_triangle(T& t0, T& v, T& w, const T* origin, const T* direction,
+                               T x0, T y0, T z0, T x1, T y1, T z1, T x2, T y2, T z2)
+    {
+        // Based on article by Tomas Möller
+        // Fast, Minimum Storage Ray-Triangle Intersection
+
+        // pvec = cross(direction, edge2)
+        const T px = direction[1] * z2 - direction[2] * y2;
+        const T py = direction[2] * x2 - direction[0] * z2;
+        const T pz = direction[0] * y2 - direction[1] * x2;
+
+        const T det = x1 * px + y1 * py + z1 * pz;
+
+        const T tx = origin[0] - x0;
+        const T ty = origin[1] - y0;
+        const T tz = origin[2] - z0;
+
+        v = tx * px + ty * py + tz * pz;
+
+        // qvec = cross(tvec, edge1)
+        const T qx = ty * z1 - tz * y1;
+        const T qy = tz * x1 - tx * z1;
+        const T qz = tx * y1 - ty * x1;
+
+        w = direction[0] * qx + direction[1] * qy + direction[2] * qz;
+
+        const T zero(0.0f);
+        const auto mask = (det > T(0.000001f)) & (v >= zero) & (w >= zero) & ((v + w) <= det);
+
+        const T invdet = T(1.0f) / select(mask, det, T(1.0f));
+        t0 = (x2 * qx + y2 * qy + z2 * qz) * invdet;
+        v = v * invdet;
+        w = w * invdet;
+
+        return maskToInt(mask);
+    }
+
+    struct BatchRay
+    {
+        BatchFloat origin[3];
+        BatchFloat direction[3];
+        BatchFloat invdir[3];
+
+        BatchRay(const Ray& ray)
+        {
+            const FastRay fast(ray);
+            for (int i = 0; i < 3; ++i)
+            {
+                origin[i] = fast.origin[i];
+                direction[i] = fast.direction[i];
+                invdir[i] = fast.invdir[i];
+            }
+        }
+    };
+
+    // The batch kernels return hits in front of the ray origin and the distance to
+    // the nearest such boundary: the entry point, or the exit point when the ray
+    // starts inside the primitive.
+
+    auto batch_box_kernel(const BatchRay& ray, const BoxBatch& boxes)
+    {
+        return [&ray, &boxes] (size_t i, BatchFloat& t)
+        {
+            BatchFloat t1;
+            u32 mask = kernel_box(t, t1, ray.origin, ray.invdir,
+                uload<BatchFloat>(&boxes.minx[i]), uload<BatchFloat>(&boxes.miny[i]), uload<BatchFloat>(&boxes.minz[i]),
+                uload<BatchFloat>(&boxes.maxx[i]), uload<BatchFloat>(&boxes.maxy[i]), uload<BatchFloat>(&boxes.maxz[i]));
+            t = max(t, BatchFloat(0.0f));
+            return mask;
+        };
+    }
+
+    auto batch_sphere_kernel(const BatchRay& ray, const SphereBatch& spheres)
+    {
+        return [&ray, &spheres] (size_t i, BatchFloat& t)
+        {
+            BatchFloat t1;
+            u32 mask = kernel_sphere(t, t1, ray.origin, ray.direction,
+                uload<BatchFloat>(&spheres.x[i]), uload<BatchFloat>(&spheres.y[i]),
+                uload<BatchFloat>(&spheres.z[i]), uload<BatchFloat>(&spheres.radius[i]));
+            const BatchFloat zero(0.0f);
+            mask &= maskToInt(t1 > zero);
+            t = select(t > zero, t, t1);
+            return mask;
+        };
+    }
+
+    auto batch_triangle_kernel(const BatchRay& ray, const TriangleBatch& triangles)
+    {
+        return [&ray, &triangles] (size_t i, BatchFloat& t)
+        {
+            BatchFloat v, w;
+            u32 mask = kernel_triangle(t, v, w, ray.origin, ray.direction,
+                uload<BatchFloat>(&triangles.x0[i]), uload<BatchFloat>(&triangles.y0[i]), uload<BatchFloat>(&triangles.z0[i]),
+                uload<BatchFloat>(&triangles.x1[i]), uload<BatchFloat>(&triangles.y1[i]), uload<BatchFloat>(&triangles.z1[i]),
+                uload<BatchFloat>(&triangles.x2[i]), uload<BatchFloat>(&triangles.y2[i]), uload<BatchFloat>(&triangles.z2[i]));
+            mask &= maskToInt(t > BatchFloat(0.0f));
+            return mask;
+        };
+    }
+
+    // Runs the kernel over the batch in blocks of BatchFloat lanes. The kernel returns the
+    // hit bits and the hit distance of each lane; the visitor receives the valid hits.
+    template <typename Kernel, typename Visitor>
+    void for_each_block(size_t size, Kernel kernel, Visitor visitor)
+    {
+        const int lanes = BatchFloat::VectorSize;
+
+        for (size_t i = 0; i < size; i += lanes)
+        {
+            BatchFloat t;
+            u32 bits = kernel(i, t);
+            bits &= valid_lanes(i, size, lanes);
+            visitor(i, bits, t);
+        }
+    }
+
+    template <typename Kernel>
+    size_t write_mask(u32* mask, size_t size, Kernel kernel)
+    {
+        std::fill(mask, mask + (size + 31) / 32, 0);
+
+        size_t count = 0;
+
+        for_each_block(size, kernel, [&] (size_t index, u32 bits, const BatchFloat& t)
+        {
+            MANGO_UNREFERENCED_PARAMETER(t);
+            mask[index / 32] |= bits << (index % 32);
+            count += u32_count_bits(bits);
+        });
+
+        return count;
+    }
+
+    template <typename Kernel>
+    bool find_closest(float& t0, int& index, size_t size, Kernel kernel)
+    {
+        t0 = std::numeric_limits<float>::max();
+        index = -1;
+
+        for_each_block(size, kernel, [&] (size_t base, u32 bits, const BatchFloat& t)
+        {
+            if (bits)
+            {
+                float temp[BatchFloat::VectorSize];
+                ustore(temp, t);
+
+                for ( ; bits; bits &= bits - 1)
+                {
+                    const int lane = u32_tzcnt(bits);
+                    if (temp[lane] < t0)
+                    {
+                        t0 = temp[lane];
+                        index = int(base + lane);
+                    }
+                }
+            }
+        });
+
+        return index >= 0;
+    }
+
+    template <typename Kernel>
+    size_t cull(u32* mask, size_t size, Kernel kernel)
+    {
+        return write_mask(mask, size, [&] (size_t i, BatchFloat& t)
+        {
+            t = 0.0f;
+            return kernel(i);
+        });
+    }
+
+} // namespace
+
 namespace mango
 {
 
@@ -266,6 +556,20 @@ namespace mango
         const float3 temp = cross(px, nx);
 
         origin = (point[0] * d0 + point[1] * d1 + temp * d2) * s;
+
+        const float4 planes[] =
+        {
+            m[3] + m[0], m[3] - m[0],
+            m[3] + m[1], m[3] - m[1],
+            m[3] + m[2], m[3] - m[2],
+        };
+
+        for (int i = 0; i < 6; ++i)
+        {
+            const float3 normal = planes[i].xyz;
+            const float scale = 1.0f / length(normal);
+            plane[i] = Plane(normal * scale, -float(planes[i].w) * scale);
+        }
     }
 
     Ray Frustum::ray(float x, float y) const
@@ -276,6 +580,172 @@ namespace mango
         return Ray(origin, normalize(p - origin));
     }
 
+    // ------------------------------------------------------------------
+    // RayPacket
+    // ------------------------------------------------------------------
+
+    template <typename T>
+    RayPacket<T>::RayPacket(const Ray* rays)
+    {
+        const int N = T::VectorSize;
+
+        for (int i = 0; i < N; ++i)
+        {
+            const FastRay ray(rays[i]);
+
+            for (int j = 0; j < 3; ++j)
+            {
+                origin[j][i] = ray.origin[j];
+                direction[j][i] = ray.direction[j];
+                invdir[j][i] = ray.invdir[j];
+            }
+        }
+    }
+
+    template struct RayPacket<float32x4>;
+    template struct RayPacket<float32x8>;
+    template struct RayPacket<float32x16>;
+
+    // ------------------------------------------------------------------
+    // BoxBatch
+    // ------------------------------------------------------------------
+
+    void BoxBatch::reserve(size_t count)
+    {
+        count = padded(count);
+        for (BatchArray* array : { &minx, &miny, &minz, &maxx, &maxy, &maxz })
+        {
+            array->reserve(count);
+        }
+    }
+
+    void BoxBatch::clear()
+    {
+        for (BatchArray* array : { &minx, &miny, &minz, &maxx, &maxy, &maxz })
+        {
+            array->clear();
+        }
+        m_size = 0;
+    }
+
+    void BoxBatch::push_back(const Box& box)
+    {
+        for (BatchArray* array : { &minx, &miny, &minz, &maxx, &maxy, &maxz })
+        {
+            grow(*array, m_size);
+        }
+
+        minx[m_size] = box.corner[0].x;
+        miny[m_size] = box.corner[0].y;
+        minz[m_size] = box.corner[0].z;
+        maxx[m_size] = box.corner[1].x;
+        maxy[m_size] = box.corner[1].y;
+        maxz[m_size] = box.corner[1].z;
+        ++m_size;
+    }
+
+    Box BoxBatch::operator [] (size_t index) const
+    {
+        assert(index < m_size);
+        return Box(float3(minx[index], miny[index], minz[index]),
+                   float3(maxx[index], maxy[index], maxz[index]));
+    }
+
+    // ------------------------------------------------------------------
+    // SphereBatch
+    // ------------------------------------------------------------------
+
+    void SphereBatch::reserve(size_t count)
+    {
+        count = padded(count);
+        for (BatchArray* array : { &x, &y, &z, &radius })
+        {
+            array->reserve(count);
+        }
+    }
+
+    void SphereBatch::clear()
+    {
+        for (BatchArray* array : { &x, &y, &z, &radius })
+        {
+            array->clear();
+        }
+        m_size = 0;
+    }
+
+    void SphereBatch::push_back(const Sphere& sphere)
+    {
+        for (BatchArray* array : { &x, &y, &z, &radius })
+        {
+            grow(*array, m_size);
+        }
+
+        x[m_size] = sphere.center.x;
+        y[m_size] = sphere.center.y;
+        z[m_size] = sphere.center.z;
+        radius[m_size] = sphere.radius;
+        ++m_size;
+    }
+
+    Sphere SphereBatch::operator [] (size_t index) const
+    {
+        assert(index < m_size);
+        return Sphere(float3(x[index], y[index], z[index]), radius[index]);
+    }
+
+    // ------------------------------------------------------------------
+    // TriangleBatch
+    // ------------------------------------------------------------------
+
+    void TriangleBatch::reserve(size_t count)
+    {
+        count = padded(count);
+        for (BatchArray* array : { &x0, &y0, &z0, &x1, &y1, &z1, &x2, &y2, &z2 })
+        {
+            array->reserve(count);
+        }
+    }
+
+    void TriangleBatch::clear()
+    {
+        for (BatchArray* array : { &x0, &y0, &z0, &x1, &y1, &z1, &x2, &y2, &z2 })
+        {
+            array->clear();
+        }
+        m_size = 0;
+    }
+
+    void TriangleBatch::push_back(const Triangle& triangle)
+    {
+        for (BatchArray* array : { &x0, &y0, &z0, &x1, &y1, &z1, &x2, &y2, &z2 })
+        {
+            grow(*array, m_size);
+        }
+
+        const float3 edge1 = triangle.position[1] - triangle.position[0];
+        const float3 edge2 = triangle.position[2] - triangle.position[0];
+
+        x0[m_size] = triangle.position[0].x;
+        y0[m_size] = triangle.position[0].y;
+        z0[m_size] = triangle.position[0].z;
+        x1[m_size] = edge1.x;
+        y1[m_size] = edge1.y;
+        z1[m_size] = edge1.z;
+        x2[m_size] = edge2.x;
+        y2[m_size] = edge2.y;
+        z2[m_size] = edge2.z;
+        ++m_size;
+    }
+
+    Triangle TriangleBatch::operator [] (size_t index) const
+    {
+        assert(index < m_size);
+        const float3 p0(x0[index], y0[index], z0[index]);
+        const float3 p1(x1[index], y1[index], z1[index]);
+        const float3 p2(x2[index], y2[index], z2[index]);
+        return Triangle(p0, p0 + p1, p0 + p2);
+    }
+
     // ------------------------------------------------------------------
     // Intersect
     // ------------------------------------------------------------------
@@ -502,10 +972,139 @@ namespace mango
         return true;
     }
 
+    // ------------------------------------------------------------------
+    // PacketIntersectRange
+    // ------------------------------------------------------------------
+
+    template <typename T>
+    u32 PacketIntersectRange<T>::intersect(const RayPacket<T>& packet, const Box& box)
+    {
+        return kernel_box(t0, t1, packet.origin, packet.invdir,
+            T(box.corner[0].x), T(box.corner[0].y), T(box.corner[0].z),
+            T(box.corner[1].x), T(box.corner[1].y), T(box.corner[1].z));
+    }
+
+    template <typename T>
+    u32 PacketIntersectRange<T>::intersect(const RayPacket<T>& packet, const Sphere& sphere)
+    {
+        return kernel_sphere(t0, t1, packet.origin, packet.direction,
+            T(sphere.center.x), T(sphere.center.y), T(sphere.center.z), T(sphere.radius));
+    }
+
+    template struct PacketIntersectRange<float32x4>;
+    template struct PacketIntersectRange<float32x8>;
+    template struct PacketIntersectRange<float32x16>;
+
+    // ------------------------------------------------------------------
+    // PacketIntersectBarycentric
+    // ------------------------------------------------------------------
+
+    template <typename T>
+    u32 PacketIntersectBarycentric<T>::intersect(const RayPacket<T>& packet, const Triangle& triangle)
+    {
+        const float3 edge1 = triangle.position[1] - triangle.position[0];
+        const float3 edge2 = triangle.position[2] - triangle.position[0];
+
+        u32 mask = kernel_triangle(t0, v, w, packet.origin, packet.direction,
+            T(triangle.position[0].x), T(triangle.position[0].y), T(triangle.position[0].z),
+            T(edge1.x), T(edge1.y), T(edge1.z),
+            T(edge2.x), T(edge2.y), T(edge2.z));
+        u = T(1.0f) - v - w;
+        return mask;
+    }
+
+    template struct PacketIntersectBarycentric<float32x4>;
+    template struct PacketIntersectBarycentric<float32x8>;
+    template struct PacketIntersectBarycentric<float32x16>;
+
+    // ------------------------------------------------------------------
+    // IntersectBatch
+    // ------------------------------------------------------------------
+
+    bool IntersectBatch::intersect(const Ray& ray, const BoxBatch& boxes)
+    {
+        const BatchRay batch(ray);
+        return find_closest(t0, index, boxes.size(), batch_box_kernel(batch, boxes));
+    }
+
+    bool IntersectBatch::intersect(const Ray& ray, const SphereBatch& spheres)
+    {
+        const BatchRay batch(ray);
+        return find_closest(t0, index, spheres.size(), batch_sphere_kernel(batch, spheres));
+    }
+
+    bool IntersectBatch::intersect(const Ray& ray, const TriangleBatch& triangles)
+    {
+        const BatchRay batch(ray);
+        return find_closest(t0, index, triangles.size(), batch_triangle_kernel(batch, triangles));
+    }
+
     // ------------------------------------------------------------------
     // intersect()
     // ------------------------------------------------------------------
 
+    size_t intersect(u32* mask, const Ray& ray, const BoxBatch& boxes)
+    {
+        const BatchRay batch(ray);
+        return write_mask(mask, boxes.size(), batch_box_kernel(batch, boxes));
+    }
+
+    size_t intersect(u32* mask, const Ray& ray, const SphereBatch& spheres)
+    {
+        const BatchRay batch(ray);
+        return write_mask(mask, spheres.size(), batch_sphere_kernel(batch, spheres));
+    }
+
+    size_t intersect(u32* mask, const Ray& ray, const TriangleBatch& triangles)
+    {
+        const BatchRay batch(ray);
+        return write_mask(mask, triangles.size(), batch_triangle_kernel(batch, triangles));
+    }
+
+    size_t intersect(u32* mask, const Frustum& frustum, const BoxBatch& boxes)
+    {
+        return cull(mask, boxes.size(), [&] (size_t i)
+        {
+            u32 inside = 0xffffffff;
+
+            for (const Plane& plane : frustum.plane)
+            {
+                // test the corner furthest along the plane normal
+                const float* x = plane.normal.x < 0 ? &boxes.minx[i] : &boxes.maxx[i];
+                const float* y = plane.normal.y < 0 ? &boxes.miny[i] : &boxes.maxy[i];
+                const float* z = plane.normal.z < 0 ? &boxes.minz[i] : &boxes.maxz[i];
+
+                const BatchFloat d = uload<BatchFloat>(x) * plane.normal.x +
+                                     uload<BatchFloat>(y) * plane.normal.y +
+                                     uload<BatchFloat>(z) * plane.normal.z;
+                inside &= maskToInt(d >= BatchFloat(plane.dist));
+            }
+
+            return inside;
+        });
+    }
+
+    size_t intersect(u32* mask, const Frustum& frustum, const SphereBatch& spheres)
+    {
+        return cull(mask, spheres.size(), [&] (size_t i)
+        {
+            const BatchFloat x = uload<BatchFloat>(&spheres.x[i]);
+            const BatchFloat y = uload<BatchFloat>(&spheres.y[i]);
+            const BatchFloat z = uload<BatchFloat>(&spheres.z[i]);
+            const BatchFloat radius = uload<BatchFloat>(&spheres.radius[i]);
+
+            u32 inside = 0xffffffff;
+
+            for (const Plane& plane : frustum.plane)
+            {
+                const BatchFloat d = x * plane.normal.x + y * plane.normal.y + z * plane.normal.z;
+                inside &= maskToInt(d + radius >= BatchFloat(plane.dist));
+            }
+
+            return inside;
+        });
+    }
+
     bool intersect(Rectangle& result, const Rectangle& rect0, const Rectangle& rect1)
     {
         // Trivial reject
@@ -6,6 +6,7 @@
     This work is based on "SLEEF" library and converted to use MANGO SIMD abstraction
     Author : Naoki Shibata
 */
+#include <limits>
 #include <mango/math/vector.hpp>
 
 namespace mango {
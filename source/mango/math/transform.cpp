@@ -0,0 +1,437 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#include <algorithm>
+#include <cstring>
+#include <mango/core/cpuinfo.hpp>
+#include <mango/core/thread.hpp>
+#include <mango/math/srgb.hpp>
+#include <mango/math/transform.hpp>
+
+#if defined(MANGO_ENABLE_F16C) || (defined(MANGO_ENABLE_SSE2) && defined(MANGO_ENABLE_TARGET_DISPATCH))
+    // F16C kernels are selected at runtime when not enabled at compile time
+    #define ARRAY_ENABLE_F16C
+#endif
+
+namespace
+{
+    using namespace mango;
+
+    static_assert(sizeof(float3) == 12, "float3 must be tightly packed.");
+
+    constexpr size_t ParallelThreshold = 64 * 1024; // elements
+    constexpr size_t BlockSize = 16 * 1024; // elements; multiple of 8
+
+    // Calls func(first, last) for consecutive ranges which cover [0, count).
+    template <typename Func>
+    void process(size_t count, Func func)
+    {
+        if (count < ParallelThreshold)
+        {
+            func(size_t(0), count);
+            return;
+        }
+
+        ConcurrentQueue queue("math.array");
+
+        for (size_t first = 0; first < count; first += BlockSize)
+        {
+            const size_t last = std::min(count, first + BlockSize);
+            queue.enqueue([=]
+            {
+                func(first, last);
+            });
+        }
+
+        queue.wait();
+    }
+
+    // ------------------------------------------------------------------
+    // float3 AoS <-> SoA
+    // ------------------------------------------------------------------
+
+    // four float3 in three vectors: a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+
+    inline void aos_to_soa(float32x4& x, float32x4& y, float32x4& z, const float3* source)
+    {
+        const float* s = reinterpret_cast<const float*>(source);
+        const float32x4 a = simd::f32x4_uload(s + 0);
+        const float32x4 b = simd::f32x4_uload(s + 4);
+        const float32x4 c = simd::f32x4_uload(s + 8);
+
+        x = shuffle<0, 3, 0, 2>(a, shuffle<2, 2, 1, 1>(b, c));
+        y = shuffle<0, 2, 0, 2>(shuffle<1, 1, 0, 0>(a, b), shuffle<3, 3, 2, 2>(b, c));
+        z = shuffle<0, 2, 0, 1>(shuffle<2, 2, 1, 1>(a, b), shuffle<0, 3, 0, 3>(c, c));
+    }
+
+    inline void soa_to_aos(float3* dest, float32x4 x, float32x4 y, float32x4 z)
+    {
+        float* d = reinterpret_cast<float*>(dest);
+        simd::f32x4_ustore(d + 0, shuffle<0, 2, 0, 2>(shuffle<0, 0, 0, 0>(x, y), shuffle<0, 0, 1, 1>(z, x)));
+        simd::f32x4_ustore(d + 4, shuffle<0, 2, 0, 2>(shuffle<1, 1, 1, 1>(y, z), shuffle<2, 2, 2, 2>(x, y)));
+        simd::f32x4_ustore(d + 8, shuffle<0, 2, 0, 2>(shuffle<2, 2, 3, 3>(z, x), shuffle<3, 3, 3, 3>(y, z)));
+    }
+
+    // ------------------------------------------------------------------
+    // kernels
+    // ------------------------------------------------------------------
+
+    struct Transform
+    {
+        float32x4 m[4][3];
+
+        Transform(const float4x4& matrix)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    m[i][j] = matrix(i, j);
+                }
+            }
+        }
+
+        void point(float32x4& x, float32x4& y, float32x4& z) const
+        {
+            const float32x4 tx = x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0];
+            const float32x4 ty = x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1];
+            const float32x4 tz = x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2];
+            x = tx;
+            y = ty;
+            z = tz;
+        }
+
+        void normal(float32x4& x, float32x4& y, float32x4& z) const
+        {
+            const float32x4 tx = x * m[0][0] + y * m[1][0] + z * m[2][0];
+            const float32x4 ty = x * m[0][1] + y * m[1][1] + z * m[2][1];
+            const float32x4 tz = x * m[0][2] + y * m[1][2] + z * m[2][2];
+            const float32x4 s = tx * tx + ty * ty + tz * tz;
+            const float32x4 scale = select(s > 0.0f, 1.0f / sqrt(s), float32x4(0.0f));
+            x = tx * scale;
+            y = ty * scale;
+            z = tz * scale;
+        }
+    };
+
+    using TransformFunc = void (Transform::*)(float32x4& x, float32x4& y, float32x4& z) const;
+
+    void transformAoS(float3* dest, const float3* source, size_t count, const Transform& transform, TransformFunc func)
+    {
+        process(count, [=, &transform] (size_t first, size_t last)
+        {
+            size_t i = first;
+
+            for ( ; i + 4 <= last; i += 4)
+            {
+                float32x4 x, y, z;
+                aos_to_soa(x, y, z, source + i);
+                (transform.*func)(x, y, z);
+                soa_to_aos(dest + i, x, y, z);
+            }
+
+            for ( ; i < last; ++i)
+            {
+                float32x4 x = source[i].x;
+                float32x4 y = source[i].y;
+                float32x4 z = source[i].z;
+                (transform.*func)(x, y, z);
+                dest[i] = float3(x.x, y.x, z.x);
+            }
+        });
+    }
+
+    void transformSoA(float* px, float* py, float* pz, size_t count, const Transform& transform, TransformFunc func)
+    {
+        process(count, [=, &transform] (size_t first, size_t last)
+        {
+            size_t i = first;
+
+            for ( ; i + 4 <= last; i += 4)
+            {
+                float32x4 x = simd::f32x4_uload(px + i);
+                float32x4 y = simd::f32x4_uload(py + i);
+                float32x4 z = simd::f32x4_uload(pz + i);
+                (transform.*func)(x, y, z);
+                simd::f32x4_ustore(px + i, x);
+                simd::f32x4_ustore(py + i, y);
+                simd::f32x4_ustore(pz + i, z);
+            }
+
+            for ( ; i < last; ++i)
+            {
+                float32x4 x = px[i];
+                float32x4 y = py[i];
+                float32x4 z = pz[i];
+                (transform.*func)(x, y, z);
+                px[i] = x.x;
+                py[i] = y.x;
+                pz[i] = z.x;
+            }
+        });
+    }
+
+    // ------------------------------------------------------------------
+    // half conversion
+    // ------------------------------------------------------------------
+
+    void f32_to_f16_simd(float16* dest, const float* source, size_t count)
+    {
+        float16x4* d = reinterpret_cast<float16x4*>(dest);
+        size_t i = 0;
+
+        for ( ; i + 4 <= count; i += 4)
+        {
+            d[i / 4] = convert<float16x4>(float32x4(simd::f32x4_uload(source + i)));
+        }
+
+        for ( ; i < count; ++i)
+        {
+            dest[i] = source[i];
+        }
+    }
+
+    void f16_to_f32_simd(float* dest, const float16* source, size_t count)
+    {
+        const float16x4* s = reinterpret_cast<const float16x4*>(source);
+        size_t i = 0;
+
+        for ( ; i + 4 <= count; i += 4)
+        {
+            simd::f32x4_ustore(dest + i, convert<float32x4>(s[i / 4]));
+        }
+
+        for ( ; i < count; ++i)
+        {
+            dest[i] = source[i];
+        }
+    }
+
+#if defined(ARRAY_ENABLE_F16C)
+
+    MANGO_TARGET_F16C
+    void f32_to_f16_f16c(float16* dest, const float* source, size_t count)
+    {
+        size_t i = 0;
+
+        for ( ; i + 8 <= count; i += 8)
+        {
+            const __m256 f = _mm256_loadu_ps(source + i);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm256_cvtps_ph(f, 0));
+        }
+
+        for ( ; i < count; ++i)
+        {
+            const __m128i h = _mm_cvtps_ph(_mm_set_ss(source[i]), 0);
+            dest[i].u = u16(_mm_cvtsi128_si32(h));
+        }
+    }
+
+    MANGO_TARGET_F16C
+    void f16_to_f32_f16c(float* dest, const float16* source, size_t count)
+    {
+        size_t i = 0;
+
+        for ( ; i + 8 <= count; i += 8)
+        {
+            const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+            _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(h));
+        }
+
+        for ( ; i < count; ++i)
+        {
+            dest[i] = _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(source[i].u)));
+        }
+    }
+
+#endif // ARRAY_ENABLE_F16C
+
+    using ConvertF32toF16 = void (*)(float16* dest, const float* source, size_t count);
+    using ConvertF16toF32 = void (*)(float* dest, const float16* source, size_t count);
+
+    struct HalfKernels
+    {
+        ConvertF32toF16 f32_to_f16 = f32_to_f16_simd;
+        ConvertF16toF32 f16_to_f32 = f16_to_f32_simd;
+
+        HalfKernels()
+        {
+            const char* variant = "simd";
+
+#if defined(ARRAY_ENABLE_F16C)
+            if (getCPUFlags() & CPU_F16C)
+            {
+                f32_to_f16 = f32_to_f16_f16c;
+                f16_to_f32 = f16_to_f32_f16c;
+                variant = "f16c";
+            }
+#endif
+
+            setKernelVariant("math.half", variant);
+        }
+    };
+
+    const HalfKernels& getHalfKernels()
+    {
+        static HalfKernels kernels;
+        return kernels;
+    }
+
+    // ------------------------------------------------------------------
+    // sRGB
+    // ------------------------------------------------------------------
+
+    struct SRGBTable
+    {
+        float linear[256];
+
+        SRGBTable()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                linear[i] = srgb_to_linear(i / 255.0f);
+            }
+        }
+    };
+
+    const SRGBTable& getSRGBTable()
+    {
+        static SRGBTable table;
+        return table;
+    }
+
+} // namespace
+
+namespace mango
+{
+
+    // ------------------------------------------------------------------
+    // array transforms
+    // ------------------------------------------------------------------
+
+    void transformPoints(float3* dest, const float3* source, size_t count, const float4x4& m)
+    {
+        transformAoS(dest, source, count, Transform(m), &Transform::point);
+    }
+
+    void transformPoints(float* x, float* y, float* z, size_t count, const float4x4& m)
+    {
+        transformSoA(x, y, z, count, Transform(m), &Transform::point);
+    }
+
+    void transformNormals(float3* dest, const float3* source, size_t count, const float4x4& m)
+    {
+        transformAoS(dest, source, count, Transform(inverseTranspose(m)), &Transform::normal);
+    }
+
+    void transformNormals(float* x, float* y, float* z, size_t count, const float4x4& m)
+    {
+        transformSoA(x, y, z, count, Transform(inverseTranspose(m)), &Transform::normal);
+    }
+
+    void transform(float32x4* dest, const float32x4* source, size_t count, const float4x4& m)
+    {
+        process(count, [=, &m] (size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                dest[i] = source[i] * m;
+            }
+        });
+    }
+
+    // ------------------------------------------------------------------
+    // array conversions
+    // ------------------------------------------------------------------
+
+    void f32_to_f16(float16* dest, const float* source, size_t count)
+    {
+        const ConvertF32toF16 func = getHalfKernels().f32_to_f16;
+        process(count, [=] (size_t first, size_t last)
+        {
+            func(dest + first, source + first, last - first);
+        });
+    }
+
+    void f16_to_f32(float* dest, const float16* source, size_t count)
+    {
+        const ConvertF16toF32 func = getHalfKernels().f16_to_f32;
+        process(count, [=] (size_t first, size_t last)
+        {
+            func(dest + first, source + first, last - first);
+        });
+    }
+
+    void linear_to_srgb(float* dest, const float* source, size_t count)
+    {
+        process(count, [=] (size_t first, size_t last)
+        {
+            size_t i = first;
+
+            for ( ; i + 4 <= last; i += 4)
+            {
+                const float32x4 linear = clamp(float32x4(simd::f32x4_uload(source + i)), 0.0f, 1.0f);
+                simd::f32x4_ustore(dest + i, linear_to_srgb(linear));
+            }
+
+            for ( ; i < last; ++i)
+            {
+                dest[i] = linear_to_srgb(source[i]);
+            }
+        });
+    }
+
+    void srgb_to_linear(float* dest, const float* source, size_t count)
+    {
+        process(count, [=] (size_t first, size_t last)
+        {
+            size_t i = first;
+
+            for ( ; i + 4 <= last; i += 4)
+            {
+                const float32x4 srgb = simd::f32x4_uload(source + i);
+                simd::f32x4_ustore(dest + i, srgb_to_linear(srgb));
+            }
+
+            for ( ; i < last; ++i)
+            {
+                dest[i] = srgb_to_linear(source[i]);
+            }
+        });
+    }
+
+    void linear_to_srgb(u8* dest, const float* source, size_t count)
+    {
+        process(count, [=] (size_t first, size_t last)
+        {
+            size_t i = first;
+
+            for ( ; i + 4 <= last; i += 4)
+            {
+                const float32x4 linear = clamp(float32x4(simd::f32x4_uload(source + i)), 0.0f, 1.0f);
+                const float32x4 srgb = clamp(linear_to_srgb(linear), 0.0f, 1.0f) * 255.0f;
+                const u32 packed = srgb.pack();
+                std::memcpy(dest + i, &packed, 4);
+            }
+
+            for ( ; i < last; ++i)
+            {
+                dest[i] = u8(linear_to_srgb(source[i]) * 255.0f + 0.5f);
+            }
+        });
+    }
+
+    void srgb_to_linear(float* dest, const u8* source, size_t count)
+    {
+        const float* table = getSRGBTable().linear;
+        process(count, [=] (size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                dest[i] = table[source[i]];
+            }
+        });
+    }
+
+} // namespace mango
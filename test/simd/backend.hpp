@@ -0,0 +1,74 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+#pragma once
+
+#include <cstdio>
+#include <mango/core/cpuinfo.hpp>
+#include <mango/simd/simd.hpp>
+
+namespace test
+{
+    using mango::u64;
+
+    // ctest treats this exit code as a skipped test (SKIP_RETURN_CODE)
+    constexpr int SKIP_RETURN_CODE = 77;
+
+    struct Backend
+    {
+        const char* name;
+        u64 features; // CPU features required to run the code compiled for the backend
+    };
+
+    // the SIMD backend which simd.hpp selected from the compiler flags
+    inline Backend getBackend()
+    {
+#if !defined(MANGO_ENABLE_SIMD)
+        return { "scalar", 0 };
+#else
+        u64 features = 0;
+
+    #if defined(MANGO_ENABLE_F16C)
+        features |= mango::CPU_F16C;
+    #endif
+    #if defined(MANGO_ENABLE_FMA3)
+        features |= mango::CPU_FMA3;
+    #endif
+
+    #if defined(MANGO_ENABLE_AVX512)
+        features |= mango::CPU_AVX512F | mango::CPU_AVX512DQ | mango::CPU_AVX512BW | mango::CPU_AVX512VL;
+        return { "avx512", features };
+    #elif defined(MANGO_ENABLE_AVX2)
+        return { "avx2", features | mango::CPU_AVX2 };
+    #elif defined(MANGO_ENABLE_AVX)
+        return { "avx", features | mango::CPU_AVX };
+    #elif defined(MANGO_ENABLE_SSE4_1)
+        return { "sse4", features | mango::CPU_SSE4_1 };
+    #elif defined(MANGO_ENABLE_SSE2)
+        return { "sse2", features | mango::CPU_SSE2 };
+    #elif defined(MANGO_ENABLE_NEON)
+        return { "neon", features };
+    #elif defined(MANGO_ENABLE_ALTIVEC)
+        return { "altivec", features };
+    #elif defined(MANGO_ENABLE_MSA)
+        return { "msa", features };
+    #else
+        return { "unknown", features };
+    #endif
+#endif
+    }
+
+    // the test cannot run when the processor does not support the instructions the backend was
+    // compiled with; the MANGO_CPU_FLAGS override is respected so that a run can be limited
+    inline bool isBackendSupported(const Backend& backend)
+    {
+        if ((mango::getCPUFlags() & backend.features) != backend.features)
+        {
+            std::printf("%s: skipped, the processor does not support the backend.\n", backend.name);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace test
@@ -0,0 +1,254 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+
+/*
+    SIMD benchmark
+
+    Reports the throughput of the simd:: operations as nanoseconds per operation (one
+    operation processes one vector) on the backend selected by the compiler flags. The
+    working set fits in the L1 cache, so the numbers measure the instructions and not the
+    memory. Run all backends with "make simd-benchmark".
+*/
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "backend.hpp"
+
+using namespace mango;
+using namespace mango::simd;
+
+namespace
+{
+
+    const int g_count = 256;        // vectors in the working set
+    const double g_duration = 0.02; // minimum duration of a measurement in seconds
+
+    const char* g_backend = "";
+    volatile u32 g_sink;
+
+    template <typename V>
+    std::string type_name()
+    {
+        using T = typename V::scalar;
+        const char* prefix = std::is_floating_point<T>::value ? "f" : std::is_signed<T>::value ? "s" : "u";
+        return prefix + std::to_string(sizeof(T) * 8) + "x" + std::to_string(int(V::size));
+    }
+
+    template <typename V>
+    V make_vector(int seed, bool unit)
+    {
+        // small, well-behaved values: the float operations must not hit denormals or NaNs
+        using T = typename V::scalar;
+        std::array<T, V::size> lanes;
+        for (int i = 0; i < V::size; ++i)
+        {
+            lanes[i] = unit ? T(1) : T(1 + (seed + i) % 7);
+        }
+
+        V v;
+        std::memcpy(reinterpret_cast<void*>(&v), lanes.data(), sizeof(V));
+        return v;
+    }
+
+    template <typename V>
+    void consume(const V* data)
+    {
+        u32 sum = 0;
+        for (int i = 0; i < g_count; ++i)
+        {
+            u32 x;
+            std::memcpy(&x, reinterpret_cast<const void*>(data + i), sizeof(x));
+            sum += x;
+        }
+        g_sink = sum;
+    }
+
+    void report(const std::string& op, const std::string& type, double seconds, u64 operations)
+    {
+        std::printf("%-8s %-22s %-7s %8.3f ns/op\n", g_backend, op.c_str(), type.c_str(), seconds * 1e9 / double(operations));
+    }
+
+    // d[i] = func(a[i], b[i]), the result is fed back into the next round
+    template <typename V, typename Func>
+    void benchmark(const std::string& op, Func func)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+
+        V a[g_count];
+        V b[g_count];
+        for (int i = 0; i < g_count; ++i)
+        {
+            a[i] = make_vector<V>(i, false);
+            b[i] = make_vector<V>(i, true);
+        }
+
+        u64 operations = 0;
+        double seconds = 0;
+        const auto start = Clock::now();
+
+        do
+        {
+            for (int i = 0; i < g_count; ++i)
+            {
+                a[i] = func(a[i], b[i]);
+            }
+            operations += g_count;
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (seconds < g_duration);
+
+        consume(a);
+        report(op, type_name<V>(), seconds, operations);
+    }
+
+    // d[i] = func(s[i]) for the operations which change the vector type
+    template <typename D, typename S, typename Func>
+    void benchmark_convert(const std::string& op, Func func)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+
+        S s[g_count];
+        D d[g_count];
+        for (int i = 0; i < g_count; ++i)
+        {
+            s[i] = make_vector<S>(i, false);
+        }
+
+        u64 operations = 0;
+        double seconds = 0;
+        const auto start = Clock::now();
+
+        do
+        {
+            for (int i = 0; i < g_count; ++i)
+            {
+                d[i] = func(s[i]);
+            }
+            operations += g_count;
+            seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (seconds < g_duration);
+
+        consume(d);
+        report(op, type_name<S>(), seconds, operations);
+    }
+
+    template <typename V>
+    void benchmark_integer()
+    {
+        benchmark<V>("add", [] (V a, V b) { return add(a, b); });
+        benchmark<V>("bitwise_xor", [] (V a, V b) { return bitwise_xor(a, b); });
+        benchmark<V>("compare_eq+select", [] (V a, V b) { return select(compare_eq(a, b), b, a); });
+        benchmark<V>("min", [] (V a, V b) { return min(a, b); });
+    }
+
+    template <typename V>
+    void benchmark_integer_saturate()
+    {
+        benchmark<V>("adds", [] (V a, V b) { return adds(a, b); });
+    }
+
+    template <typename V>
+    void benchmark_integer_mullo()
+    {
+        benchmark<V>("mullo", [] (V a, V b) { return mullo(a, b); });
+        benchmark<V>("sll", [] (V a, V) { return sll(a, 3); });
+        benchmark<V>("srli<3>", [] (V a, V) { return srli<3>(a); });
+    }
+
+    template <typename V>
+    void benchmark_float()
+    {
+        benchmark<V>("add", [] (V a, V b) { return add(a, b); });
+        benchmark<V>("mul", [] (V a, V b) { return mul(a, b); });
+        benchmark<V>("div", [] (V a, V b) { return div(a, b); });
+        benchmark<V>("madd", [] (V a, V b) { return madd(a, b, b); });
+        benchmark<V>("min", [] (V a, V b) { return min(a, b); });
+        benchmark<V>("sqrt", [] (V a, V) { return sqrt(a); });
+        benchmark<V>("rcp", [] (V a, V) { return rcp(a); });
+        benchmark<V>("fast_rcp", [] (V a, V) { return fast_rcp(a); });
+        benchmark<V>("rsqrt", [] (V a, V) { return rsqrt(a); });
+        benchmark<V>("round", [] (V a, V) { return round(a); });
+        benchmark<V>("floor", [] (V a, V) { return floor(a); });
+        benchmark<V>("compare_lt+select", [] (V a, V b) { return select(compare_lt(a, b), b, a); });
+    }
+
+    void benchmark_all()
+    {
+        benchmark_integer<u8x16>();
+        benchmark_integer<u16x8>();
+        benchmark_integer<u32x4>();
+        benchmark_integer<u8x32>();
+        benchmark_integer<u16x16>();
+        benchmark_integer<u32x8>();
+        benchmark_integer<u8x64>();
+        benchmark_integer<u16x32>();
+        benchmark_integer<u32x16>();
+
+        benchmark_integer_saturate<u8x16>();
+        benchmark_integer_saturate<s16x8>();
+        benchmark_integer_saturate<u8x32>();
+        benchmark_integer_saturate<s16x16>();
+        benchmark_integer_saturate<u8x64>();
+        benchmark_integer_saturate<s16x32>();
+
+        benchmark_integer_mullo<u16x8>();
+        benchmark_integer_mullo<u32x4>();
+        benchmark_integer_mullo<u16x16>();
+        benchmark_integer_mullo<u32x8>();
+        benchmark_integer_mullo<u16x32>();
+        benchmark_integer_mullo<u32x16>();
+
+        benchmark_float<f32x4>();
+        benchmark_float<f32x8>();
+        benchmark_float<f32x16>();
+        benchmark_float<f64x2>();
+        benchmark_float<f64x4>();
+        benchmark_float<f64x8>();
+
+        benchmark<f32x4>("shuffle<3,2,1,0>", [] (f32x4 a, f32x4) { return shuffle<3, 2, 1, 0>(a); });
+        benchmark<f32x4>("hadd", [] (f32x4 a, f32x4 b) { return hadd(a, b); });
+        benchmark<f32x4>("cross3", [] (f32x4 a, f32x4 b) { return cross3(a, b); });
+        benchmark<u8x16>("unpacklo", [] (u8x16 a, u8x16 b) { return unpacklo(a, b); });
+
+        benchmark_convert<s32x4, f32x4>("convert<s32x4>", [] (f32x4 s) { return convert<s32x4>(s); });
+        benchmark_convert<f32x4, u32x4>("convert<f32x4>", [] (u32x4 s) { return convert<f32x4>(s); });
+        benchmark_convert<u32x4, f32x4>("convert<u32x4>", [] (f32x4 s) { return convert<u32x4>(s); });
+        benchmark_convert<s32x8, f32x8>("convert<s32x8>", [] (f32x8 s) { return convert<s32x8>(s); });
+        benchmark_convert<f32x8, u32x8>("convert<f32x8>", [] (u32x8 s) { return convert<f32x8>(s); });
+        benchmark_convert<f32x4, f64x4>("convert<f32x4>", [] (f64x4 s) { return convert<f32x4>(s); });
+        benchmark_convert<s64x4, f64x4>("convert<s64x4>", [] (f64x4 s) { return convert<s64x4>(s); });
+        benchmark_convert<f16x4, f32x4>("convert<f16x4>", [] (f32x4 s) { return convert<f16x4>(s); });
+        benchmark_convert<u32x4, u8x16>("extend32x4", [] (u8x16 s) { return extend32x4(s); });
+        benchmark_convert<u8x16, u16x8>("narrow", [] (u16x8 s) { return narrow(s, s); });
+
+        f32 table[256];
+        for (int i = 0; i < 256; ++i)
+        {
+            table[i] = f32(i);
+        }
+
+        const f32* address = table;
+        benchmark_convert<f32x4, s32x4>("gather4", [=] (s32x4 offset) { return gather4(address, offset); });
+        benchmark_convert<f32x8, s32x8>("gather8", [=] (s32x8 offset) { return gather8(address, offset); });
+        benchmark_convert<f32x16, s32x16>("gather16", [=] (s32x16 offset) { return gather16(address, offset); });
+    }
+
+} // namespace
+
+int main()
+{
+    const test::Backend backend = test::getBackend();
+    if (!test::isBackendSupported(backend))
+    {
+        // not an error, "make simd-benchmark" continues with the next backend
+        return 0;
+    }
+
+    g_backend = backend.name;
+    benchmark_all();
+    return 0;
+}
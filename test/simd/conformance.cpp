@@ -0,0 +1,1770 @@
+/*
+    MANGO Multimedia Development Platform
+    Copyright (C) 2012-2019 Twilight Finland 3D Oy Ltd. All rights reserved.
+*/
+
+/*
+    SIMD conformance test
+
+    Every portable simd:: operation is checked lane by lane against a scalar reference
+    computed in this file. The test is compiled once per backend (see build/CMakeLists.txt);
+    the scalar emulation is built with MANGO_DISABLE_SIMD.
+
+    The floating-point results must be exact, except for the documented approximations
+    (fast_rcp, fast_rsqrt, fast_sqrt, rcp, rsqrt). Rounding to integer is round-to-nearest-even
+    everywhere, and narrow() saturates to the range of the narrower type. Shift counts are tested
+    in the range [0, scalar bits - 1].
+*/
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include "backend.hpp"
+
+using namespace mango;
+using namespace mango::simd;
+
+namespace
+{
+
+    // ----------------------------------------------------------------------------
+    // lanes
+    // ----------------------------------------------------------------------------
+
+    template <typename V>
+    using Lanes = std::array<typename V::scalar, V::size>;
+
+    template <typename V>
+    V load(const Lanes<V>& lanes)
+    {
+        static_assert(sizeof(V) == sizeof(Lanes<V>), "Unexpected vector layout.");
+        V v;
+        std::memcpy(reinterpret_cast<void*>(&v), lanes.data(), sizeof(V));
+        return v;
+    }
+
+    template <typename V>
+    Lanes<V> store(V v)
+    {
+        static_assert(sizeof(V) == sizeof(Lanes<V>), "Unexpected vector layout.");
+        Lanes<V> lanes;
+        std::memcpy(reinterpret_cast<void*>(lanes.data()), reinterpret_cast<const void*>(&v), sizeof(V));
+        return lanes;
+    }
+
+    template <typename T>
+    using Unsigned = typename std::make_unsigned<T>::type;
+
+    template <typename T>
+    struct is_float
+    {
+        enum { value = std::is_floating_point<T>::value || std::is_same<T, f16>::value };
+    };
+
+    template <typename V>
+    std::string type_name()
+    {
+        using T = typename V::scalar;
+        const char* prefix = is_float<T>::value ? "f" : std::is_signed<T>::value ? "s" : "u";
+        return prefix + std::to_string(sizeof(T) * 8) + "x" + std::to_string(int(V::size));
+    }
+
+    // ----------------------------------------------------------------------------
+    // values
+    // ----------------------------------------------------------------------------
+
+    template <typename T>
+    std::string str(T value)
+    {
+        return std::to_string(+value);
+    }
+
+    std::string str(f64 value)
+    {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+        return buffer;
+    }
+
+    std::string str(f32 value)
+    {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+        return buffer;
+    }
+
+    std::string str(f16 value)
+    {
+        return str(f32(value));
+    }
+
+    template <typename T, std::size_t N>
+    std::string str(const std::array<T, N>& lanes)
+    {
+        std::string s = "{";
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            s += (i ? ", " : " ") + str(lanes[i]);
+        }
+        return s + " }";
+    }
+
+    template <typename T>
+    bool same(T result, T expected, double)
+    {
+        return result == expected;
+    }
+
+    bool same(f64 result, f64 expected, double tolerance)
+    {
+        if (std::isnan(expected))
+        {
+            return std::isnan(result);
+        }
+        if (result == expected)
+        {
+            return true;
+        }
+        // the tolerance is relative, but never smaller than absolute tolerance
+        return std::abs(result - expected) <= tolerance * std::max(1.0, std::abs(expected));
+    }
+
+    bool same(f32 result, f32 expected, double tolerance)
+    {
+        return same(f64(result), f64(expected), tolerance);
+    }
+
+    bool same(f16 result, f16 expected, double tolerance)
+    {
+        return same(f64(f32(result)), f64(f32(expected)), tolerance);
+    }
+
+    // ----------------------------------------------------------------------------
+    // random values
+    // ----------------------------------------------------------------------------
+
+    std::mt19937_64 g_engine(0x6d616e676f);
+
+    u64 random_bits()
+    {
+        return g_engine();
+    }
+
+    int random_index(int count)
+    {
+        return int(random_bits() % u64(count));
+    }
+
+    f64 random_unit()
+    {
+        // [0, 1) with 53 random bits
+        return std::ldexp(f64(random_bits() >> 11), -53);
+    }
+
+    template <typename T>
+    T random_integer()
+    {
+        using limits = std::numeric_limits<T>;
+
+        const T edges[] =
+        {
+            T(0), T(1), T(-1), T(2), limits::min(), limits::max(),
+            T(limits::min() + 1), T(limits::max() - 1), T(limits::max() / 2), T(limits::max() / 2 + 1)
+        };
+
+        if (random_index(4) == 0)
+        {
+            return edges[random_index(int(sizeof(edges) / sizeof(edges[0])))];
+        }
+
+        T value;
+        u64 bits = random_bits();
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    T random_float()
+    {
+        switch (random_index(8))
+        {
+            case 0:
+            {
+                const T edges[] = { T(0), -T(0), T(1), -T(1), T(0.5), -T(0.5), T(1.5), -T(1.5), T(2.5), -T(2.5) };
+                return edges[random_index(int(sizeof(edges) / sizeof(edges[0])))];
+            }
+
+            case 1:
+                // quarters, the rounding functions see many exact ties
+                return T(random_index(513) - 256) * T(0.25);
+
+            case 2:
+            {
+                // large magnitudes, above the integer ranges and the precision of the mantissa
+                T mantissa = T(1) + T(random_index(1 << 20)) / T(1 << 20);
+                T value = std::ldexp(mantissa, 20 + random_index(std::numeric_limits<T>::digits + 20));
+                return random_index(2) ? -value : value;
+            }
+
+            default:
+                return T(random_unit() * 2000.0 - 1000.0);
+        }
+    }
+
+    template <typename T>
+    T random_select(std::true_type)
+    {
+        return random_float<T>();
+    }
+
+    template <typename T>
+    T random_select(std::false_type)
+    {
+        return random_integer<T>();
+    }
+
+    template <typename T>
+    T random_value()
+    {
+        return random_select<T>(std::is_floating_point<T>());
+    }
+
+    template <typename T>
+    T random_quarter(int range)
+    {
+        // values which are exact, and have exact products and sums, in every precision
+        return T(random_index(range * 8 + 1) - range * 4) * T(0.25);
+    }
+
+    template <typename V, typename Generator>
+    Lanes<V> generate(Generator generator)
+    {
+        Lanes<V> lanes;
+        for (auto& lane : lanes)
+        {
+            lane = generator();
+        }
+        return lanes;
+    }
+
+    template <typename V>
+    Lanes<V> generate()
+    {
+        return generate<V>(random_value<typename V::scalar>);
+    }
+
+    // ----------------------------------------------------------------------------
+    // checks
+    // ----------------------------------------------------------------------------
+
+    const int g_iterations = 250;
+    const int g_max_reports = 3; // per operation and type, a broken operation fails every check
+
+    const char* g_backend = "";
+    int g_checks = 0;
+    int g_failures = 0;
+    std::map<std::string, int> g_reports;
+
+    template <typename T, std::size_t N, typename Describe>
+    void compare(const std::string& op, const std::string& type,
+                 const std::array<T, N>& result, const std::array<T, N>& expected,
+                 double tolerance, Describe describe)
+    {
+        ++g_checks;
+
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            if (!same(result[i], expected[i], tolerance))
+            {
+                if (g_reports[op + type]++ < g_max_reports)
+                {
+                    std::printf("FAILED: %s %s(%s) lane %d: result %s, expected %s; inputs %s\n",
+                        g_backend, op.c_str(), type.c_str(), int(i),
+                        str(result[i]).c_str(), str(expected[i]).c_str(), describe().c_str());
+                }
+                ++g_failures;
+                return;
+            }
+        }
+    }
+
+    template <typename T>
+    void compare_scalar(const std::string& op, const std::string& type, T result, T expected,
+                        double tolerance, const std::string& inputs)
+    {
+        std::array<T, 1> r = {{ result }};
+        std::array<T, 1> e = {{ expected }};
+        compare(op, type, r, e, tolerance, [&] { return inputs; });
+    }
+
+    // lane-wise reference: V -> V
+
+    template <typename V, typename Func, typename Ref, typename Generator>
+    void check_unary(const std::string& op, Func func, Ref ref, Generator generator, double tolerance = 0)
+    {
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>(generator);
+
+            Lanes<V> expected;
+            for (int i = 0; i < V::size; ++i)
+            {
+                expected[i] = ref(a[i]);
+            }
+
+            const Lanes<V> result = store<V>(func(load<V>(a)));
+            compare(op, type_name<V>(), result, expected, tolerance, [&] { return str(a); });
+        }
+    }
+
+    template <typename V, typename Func, typename Ref>
+    void check_unary(const std::string& op, Func func, Ref ref)
+    {
+        check_unary<V>(op, func, ref, random_value<typename V::scalar>);
+    }
+
+    template <typename V, typename Func, typename Ref, typename Generator>
+    void check_binary(const std::string& op, Func func, Ref ref, Generator generator, double tolerance = 0)
+    {
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>(generator);
+            Lanes<V> b = generate<V>(generator);
+
+            // equal lanes are an edge case for most of the operations
+            for (int i = 0; i < V::size; ++i)
+            {
+                if (random_index(8) == 0)
+                    b[i] = a[i];
+            }
+
+            Lanes<V> expected;
+            for (int i = 0; i < V::size; ++i)
+            {
+                expected[i] = ref(a[i], b[i]);
+            }
+
+            const Lanes<V> result = store<V>(func(load<V>(a), load<V>(b)));
+            compare(op, type_name<V>(), result, expected, tolerance, [&] { return str(a) + " " + str(b); });
+        }
+    }
+
+    template <typename V, typename Func, typename Ref>
+    void check_binary(const std::string& op, Func func, Ref ref)
+    {
+        check_binary<V>(op, func, ref, random_value<typename V::scalar>);
+    }
+
+    template <typename V, typename Func, typename Ref, typename Generator>
+    void check_ternary(const std::string& op, Func func, Ref ref, Generator generator)
+    {
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>(generator);
+            const Lanes<V> b = generate<V>(generator);
+            const Lanes<V> c = generate<V>(generator);
+
+            Lanes<V> expected;
+            for (int i = 0; i < V::size; ++i)
+            {
+                expected[i] = ref(a[i], b[i], c[i]);
+            }
+
+            const Lanes<V> result = store<V>(func(load<V>(a), load<V>(b), load<V>(c)));
+            compare(op, type_name<V>(), result, expected, 0, [&] { return str(a) + " " + str(b) + " " + str(c); });
+        }
+    }
+
+    // whole vector reference: (V, V) -> R
+
+    template <typename R, typename V, typename Func, typename Ref, typename Generator>
+    void check_lanes(const std::string& op, Func func, Ref ref, Generator generator, double tolerance = 0)
+    {
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>(generator);
+            const Lanes<V> b = generate<V>(generator);
+            const Lanes<R> expected = ref(a, b);
+            const Lanes<R> result = store<R>(func(load<V>(a), load<V>(b)));
+            compare(op, type_name<V>(), result, expected, tolerance, [&] { return str(a) + " " + str(b); });
+        }
+    }
+
+    template <typename R, typename V, typename Func, typename Ref>
+    void check_lanes(const std::string& op, Func func, Ref ref)
+    {
+        check_lanes<R, V>(op, func, ref, random_value<typename V::scalar>);
+    }
+
+    // ----------------------------------------------------------------------------
+    // masks
+    // ----------------------------------------------------------------------------
+
+    template <typename M>
+    u64 mask_bits(M mask)
+    {
+        return u64(get_mask(mask));
+    }
+
+    template <typename V>
+    u64 mask_all()
+    {
+        return V::size == 64 ? ~u64(0) : (u64(1) << V::size) - 1;
+    }
+
+    template <typename V, typename Func, typename Ref>
+    void check_compare(const std::string& op, Func func, Ref ref)
+    {
+        using T = typename V::scalar;
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>();
+            Lanes<V> b = generate<V>();
+
+            for (int i = 0; i < V::size; ++i)
+            {
+                if (random_index(4) == 0)
+                    b[i] = a[i];
+            }
+
+            u64 expected = 0;
+            for (int i = 0; i < V::size; ++i)
+            {
+                expected |= u64(ref(a[i], b[i])) << i;
+            }
+
+            const auto mask = func(load<V>(a), load<V>(b));
+            compare_scalar(op, type_name<V>(), mask_bits(mask), expected, 0, str(a) + " " + str(b));
+
+            // the mask must also be usable for select
+            Lanes<V> selected;
+            for (int i = 0; i < V::size; ++i)
+            {
+                selected[i] = ref(a[i], b[i]) ? a[i] : T(b[i]);
+            }
+
+            const Lanes<V> result = store<V>(select(mask, load<V>(a), load<V>(b)));
+            compare(op + "+select", type_name<V>(), result, selected, 0, [&] { return str(a) + " " + str(b); });
+        }
+    }
+
+    // lane masks for the types which have no compare of their own (64 bit integers)
+
+    template <int Bits, int Size>
+    struct MaskSource;
+
+    template <> struct MaskSource<8, 16>  { using type = s8x16; };
+    template <> struct MaskSource<8, 32>  { using type = s8x32; };
+    template <> struct MaskSource<8, 64>  { using type = s8x64; };
+    template <> struct MaskSource<16, 8>  { using type = s16x8; };
+    template <> struct MaskSource<16, 16> { using type = s16x16; };
+    template <> struct MaskSource<16, 32> { using type = s16x32; };
+    template <> struct MaskSource<32, 4>  { using type = f32x4; };
+    template <> struct MaskSource<32, 8>  { using type = f32x8; };
+    template <> struct MaskSource<32, 16> { using type = f32x16; };
+    template <> struct MaskSource<64, 2>  { using type = f64x2; };
+    template <> struct MaskSource<64, 4>  { using type = f64x4; };
+    template <> struct MaskSource<64, 8>  { using type = f64x8; };
+
+    template <typename V>
+    using MaskSourceType = typename MaskSource<int(sizeof(typename V::scalar) * 8), V::size>::type;
+
+    template <typename V>
+    void check_select()
+    {
+        using S = MaskSourceType<V>;
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<S> c = generate<S>();
+            const Lanes<S> d = generate<S>();
+            const Lanes<V> a = generate<V>();
+            const Lanes<V> b = generate<V>();
+
+            Lanes<V> expected;
+            for (int i = 0; i < V::size; ++i)
+            {
+                expected[i] = c[i] > d[i] ? a[i] : b[i];
+            }
+
+            const auto mask = compare_gt(load<S>(c), load<S>(d));
+            const Lanes<V> result = store<V>(select(mask, load<V>(a), load<V>(b)));
+            compare("select", type_name<V>(), result, expected, 0, [&] { return str(a) + " " + str(b) + " " + str(c) + " " + str(d); });
+        }
+    }
+
+    template <typename V>
+    void check_mask_operations()
+    {
+        // the mask type of V, tested through the compare of V
+        const std::string type = type_name<V>();
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>();
+            const Lanes<V> b = generate<V>();
+            const Lanes<V> c = generate<V>();
+            const Lanes<V> d = generate<V>();
+
+            const auto mask0 = compare_gt(load<V>(a), load<V>(b));
+            const auto mask1 = compare_gt(load<V>(c), load<V>(d));
+            const u64 bits0 = mask_bits(mask0);
+            const u64 bits1 = mask_bits(mask1);
+            const std::string inputs = str(a) + " " + str(b) + " " + str(c) + " " + str(d);
+
+            compare_scalar("mask &", type, mask_bits(mask0 & mask1), bits0 & bits1, 0, inputs);
+            compare_scalar("mask |", type, mask_bits(mask0 | mask1), bits0 | bits1, 0, inputs);
+            compare_scalar("mask ^", type, mask_bits(mask0 ^ mask1), bits0 ^ bits1, 0, inputs);
+            compare_scalar("none_of", type, none_of(mask0), bits0 == 0, 0, inputs);
+            compare_scalar("any_of", type, any_of(mask0), bits0 != 0, 0, inputs);
+            compare_scalar("all_of", type, all_of(mask0), bits0 == mask_all<V>(), 0, inputs);
+
+            // all lanes clear and all lanes set
+            const auto none = compare_gt(load<V>(a), load<V>(a));
+            const auto all = compare_eq(load<V>(a), load<V>(a));
+            compare_scalar("get_mask", type, mask_bits(none), u64(0), 0, inputs);
+            compare_scalar("get_mask", type, mask_bits(all), mask_all<V>(), 0, inputs);
+            compare_scalar("none_of", type, none_of(none), true, 0, inputs);
+            compare_scalar("any_of", type, any_of(none), false, 0, inputs);
+            compare_scalar("all_of", type, all_of(none), false, 0, inputs);
+            compare_scalar("none_of", type, none_of(all), false, 0, inputs);
+            compare_scalar("any_of", type, any_of(all), true, 0, inputs);
+            compare_scalar("all_of", type, all_of(all), true, 0, inputs);
+        }
+    }
+
+    // ----------------------------------------------------------------------------
+    // unpack
+    // ----------------------------------------------------------------------------
+
+    // unpack interleaves the low or high halves of each 128 bit block
+    template <typename V, bool High>
+    Lanes<V> unpack_reference(const Lanes<V>& a, const Lanes<V>& b)
+    {
+        const int block = 16 / int(sizeof(typename V::scalar));
+        const int half = block / 2;
+
+        Lanes<V> v;
+        for (int base = 0; base < V::size; base += block)
+        {
+            for (int i = 0; i < half; ++i)
+            {
+                const int source = base + i + (High ? half : 0);
+                v[base + i * 2 + 0] = a[source];
+                v[base + i * 2 + 1] = b[source];
+            }
+        }
+        return v;
+    }
+
+    template <typename V>
+    void check_unpack()
+    {
+        check_lanes<V, V>("unpacklo", [] (V a, V b) { return unpacklo(a, b); }, unpack_reference<V, false>);
+        check_lanes<V, V>("unpackhi", [] (V a, V b) { return unpackhi(a, b); }, unpack_reference<V, true>);
+    }
+
+    // ----------------------------------------------------------------------------
+    // integer
+    // ----------------------------------------------------------------------------
+
+    template <typename T>
+    T wrap_add(T a, T b)
+    {
+        return T(Unsigned<T>(Unsigned<T>(a) + Unsigned<T>(b)));
+    }
+
+    template <typename T>
+    T wrap_sub(T a, T b)
+    {
+        return T(Unsigned<T>(Unsigned<T>(a) - Unsigned<T>(b)));
+    }
+
+    template <typename T>
+    T wrap_mul(T a, T b)
+    {
+        return T(Unsigned<T>(u64(Unsigned<T>(a)) * u64(Unsigned<T>(b))));
+    }
+
+    template <typename T>
+    T saturate(s64 value)
+    {
+        using limits = std::numeric_limits<T>;
+        return T(std::min<s64>(std::max<s64>(value, limits::min()), limits::max()));
+    }
+
+    template <typename V, int Count>
+    void check_shift_immediate()
+    {
+        using T = typename V::scalar;
+        using U = Unsigned<T>;
+
+        const std::string count = "<" + std::to_string(Count) + ">";
+        check_unary<V>("slli" + count, [] (V a) { return slli<Count>(a); }, [] (T a) { return T(U(U(a) << Count)); });
+        check_unary<V>("srli" + count, [] (V a) { return srli<Count>(a); }, [] (T a) { return T(U(U(a) >> Count)); });
+    }
+
+    template <typename V, int Count>
+    void check_shift_arithmetic_immediate()
+    {
+        using T = typename V::scalar;
+
+        const std::string count = "<" + std::to_string(Count) + ">";
+        check_unary<V>("srai" + count, [] (V a) { return srai<Count>(a); }, [] (T a) { return T(a >> Count); });
+    }
+
+    template <typename V>
+    void check_shift()
+    {
+        using T = typename V::scalar;
+        using U = Unsigned<T>;
+        const int bits = sizeof(T) * 8;
+
+        check_shift_immediate<V, 1>();
+        check_shift_immediate<V, sizeof(T) * 4>();
+        check_shift_immediate<V, sizeof(T) * 8 - 1>();
+
+        for (int count = 0; count < bits; ++count)
+        {
+            check_unary<V>("sll", [=] (V a) { return sll(a, count); }, [=] (T a) { return T(U(U(a) << count)); });
+            check_unary<V>("srl", [=] (V a) { return srl(a, count); }, [=] (T a) { return T(U(U(a) >> count)); });
+        }
+    }
+
+    template <typename V>
+    void check_shift_arithmetic()
+    {
+        using T = typename V::scalar;
+        const int bits = sizeof(T) * 8;
+
+        check_shift_arithmetic_immediate<V, 1>();
+        check_shift_arithmetic_immediate<V, sizeof(T) * 4>();
+        check_shift_arithmetic_immediate<V, sizeof(T) * 8 - 1>();
+
+        for (int count = 0; count < bits; ++count)
+        {
+            check_unary<V>("sra", [=] (V a) { return sra(a, count); }, [=] (T a) { return T(a >> count); });
+        }
+    }
+
+    template <typename V>
+    void check_shift_variable()
+    {
+        using T = typename V::scalar;
+        using U = Unsigned<T>;
+        using C = u32x4;
+
+        // 32 bit lanes shifted by a count per lane
+        const auto count = [] { return u32(random_index(32)); };
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>();
+            const Lanes<C> c = generate<C>(count);
+
+            Lanes<V> sll_expected;
+            Lanes<V> srl_expected;
+            Lanes<V> sra_expected;
+
+            for (int i = 0; i < V::size; ++i)
+            {
+                sll_expected[i] = T(U(U(a[i]) << c[i]));
+                srl_expected[i] = T(U(U(a[i]) >> c[i]));
+                sra_expected[i] = T(s32(a[i]) >> c[i]);
+            }
+
+            const auto inputs = [&] { return str(a) + " " + str(c); };
+            compare("sll", type_name<V>(), store<V>(sll(load<V>(a), load<C>(c))), sll_expected, 0, inputs);
+            compare("srl", type_name<V>(), store<V>(srl(load<V>(a), load<C>(c))), srl_expected, 0, inputs);
+            compare("sra", type_name<V>(), store<V>(sra(load<V>(a), load<C>(c))), sra_expected, 0, inputs);
+        }
+    }
+
+    template <typename V>
+    void check_integer()
+    {
+        using T = typename V::scalar;
+        using U = Unsigned<T>;
+
+        check_binary<V>("add", [] (V a, V b) { return add(a, b); }, wrap_add<T>);
+        check_binary<V>("sub", [] (V a, V b) { return sub(a, b); }, wrap_sub<T>);
+        check_binary<V>("bitwise_nand", [] (V a, V b) { return bitwise_nand(a, b); }, [] (T a, T b) { return T(~U(a) & U(b)); });
+        check_binary<V>("bitwise_and", [] (V a, V b) { return bitwise_and(a, b); }, [] (T a, T b) { return T(a & b); });
+        check_binary<V>("bitwise_or", [] (V a, V b) { return bitwise_or(a, b); }, [] (T a, T b) { return T(a | b); });
+        check_binary<V>("bitwise_xor", [] (V a, V b) { return bitwise_xor(a, b); }, [] (T a, T b) { return T(a ^ b); });
+        check_unary<V>("bitwise_not", [] (V a) { return bitwise_not(a); }, [] (T a) { return T(~U(a)); });
+
+        check_select<V>();
+        check_unpack<V>();
+    }
+
+    // 8, 16 and 32 bit lanes
+    template <typename V>
+    void check_integer_compare()
+    {
+        using T = typename V::scalar;
+
+        check_compare<V>("compare_eq", [] (V a, V b) { return compare_eq(a, b); }, [] (T a, T b) { return a == b; });
+        check_compare<V>("compare_gt", [] (V a, V b) { return compare_gt(a, b); }, [] (T a, T b) { return a > b; });
+        check_mask_operations<V>();
+    }
+
+    // 8, 16 and 32 bit lanes in 128 bit vectors
+    template <typename V>
+    void check_integer_compare_full()
+    {
+        using T = typename V::scalar;
+
+        check_integer_compare<V>();
+        check_compare<V>("compare_neq", [] (V a, V b) { return compare_neq(a, b); }, [] (T a, T b) { return a != b; });
+        check_compare<V>("compare_lt", [] (V a, V b) { return compare_lt(a, b); }, [] (T a, T b) { return a < b; });
+        check_compare<V>("compare_le", [] (V a, V b) { return compare_le(a, b); }, [] (T a, T b) { return a <= b; });
+        check_compare<V>("compare_ge", [] (V a, V b) { return compare_ge(a, b); }, [] (T a, T b) { return a >= b; });
+    }
+
+    template <typename V>
+    void check_integer_min_max()
+    {
+        using T = typename V::scalar;
+
+        check_binary<V>("min", [] (V a, V b) { return min(a, b); }, [] (T a, T b) { return std::min(a, b); });
+        check_binary<V>("max", [] (V a, V b) { return max(a, b); }, [] (T a, T b) { return std::max(a, b); });
+    }
+
+    template <typename V>
+    void check_integer_saturate()
+    {
+        using T = typename V::scalar;
+
+        check_binary<V>("adds", [] (V a, V b) { return adds(a, b); }, [] (T a, T b) { return saturate<T>(s64(a) + s64(b)); });
+        check_binary<V>("subs", [] (V a, V b) { return subs(a, b); }, [] (T a, T b) { return saturate<T>(s64(a) - s64(b)); });
+    }
+
+    template <typename V>
+    void check_integer_signed()
+    {
+        using T = typename V::scalar;
+
+        check_unary<V>("abs", [] (V a) { return abs(a); }, [] (T a) { return a < 0 ? wrap_sub(T(0), a) : a; });
+        check_unary<V>("neg", [] (V a) { return neg(a); }, [] (T a) { return wrap_sub(T(0), a); });
+    }
+
+    template <typename V>
+    void check_integer_mullo()
+    {
+        using T = typename V::scalar;
+
+        check_binary<V>("mullo", [] (V a, V b) { return mullo(a, b); }, wrap_mul<T>);
+    }
+
+    template <typename V>
+    void check_integer_128()
+    {
+        check_integer<V>();
+        check_integer_compare_full<V>();
+        check_integer_min_max<V>();
+    }
+
+    template <typename V>
+    void check_integer_256()
+    {
+        check_integer<V>();
+        check_integer_compare<V>();
+        check_integer_min_max<V>();
+    }
+
+    template <typename V>
+    void check_integer_64()
+    {
+        check_integer<V>();
+        check_shift<V>();
+    }
+
+    // ----------------------------------------------------------------------------
+    // float
+    // ----------------------------------------------------------------------------
+
+    template <typename T>
+    T random_positive()
+    {
+        T value = std::abs(random_float<T>());
+        return value == 0 ? T(1) : value;
+    }
+
+    template <typename T>
+    T random_nonzero()
+    {
+        T value = random_float<T>();
+        return value == 0 ? T(1) : value;
+    }
+
+    template <typename T>
+    T random_moderate()
+    {
+        // the approximations are specified in the range of the normalized values
+        T value = T(random_unit() * 2000.0 - 1000.0);
+        return std::abs(value) < T(1e-3) ? T(1) : value;
+    }
+
+    template <typename T, typename Op>
+    T bitwise(T a, T b, Op op)
+    {
+        using U = typename std::conditional<sizeof(T) == 4, u32, u64>::type;
+        U x;
+        U y;
+        std::memcpy(&x, &a, sizeof(T));
+        std::memcpy(&y, &b, sizeof(T));
+        U z = op(x, y);
+        T result;
+        std::memcpy(&result, &z, sizeof(T));
+        return result;
+    }
+
+    template <typename V>
+    void check_float()
+    {
+        using T = typename V::scalar;
+
+        const double approximate = 1.0 / 1024;  // 12 bit estimates, such as rcpps
+        const double refined = 1.0 / 65536;     // estimates with one Newton-Raphson step
+        const auto positive = random_positive<T>;
+        const auto nonzero = random_nonzero<T>;
+        const auto moderate = random_moderate<T>;
+        const auto quarter = [] { return random_quarter<T>(64); };
+
+        check_binary<V>("bitwise_nand", [] (V a, V b) { return bitwise_nand(a, b); },
+            [] (T a, T b) { return bitwise(a, b, [] (u64 x, u64 y) { return ~x & y; }); });
+        check_binary<V>("bitwise_and", [] (V a, V b) { return bitwise_and(a, b); },
+            [] (T a, T b) { return bitwise(a, b, [] (u64 x, u64 y) { return x & y; }); });
+        check_binary<V>("bitwise_or", [] (V a, V b) { return bitwise_or(a, b); },
+            [] (T a, T b) { return bitwise(a, b, [] (u64 x, u64 y) { return x | y; }); });
+        check_binary<V>("bitwise_xor", [] (V a, V b) { return bitwise_xor(a, b); },
+            [] (T a, T b) { return bitwise(a, b, [] (u64 x, u64 y) { return x ^ y; }); });
+        check_unary<V>("bitwise_not", [] (V a) { return bitwise_not(a); },
+            [] (T a) { return bitwise(a, a, [] (u64 x, u64) { return ~x; }); });
+
+        check_binary<V>("min", [] (V a, V b) { return min(a, b); }, [] (T a, T b) { return std::min(a, b); });
+        check_binary<V>("max", [] (V a, V b) { return max(a, b); }, [] (T a, T b) { return std::max(a, b); });
+        check_unary<V>("abs", [] (V a) { return abs(a); }, [] (T a) { return std::abs(a); });
+        check_unary<V>("neg", [] (V a) { return neg(a); }, [] (T a) { return -a; });
+        check_unary<V>("sign", [] (V a) { return sign(a); }, [] (T a) { return a < 0 ? T(-1) : a > 0 ? T(1) : T(0); });
+
+        check_binary<V>("add", [] (V a, V b) { return add(a, b); }, [] (T a, T b) { return a + b; });
+        check_binary<V>("sub", [] (V a, V b) { return sub(a, b); }, [] (T a, T b) { return a - b; });
+        check_binary<V>("mul", [] (V a, V b) { return mul(a, b); }, [] (T a, T b) { return a * b; });
+        check_binary<V>("div", [] (V a, V b) { return div(a, b); }, [] (T a, T b) { return a / b; }, nonzero);
+        check_ternary<V>("madd", [] (V a, V b, V c) { return madd(a, b, c); }, [] (T a, T b, T c) { return a + b * c; }, quarter);
+        check_ternary<V>("msub", [] (V a, V b, V c) { return msub(a, b, c); }, [] (T a, T b, T c) { return a - b * c; }, quarter);
+
+        check_unary<V>("fast_rcp", [] (V a) { return fast_rcp(a); }, [] (T a) { return T(1) / a; }, moderate, approximate);
+        check_unary<V>("fast_rsqrt", [] (V a) { return fast_rsqrt(a); }, [] (T a) { return T(1) / std::sqrt(a); },
+            [=] { return std::abs(moderate()); }, approximate);
+        check_unary<V>("fast_sqrt", [] (V a) { return fast_sqrt(a); }, [] (T a) { return std::sqrt(a); },
+            [=] { return std::abs(moderate()); }, approximate);
+        check_unary<V>("rcp", [] (V a) { return rcp(a); }, [] (T a) { return T(1) / a; }, moderate, refined);
+        check_unary<V>("rsqrt", [] (V a) { return rsqrt(a); }, [] (T a) { return T(1) / std::sqrt(a); },
+            [=] { return std::abs(moderate()); }, refined);
+        check_unary<V>("sqrt", [] (V a) { return sqrt(a); }, [] (T a) { return std::sqrt(a); }, positive);
+
+        check_compare<V>("compare_eq", [] (V a, V b) { return compare_eq(a, b); }, [] (T a, T b) { return a == b; });
+        check_compare<V>("compare_neq", [] (V a, V b) { return compare_neq(a, b); }, [] (T a, T b) { return a != b; });
+        check_compare<V>("compare_lt", [] (V a, V b) { return compare_lt(a, b); }, [] (T a, T b) { return a < b; });
+        check_compare<V>("compare_le", [] (V a, V b) { return compare_le(a, b); }, [] (T a, T b) { return a <= b; });
+        check_compare<V>("compare_gt", [] (V a, V b) { return compare_gt(a, b); }, [] (T a, T b) { return a > b; });
+        check_compare<V>("compare_ge", [] (V a, V b) { return compare_ge(a, b); }, [] (T a, T b) { return a >= b; });
+        check_mask_operations<V>();
+
+        check_unary<V>("round", [] (V a) { return round(a); }, [] (T a) { return std::nearbyint(a); });
+        check_unary<V>("trunc", [] (V a) { return trunc(a); }, [] (T a) { return std::trunc(a); });
+        check_unary<V>("floor", [] (V a) { return floor(a); }, [] (T a) { return std::floor(a); });
+        check_unary<V>("ceil", [] (V a) { return ceil(a); }, [] (T a) { return std::ceil(a); });
+        check_unary<V>("fract", [] (V a) { return fract(a); }, [] (T a) { return a - std::floor(a); });
+
+        check_unpack<V>();
+    }
+
+    template <typename V, int Index>
+    void check_component()
+    {
+        using T = typename V::scalar;
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>();
+            const T s = random_value<T>();
+
+            Lanes<V> expected = a;
+            expected[Index] = s;
+
+            const std::string op = "<" + std::to_string(Index) + ">";
+            const auto inputs = [&] { return str(a) + " " + str(s); };
+            compare("set_component" + op, type_name<V>(), store<V>(set_component<Index>(load<V>(a), s)), expected, 0, inputs);
+            compare_scalar("get_component" + op, type_name<V>(), get_component<Index>(load<V>(a)), a[Index], 0, inputs());
+        }
+    }
+
+    template <typename V>
+    void check_components()
+    {
+        check_component<V, 0>();
+        check_component<V, 1>();
+        check_component<V, V::size - 1>();
+    }
+
+    // ----------------------------------------------------------------------------
+    // memory and initialization, the functions are prefixed with the vector type
+    // ----------------------------------------------------------------------------
+
+    template <typename V, typename Zero, typename Set1>
+    void check_initialize(Zero zero, Set1 set1)
+    {
+        using T = typename V::scalar;
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const T s = random_value<T>();
+
+            Lanes<V> zeros;
+            Lanes<V> splat;
+            zeros.fill(T(0));
+            splat.fill(s);
+
+            compare("zero", type_name<V>(), store<V>(zero()), zeros, 0, [] { return std::string(); });
+            compare("set1", type_name<V>(), store<V>(set1(s)), splat, 0, [&] { return str(s); });
+        }
+    }
+
+    template <typename V, typename Load, typename Store>
+    void check_memory(Load uload, Store ustore)
+    {
+        using T = typename V::scalar;
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>();
+            const auto inputs = [&] { return str(a); };
+
+            // unaligned load and store
+            T buffer[V::size + 1];
+            std::memcpy(buffer + 1, a.data(), sizeof(a));
+            compare("uload", type_name<V>(), store<V>(uload(buffer + 1)), a, 0, inputs);
+
+            Lanes<V> result;
+            ustore(buffer + 1, load<V>(a));
+            std::memcpy(result.data(), buffer + 1, sizeof(result));
+            compare("ustore", type_name<V>(), result, a, 0, inputs);
+        }
+    }
+
+    template <typename V, typename Load, typename Store>
+    void check_memory_low(Load load_low, Store store_low)
+    {
+        using T = typename V::scalar;
+        const int half = V::size / 2;
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>();
+
+            // load_low clears the high half
+            Lanes<V> low = a;
+            std::fill(low.begin() + half, low.end(), T(0));
+
+            T buffer[V::size + 1];
+            std::memcpy(buffer + 1, a.data(), sizeof(a));
+            compare("load_low", type_name<V>(), store<V>(load_low(buffer + 1)), low, 0, [&] { return str(a); });
+
+            // store_low writes only the low half
+            const T sentinel = random_value<T>();
+            std::fill(buffer, buffer + V::size + 1, sentinel);
+            store_low(buffer + 1, load<V>(a));
+
+            Lanes<V> result;
+            Lanes<V> expected = a;
+            std::fill(expected.begin() + half, expected.end(), sentinel);
+            std::memcpy(result.data(), buffer + 1, sizeof(result));
+            compare("store_low", type_name<V>(), result, expected, 0, [&] { return str(a); });
+        }
+    }
+
+    template <typename V, typename Set>
+    void check_set(Set set)
+    {
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>();
+            compare("set" + std::to_string(int(V::size)), type_name<V>(), store<V>(set(a)), a, 0, [&] { return str(a); });
+        }
+    }
+
+    #define CHECK_INITIALIZE(V) \
+        check_initialize<V>( \
+            [] { return V##_zero(); }, \
+            [] (V::scalar s) { return V##_set1(s); })
+
+    #define CHECK_MEMORY(V) \
+        check_memory<V>( \
+            [] (const V::scalar* p) { return V##_uload(p); }, \
+            [] (V::scalar* p, V a) { V##_ustore(p, a); })
+
+    #define CHECK_MEMORY_LOW(V) \
+        check_memory_low<V>( \
+            [] (const V::scalar* p) { return V##_load_low(p); }, \
+            [] (V::scalar* p, V a) { V##_store_low(p, a); })
+
+    void check_memory_all()
+    {
+        CHECK_INITIALIZE(u8x16);
+        CHECK_INITIALIZE(u16x8);
+        CHECK_INITIALIZE(u32x4);
+        CHECK_INITIALIZE(u64x2);
+        CHECK_INITIALIZE(s8x16);
+        CHECK_INITIALIZE(s16x8);
+        CHECK_INITIALIZE(s32x4);
+        CHECK_INITIALIZE(s64x2);
+        CHECK_INITIALIZE(f32x4);
+        CHECK_INITIALIZE(f64x2);
+
+        CHECK_INITIALIZE(u8x32);
+        CHECK_INITIALIZE(u16x16);
+        CHECK_INITIALIZE(u32x8);
+        CHECK_INITIALIZE(u64x4);
+        CHECK_INITIALIZE(s8x32);
+        CHECK_INITIALIZE(s16x16);
+        CHECK_INITIALIZE(s32x8);
+        CHECK_INITIALIZE(s64x4);
+        CHECK_INITIALIZE(f32x8);
+        CHECK_INITIALIZE(f64x4);
+
+        CHECK_INITIALIZE(u8x64);
+        CHECK_INITIALIZE(u16x32);
+        CHECK_INITIALIZE(u32x16);
+        CHECK_INITIALIZE(u64x8);
+        CHECK_INITIALIZE(s8x64);
+        CHECK_INITIALIZE(s16x32);
+        CHECK_INITIALIZE(s32x16);
+        CHECK_INITIALIZE(s64x8);
+        CHECK_INITIALIZE(f32x16);
+        CHECK_INITIALIZE(f64x8);
+
+        CHECK_MEMORY(u32x4);
+        CHECK_MEMORY(s32x4);
+        CHECK_MEMORY(f32x4);
+        CHECK_MEMORY(f64x2);
+
+        CHECK_MEMORY(u32x8);
+        CHECK_MEMORY(s32x8);
+        CHECK_MEMORY(f32x8);
+        CHECK_MEMORY(f64x4);
+
+        CHECK_MEMORY(u32x16);
+        CHECK_MEMORY(s32x16);
+        CHECK_MEMORY(f32x16);
+        CHECK_MEMORY(f64x8);
+
+        CHECK_MEMORY_LOW(u8x16);
+        CHECK_MEMORY_LOW(u16x8);
+        CHECK_MEMORY_LOW(u32x4);
+        CHECK_MEMORY_LOW(s8x16);
+        CHECK_MEMORY_LOW(s16x8);
+        CHECK_MEMORY_LOW(s32x4);
+
+        check_set<u8x16>([] (const Lanes<u8x16>& a) {
+            return u8x16_set16(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7],
+                               a[8], a[9], a[10], a[11], a[12], a[13], a[14], a[15]); });
+        check_set<s8x16>([] (const Lanes<s8x16>& a) {
+            return s8x16_set16(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7],
+                               a[8], a[9], a[10], a[11], a[12], a[13], a[14], a[15]); });
+        check_set<u16x8>([] (const Lanes<u16x8>& a) { return u16x8_set8(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]); });
+        check_set<s16x8>([] (const Lanes<s16x8>& a) { return s16x8_set8(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]); });
+        check_set<u32x4>([] (const Lanes<u32x4>& a) { return u32x4_set4(a[0], a[1], a[2], a[3]); });
+        check_set<s32x4>([] (const Lanes<s32x4>& a) { return s32x4_set4(a[0], a[1], a[2], a[3]); });
+        check_set<u64x2>([] (const Lanes<u64x2>& a) { return u64x2_set2(a[0], a[1]); });
+        check_set<s64x2>([] (const Lanes<s64x2>& a) { return s64x2_set2(a[0], a[1]); });
+        check_set<f32x4>([] (const Lanes<f32x4>& a) { return f32x4_set4(a[0], a[1], a[2], a[3]); });
+        check_set<f64x2>([] (const Lanes<f64x2>& a) { return f64x2_set2(a[0], a[1]); });
+
+        check_set<u32x8>([] (const Lanes<u32x8>& a) { return u32x8_set8(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]); });
+        check_set<s32x8>([] (const Lanes<s32x8>& a) { return s32x8_set8(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]); });
+        check_set<u64x4>([] (const Lanes<u64x4>& a) { return u64x4_set4(a[0], a[1], a[2], a[3]); });
+        check_set<s64x4>([] (const Lanes<s64x4>& a) { return s64x4_set4(a[0], a[1], a[2], a[3]); });
+        check_set<f32x8>([] (const Lanes<f32x8>& a) { return f32x8_set8(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]); });
+        check_set<f64x4>([] (const Lanes<f64x4>& a) { return f64x4_set4(a[0], a[1], a[2], a[3]); });
+    }
+
+    // ----------------------------------------------------------------------------
+    // 128 bit vector specials
+    // ----------------------------------------------------------------------------
+
+    template <int X, int Y, int Z, int W>
+    void check_shuffle4()
+    {
+        const std::string op = "shuffle<" + std::to_string(X) + "," + std::to_string(Y) + "," +
+            std::to_string(Z) + "," + std::to_string(W) + ">";
+
+        check_lanes<f32x4, f32x4>(op, [] (f32x4 a, f32x4 b) { return shuffle<X, Y, Z, W>(a, b); },
+            [] (const Lanes<f32x4>& a, const Lanes<f32x4>& b) { return Lanes<f32x4> {{ a[X], a[Y], b[Z], b[W] }}; });
+        check_lanes<f32x4, f32x4>(op, [] (f32x4 a, f32x4) { return shuffle<X, Y, Z, W>(a); },
+            [] (const Lanes<f32x4>& a, const Lanes<f32x4>&) { return Lanes<f32x4> {{ a[X], a[Y], a[Z], a[W] }}; });
+        check_lanes<u32x4, u32x4>(op, [] (u32x4 a, u32x4) { return shuffle<X, Y, Z, W>(a); },
+            [] (const Lanes<u32x4>& a, const Lanes<u32x4>&) { return Lanes<u32x4> {{ a[X], a[Y], a[Z], a[W] }}; });
+        check_lanes<s32x4, s32x4>(op, [] (s32x4 a, s32x4) { return shuffle<X, Y, Z, W>(a); },
+            [] (const Lanes<s32x4>& a, const Lanes<s32x4>&) { return Lanes<s32x4> {{ a[X], a[Y], a[Z], a[W] }}; });
+        check_lanes<f64x4, f64x4>(op, [] (f64x4 a, f64x4) { return shuffle<X, Y, Z, W>(a); },
+            [] (const Lanes<f64x4>& a, const Lanes<f64x4>&) { return Lanes<f64x4> {{ a[X], a[Y], a[Z], a[W] }}; });
+    }
+
+    template <int X, int Y>
+    void check_shuffle2()
+    {
+        const std::string op = "shuffle<" + std::to_string(X) + "," + std::to_string(Y) + ">";
+
+        check_lanes<f64x2, f64x2>(op, [] (f64x2 a, f64x2 b) { return shuffle<X, Y>(a, b); },
+            [] (const Lanes<f64x2>& a, const Lanes<f64x2>& b) { return Lanes<f64x2> {{ a[X], b[Y] }}; });
+        check_lanes<f64x2, f64x2>(op, [] (f64x2 a, f64x2) { return shuffle<X, Y>(a); },
+            [] (const Lanes<f64x2>& a, const Lanes<f64x2>&) { return Lanes<f64x2> {{ a[X], a[Y] }}; });
+    }
+
+    template <typename V>
+    Lanes<V> hadd_reference(const Lanes<V>& a, const Lanes<V>& b)
+    {
+        // pairwise sums of a and b in each 128 bit block
+        Lanes<V> v;
+        for (int base = 0; base < V::size; base += 4)
+        {
+            v[base + 0] = a[base + 0] + a[base + 1];
+            v[base + 1] = a[base + 2] + a[base + 3];
+            v[base + 2] = b[base + 0] + b[base + 1];
+            v[base + 3] = b[base + 2] + b[base + 3];
+        }
+        return v;
+    }
+
+    template <typename V>
+    void check_horizontal_min_max()
+    {
+        check_lanes<V, V>("hmin", [] (V a, V) { return hmin(a); }, [] (const Lanes<V>& a, const Lanes<V>&) {
+            Lanes<V> v;
+            v.fill(*std::min_element(a.begin(), a.end()));
+            return v;
+        });
+        check_lanes<V, V>("hmax", [] (V a, V) { return hmax(a); }, [] (const Lanes<V>& a, const Lanes<V>&) {
+            Lanes<V> v;
+            v.fill(*std::max_element(a.begin(), a.end()));
+            return v;
+        });
+    }
+
+    void check_float_128()
+    {
+        check_shuffle4<0, 1, 2, 3>();
+        check_shuffle4<3, 2, 1, 0>();
+        check_shuffle4<1, 0, 3, 2>();
+        check_shuffle4<2, 3, 0, 1>();
+        check_shuffle4<0, 0, 3, 3>();
+        check_shuffle4<2, 1, 2, 0>();
+        check_shuffle2<0, 0>();
+        check_shuffle2<0, 1>();
+        check_shuffle2<1, 0>();
+        check_shuffle2<1, 1>();
+
+        check_lanes<f32x4, f32x4>("movelh", [] (f32x4 a, f32x4 b) { return movelh(a, b); },
+            [] (const Lanes<f32x4>& a, const Lanes<f32x4>& b) { return Lanes<f32x4> {{ a[0], a[1], b[0], b[1] }}; });
+        check_lanes<f32x4, f32x4>("movehl", [] (f32x4 a, f32x4 b) { return movehl(a, b); },
+            [] (const Lanes<f32x4>& a, const Lanes<f32x4>& b) { return Lanes<f32x4> {{ b[2], b[3], a[2], a[3] }}; });
+
+        check_lanes<f32x4, f32x4>("hadd", [] (f32x4 a, f32x4 b) { return hadd(a, b); }, hadd_reference<f32x4>);
+        check_lanes<f32x8, f32x8>("hadd", [] (f32x8 a, f32x8 b) { return hadd(a, b); }, hadd_reference<f32x8>);
+        check_horizontal_min_max<f32x4>();
+        check_horizontal_min_max<f64x4>();
+
+        const auto quarter = [] { return random_quarter<f32>(64); };
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<f32x4> a = generate<f32x4>(quarter);
+            const Lanes<f32x4> b = generate<f32x4>(quarter);
+            const f32x4 va = load<f32x4>(a);
+            const f32x4 vb = load<f32x4>(b);
+            const std::string inputs = str(a) + " " + str(b);
+
+            compare_scalar("dot3", "f32x4", dot3(va, vb), a[0] * b[0] + a[1] * b[1] + a[2] * b[2], 0, inputs);
+            compare_scalar("dot4", "f32x4", dot4(va, vb), a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3], 0, inputs);
+
+            const Lanes<f32x4> cross =
+            {{
+                a[1] * b[2] - a[2] * b[1],
+                a[2] * b[0] - a[0] * b[2],
+                a[0] * b[1] - a[1] * b[0],
+                0.0f
+            }};
+            compare("cross3", "f32x4", store<f32x4>(cross3(va, vb)), cross, 0, [&] { return inputs; });
+
+            const f32 s = quarter();
+            Lanes<f32x4> quotient;
+            for (int i = 0; i < 4; ++i)
+            {
+                quotient[i] = a[i] / s;
+            }
+            if (s != 0)
+            {
+                compare("div(scalar)", "f32x4", store<f32x4>(div(va, s)), quotient, 0, [&] { return inputs + " " + str(s); });
+            }
+        }
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const auto quarter64 = [] { return random_quarter<f64>(64); };
+            const Lanes<f64x2> a = generate<f64x2>(quarter64);
+            const Lanes<f64x2> b = generate<f64x2>(quarter64);
+            const Lanes<f64x4> c = generate<f64x4>(quarter64);
+            const Lanes<f64x4> d = generate<f64x4>(quarter64);
+
+            compare_scalar("dot2", "f64x2", dot2(load<f64x2>(a), load<f64x2>(b)), a[0] * b[0] + a[1] * b[1], 0, str(a) + " " + str(b));
+            compare_scalar("dot4", "f64x4", dot4(load<f64x4>(c), load<f64x4>(d)), c[0] * d[0] + c[1] * d[1] + c[2] * d[2] + c[3] * d[3], 0, str(c) + " " + str(d));
+
+            const f64 s = quarter64();
+            Lanes<f64x2> quotient = {{ a[0] / s, a[1] / s }};
+            if (s != 0)
+            {
+                compare("div(scalar)", "f64x2", store<f64x2>(div(load<f64x2>(a), s)), quotient, 0, [&] { return str(a) + " " + str(s); });
+            }
+        }
+    }
+
+    // ----------------------------------------------------------------------------
+    // common.hpp
+    // ----------------------------------------------------------------------------
+
+    template <typename V>
+    void check_common_xyzw()
+    {
+        using T = typename V::scalar;
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>();
+            const T s = random_value<T>();
+            const V v = load<V>(a);
+            const std::string inputs = str(a) + " " + str(s);
+            const auto describe = [&] { return inputs; };
+
+            const Lanes<V> x = {{ s, a[1], a[2], a[3] }};
+            const Lanes<V> y = {{ a[0], s, a[2], a[3] }};
+            const Lanes<V> z = {{ a[0], a[1], s, a[3] }};
+            const Lanes<V> w = {{ a[0], a[1], a[2], s }};
+            compare("set_x", type_name<V>(), store<V>(set_x(v, s)), x, 0, describe);
+            compare("set_y", type_name<V>(), store<V>(set_y(v, s)), y, 0, describe);
+            compare("set_z", type_name<V>(), store<V>(set_z(v, s)), z, 0, describe);
+            compare("set_w", type_name<V>(), store<V>(set_w(v, s)), w, 0, describe);
+
+            compare_scalar("get_x", type_name<V>(), get_x(v), a[0], 0, inputs);
+            compare_scalar("get_y", type_name<V>(), get_y(v), a[1], 0, inputs);
+            compare_scalar("get_z", type_name<V>(), get_z(v), a[2], 0, inputs);
+            compare_scalar("get_w", type_name<V>(), get_w(v), a[3], 0, inputs);
+
+            const Lanes<V> sx = {{ a[0], a[0], a[0], a[0] }};
+            const Lanes<V> sy = {{ a[1], a[1], a[1], a[1] }};
+            const Lanes<V> sz = {{ a[2], a[2], a[2], a[2] }};
+            const Lanes<V> sw = {{ a[3], a[3], a[3], a[3] }};
+            compare("splat_x", type_name<V>(), store<V>(splat_x(v)), sx, 0, describe);
+            compare("splat_y", type_name<V>(), store<V>(splat_y(v)), sy, 0, describe);
+            compare("splat_z", type_name<V>(), store<V>(splat_z(v)), sz, 0, describe);
+            compare("splat_w", type_name<V>(), store<V>(splat_w(v)), sw, 0, describe);
+        }
+    }
+
+    template <typename V>
+    void check_common_clamp()
+    {
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>();
+            Lanes<V> low = generate<V>();
+            Lanes<V> high = generate<V>();
+
+            Lanes<V> expected;
+            for (int i = 0; i < V::size; ++i)
+            {
+                if (low[i] > high[i])
+                    std::swap(low[i], high[i]);
+                expected[i] = std::min(std::max(a[i], low[i]), high[i]);
+            }
+
+            compare("clamp", type_name<V>(), store<V>(clamp(load<V>(a), load<V>(low), load<V>(high))), expected, 0,
+                [&] { return str(a) + " " + str(low) + " " + str(high); });
+        }
+    }
+
+    void check_common()
+    {
+        check_common_xyzw<u32x4>();
+        check_common_xyzw<s32x4>();
+        check_common_xyzw<f32x4>();
+
+        check_common_clamp<u8x16>();
+        check_common_clamp<u16x8>();
+        check_common_clamp<u32x4>();
+        check_common_clamp<s8x16>();
+        check_common_clamp<s16x8>();
+        check_common_clamp<s32x4>();
+        check_common_clamp<f32x4>();
+        check_common_clamp<f32x8>();
+        check_common_clamp<f64x2>();
+    }
+
+    // ----------------------------------------------------------------------------
+    // conversions
+    // ----------------------------------------------------------------------------
+
+    template <typename D, typename S, typename Func, typename Ref, typename Generator>
+    void check_convert(const std::string& op, Func func, Ref ref, Generator generator)
+    {
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<S> a = generate<S>(generator);
+
+            Lanes<D> expected;
+            for (int i = 0; i < D::size; ++i)
+            {
+                expected[i] = ref(a[i]);
+            }
+
+            const Lanes<D> result = store<D>(func(load<S>(a)));
+            compare(op + "<" + type_name<D>() + ">", type_name<S>(), result, expected, 0, [&] { return str(a); });
+        }
+    }
+
+    template <typename D, typename S>
+    void check_reinterpret()
+    {
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<S> a = generate<S>();
+
+            Lanes<D> expected;
+            std::memcpy(expected.data(), a.data(), sizeof(expected));
+
+            const Lanes<D> result = store<D>(reinterpret<D>(load<S>(a)));
+            compare("reinterpret<" + type_name<D>() + ">", type_name<S>(), result, expected, 0, [&] { return str(a); });
+        }
+    }
+
+    template <typename D, typename S, typename Func>
+    void check_extend(const std::string& op, Func func)
+    {
+        using T = typename D::scalar;
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<S> a = generate<S>();
+
+            Lanes<D> expected;
+            for (int i = 0; i < D::size; ++i)
+            {
+                expected[i] = T(a[i]);
+            }
+
+            compare(op, type_name<S>(), store<D>(func(load<S>(a))), expected, 0, [&] { return str(a); });
+        }
+    }
+
+    template <typename D, typename S>
+    void check_narrow()
+    {
+        using T = typename D::scalar;
+        const int half = S::size;
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<S> a = generate<S>();
+            const Lanes<S> b = generate<S>();
+
+            Lanes<D> expected;
+            for (int i = 0; i < half; ++i)
+            {
+                expected[i + 0] = saturate<T>(s64(a[i]));
+                expected[i + half] = saturate<T>(s64(b[i]));
+            }
+
+            compare("narrow", type_name<S>(), store<D>(narrow(load<S>(a), load<S>(b))), expected, 0,
+                [&] { return str(a) + " " + str(b); });
+        }
+    }
+
+    template <typename V, typename H>
+    void check_halves()
+    {
+        const int half = H::size;
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<V> a = generate<V>();
+            const Lanes<H> b = generate<H>();
+            const Lanes<H> c = generate<H>();
+            const V v = load<V>(a);
+            const auto inputs = [&] { return str(a) + " " + str(b) + " " + str(c); };
+
+            Lanes<H> low;
+            Lanes<H> high;
+            std::copy(a.begin(), a.begin() + half, low.begin());
+            std::copy(a.begin() + half, a.end(), high.begin());
+            compare("get_low", type_name<V>(), store<H>(get_low(v)), low, 0, inputs);
+            compare("get_high", type_name<V>(), store<H>(get_high(v)), high, 0, inputs);
+
+            Lanes<V> set_low_expected = a;
+            Lanes<V> set_high_expected = a;
+            Lanes<V> combined;
+            std::copy(b.begin(), b.end(), set_low_expected.begin());
+            std::copy(b.begin(), b.end(), set_high_expected.begin() + half);
+            std::copy(b.begin(), b.end(), combined.begin());
+            std::copy(c.begin(), c.end(), combined.begin() + half);
+            compare("set_low", type_name<V>(), store<V>(set_low(v, load<H>(b))), set_low_expected, 0, inputs);
+            compare("set_high", type_name<V>(), store<V>(set_high(v, load<H>(b))), set_high_expected, 0, inputs);
+            compare("combine", type_name<V>(), store<V>(combine(load<H>(b), load<H>(c))), combined, 0, inputs);
+        }
+    }
+
+    template <typename T>
+    T random_in_range(f64 low, f64 high)
+    {
+        // mostly exact ties and integers, in the range of the destination type
+        if (random_index(2))
+        {
+            return T(std::floor(low + random_unit() * (high - low)) + 0.5 * random_index(2));
+        }
+        return T(low + random_unit() * (high - low));
+    }
+
+    template <typename S, typename D>
+    void check_float_integer_convert(f64 low, f64 high)
+    {
+        using T = typename D::scalar;
+        using E = typename S::scalar;
+
+        const auto generator = [=] { return random_in_range<E>(low, high); };
+
+        check_convert<D, S>("convert", [] (S a) { return convert<D>(a); }, [] (E a) { return T(std::nearbyint(a)); }, generator);
+    }
+
+    void check_conversions()
+    {
+        check_reinterpret<u32x4, f32x4>();
+        check_reinterpret<f32x4, u32x4>();
+        check_reinterpret<u8x16, s32x4>();
+        check_reinterpret<s16x8, u64x2>();
+        check_reinterpret<f64x2, u64x2>();
+        check_reinterpret<u64x2, f64x2>();
+        check_reinterpret<u32x8, f32x8>();
+        check_reinterpret<f32x8, s32x8>();
+        check_reinterpret<u32x16, f32x16>();
+        check_reinterpret<f32x16, s32x16>();
+
+        check_extend<u16x8, u8x16>("extend16x8", [] (u8x16 a) { return extend16x8(a); });
+        check_extend<u32x4, u8x16>("extend32x4", [] (u8x16 a) { return extend32x4(a); });
+        check_extend<u32x4, u16x8>("extend32x4", [] (u16x8 a) { return extend32x4(a); });
+        check_extend<u32x8, u16x8>("extend32x8", [] (u16x8 a) { return extend32x8(a); });
+        check_extend<s16x8, s8x16>("extend16x8", [] (s8x16 a) { return extend16x8(a); });
+        check_extend<s32x4, s8x16>("extend32x4", [] (s8x16 a) { return extend32x4(a); });
+        check_extend<s32x4, s16x8>("extend32x4", [] (s16x8 a) { return extend32x4(a); });
+        check_extend<s32x8, s16x8>("extend32x8", [] (s16x8 a) { return extend32x8(a); });
+
+        check_narrow<u8x16, u16x8>();
+        check_narrow<u16x8, u32x4>();
+        check_narrow<s8x16, s16x8>();
+        check_narrow<s16x8, s32x4>();
+
+        check_halves<u32x8, u32x4>();
+        check_halves<s32x8, s32x4>();
+        check_halves<f32x8, f32x4>();
+        check_halves<f64x4, f64x2>();
+
+        // integer -> float, rounded to nearest even when the integer is not representable
+        check_convert<f32x4, s32x4>("convert", [] (s32x4 a) { return convert<f32x4>(a); }, [] (s32 a) { return f32(a); }, random_integer<s32>);
+        check_convert<f32x4, u32x4>("convert", [] (u32x4 a) { return convert<f32x4>(a); }, [] (u32 a) { return f32(a); }, random_integer<u32>);
+        check_convert<f32x8, s32x8>("convert", [] (s32x8 a) { return convert<f32x8>(a); }, [] (s32 a) { return f32(a); }, random_integer<s32>);
+        check_convert<f32x8, u32x8>("convert", [] (u32x8 a) { return convert<f32x8>(a); }, [] (u32 a) { return f32(a); }, random_integer<u32>);
+        check_convert<f32x16, s32x16>("convert", [] (s32x16 a) { return convert<f32x16>(a); }, [] (s32 a) { return f32(a); }, random_integer<s32>);
+        check_convert<f32x16, u32x16>("convert", [] (u32x16 a) { return convert<f32x16>(a); }, [] (u32 a) { return f32(a); }, random_integer<u32>);
+        check_convert<f64x4, s32x4>("convert", [] (s32x4 a) { return convert<f64x4>(a); }, [] (s32 a) { return f64(a); }, random_integer<s32>);
+        check_convert<f64x4, u32x4>("convert", [] (u32x4 a) { return convert<f64x4>(a); }, [] (u32 a) { return f64(a); }, random_integer<u32>);
+
+        // float -> integer, round to nearest even
+        const f64 s32_low = -2147483648.0;
+        const f64 s32_high = 2147483520.0; // largest f32 below 2^31
+        const f64 u32_high = 4294967040.0; // largest f32 below 2^32
+        check_float_integer_convert<f32x4, s32x4>(s32_low, s32_high);
+        check_float_integer_convert<f32x4, u32x4>(0, u32_high);
+        check_float_integer_convert<f32x8, s32x8>(s32_low, s32_high);
+        check_float_integer_convert<f32x8, u32x8>(0, u32_high);
+        check_float_integer_convert<f32x16, s32x16>(s32_low, s32_high);
+        check_float_integer_convert<f32x16, u32x16>(0, u32_high);
+        check_float_integer_convert<f64x4, s32x4>(s32_low, 2147483647.0);
+        check_float_integer_convert<f64x4, u32x4>(0, 4294967295.0);
+        check_float_integer_convert<f64x4, s64x4>(-9.2e18, 9.2e18);
+
+        // float -> integer, truncate
+        const auto truncate_f32 = [=] { return random_in_range<f32>(s32_low, s32_high); };
+        const auto truncate_f64 = [=] { return random_in_range<f64>(s32_low, 2147483647.0); };
+        check_convert<s32x4, f32x4>("truncate", [] (f32x4 a) { return truncate<s32x4>(a); }, [] (f32 a) { return s32(a); }, truncate_f32);
+        check_convert<s32x8, f32x8>("truncate", [] (f32x8 a) { return truncate<s32x8>(a); }, [] (f32 a) { return s32(a); }, truncate_f32);
+        check_convert<s32x16, f32x16>("truncate", [] (f32x16 a) { return truncate<s32x16>(a); }, [] (f32 a) { return s32(a); }, truncate_f32);
+        check_convert<s32x4, f64x4>("truncate", [] (f64x4 a) { return truncate<s32x4>(a); }, [] (f64 a) { return s32(a); }, truncate_f64);
+
+        // float <-> double; the double -> float conversion rounds to nearest even
+        check_convert<f64x4, f32x4>("convert", [] (f32x4 a) { return convert<f64x4>(a); }, [] (f32 a) { return f64(a); }, random_float<f32>);
+        check_convert<f32x4, f64x4>("convert", [] (f64x4 a) { return convert<f32x4>(a); }, [] (f64 a) { return f32(a); }, [] {
+            return random_float<f64>() * (1.0 + std::ldexp(1.0, -30) * random_index(64));
+        });
+
+        // integer -> double
+        check_convert<f64x4, s64x4>("convert", [] (s64x4 a) { return convert<f64x4>(a); }, [] (s64 a) { return f64(a); }, [] {
+            return s64(random_integer<s32>()) * (random_index(2) ? 1 : 0x10000);
+        });
+
+        // half float; the values are exactly representable in both precisions
+        const auto half = [] { return random_quarter<f32>(1024); };
+        check_convert<f32x4, f16x4>("convert", [] (f16x4 a) { return convert<f32x4>(a); }, [] (f16 a) { return f32(a); },
+            [=] { return f16(half()); });
+        check_convert<f16x4, f32x4>("convert", [] (f32x4 a) { return convert<f16x4>(a); }, [] (f32 a) { return f16(a); }, half);
+
+        // s32x4 <-> packed bytes
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            const Lanes<s32x4> a = generate<s32x4>([] { return s32(random_index(512) - 128); });
+
+            u32 expected = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                expected |= u32(std::min(std::max(a[i], 0), 255)) << (i * 8);
+            }
+            compare_scalar("pack", "s32x4", pack(load<s32x4>(a)), expected, 0, str(a));
+
+            const u32 packed = u32(random_bits());
+            const Lanes<s32x4> unpacked = {{ s32(packed & 0xff), s32((packed >> 8) & 0xff), s32((packed >> 16) & 0xff), s32(packed >> 24) }};
+            compare("unpack", "s32x4", store<s32x4>(unpack(packed)), unpacked, 0, [&] { return str(packed); });
+        }
+    }
+
+    // ----------------------------------------------------------------------------
+    // gather
+    // ----------------------------------------------------------------------------
+
+    template <typename V, typename O, typename Gather, typename MaskedGather>
+    void check_gather(const std::string& op, Gather gather, MaskedGather masked_gather)
+    {
+        using T = typename V::scalar;
+        using S = MaskSourceType<V>;
+
+        T table[256];
+        for (auto& value : table)
+        {
+            value = random_value<T>();
+        }
+
+        for (int iteration = 0; iteration < g_iterations; ++iteration)
+        {
+            Lanes<O> offset;
+            offset.fill(0);
+            for (int i = 0; i < V::size; ++i)
+            {
+                offset[i] = random_index(256);
+            }
+
+            Lanes<V> expected;
+            for (int i = 0; i < V::size; ++i)
+            {
+                expected[i] = table[offset[i]];
+            }
+
+            compare(op, type_name<V>(), store<V>(gather(table, load<O>(offset))), expected, 0, [&] { return str(offset); });
+
+            const Lanes<V> value = generate<V>();
+            const Lanes<S> c = generate<S>();
+            const Lanes<S> d = generate<S>();
+
+            Lanes<V> masked;
+            for (int i = 0; i < V::size; ++i)
+            {
+                masked[i] = c[i] > d[i] ? table[offset[i]] : value[i];
+            }
+
+            const auto mask = compare_gt(load<S>(c), load<S>(d));
+            compare(op + "(masked)", type_name<V>(), store<V>(masked_gather(table, load<O>(offset), load<V>(value), mask)), masked, 0,
+                [&] { return str(offset) + " " + str(value) + " " + str(c) + " " + str(d); });
+        }
+    }
+
+    #define CHECK_GATHER(func, V, O) \
+        check_gather<V, O>(#func, \
+            [] (const V::scalar* p, O offset) { return func(p, offset); }, \
+            [] (const V::scalar* p, O offset, V value, decltype(compare_gt(MaskSourceType<V>(), MaskSourceType<V>())) mask) { \
+                return func(p, offset, value, mask); })
+
+    void check_gathers()
+    {
+        CHECK_GATHER(gather4, f32x4, s32x4);
+        CHECK_GATHER(gather4, u32x4, s32x4);
+        CHECK_GATHER(gather4, s32x4, s32x4);
+        CHECK_GATHER(gather2, f64x2, s32x4);
+        CHECK_GATHER(gather2, u64x2, s32x4);
+        CHECK_GATHER(gather2, s64x2, s32x4);
+        CHECK_GATHER(gather8, f32x8, s32x8);
+        CHECK_GATHER(gather8, u32x8, s32x8);
+        CHECK_GATHER(gather8, s32x8, s32x8);
+        CHECK_GATHER(gather4, f64x4, s32x4);
+        CHECK_GATHER(gather4, u64x4, s32x4);
+        CHECK_GATHER(gather4, s64x4, s32x4);
+        CHECK_GATHER(gather16, f32x16, s32x16);
+        CHECK_GATHER(gather16, u32x16, s32x16);
+        CHECK_GATHER(gather16, s32x16, s32x16);
+        CHECK_GATHER(gather8, f64x8, s32x8);
+        CHECK_GATHER(gather8, u64x8, s32x8);
+        CHECK_GATHER(gather8, s64x8, s32x8);
+    }
+
+    // ----------------------------------------------------------------------------
+    // all types
+    // ----------------------------------------------------------------------------
+
+    void check_all()
+    {
+        check_memory_all();
+
+        check_integer_128<u8x16>();
+        check_integer_128<u16x8>();
+        check_integer_128<u32x4>();
+        check_integer_128<s8x16>();
+        check_integer_128<s16x8>();
+        check_integer_128<s32x4>();
+        check_integer_64<u64x2>();
+        check_integer_64<s64x2>();
+
+        check_integer_256<u8x32>();
+        check_integer_256<u16x16>();
+        check_integer_256<u32x8>();
+        check_integer_256<s8x32>();
+        check_integer_256<s16x16>();
+        check_integer_256<s32x8>();
+        check_integer_64<u64x4>();
+        check_integer_64<s64x4>();
+
+        check_integer_256<u8x64>();
+        check_integer_256<u16x32>();
+        check_integer_256<u32x16>();
+        check_integer_256<s8x64>();
+        check_integer_256<s16x32>();
+        check_integer_256<s32x16>();
+        check_integer_64<u64x8>();
+        check_integer_64<s64x8>();
+
+        check_integer_saturate<u8x16>();
+        check_integer_saturate<u16x8>();
+        check_integer_saturate<s8x16>();
+        check_integer_saturate<s16x8>();
+        check_integer_saturate<u8x32>();
+        check_integer_saturate<u16x16>();
+        check_integer_saturate<s8x32>();
+        check_integer_saturate<s16x16>();
+        check_integer_saturate<u8x64>();
+        check_integer_saturate<u16x32>();
+        check_integer_saturate<s8x64>();
+        check_integer_saturate<s16x32>();
+
+        check_integer_signed<s8x16>();
+        check_integer_signed<s16x8>();
+        check_integer_signed<s32x4>();
+        check_integer_signed<s8x32>();
+        check_integer_signed<s16x16>();
+        check_integer_signed<s32x8>();
+        check_integer_signed<s8x64>();
+        check_integer_signed<s16x32>();
+        check_integer_signed<s32x16>();
+
+        // the 8 bit lanes have no shifts
+        check_shift<u16x8>();
+        check_shift<u32x4>();
+        check_shift<s16x8>();
+        check_shift<s32x4>();
+        check_shift<u16x16>();
+        check_shift<u32x8>();
+        check_shift<s16x16>();
+        check_shift<s32x8>();
+        check_shift<u16x32>();
+        check_shift<u32x16>();
+        check_shift<s16x32>();
+        check_shift<s32x16>();
+
+        check_shift_arithmetic<s16x8>();
+        check_shift_arithmetic<s32x4>();
+        check_shift_arithmetic<s16x16>();
+        check_shift_arithmetic<s32x8>();
+        check_shift_arithmetic<s16x32>();
+        check_shift_arithmetic<s32x16>();
+
+        check_shift_variable<u32x4>();
+        check_shift_variable<s32x4>();
+
+        check_integer_mullo<u16x8>();
+        check_integer_mullo<u32x4>();
+        check_integer_mullo<s16x8>();
+        check_integer_mullo<s32x4>();
+        check_integer_mullo<u16x16>();
+        check_integer_mullo<u32x8>();
+        check_integer_mullo<s16x16>();
+        check_integer_mullo<s32x8>();
+        check_integer_mullo<u16x32>();
+        check_integer_mullo<u32x16>();
+        check_integer_mullo<s16x32>();
+        check_integer_mullo<s32x16>();
+
+        check_components<u8x16>();
+        check_components<u16x8>();
+        check_components<u32x4>();
+        check_components<u64x2>();
+        check_components<s8x16>();
+        check_components<s16x8>();
+        check_components<s32x4>();
+        check_components<s64x2>();
+        check_components<f32x4>();
+        check_components<f64x2>();
+        check_components<u32x8>();
+        check_components<s32x8>();
+        check_components<f64x4>();
+
+        check_float<f32x4>();
+        check_float<f32x8>();
+        check_float<f32x16>();
+        check_float<f64x2>();
+        check_float<f64x4>();
+        check_float<f64x8>();
+        check_float_128();
+
+        check_common();
+        check_conversions();
+        check_gathers();
+    }
+
+} // namespace
+
+int main()
+{
+    const test::Backend backend = test::getBackend();
+    if (!test::isBackendSupported(backend))
+    {
+        return test::SKIP_RETURN_CODE;
+    }
+
+    g_backend = backend.name;
+    check_all();
+
+    std::printf("%s: %d checks, %d failed.\n", backend.name, g_checks, g_failures);
+    return g_failures ? 1 : 0;
+}